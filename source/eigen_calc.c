@@ -3,30 +3,204 @@
     
      The external:
        - Is instantiated with a dimension [qte.eigencalc n].
-       - Expects a plain list message of 2*n*n floats (row-major order; each element is represented as real, imag).
-       - On bang, converts the matrix to column-major, computes eigenvalues/eigenvectors,
-         and outputs:
-           Left outlet: n real eigenvalues.
-           Right outlet: 2*n*n floats for eigenvectors (each eigenvector is a column with interleaved real, imag).
+       - Expects a plain list message of 2*n*n floats (row-major order; each element is represented as real, imag),
+         or a "jit_matrix <name>" message naming a 2-plane float64 n×n matrix (plane 0 = real, plane 1 = imag).
+       - On bang, converts the matrix to column-major, computes eigenvalues/eigenvectors
+         with the LAPACK driver chosen by @driver (zheev, zheevd or zheevr), and outputs:
+           Left outlet: n real eigenvalues (ascending).
+           Right outlet: 2*n*n floats for eigenvectors (each eigenvector is a column with interleaved real, imag),
+                         or, with @format matrix, a 2-plane float64 n×n jit.matrix whose columns are the eigenvectors.
+       - @range index / @range value restrict the output to the m eigenpairs with
+         indices @index lo hi or eigenvalues in (@values lo hi]; both outlets then carry
+         m eigenvalues and 2*n*m eigenvector floats. @vectors 0 outputs eigenvalues only.
+       - @async 1 runs the decomposition on a background thread on a snapshot of the
+         matrix and outputs the result on the main thread. A newer bang supersedes a job
+         still in flight, "cancel" drops it, and the right outlet reports busy / done / cancelled.
+       - Results are kept in an LRU cache of up to @cachesize MB (0 disables it), keyed by a
+         hash of the matrix, n and the solve settings; a bang on a matrix already decomposed
+         re-emits the cached eigenpairs without calling LAPACK. "cache_stats" sends
+         "cache_stats hits misses entries bytes" from the right outlet, "cache_clear" empties it.
+       - @track 1 (full spectrum with eigenvectors) follows the eigenpairs of a slowly varying
+         matrix: each bang refines the previous eigenvectors (qte_eigh_track) instead of
+         decomposing from scratch, and falls back to the @driver solve when that does not
+         converge to @tracktol, matching the new eigenpairs to the previous ones. Eigenpairs
+         keep their order and phase from bang to bang (so the eigenvalues are ascending only
+         until levels cross) and the right outlet reports "track converged <iterations>" or
+         "track solved". Tracked results bypass the cache.
+       - @blocks 1 (default) looks for disconnected blocks before decomposing a dense or packed
+         matrix: basis states that no chain of nonzero entries connects (subsystems combined
+         with qte.hermcombiner, say) are decomposed as separate blocks with zheevd (zheev with
+         @driver zheev), sum n_k^3 instead of n^3, spread over @threads cores (0 = one per core)
+         when there are several. @parity 1 also tries the even/odd split of a matrix symmetric
+         under the reflection i -> n-1-i, and keeps whichever split is cheaper (qte.quantumho's
+         H is not: the reflection conjugates its P^2, so @parity does not split it). The eigenpairs
+         are merged in ascending order, so the outlets carry the usual format (each eigenvector
+         is zero outside its block); the right outlet reports "blocks <count> <parity>" when a
+         split was used. A packed matrix that splits (or any, with @parity 1) is unpacked first.
+       - Banded and sparse Hamiltonians need no dense n×n storage:
+           "band kd <diagonals>" holds the main diagonal and the kd superdiagonals, one after
+             the other, as (real, imag) pairs (entry k of diagonal d is H(k, k+d)); n follows
+             from the length. "band kd <name>" reads them from a 2-plane float64 jit.matrix with
+             kd+1 rows (row d = diagonal d, n columns). Solved with zhbevd in O(kd n^2).
+           "sparse i j re im ..." sets H(i, j) = re + i*im and H(j, i) to its conjugate
+             (0-based, i, j < n); "sparse <name>" reads the entries from a 2-plane float64
+             jit.matrix with 2 columns, one entry per row: cell 0 = (i, j), cell 1 = (re, im).
+             With @range index lo hi, the lowest hi+1 eigenpairs are found by Lanczos (basis of
+             at most @krylov vectors, 0 = automatic) in O(n) storage per vector; any other
+             range decomposes the matrix densely.
+           "packed <floats>" holds the upper triangle column by column in LAPACK packed
+             storage (entry i + j(j+1)/2 is H(i, j), i <= j) as n(n+1) floats, about half the
+             full list; n follows from the length. Solved with zhpevd on the packed data as
+             received, with no transpose into a second buffer.
+         The last matrix received (list, jit_matrix, band, sparse or packed) is the one decomposed.
+         Each one received is stored as a new version, published in a slot (t_qte_slots), so a
+         bang from the scheduler decomposes the version it pinned while the UI sends the next.
+       - "stats" sends the parse (storing input), compute (snapshot and solve, on the worker
+         thread with @async 1; a cache hit counts as a compute) and output latencies from the
+         right outlet (see qte_stats_message).
+       - "write <file>" saves the eigenpairs of the stored matrix (from the cache, or solved
+         on the spot) to a snapshot file (see qte_snapshot_write): eigenvalues, column-major
+         eigenvectors and a hash of the matrix and settings. "read <file>" maps a snapshot
+         and outputs it in place, without parsing or solving (adopting its n); while it is
+         loaded, a bang on the matrix it was made from (or with no matrix stored) re-emits it
+         like a cache hit, so a patch starts from a page-in instead of an O(n^3) solve.
 */
 
 #include "ext.h"
 #include "ext_obex.h"
-// Include both clapack.h for LAPACK function declarations
-#include <Accelerate/Accelerate.h>
+#include "jit.common.h"
+// LAPACK drivers are in qte_core (qte_eigh).
+#include "qte_core.h"
+#include "qte_core_max.h"
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
+
+#define QTE_EIGENCALC_TRACK_ITER 4    // corrections per bang before falling back
+#define QTE_EIGENCALC_LANCZOS_TOL 1e-10
+#define QTE_EIGENCALC_BLOCK_TOL 1e-15   // entries below this times max|H| do not couple blocks
+
+// Storage of the stored input matrix.
+typedef enum _qte_eigencalc_input {
+    QTE_EIGENCALC_DENSE = 0,      // matrix
+    QTE_EIGENCALC_BAND = 1,       // band, kd
+    QTE_EIGENCALC_SPARSE = 2,     // sparse
+    QTE_EIGENCALC_PACKED = 3,     // packed
+    QTE_EIGENCALC_NONE = 4        // nothing stored (yet, or since a dim)
+} t_qte_eigencalc_input;
+
+// One version of the stored input matrix, published in x->in_slots. A set_*
+// style handler fills a version no bang holds and publishes it; `input` tells
+// which of the storages is current, the others keep their capacity for reuse.
+typedef struct _qte_eigencalc_matrix {
+    long n;
+    t_qte_eigencalc_input input;
+    t_qte_cmatrix matrix;         // dense, row-major
+    t_qte_cmatrix band;           // (kd + 1) x n LAPACK upper band storage, column-major
+    long kd;
+    t_qte_csr sparse;
+    t_qte_cvector packed;
+} t_qte_eigencalc_matrix;
+
+// A snapshot of one decomposition request (see qte_eigencalc_job_new).
+typedef struct _qte_eigencalc_job {
+    long n;
+    t_qte_eigh_params params;     // driver, eigenvectors or not, spectrum range
+    t_qte_eigencalc_input input;  // dense (or densified), band, or sparse (Lanczos)
+    t_qte_cmatrix A;              // n x n column-major input, or the band storage (destroyed by LAPACK)
+    long kd;                      // superdiagonals of a band input
+    t_qte_cvector AP;             // packed input (destroyed by LAPACK)
+    t_qte_csr S;                  // sparse input (Lanczos)
+    long krylov;                  // Lanczos basis size, 0 = automatic
+    double *w;                    // eigenvalues, w_size allocated
+    long w_size;
+    t_qte_cmatrix Z;              // n x m column-major eigenvectors
+    long m;                       // number of eigenpairs found
+    long generation;              // request counter value when submitted
+    double seconds;               // time spent in qte_eigencalc_job_run (stats)
+    // Tracking (@track 1): refine Vprev instead of decomposing A from scratch.
+    int track;
+    double tracktol;
+    t_qte_cmatrix Vprev;          // previous eigenvectors, 0 rows on the first bang
+    t_qte_eigh_tracker tracker;
+    int tracked;                  // corrections applied, -1 = decomposed from scratch
+    // Block decomposition (@blocks 1, dense and packed input).
+    int blocks;
+    int parity;                   // try the parity split as well (@parity 1)
+    long threads;
+    t_qte_eigh_split split;       // scratch of qte_eigh_blocks
+    long split_count;             // blocks decomposed separately, 1 = the whole matrix
+    int split_parity;             // 1 if they came from the parity split
+    // Result cache (see qte_eigencalc_cache_*): a finished job becomes a cache entry.
+    uint64_t key;                 // hash of the matrix, n and params
+    size_t bytes;                 // storage held by w and Z
+    struct _qte_eigencalc_job *prev, *next;
+} t_qte_eigencalc_job;
 
 // Object structure
 typedef struct _qte_eigencalc {
     t_object ob;
     long n;   // Matrix dimension
-    // Stored complex matrix, in row-major order.
-    // Expected input is 2*n*n floats, interpreted as n*n complex numbers.
-    __CLPK_doublecomplex *matrix;
-    // Two outlets: left for eigenvalues, right for eigenvectors.
+    // Stored input matrix (dense, band, sparse or packed), one version per
+    // slot; a bang pins the published one (see qte_eigencalc_acquire).
+    t_qte_slots in_slots;
+    t_qte_eigencalc_matrix in[QTE_SLOTS];
+    long krylov;                    // Lanczos basis size, 0 = automatic
+    // Data outlets: left for eigenvalues, middle for eigenvectors.
     void *out_eigenvalues;
     void *out_eigenvectors;
+    // LAPACK driver: "zheev", "zheevd" or "zheevr".
+    t_symbol *driver;
+    // Spectrum selection: "all", "index" (index[0]..index[1], 0-based) or
+    // "value" (eigenvalues in (values[0], values[1]]). Subsets use zheevr.
+    t_symbol *range;
+    long index[2];
+    double values[2];
+    // 0 = eigenvalues only, 1 = eigenvalues and eigenvectors.
+    long vectors;
+    // Output format for the eigenvectors: "list" or "matrix".
+    t_symbol *format;
+    // Registered 2-plane float64 jit.matrix used for @format matrix output.
+    void *outmatrix;
+    t_symbol *outmatrix_name;
+    // Background decomposition (@async 1).
+    long async;
+    void *out_status;               // "busy", "done" or "cancelled"
+    t_systhread worker;
+    t_systhread_mutex mutex;        // guards pending, finished, busy and generation
+    void *qelem;                    // outputs finished jobs on the main thread
+    t_qte_eigencalc_job *pending;   // newest request not yet picked up by the worker
+    t_qte_eigencalc_job *finished;  // result waiting for the qelem
+    long busy;                      // a worker thread is running
+    long generation;                // bumped by every bang and cancel
+    // Result cache, most recently used first (main thread only).
+    double cachesize;               // capacity in MB, 0 = off
+    t_qte_eigencalc_job *cache_head;
+    t_qte_eigencalc_job *cache_tail;
+    size_t cache_bytes;
+    long cache_entries;
+    long cache_hits;
+    long cache_misses;
+    // Eigenpair tracking (@track 1): eigenvectors of the last output, column-major.
+    long track;
+    double tracktol;
+    t_qte_cmatrix track_V;
+    t_qte_snapshot snap;            // last file read, mapped ("read")
+    // Block decomposition: @blocks 1 decomposes disconnected blocks separately,
+    // @parity 1 also tries the even/odd split, @threads spreads the blocks.
+    long blocks;
+    long parity;
+    long threads;                   // 0 = one per core
+    // Scratch kept across bangs, so that a steady stream of bangs allocates nothing:
+    // the LAPACK workspace (held by one solve at a time, see qte_eigencalc_work_take),
+    // the storage of the last job that was not cached (reused by the next one) and
+    // the output atoms.
+    t_qte_eigh_work ws;
+    long ws_busy;                   // guarded by mutex
+    t_qte_eigencalc_job *spare;     // main thread only
+    t_atom *out_list;
+    long out_list_size;
+    t_qte_stats stats;              // "stats" message / qte.profiler (main thread)
 } t_qte_eigencalc;
 
 static t_class *qte_eigencalc_class = NULL;
@@ -37,8 +211,26 @@ void *qte_eigencalc_new(t_symbol *s, long argc, t_atom *argv);
 void  qte_eigencalc_free(t_qte_eigencalc *x);
 void  qte_eigencalc_assist(t_qte_eigencalc *x, void *b, long m, long a, char *s);
 void  qte_eigencalc_list(t_qte_eigencalc *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_eigencalc_jit_matrix(t_qte_eigencalc *x, t_symbol *s);
+void  qte_eigencalc_band(t_qte_eigencalc *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_eigencalc_sparse(t_qte_eigencalc *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_eigencalc_packed(t_qte_eigencalc *x, t_symbol *s, long argc, t_atom *argv);
 void  qte_eigencalc_bang(t_qte_eigencalc *x);
 void  qte_eigencalc_dim(t_qte_eigencalc *x, long n);
+void  qte_eigencalc_cancel(t_qte_eigencalc *x);
+void  qte_eigencalc_cache_stats(t_qte_eigencalc *x);
+void  qte_eigencalc_cache_clear(t_qte_eigencalc *x);
+void  qte_eigencalc_stats(t_qte_eigencalc *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_eigencalc_write(t_qte_eigencalc *x, t_symbol *s);
+void  qte_eigencalc_read(t_qte_eigencalc *x, t_symbol *s);
+t_max_err qte_eigencalc_cachesize_set(t_qte_eigencalc *x, void *attr, long argc, t_atom *argv);
+static t_qte_eigencalc_job *qte_eigencalc_job_new(t_qte_eigencalc *x, const t_qte_eigencalc_matrix *in,
+                                                  const t_qte_eigh_params *p);
+static void qte_eigencalc_job_free(t_qte_eigencalc_job *job);
+static void qte_eigencalc_matrix_free(t_qte_eigencalc_matrix *in);
+static void qte_eigencalc_job_recycle(t_qte_eigencalc *x, t_qte_eigencalc_job *job);
+static void qte_eigencalc_qfn(t_qte_eigencalc *x);
+static void qte_eigencalc_cache_insert(t_qte_eigencalc *x, t_qte_eigencalc_job *job);
 
 /* ----------------------------------------------------------------------------
    ext_main – class initialization
@@ -54,8 +246,74 @@ void ext_main(void *r) {
     class_addmethod(c, (method)qte_eigencalc_dim, "dim", A_LONG, 0);
     // Register the "list" method to accept a plain list message with 2*n*n floats.
     class_addmethod(c, (method)qte_eigencalc_list, "list", A_GIMME, 0);
+    // "jit_matrix" reads a 2-plane float64 matrix in place instead of a list.
+    class_addmethod(c, (method)qte_eigencalc_jit_matrix, "jit_matrix", A_SYM, 0);
+    // "band" and "sparse" store banded and sparse matrices without dense storage.
+    class_addmethod(c, (method)qte_eigencalc_band, "band", A_GIMME, 0);
+    class_addmethod(c, (method)qte_eigencalc_sparse, "sparse", A_GIMME, 0);
+    class_addmethod(c, (method)qte_eigencalc_packed, "packed", A_GIMME, 0);
     // "bang" triggers the eigen-decomposition.
     class_addmethod(c, (method)qte_eigencalc_bang, "bang", 0);
+    // "cancel" drops a pending or running background decomposition.
+    class_addmethod(c, (method)qte_eigencalc_cancel, "cancel", 0);
+    // "cache_stats" reports the result cache, "cache_clear" empties it.
+    class_addmethod(c, (method)qte_eigencalc_cache_stats, "cache_stats", 0);
+    class_addmethod(c, (method)qte_eigencalc_cache_clear, "cache_clear", 0);
+    // "stats" reports latencies per stage.
+    class_addmethod(c, (method)qte_eigencalc_stats, "stats", A_GIMME, 0);
+    // "write" / "read" save and map eigenbasis snapshots.
+    class_addmethod(c, (method)qte_eigencalc_write, "write", A_DEFSYM, 0);
+    class_addmethod(c, (method)qte_eigencalc_read, "read", A_DEFSYM, 0);
+
+    CLASS_ATTR_SYM(c, "driver", 0, t_qte_eigencalc, driver);
+    CLASS_ATTR_ENUM(c, "driver", 0, "zheev zheevd zheevr");
+    CLASS_ATTR_LABEL(c, "driver", 0, "LAPACK Driver");
+
+    CLASS_ATTR_SYM(c, "range", 0, t_qte_eigencalc, range);
+    CLASS_ATTR_ENUM(c, "range", 0, "all index value");
+    CLASS_ATTR_LABEL(c, "range", 0, "Spectrum Selection");
+
+    CLASS_ATTR_LONG_ARRAY(c, "index", 0, t_qte_eigencalc, index, 2);
+    CLASS_ATTR_LABEL(c, "index", 0, "Eigenpair Index Range (0-based, inclusive)");
+
+    CLASS_ATTR_DOUBLE_ARRAY(c, "values", 0, t_qte_eigencalc, values, 2);
+    CLASS_ATTR_LABEL(c, "values", 0, "Eigenvalue Range (lo, hi]");
+
+    CLASS_ATTR_LONG(c, "vectors", 0, t_qte_eigencalc, vectors);
+    CLASS_ATTR_STYLE_LABEL(c, "vectors", 0, "onoff", "Compute Eigenvectors");
+
+    CLASS_ATTR_LONG(c, "async", 0, t_qte_eigencalc, async);
+    CLASS_ATTR_STYLE_LABEL(c, "async", 0, "onoff", "Decompose on a Background Thread");
+
+    CLASS_ATTR_LONG(c, "krylov", 0, t_qte_eigencalc, krylov);
+    CLASS_ATTR_FILTER_MIN(c, "krylov", 0);
+    CLASS_ATTR_LABEL(c, "krylov", 0, "Lanczos Basis Size (0 = automatic)");
+
+    CLASS_ATTR_LONG(c, "track", 0, t_qte_eigencalc, track);
+    CLASS_ATTR_STYLE_LABEL(c, "track", 0, "onoff", "Track Eigenpairs Across Bangs");
+
+    CLASS_ATTR_DOUBLE(c, "tracktol", 0, t_qte_eigencalc, tracktol);
+    CLASS_ATTR_FILTER_MIN(c, "tracktol", 0);
+    CLASS_ATTR_LABEL(c, "tracktol", 0, "Tracking Residual Tolerance (relative)");
+
+    CLASS_ATTR_LONG(c, "blocks", 0, t_qte_eigencalc, blocks);
+    CLASS_ATTR_STYLE_LABEL(c, "blocks", 0, "onoff", "Decompose Disconnected Blocks Separately");
+
+    CLASS_ATTR_LONG(c, "parity", 0, t_qte_eigencalc, parity);
+    CLASS_ATTR_STYLE_LABEL(c, "parity", 0, "onoff", "Try the Parity (Even/Odd) Split");
+
+    CLASS_ATTR_LONG(c, "threads", 0, t_qte_eigencalc, threads);
+    CLASS_ATTR_FILTER_MIN(c, "threads", 0);
+    CLASS_ATTR_LABEL(c, "threads", 0, "Threads (0 = one per core)");
+
+    CLASS_ATTR_DOUBLE(c, "cachesize", 0, t_qte_eigencalc, cachesize);
+    CLASS_ATTR_ACCESSORS(c, "cachesize", NULL, qte_eigencalc_cachesize_set);
+    CLASS_ATTR_FILTER_MIN(c, "cachesize", 0);
+    CLASS_ATTR_LABEL(c, "cachesize", 0, "Result Cache Size (MB)");
+
+    CLASS_ATTR_SYM(c, "format", 0, t_qte_eigencalc, format);
+    CLASS_ATTR_ENUM(c, "format", 0, "list matrix");
+    CLASS_ATTR_LABEL(c, "format", 0, "Eigenvector Output Format");
     
     class_register(CLASS_BOX, c);
     qte_eigencalc_class = c;
@@ -69,16 +327,66 @@ void *qte_eigencalc_new(t_symbol *s, long argc, t_atom *argv) {
     if (x) {
         // Default dimension is 3.
         x->n = 3;
-        if (argc >= 1) {
+        if (attr_args_offset(argc, argv) >= 1) {
             long tmp = atom_getlong(argv);
             if (tmp > 0)
                 x->n = tmp;
         }
-        x->matrix = NULL;
-        // Create two outlets (Max creates outlets right-to-left):
-        // left for eigenvalues, right for eigenvectors.
-        x->out_eigenvectors = outlet_new((t_object *)x, NULL); // right
+        qte_slots_init(&x->in_slots);
+        for (int i = 0; i < QTE_SLOTS; i++) {
+            t_qte_eigencalc_matrix *in = x->in + i;
+            in->n = 0;
+            in->input = QTE_EIGENCALC_NONE;
+            qte_cmatrix_init(&in->matrix);
+            qte_cmatrix_init(&in->band);
+            in->kd = 0;
+            qte_csr_init(&in->sparse);
+            qte_cvector_init(&in->packed);
+        }
+        x->krylov = 0;
+        x->driver = gensym("zheev");
+        x->range = gensym("all");
+        x->index[0] = 0;
+        x->index[1] = x->n - 1;
+        x->values[0] = -1.0;
+        x->values[1] = 1.0;
+        x->vectors = 1;
+        x->format = gensym("list");
+        x->outmatrix = qte_jit_outmatrix_new(&x->outmatrix_name);
+        x->async = 0;
+        x->worker = NULL;
+        systhread_mutex_new(&x->mutex, 0);
+        x->qelem = qelem_new(x, (method)qte_eigencalc_qfn);
+        x->pending = NULL;
+        x->finished = NULL;
+        x->busy = 0;
+        x->generation = 0;
+        x->cachesize = 64.0;
+        x->cache_head = NULL;
+        x->cache_tail = NULL;
+        x->cache_bytes = 0;
+        x->cache_entries = 0;
+        x->cache_hits = 0;
+        x->cache_misses = 0;
+        x->track = 0;
+        x->tracktol = 1e-10;
+        qte_cmatrix_init(&x->track_V);
+        qte_snapshot_init(&x->snap);
+        x->blocks = 1;
+        x->parity = 0;
+        x->threads = 0;
+        qte_eigh_work_init(&x->ws);
+        x->ws_busy = 0;
+        x->spare = NULL;
+        x->out_list = NULL;
+        x->out_list_size = 0;
+        // Create the outlets (Max creates outlets right-to-left):
+        // left for eigenvalues, middle for eigenvectors, right for status.
+        x->out_status = outlet_new((t_object *)x, NULL);       // right
+        x->out_eigenvectors = outlet_new((t_object *)x, NULL); // middle
         x->out_eigenvalues = outlet_new((t_object *)x, NULL);  // left
+        qte_stats_register((t_object *)x, &x->stats);
+        attr_args_process(x, argc, argv);
     }
     return (x);
 }
@@ -87,8 +395,101 @@ void *qte_eigencalc_new(t_symbol *s, long argc, t_atom *argv) {
    Destructor
 ---------------------------------------------------------------------------- */
 void qte_eigencalc_free(t_qte_eigencalc *x) {
-    if (x->matrix)
-        free(x->matrix);
+    qte_stats_unregister((t_object *)x);
+    // Drop queued work; a running solve cannot be interrupted, so wait for it.
+    systhread_mutex_lock(x->mutex);
+    qte_eigencalc_job_free(x->pending);
+    x->pending = NULL;
+    x->generation++;
+    systhread_mutex_unlock(x->mutex);
+    if (x->worker) {
+        unsigned int ret;
+        systhread_join(x->worker, &ret);
+    }
+    qelem_free(x->qelem);
+    qte_eigencalc_job_free(x->finished);
+    systhread_mutex_free(x->mutex);
+    qte_eigencalc_cache_clear(x);
+    qte_cmatrix_free(&x->track_V);
+    for (int i = 0; i < QTE_SLOTS; i++)
+        qte_eigencalc_matrix_free(x->in + i);
+    qte_snapshot_close(&x->snap);
+    qte_eigencalc_job_free(x->spare);
+    qte_eigh_work_free(&x->ws);
+    if (x->out_list)
+        sysmem_freeptr(x->out_list);
+    if (x->outmatrix)
+        jit_object_free(x->outmatrix);
+}
+
+/* ----------------------------------------------------------------------------
+   Stored matrix versions – the handlers below are the one writer (main
+   thread); bang, write and read are the readers.
+---------------------------------------------------------------------------- */
+static void qte_eigencalc_matrix_free(t_qte_eigencalc_matrix *in) {
+    qte_cmatrix_free(&in->matrix);
+    qte_cmatrix_free(&in->band);
+    qte_csr_free(&in->sparse);
+    qte_cvector_free(&in->packed);
+    in->n = 0;
+    in->input = QTE_EIGENCALC_NONE;
+}
+
+/* Writer side: a version no reader holds, to fill and then publish; NULL
+   (with an error) while readers hold every other one. */
+static t_qte_eigencalc_matrix *qte_eigencalc_claim(t_qte_eigencalc *x, int *i) {
+    *i = qte_slots_claim(&x->in_slots);
+    if (*i < 0) {
+        object_error((t_object *)x, "Stored matrix still in use, try again");
+        return NULL;
+    }
+    return x->in + *i;
+}
+
+/* Writer side: publishes version i, holding `input`, for the current
+   dimension and frees the versions of another dimension no reader holds. */
+static void qte_eigencalc_publish(t_qte_eigencalc *x, int i, t_qte_eigencalc_input input) {
+    x->in[i].n = x->n;
+    x->in[i].input = input;
+    qte_slots_publish(&x->in_slots, i);
+    for (i = 0; i < QTE_SLOTS; i++) {
+        if (x->in[i].n != x->n && qte_slots_idle(&x->in_slots, i))
+            qte_eigencalc_matrix_free(x->in + i);
+    }
+}
+
+/* Reader side: pins the published version in *i, NULL (holding nothing) when
+   no matrix is stored for the current dimension. A non-NULL result is paired
+   with qte_eigencalc_release. */
+static const t_qte_eigencalc_matrix *qte_eigencalc_acquire(t_qte_eigencalc *x, int *i) {
+    *i = qte_slots_acquire(&x->in_slots);
+    if (*i < 0)
+        return NULL;
+    if (x->in[*i].input == QTE_EIGENCALC_NONE || x->in[*i].n != x->n) {
+        qte_slots_release(&x->in_slots, *i);
+        *i = -1;
+        return NULL;
+    }
+    return x->in + *i;
+}
+
+static void qte_eigencalc_release(t_qte_eigencalc *x, int i) {
+    if (i >= 0)
+        qte_slots_release(&x->in_slots, i);
+}
+
+/* Switches to dimension n, keeping the stored matrix versions: the caller
+   publishes one for n. */
+static void qte_eigencalc_resize(t_qte_eigencalc *x, long n) {
+    // @index keeps a range that still fits; one ending at the old top
+    // eigenpair (the default) follows the new dimension.
+    if (x->index[1] == x->n - 1 || x->index[1] >= n)
+        x->index[1] = n - 1;
+    if (x->index[0] > x->index[1])
+        x->index[0] = x->index[1];
+    x->n = n;
+    qte_cmatrix_free(&x->track_V);
+    object_post((t_object *)x, "Dimension set to %ld", n);
 }
 
 void qte_eigencalc_dim(t_qte_eigencalc *x, long n)
@@ -99,13 +500,12 @@ void qte_eigencalc_dim(t_qte_eigencalc *x, long n)
     }
     if (x->n == n)
         return;
-
-    x->n = n;
-    if (x->matrix) {
-        free(x->matrix);
-        x->matrix = NULL;
-    }
-    object_post((t_object *)x, "Dimension set to %ld", n);
+    // The stored matrix of the old dimension is dropped.
+    int i;
+    if (!qte_eigencalc_claim(x, &i))
+        return;
+    qte_eigencalc_resize(x, n);
+    qte_eigencalc_publish(x, i, QTE_EIGENCALC_NONE);
 }
 
 /* ----------------------------------------------------------------------------
@@ -113,12 +513,14 @@ void qte_eigencalc_dim(t_qte_eigencalc *x, long n)
 ---------------------------------------------------------------------------- */
 void qte_eigencalc_assist(t_qte_eigencalc *x, void *b, long m, long a, char *s) {
     if (m == 1)
-        sprintf(s, "Input: list of %ld floats (2*n*n, row-major complex matrix), then bang", 2 * x->n * x->n);
+        sprintf(s, "Input: list of %ld floats (2*n*n, row-major complex matrix), jit_matrix (2-plane float64), band, sparse or packed, then bang; write / read snapshot files", 2 * x->n * x->n);
     else {
         if (a == 0)
             sprintf(s, "Left outlet: %ld eigenvalues (real)", x->n);
+        else if (a == 2)
+            sprintf(s, "Status outlet: busy / done / cancelled (@async 1), track, cache_stats, stats");
         else
-            sprintf(s, "Right outlet: %ld eigenvectors (column-major, each as (real, imag) pair)", x->n * x->n);
+            sprintf(s, "Middle outlet: %ld eigenvectors (column-major, each as (real, imag) pair, or jit_matrix with @format matrix)", x->n * x->n);
     }
 }
 
@@ -133,146 +535,972 @@ void qte_eigencalc_list(t_qte_eigencalc *x, t_symbol *s, long argc, t_atom *argv
         object_error((t_object *)x, "Expected %ld floats for complex matrix, got %ld", total, argc);
         return;
     }
-    if (x->matrix)
-        free(x->matrix);
-    x->matrix = (__CLPK_doublecomplex *)malloc(n * n * sizeof(__CLPK_doublecomplex));
-    if (!x->matrix) {
+    double t = qte_stats_begin(&x->stats);
+    int i;
+    t_qte_eigencalc_matrix *in = qte_eigencalc_claim(x, &i);
+    if (!in)
+        return;
+    if (qte_cmatrix_resize(&in->matrix, n, n, QTE_ROW_MAJOR)) {
         object_error((t_object *)x, "Memory allocation failed for matrix storage.");
         return;
     }
-    for (long i = 0; i < n * n; i++) {
-        double re = atom_getfloat(argv + (2 * i));
-        double im = atom_getfloat(argv + (2 * i + 1));
-        __CLPK_doublecomplex z;
-        z.r = re;
-        z.i = im;
-        x->matrix[i] = z;
-    }
+    qte_atoms_to_cmatrix(argc, argv, &in->matrix, QTE_ROW_MAJOR);
+    qte_eigencalc_publish(x, i, QTE_EIGENCALC_DENSE);
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
     object_post((t_object *)x, "Complex matrix stored (dimension %ld).", n);
 }
 
 /* ----------------------------------------------------------------------------
-   qte_eigencalc_bang – performs the eigen-decomposition using LAPACK
+   qte_eigencalc_jit_matrix – stores the input complex matrix from a named
+   2-plane float64 jit.matrix, reading its rows in place (no atom parsing).
+   A square matrix of a different size switches the object's dimension; one
+   that cannot be read leaves the dimension and the stored matrix as they were.
 ---------------------------------------------------------------------------- */
-void qte_eigencalc_bang(t_qte_eigencalc *x) {
-    if (!x->matrix) {
-        object_error((t_object *)x, "No matrix stored. Use a list message first.");
+void qte_eigencalc_jit_matrix(t_qte_eigencalc *x, t_symbol *s) {
+    double t = qte_stats_begin(&x->stats);
+    long rows, cols;
+    if (qte_jit_matrix_dims(s, &rows, &cols) || rows != cols) {
+        object_error((t_object *)x, "Expected a square 2-plane float64 jit.matrix");
         return;
     }
-    long n = x->n;
-    __CLPK_integer N = (__CLPK_integer)n;
-    __CLPK_integer total = N * N;
+    int i;
+    t_qte_eigencalc_matrix *in = qte_eigencalc_claim(x, &i);
+    if (!in)
+        return;
     
-    // Convert the stored row-major matrix to column-major order (for LAPACK).
-    __CLPK_doublecomplex *A = (__CLPK_doublecomplex *)malloc(total * sizeof(__CLPK_doublecomplex));
-    if (!A) {
-        object_error((t_object *)x, "Memory allocation failed for LAPACK matrix.");
+    // Each matrix row is n interleaved (real, imag) cells, the same layout as a
+    // row of the stored row-major matrix, so rows copy straight across.
+    in->matrix.layout = QTE_ROW_MAJOR;
+    if (qte_jit_matrix_read(s, &in->matrix)) {
+        object_error((t_object *)x, "Could not read jit.matrix %s", s->s_name);
         return;
     }
-    for (long i = 0; i < n; i++) {
-        for (long j = 0; j < n; j++) {
-            // Row-major index: i*n + j, column-major index: j*n + i.
-            A[j*n + i] = x->matrix[i*n + j];
+    if (rows != x->n)
+        qte_eigencalc_resize(x, rows);
+    qte_eigencalc_publish(x, i, QTE_EIGENCALC_DENSE);
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+}
+
+/* ----------------------------------------------------------------------------
+   qte_eigencalc_band – stores a Hermitian band matrix with kd superdiagonals,
+   given diagonal by diagonal (main diagonal first) as a list of (real, imag)
+   pairs or as the rows of a jit.matrix, in LAPACK upper band storage.
+---------------------------------------------------------------------------- */
+void qte_eigencalc_band(t_qte_eigencalc *x, t_symbol *s, long argc, t_atom *argv) {
+    if (argc < 2 || atom_gettype(argv) != A_LONG || atom_getlong(argv) < 0) {
+        object_error((t_object *)x, "Expected band kd followed by the diagonals or a jit.matrix name");
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    long kd = atom_getlong(argv);
+    long n;
+    t_qte_cmatrix D;                // row d = diagonal d (row-major, (kd + 1) x n)
+    qte_cmatrix_init(&D);
+    D.layout = QTE_ROW_MAJOR;
+    if (atom_gettype(argv + 1) == A_SYM) {
+        t_symbol *name = atom_getsym(argv + 1);
+        long rows;
+        if (qte_jit_matrix_dims(name, &rows, &n) || rows != kd + 1 || qte_jit_matrix_read(name, &D)) {
+            object_error((t_object *)x, "Expected a 2-plane float64 jit.matrix with %ld rows", kd + 1);
+            qte_cmatrix_free(&D);
+            return;
+        }
+    } else {
+        // 2 * sum over d of (n - d) floats.
+        long pairs = (argc - 1) / 2;
+        n = (pairs + kd * (kd + 1) / 2) / (kd + 1);
+        if ((argc - 1) % 2 || n <= kd || (kd + 1) * n - kd * (kd + 1) / 2 != pairs) {
+            object_error((t_object *)x, "Expected 2 * ((kd + 1) * n - kd * (kd + 1) / 2) floats after band %ld", kd);
+            return;
+        }
+        if (qte_cmatrix_resize(&D, kd + 1, n, QTE_ROW_MAJOR)) {
+            object_error((t_object *)x, "Memory allocation failed for band storage.");
+            return;
+        }
+        const t_atom *ap = argv + 1;
+        for (long d = 0; d <= kd; d++) {
+            for (long k = 0; k < n; k++) {
+                if (k < n - d) {
+                    D.data[d * n + k] = atom_getfloat(ap) + I * atom_getfloat(ap + 1);
+                    ap += 2;
+                } else {
+                    D.data[d * n + k] = 0.0;
+                }
+            }
         }
     }
-    
-    // Allocate eigenvalue array
-    __CLPK_doublereal *w = (__CLPK_doublereal *)malloc(n * sizeof(__CLPK_doublereal));
-    if (!w) {
-        object_error((t_object *)x, "Memory allocation failed for eigenvalues.");
-        free(A);
+    if (n <= kd) {
+        object_error((t_object *)x, "band needs more than kd = %ld columns", kd);
+        qte_cmatrix_free(&D);
+        return;
+    }
+    int i;
+    t_qte_eigencalc_matrix *in = qte_eigencalc_claim(x, &i);
+    if (!in) {
+        qte_cmatrix_free(&D);
         return;
     }
     
-    // Set up parameters for zheev_ (using original LAPACK naming with underscore)
-    char jobz = 'V'; // compute eigenvectors
-    char uplo = 'U'; // matrix is stored in the upper triangle
-    __CLPK_integer LDA = N, info;
+    // AB(kd + i - j, j) = H(i, j): entry k of diagonal d goes to row kd - d, column k + d.
+    if (qte_cmatrix_resize(&in->band, kd + 1, n, QTE_COL_MAJOR)) {
+        object_error((t_object *)x, "Memory allocation failed for band storage.");
+        qte_cmatrix_free(&D);
+        return;
+    }
+    qte_cmatrix_zero(&in->band);
+    for (long d = 0; d <= kd; d++) {
+        for (long k = 0; k + d < n; k++) {
+            double complex z = D.data[d * n + k];
+            in->band.data[(k + d) * in->band.ld + kd - d] = d ? z : creal(z);
+        }
+    }
+    qte_cmatrix_free(&D);
+    in->kd = kd;
+    if (n != x->n)
+        qte_eigencalc_resize(x, n);
+    qte_eigencalc_publish(x, i, QTE_EIGENCALC_BAND);
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+    object_post((t_object *)x, "Band matrix stored (dimension %ld, %ld superdiagonals).", n, kd);
+}
+
+/* ----------------------------------------------------------------------------
+   qte_eigencalc_sparse – stores a sparse Hermitian matrix from (i, j, re, im)
+   entries, as a list or as the rows of a jit.matrix.
+---------------------------------------------------------------------------- */
+void qte_eigencalc_sparse(t_qte_eigencalc *x, t_symbol *s, long argc, t_atom *argv) {
+    double t = qte_stats_begin(&x->stats);
+    long n = x->n, count;
+    t_qte_cmatrix E;                // entries as rows: ((i, j), (re, im))
+    qte_cmatrix_init(&E);
+    E.layout = QTE_ROW_MAJOR;
+    if (argc == 1 && atom_gettype(argv) == A_SYM) {
+        t_symbol *name = atom_getsym(argv);
+        long cols;
+        if (qte_jit_matrix_dims(name, &count, &cols) || cols != 2 || qte_jit_matrix_read(name, &E)) {
+            object_error((t_object *)x, "Expected a 2-plane float64 jit.matrix with 2 columns");
+            qte_cmatrix_free(&E);
+            return;
+        }
+    } else {
+        if (argc == 0 || argc % 4) {
+            object_error((t_object *)x, "Expected sparse i j re im ... (4 values per entry), got %ld", argc);
+            return;
+        }
+        count = argc / 4;
+        if (qte_cmatrix_resize(&E, count, 2, QTE_ROW_MAJOR)) {
+            object_error((t_object *)x, "Memory allocation failed for sparse entries.");
+            return;
+        }
+        for (long k = 0; k < count; k++) {
+            const t_atom *ap = argv + 4 * k;
+            E.data[2 * k] = atom_getfloat(ap) + I * atom_getfloat(ap + 1);
+            E.data[2 * k + 1] = atom_getfloat(ap + 2) + I * atom_getfloat(ap + 3);
+        }
+    }
     
-    // Workspace query to determine optimal lwork size
-    __CLPK_integer lwork = -1;
-    __CLPK_doublecomplex work_query;
-    __CLPK_integer rwork_dim = 3*N - 2;
-    __CLPK_doublereal *rwork = (__CLPK_doublereal *)malloc(rwork_dim * sizeof(__CLPK_doublereal));
-    if (!rwork) {
-        object_error((t_object *)x, "Memory allocation failed for rwork.");
-        free(A); free(w);
+    long *ij = (long *)malloc(2 * count * sizeof(long) + 1);
+    double complex *z = (double complex *)malloc(count * sizeof(double complex) + 1);
+    int err = !ij || !z;
+    for (long k = 0; !err && k < count; k++) {
+        ij[k] = lround(creal(E.data[2 * k]));
+        ij[count + k] = lround(cimag(E.data[2 * k]));
+        z[k] = E.data[2 * k + 1];
+        if (ij[k] < 0 || ij[k] >= n || ij[count + k] < 0 || ij[count + k] >= n) {
+            object_error((t_object *)x, "sparse entry (%ld, %ld) outside the %ld x %ld matrix",
+                         ij[k], ij[count + k], n, n);
+            err = 1;
+        }
+    }
+    int i;
+    t_qte_eigencalc_matrix *in = err ? NULL : qte_eigencalc_claim(x, &i);
+    if (in && qte_csr_from_triplets(&in->sparse, n, count, ij, ij + count, z)) {
+        object_error((t_object *)x, "Memory allocation failed for sparse storage.");
+        in = NULL;
+    }
+    free(ij);
+    free(z);
+    qte_cmatrix_free(&E);
+    if (!in)
+        return;
+    qte_eigencalc_publish(x, i, QTE_EIGENCALC_SPARSE);
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+    object_post((t_object *)x, "Sparse matrix stored (dimension %ld, %ld nonzeros).", n, in->sparse.nnz);
+}
+
+/* ----------------------------------------------------------------------------
+   qte_eigencalc_packed – stores a Hermitian matrix given as its upper triangle
+   in LAPACK packed storage, n(n+1) floats ((real, imag) per entry); the
+   dimension follows from the length.
+---------------------------------------------------------------------------- */
+void qte_eigencalc_packed(t_qte_eigencalc *x, t_symbol *s, long argc, t_atom *argv) {
+    long n = (argc % 2) ? -1 : qte_packed_dim(argc / 2);
+    if (n < 1) {
+        object_error((t_object *)x, "Expected n(n+1) floats for a packed matrix, got %ld", argc);
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    int i;
+    t_qte_eigencalc_matrix *in = qte_eigencalc_claim(x, &i);
+    if (!in)
+        return;
+    if (qte_cvector_resize(&in->packed, argc / 2)) {
+        object_error((t_object *)x, "Memory allocation failed for packed storage.");
         return;
     }
+    qte_atoms_to_cvector(argc, argv, &in->packed);
+    if (n != x->n)
+        qte_eigencalc_resize(x, n);
+    qte_eigencalc_publish(x, i, QTE_EIGENCALC_PACKED);
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+}
+
+/* ----------------------------------------------------------------------------
+   Decomposition jobs – a job snapshots the matrix (already column-major for
+   LAPACK) together with every setting that affects the solve, so it can run
+   on the worker thread while the object keeps accepting new input.
+---------------------------------------------------------------------------- */
+/* Fills p from the object's settings. Only the fields the selected range uses
+   are set (the rest stay zero), so p can also be hashed as part of a cache key. */
+static int qte_eigencalc_params(t_qte_eigencalc *x, t_qte_eigh_params *p) {
+    long n = x->n;
+    memset(p, 0, sizeof(*p));
     
-    // Use the function with trailing underscore - this is the actual function name in Apple's implementation
-    #pragma clang diagnostic push
-    #pragma clang diagnostic ignored "-Wdeprecated-declarations"
-    zheev_(&jobz, &uplo, &N, A, &LDA, w, &work_query, &lwork, rwork, &info);
-    #pragma clang diagnostic pop
+    // Subset selection is only offered by zheevr.
+    p->range = 'A';
+    if (x->range == gensym("index")) {
+        if (x->index[0] < 0 || x->index[1] < x->index[0] || x->index[1] >= n) {
+            object_error((t_object *)x, "index range must satisfy 0 <= lo <= hi < %ld", n);
+            return -1;
+        }
+        p->range = 'I';
+        p->il = x->index[0] + 1;
+        p->iu = x->index[1] + 1;
+    } else if (x->range == gensym("value")) {
+        if (x->values[1] <= x->values[0]) {
+            object_error((t_object *)x, "value range must satisfy lo < hi");
+            return -1;
+        }
+        p->range = 'V';
+        p->vl = x->values[0];
+        p->vu = x->values[1];
+    }
+    if (p->range != 'A' || x->driver == gensym("zheevr"))
+        p->driver = QTE_ZHEEVR;
+    else if (x->driver == gensym("zheevd"))
+        p->driver = QTE_ZHEEVD;
+    else
+        p->driver = QTE_ZHEEV;
+    p->vectors = x->vectors ? 1 : 0;
+    return 0;
+}
+
+/* Tracking needs the whole spectrum with eigenvectors of a dense (or packed) matrix. */
+static int qte_eigencalc_tracks(t_qte_eigencalc *x, const t_qte_eigencalc_matrix *in,
+                                const t_qte_eigh_params *p) {
+    return x->track && (in->input == QTE_EIGENCALC_DENSE || in->input == QTE_EIGENCALC_PACKED) &&
+           p->range == 'A' && p->vectors;
+}
+
+/* Takes x->spare, whose storage (w, A, Z, Vprev, tracker) is reused as far as
+   it fits, or allocates a fresh job, and copies the pinned version in into it. */
+static t_qte_eigencalc_job *qte_eigencalc_job_new(t_qte_eigencalc *x, const t_qte_eigencalc_matrix *in,
+                                                  const t_qte_eigh_params *p) {
+    long n = in->n;
+    t_qte_eigencalc_job *job = x->spare;
+    x->spare = NULL;
+    if (!job) {
+        job = (t_qte_eigencalc_job *)calloc(1, sizeof(t_qte_eigencalc_job));
+        if (!job) {
+            object_error((t_object *)x, "Memory allocation failed for decomposition job.");
+            return NULL;
+        }
+        qte_eigh_tracker_init(&job->tracker);
+        qte_eigh_split_init(&job->split);
+    }
+    job->n = n;
+    job->params = *p;
+    job->m = n;
+    job->kd = 0;
+    job->krylov = 0;
+    job->generation = 0;
+    job->seconds = 0.0;
+    job->tracktol = x->tracktol;
+    job->tracked = -1;
+    job->key = 0;
+    job->bytes = 0;
+    job->prev = job->next = NULL;
+    job->blocks = x->blocks ? 1 : 0;
+    job->parity = x->parity ? 1 : 0;
+    job->threads = qte_threads(x->threads);
+    job->split_count = 1;
+    job->split_parity = 0;
     
-    if (info != 0) {
-        object_error((t_object *)x, "zheev_ workspace query error: info=%d", info);
-        free(A); free(w); free(rwork);
+    job->track = qte_eigencalc_tracks(x, in, p);
+    qte_cmatrix_reshape(&job->Vprev, 0, 0, QTE_COL_MAJOR);
+    if (job->track && x->track_V.rows == n &&
+        qte_cmatrix_copy(&job->Vprev, &x->track_V, QTE_COL_MAJOR)) {
+        object_error((t_object *)x, "Memory allocation failed for tracking state.");
+        qte_eigencalc_job_free(job);
+        return NULL;
+    }
+    
+    if (job->w_size < n) {
+        free(job->w);
+        job->w_size = 0;
+        if ((job->w = (double *)malloc(n * sizeof(double))))
+            job->w_size = n;
+    }
+    job->input = in->input;
+    job->A.layout = QTE_COL_MAJOR;
+    int err;
+    if (!job->w) {
+        err = 1;
+    } else if (in->input == QTE_EIGENCALC_BAND) {
+        job->kd = in->kd;
+        err = qte_cmatrix_copy(&job->A, &in->band, QTE_COL_MAJOR);
+    } else if (in->input == QTE_EIGENCALC_SPARSE && p->range == 'I') {
+        job->krylov = x->krylov;
+        err = qte_csr_copy(&job->S, &in->sparse);
+    } else if (in->input == QTE_EIGENCALC_SPARSE) {
+        // Lanczos finds the lowest eigenpairs; other ranges decompose densely.
+        job->input = QTE_EIGENCALC_DENSE;
+        err = qte_csr_to_dense(&in->sparse, &job->A);
+    } else if (in->input == QTE_EIGENCALC_PACKED && job->track) {
+        // Tracking works on the full matrix.
+        job->input = QTE_EIGENCALC_DENSE;
+        err = qte_packed_to_cmatrix(&in->packed, &job->A);
+    } else if (in->input == QTE_EIGENCALC_PACKED) {
+        err = qte_cvector_resize(&job->AP, in->packed.n);
+        if (!err)
+            memcpy(job->AP.data, in->packed.data, in->packed.n * sizeof(double complex));
+    } else {
+        // Convert the stored row-major matrix to column-major order (for LAPACK).
+        err = qte_cmatrix_copy(&job->A, &in->matrix, QTE_COL_MAJOR);
+    }
+    if (err) {
+        object_error((t_object *)x, "Memory allocation failed for LAPACK matrix.");
+        qte_eigencalc_job_free(job);
+        return NULL;
+    }
+    return job;
+}
+
+static void qte_eigencalc_job_free(t_qte_eigencalc_job *job) {
+    if (!job)
+        return;
+    qte_cmatrix_free(&job->Z);
+    qte_cmatrix_free(&job->A);
+    qte_cvector_free(&job->AP);
+    qte_csr_free(&job->S);
+    qte_cmatrix_free(&job->Vprev);
+    qte_eigh_tracker_free(&job->tracker);
+    qte_eigh_split_free(&job->split);
+    free(job->w);
+    free(job);
+}
+
+/* Keeps a job that is done with (main thread) as x->spare for the next bang. */
+static void qte_eigencalc_job_recycle(t_qte_eigencalc *x, t_qte_eigencalc_job *job) {
+    qte_eigencalc_job_free(x->spare);
+    x->spare = job;
+}
+
+/* The LAPACK workspace goes to one solve at a time; a synchronous bang made
+   while the worker holds it solves with a one-off workspace (NULL). */
+static t_qte_eigh_work *qte_eigencalc_work_take(t_qte_eigencalc *x) {
+    t_qte_eigh_work *ws = NULL;
+    systhread_mutex_lock(x->mutex);
+    if (!x->ws_busy) {
+        x->ws_busy = 1;
+        ws = &x->ws;
+    }
+    systhread_mutex_unlock(x->mutex);
+    return ws;
+}
+
+static void qte_eigencalc_work_give(t_qte_eigencalc *x, t_qte_eigh_work *ws) {
+    if (!ws)
         return;
+    systhread_mutex_lock(x->mutex);
+    x->ws_busy = 0;
+    systhread_mutex_unlock(x->mutex);
+}
+
+/* qte_eigh, or with @blocks 1 qte_eigh_blocks, which decomposes the blocks
+   the matrix splits into separately. */
+static int qte_eigencalc_eigh(t_qte_eigencalc_job *job, t_qte_eigh_work *ws, int *info) {
+    if (!job->blocks)
+        return qte_eigh(&job->params, &job->A, job->w, &job->Z, &job->m, ws, info);
+    int err = qte_eigh_blocks(&job->params, &job->split, &job->A, job->parity, QTE_EIGENCALC_BLOCK_TOL,
+                              job->threads, job->w, &job->Z, &job->m, ws, info);
+    job->split_count = job->split.count;
+    job->split_parity = job->split.parity;
+    return err;
+}
+
+/* ----------------------------------------------------------------------------
+   qte_eigencalc_job_run – runs the job's LAPACK driver (qte_eigh) and reports
+   errors. A tracking job first refines the previous eigenvectors and only
+   decomposes when that does not converge; band, packed and sparse jobs use
+   zhbevd, zhpevd and Lanczos; a packed matrix that splits into blocks (or
+   with @parity 1) is unpacked and decomposed block by block instead. Safe to call from any thread: only the job and
+   the workspace taken for it are written.
+---------------------------------------------------------------------------- */
+static int qte_eigencalc_job_solve(t_qte_eigencalc *x, t_qte_eigencalc_job *job, t_qte_eigh_work *ws) {
+    static const char *names[] = { "zheev", "zheevd", "zheevr" };
+    int info = 0, err;
+    if (job->input == QTE_EIGENCALC_BAND) {
+        err = qte_eigh_band(&job->params, job->kd, &job->A, job->w, &job->Z, ws, &info);
+        if (!err) {
+            job->m = job->n;
+            qte_eigh_select(&job->params, job->w, &job->Z, &job->m);
+        } else if (err == QTE_ERR_ALLOC) {
+            object_error((t_object *)x, "Memory allocation failed for zhbevd.");
+        } else {
+            object_error((t_object *)x, "Band eigen-decomposition (zhbevd) failed: info=%d", info);
+        }
+        return err ? -1 : 0;
+    }
+    if (job->input == QTE_EIGENCALC_PACKED && job->blocks &&
+        (job->parity || qte_packed_blocks(&job->split, &job->AP, QTE_EIGENCALC_BLOCK_TOL) > 1)) {
+        if (qte_packed_to_cmatrix(&job->AP, &job->A)) {
+            object_error((t_object *)x, "Memory allocation failed for LAPACK matrix.");
+            return -1;
+        }
+        job->input = QTE_EIGENCALC_DENSE;
+    }
+    if (job->input == QTE_EIGENCALC_PACKED) {
+        err = qte_eigh_packed(&job->params, &job->AP, job->w, &job->Z, ws, &info);
+        if (!err) {
+            job->m = job->n;
+            qte_eigh_select(&job->params, job->w, &job->Z, &job->m);
+        } else if (err == QTE_ERR_ALLOC) {
+            object_error((t_object *)x, "Memory allocation failed for zhpevd.");
+        } else {
+            object_error((t_object *)x, "Packed eigen-decomposition (zhpevd) failed: info=%d", info);
+        }
+        return err ? -1 : 0;
+    }
+    if (job->input == QTE_EIGENCALC_SPARSE) {
+        long steps = 0;
+        job->m = job->params.iu;
+        err = qte_lanczos(&job->S, job->m, job->krylov, QTE_EIGENCALC_LANCZOS_TOL,
+                          job->params.vectors, job->w, &job->Z, &steps, &info);
+        if (err == QTE_ERR_CONVERGE) {
+            object_warn((t_object *)x, "Lanczos not converged after %ld steps; try a larger @krylov.", steps);
+            err = 0;
+        } else if (err == QTE_ERR_DEFLATE) {
+            object_warn((t_object *)x, "Lanczos eigenpairs converged, but the search for missed copies of degenerate eigenvalues stopped after %ld steps.", steps);
+            err = 0;
+        }
+        if (!err)
+            qte_eigh_select(&job->params, job->w, &job->Z, &job->m);
+        else if (err == QTE_ERR_ALLOC)
+            object_error((t_object *)x, "Memory allocation failed for the Lanczos basis.");
+        else
+            object_error((t_object *)x, "Lanczos Ritz values (dsyev) failed: info=%d", info);
+        return err ? -1 : 0;
+    }
+    if (job->track && job->Vprev.rows) {
+        int iters = 0;
+        err = qte_cmatrix_copy(&job->Z, &job->Vprev, QTE_COL_MAJOR);
+        if (!err)
+            err = qte_eigh_track(&job->tracker, &job->A, job->w, &job->Z, job->tracktol,
+                                 QTE_EIGENCALC_TRACK_ITER, &iters);
+        if (!err) {
+            job->tracked = iters;
+            job->m = job->n;
+            return 0;
+        }
+        if (err == QTE_ERR_ALLOC) {
+            object_error((t_object *)x, "Memory allocation failed for eigenpair tracking.");
+            return -1;
+        }
     }
-    lwork = (__CLPK_integer)(work_query.r) + 1;
-    if (lwork < 1) {
-        lwork = 1;
+    err = qte_eigencalc_eigh(job, ws, &info);
+    if (!err && job->track && job->Vprev.rows)
+        err = qte_eigh_align(&job->tracker, &job->Vprev, job->w, &job->Z);
+    if (err == QTE_ERR_ALLOC)
+        object_error((t_object *)x, "Memory allocation failed for LAPACK workspace.");
+    else if (err == QTE_ERR_QUERY)
+        object_error((t_object *)x, "%s_ workspace query error: info=%d", names[job->params.driver], info);
+    else if (err == QTE_ERR_SOLVE)
+        object_error((t_object *)x, "Eigen-decomposition failed: info=%d", info);
+    return err ? -1 : 0;
+}
+
+static int qte_eigencalc_job_run(t_qte_eigencalc *x, t_qte_eigencalc_job *job) {
+    t_qte_eigh_work *ws = qte_eigencalc_work_take(x);
+    int err = qte_eigencalc_job_solve(x, job, ws);
+    qte_eigencalc_work_give(x, ws);
+    return err;
+}
+
+/* Sends a finished job's eigenpairs out of the outlets (main or scheduler thread).
+   Both lists are built in x->out_list (eigenvalues, then eigenvectors) before the
+   first outlet call, so the output time started at t does not include the objects
+   downstream. */
+static void qte_eigencalc_job_output(t_qte_eigencalc *x, t_qte_eigencalc_job *job, double t) {
+    long n = job->n;
+    long m = job->m;
+    if (m == 0) {
+        object_warn((t_object *)x, "No eigenvalues in the requested range.");
+        return;
     }
-    __CLPK_doublecomplex *work = (__CLPK_doublecomplex *)malloc(lwork * sizeof(__CLPK_doublecomplex));
-    if (!work) {
-        object_error((t_object *)x, "Memory allocation failed for work.");
-        free(A); free(w); free(rwork);
+    
+    // The m eigenvalues for the left outlet.
+    int matrix = job->params.vectors && x->format == gensym("matrix");
+    int list = job->params.vectors && !matrix;
+    if (qte_atoms_reserve(&x->out_list, &x->out_list_size, list ? m + 2 * n * m : m, &x->stats)) {
+        object_error((t_object *)x, "Memory allocation failed for output list.");
         return;
     }
+    t_atom *eigvals_list = x->out_list;
+    for (long i = 0; i < m; i++) {
+        atom_setfloat(eigvals_list + i, job->w[i]);
+    }
+    x->stats.atoms += m;
     
-    // Actual eigen-decomposition call using the LAPACK function with underscore
-    #pragma clang diagnostic push
-    #pragma clang diagnostic ignored "-Wdeprecated-declarations"
-    zheev_(&jobz, &uplo, &N, A, &LDA, w, work, &lwork, rwork, &info);
-    #pragma clang diagnostic pop
+    // Eigenvectors preserving column-major format from LAPACK, one eigenvector
+    // (column of Z) after the other, or written to the output jit.matrix.
+    t_atom *eigvecs_list = x->out_list + m;
+    int ready = 0;                  // eigenvectors to send
+    if (matrix) {
+        if (!x->outmatrix) {
+            object_error((t_object *)x, "No output jit.matrix available.");
+        } else if (qte_jit_matrix_write(x->outmatrix, &job->Z)) {
+            object_error((t_object *)x, "Output jit.matrix has no data.");
+        } else {
+            x->stats.atoms += 1;
+            ready = 1;
+        }
+    } else if (list) {
+        qte_atoms_from_cmatrix(eigvecs_list, &job->Z, QTE_COL_MAJOR);
+        x->stats.atoms += 2 * n * m;
+        ready = 1;
+    }
+    if (job->track) {
+        // The next tracking bang starts from these eigenvectors.
+        if (qte_cmatrix_copy(&x->track_V, &job->Z, QTE_COL_MAJOR))
+            qte_cmatrix_free(&x->track_V);
+    }
+    qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t);
     
-    free(work);
-    free(rwork);
-    if (info != 0) {
-        object_error((t_object *)x, "Eigen-decomposition failed: info=%d", info);
-        free(A); free(w);
+    outlet_list(x->out_eigenvalues, gensym("list"), m, eigvals_list);
+    
+    if (job->split_count > 1 || job->split_parity) {
+        t_atom a[2];
+        atom_setlong(a, job->split_count);
+        atom_setlong(a + 1, job->split_parity);
+        outlet_anything(x->out_status, gensym("blocks"), 2, a);
+    }
+    if (job->track) {
+        t_atom a[2];
+        if (job->tracked >= 0) {
+            atom_setsym(a, gensym("converged"));
+            atom_setlong(a + 1, job->tracked);
+            outlet_anything(x->out_status, gensym("track"), 2, a);
+        } else {
+            atom_setsym(a, gensym("solved"));
+            outlet_anything(x->out_status, gensym("track"), 1, a);
+        }
+    }
+    
+    if (!ready)
         return;
+    if (matrix) {
+        t_atom a;
+        atom_setsym(&a, x->outmatrix_name);
+        outlet_anything(x->out_eigenvectors, _jit_sym_jit_matrix, 1, &a);
+    } else {
+        outlet_list(x->out_eigenvectors, gensym("list"), 2 * n * m, eigvecs_list);
+    }
+    object_post((t_object *)x, "Eigen-decomposition completed successfully.");
+}
+
+/* ----------------------------------------------------------------------------
+   Background decomposition (@async 1)
+   One worker thread at a time drains x->pending. A job whose generation is no
+   longer current when it finishes (a newer bang or a cancel arrived) is
+   dropped; otherwise it is handed to the qelem, which outputs on the main thread.
+---------------------------------------------------------------------------- */
+static void *qte_eigencalc_worker(t_qte_eigencalc *x) {
+    while (1) {
+        systhread_mutex_lock(x->mutex);
+        t_qte_eigencalc_job *job = x->pending;
+        x->pending = NULL;
+        if (!job) {
+            x->busy = 0;
+            systhread_mutex_unlock(x->mutex);
+            break;
+        }
+        systhread_mutex_unlock(x->mutex);
+        
+        double t0 = qte_time_now();
+        int err = qte_eigencalc_job_run(x, job);
+        job->seconds = qte_time_now() - t0;
+        
+        systhread_mutex_lock(x->mutex);
+        if (!err && job->generation == x->generation) {
+            qte_eigencalc_job_free(x->finished);
+            x->finished = job;
+            job = NULL;
+            qelem_set(x->qelem);
+        }
+        systhread_mutex_unlock(x->mutex);
+        qte_eigencalc_job_free(job);
+    }
+    systhread_exit(0);
+    return NULL;
+}
+
+static void qte_eigencalc_qfn(t_qte_eigencalc *x) {
+    systhread_mutex_lock(x->mutex);
+    t_qte_eigencalc_job *job = x->finished;
+    x->finished = NULL;
+    systhread_mutex_unlock(x->mutex);
+    if (!job)
+        return;
+    qte_latency_add(&x->stats.stage[QTE_STAGE_COMPUTE], job->seconds);
+    qte_eigencalc_job_output(x, job, qte_stats_begin(&x->stats));
+    qte_eigencalc_cache_insert(x, job);
+    outlet_anything(x->out_status, gensym("done"), 0, NULL);
+}
+
+static void qte_eigencalc_submit(t_qte_eigencalc *x, t_qte_eigencalc_job *job) {
+    int spawn = 0;
+    systhread_mutex_lock(x->mutex);
+    // The newest request replaces any request that has not started yet.
+    qte_eigencalc_job_free(x->pending);
+    x->pending = job;
+    job->generation = ++x->generation;
+    if (!x->busy) {
+        x->busy = 1;
+        spawn = 1;
     }
+    systhread_mutex_unlock(x->mutex);
     
-    // Output eigenvalues to left outlet.
-    t_atom *eigvals_list = (t_atom *)sysmem_newptr(n * sizeof(t_atom));
-    if (!eigvals_list) {
-        object_error((t_object *)x, "Memory allocation failed for eigenvalue output list.");
-        free(A);
-        free(w);
+    outlet_anything(x->out_status, gensym("busy"), 0, NULL);
+    if (spawn) {
+        // The previous worker has already left its loop; reap it before starting anew.
+        if (x->worker) {
+            unsigned int ret;
+            systhread_join(x->worker, &ret);
+            x->worker = NULL;
+        }
+        systhread_create((method)qte_eigencalc_worker, x, 0, 0, 0, &x->worker);
+    }
+}
+
+/* cancel – drops the queued request and discards the result of the running one. */
+void qte_eigencalc_cancel(t_qte_eigencalc *x) {
+    systhread_mutex_lock(x->mutex);
+    long busy = x->busy || x->finished;
+    qte_eigencalc_job_free(x->pending);
+    x->pending = NULL;
+    qte_eigencalc_job_free(x->finished);
+    x->finished = NULL;
+    x->generation++;
+    systhread_mutex_unlock(x->mutex);
+    qelem_unset(x->qelem);
+    if (busy)
+        outlet_anything(x->out_status, gensym("cancelled"), 0, NULL);
+}
+
+/* ----------------------------------------------------------------------------
+   Result cache – finished jobs (input matrix released) in a doubly linked list,
+   most recently used first, evicted from the tail once the entries together
+   hold more than @cachesize MB. Only the main thread touches it: entries are
+   inserted by the synchronous bang and by the qelem.
+---------------------------------------------------------------------------- */
+static uint64_t qte_eigencalc_key(t_qte_eigencalc *x, const t_qte_eigencalc_matrix *in,
+                                  const t_qte_eigh_params *p) {
+    uint64_t seed = qte_hash64(p, sizeof(*p), (uint64_t)in->n);
+    seed = qte_hash64(&in->input, sizeof(in->input), seed);
+    long split[2] = { x->blocks ? 1 : 0, x->parity ? 1 : 0 };
+    seed = qte_hash64(split, sizeof(split), seed);
+    if (in->input == QTE_EIGENCALC_BAND) {
+        seed = qte_hash64(&in->kd, sizeof(in->kd), seed);
+        return qte_hash64(in->band.data, in->band.rows * in->band.cols * sizeof(double complex), seed);
+    }
+    if (in->input == QTE_EIGENCALC_SPARSE) {
+        const t_qte_csr *S = &in->sparse;
+        seed = qte_hash64(&x->krylov, sizeof(x->krylov), seed);
+        seed = qte_hash64(S->rowptr, (S->n + 1) * sizeof(long), seed);
+        seed = qte_hash64(S->col, S->nnz * sizeof(long), seed);
+        return qte_hash64(S->val, S->nnz * sizeof(double complex), seed);
+    }
+    if (in->input == QTE_EIGENCALC_PACKED)
+        return qte_hash64(in->packed.data, in->packed.n * sizeof(double complex), seed);
+    return qte_hash64(in->matrix.data, in->n * in->n * sizeof(double complex), seed);
+}
+
+static void qte_eigencalc_cache_unlink(t_qte_eigencalc *x, t_qte_eigencalc_job *e) {
+    if (e->prev)
+        e->prev->next = e->next;
+    else
+        x->cache_head = e->next;
+    if (e->next)
+        e->next->prev = e->prev;
+    else
+        x->cache_tail = e->prev;
+    e->prev = e->next = NULL;
+}
+
+static void qte_eigencalc_cache_push(t_qte_eigencalc *x, t_qte_eigencalc_job *e) {
+    e->prev = NULL;
+    e->next = x->cache_head;
+    if (x->cache_head)
+        x->cache_head->prev = e;
+    else
+        x->cache_tail = e;
+    x->cache_head = e;
+}
+
+/* Evicts least recently used entries until bytes more would fit. */
+static void qte_eigencalc_cache_trim(t_qte_eigencalc *x, size_t bytes) {
+    size_t capacity = (size_t)(x->cachesize * 1048576.0);
+    while (x->cache_tail && x->cache_bytes + bytes > capacity) {
+        t_qte_eigencalc_job *e = x->cache_tail;
+        qte_eigencalc_cache_unlink(x, e);
+        x->cache_bytes -= e->bytes;
+        x->cache_entries--;
+        qte_eigencalc_job_free(e);
+    }
+}
+
+/* Returns the entry for key (moved to the front) or NULL. */
+static t_qte_eigencalc_job *qte_eigencalc_cache_find(t_qte_eigencalc *x, uint64_t key, long n) {
+    for (t_qte_eigencalc_job *e = x->cache_head; e; e = e->next) {
+        if (e->key == key && e->n == n) {
+            qte_eigencalc_cache_unlink(x, e);
+            qte_eigencalc_cache_push(x, e);
+            return e;
+        }
+    }
+    return NULL;
+}
+
+/* Takes ownership of a finished job: caches it if it fits, recycles it otherwise. */
+static void qte_eigencalc_cache_insert(t_qte_eigencalc *x, t_qte_eigencalc_job *job) {
+    // A tracked result depends on the previous bangs, not only on the matrix.
+    job->bytes = sizeof(*job) + job->w_size * sizeof(double) + job->Z.capacity * sizeof(double complex);
+    if (job->track || job->bytes > (size_t)(x->cachesize * 1048576.0)) {
+        qte_eigencalc_job_recycle(x, job);
         return;
     }
-    for (long i = 0; i < n; i++) {
-        atom_setfloat(eigvals_list + i, w[i]);
+    qte_cmatrix_free(&job->A);
+    qte_cvector_free(&job->AP);
+    qte_csr_free(&job->S);
+    qte_cmatrix_free(&job->Vprev);
+    qte_eigh_tracker_free(&job->tracker);
+    qte_eigh_split_free(&job->split);
+    qte_eigencalc_cache_trim(x, job->bytes);
+    qte_eigencalc_cache_push(x, job);
+    x->cache_bytes += job->bytes;
+    x->cache_entries++;
+}
+
+void qte_eigencalc_cache_clear(t_qte_eigencalc *x) {
+    while (x->cache_head) {
+        t_qte_eigencalc_job *e = x->cache_head;
+        qte_eigencalc_cache_unlink(x, e);
+        qte_eigencalc_job_free(e);
+    }
+    x->cache_bytes = 0;
+    x->cache_entries = 0;
+}
+
+/* cache_stats – "cache_stats hits misses entries bytes" from the status outlet. */
+void qte_eigencalc_cache_stats(t_qte_eigencalc *x) {
+    t_atom a[4];
+    atom_setlong(a, x->cache_hits);
+    atom_setlong(a + 1, x->cache_misses);
+    atom_setlong(a + 2, x->cache_entries);
+    atom_setlong(a + 3, (t_atom_long)x->cache_bytes);
+    outlet_anything(x->out_status, gensym("cache_stats"), 4, a);
+}
+
+t_max_err qte_eigencalc_cachesize_set(t_qte_eigencalc *x, void *attr, long argc, t_atom *argv) {
+    if (argc && argv) {
+        double mb = atom_getfloat(argv);
+        x->cachesize = mb > 0.0 ? mb : 0.0;
+        qte_eigencalc_cache_trim(x, 0);
+    }
+    return MAX_ERR_NONE;
+}
+
+/* Drops the result of a background job still in flight. */
+static void qte_eigencalc_supersede(t_qte_eigencalc *x) {
+    systhread_mutex_lock(x->mutex);
+    x->generation++;
+    systhread_mutex_unlock(x->mutex);
+}
+
+/* Outputs the mapped snapshot through a job whose w and Z point into the mapping. */
+static void qte_eigencalc_snapshot_output(t_qte_eigencalc *x, double t) {
+    t_qte_eigencalc_job job;
+    memset(&job, 0, sizeof(job));
+    job.n = (long)x->snap.header.n;
+    job.m = (long)x->snap.header.m;
+    job.w = x->snap.w;
+    job.Z = x->snap.V;
+    job.params.vectors = x->vectors && (x->snap.header.flags & QTE_SNAPSHOT_VECTORS);
+    job.tracked = -1;
+    qte_eigencalc_job_output(x, &job, t);
+}
+
+/* ----------------------------------------------------------------------------
+   qte_eigencalc_bang – performs the eigen-decomposition using LAPACK, or
+   re-emits a cached result for the same matrix and settings.
+---------------------------------------------------------------------------- */
+void qte_eigencalc_bang(t_qte_eigencalc *x) {
+    int snapshot = x->snap.base && x->snap.header.n == x->n;
+    int i;
+    const t_qte_eigencalc_matrix *in = qte_eigencalc_acquire(x, &i);
+    if (!in) {
+        if (snapshot) {
+            qte_eigencalc_supersede(x);
+            qte_eigencalc_snapshot_output(x, qte_stats_begin(&x->stats));
+            return;
+        }
+        object_error((t_object *)x, "No matrix stored. Use a list message first.");
+        return;
     }
-    outlet_list(x->out_eigenvalues, gensym("list"), n, eigvals_list);
-    sysmem_freeptr(eigvals_list);
+    t_qte_eigh_params params;
+    if (qte_eigencalc_params(x, &params)) {
+        qte_eigencalc_release(x, i);
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
     
-    // Output eigenvectors preserving column-major format from LAPACK
-    t_atom *eigvecs_list = (t_atom *)sysmem_newptr(2 * total * sizeof(t_atom));
-    if (!eigvecs_list) {
-        object_error((t_object *)x, "Memory allocation failed for eigenvector output list.");
-        free(A);
-        free(w);
-        return;
-    }
-    for (long j = 0; j < n; j++) {  // j is column index (eigenvector index)
-        for (long i = 0; i < n; i++) {  // i is row index within the eigenvector
-            // Column-major indexing for A: element (i,j) is at index j*n + i
-            __CLPK_doublecomplex z = A[j*n + i];
-            // Keep the same column-major order in the output
-            long idx = 2 * (j*n + i);
-            atom_setfloat(eigvecs_list + idx, z.r);
-            atom_setfloat(eigvecs_list + idx + 1, z.i);
+    uint64_t key = 0;
+    if ((x->cachesize > 0.0 || snapshot) && !qte_eigencalc_tracks(x, in, &params)) {
+        key = qte_eigencalc_key(x, in, &params);
+        t_qte_eigencalc_job *hit = x->cachesize > 0.0 ? qte_eigencalc_cache_find(x, key, in->n) : NULL;
+        if (hit || (snapshot && x->snap.header.source_hash == key)) {
+            qte_eigencalc_release(x, i);
+            x->cache_hits++;
+            // Supersede any background job still in flight, as a new result would.
+            qte_eigencalc_supersede(x);
+            t = qte_stats_lap(&x->stats, QTE_STAGE_COMPUTE, t);
+            if (hit)
+                qte_eigencalc_job_output(x, hit, t);
+            else
+                qte_eigencalc_snapshot_output(x, t);
+            if (x->async)
+                outlet_anything(x->out_status, gensym("done"), 0, NULL);
+            return;
         }
+        if (x->cachesize > 0.0)
+            x->cache_misses++;
     }
-    outlet_list(x->out_eigenvectors, gensym("list"), 2 * total, eigvecs_list);
-    sysmem_freeptr(eigvecs_list);
     
-    free(A);
-    free(w);
+    // The job has a copy of the matrix: the version can go.
+    t_qte_eigencalc_job *job = qte_eigencalc_job_new(x, in, &params);
+    qte_eigencalc_release(x, i);
+    if (!job)
+        return;
+    job->key = key;
     
-    object_post((t_object *)x, "Eigen-decomposition completed successfully.");
+    if (x->async) {
+        qte_eigencalc_submit(x, job);
+        return;
+    }
+    
+    // A synchronous bang also supersedes any background job still in flight.
+    qte_eigencalc_supersede(x);
+    
+    if (qte_eigencalc_job_run(x, job) == 0) {
+        t = qte_stats_lap(&x->stats, QTE_STAGE_COMPUTE, t);
+        qte_eigencalc_job_output(x, job, t);
+        qte_eigencalc_cache_insert(x, job);
+    } else {
+        qte_eigencalc_job_recycle(x, job);
+    }
+}
+
+/* stats – latencies, bytes and atoms from the status outlet ("stats reset" clears them). */
+void qte_eigencalc_stats(t_qte_eigencalc *x, t_symbol *s, long argc, t_atom *argv) {
+    qte_stats_message((t_object *)x, &x->stats, x->out_status, argc, argv);
+}
+
+/* ----------------------------------------------------------------------------
+   Snapshots – "write <file>" saves the eigenpairs of the stored matrix with the
+   current settings, "read <file>" maps a snapshot and outputs it.
+---------------------------------------------------------------------------- */
+void qte_eigencalc_write(t_qte_eigencalc *x, t_symbol *s) {
+    char path[MAX_PATH_CHARS];
+    t_qte_eigh_params params;
+    int i;
+    const t_qte_eigencalc_matrix *in = qte_eigencalc_acquire(x, &i);
+    if (!in) {
+        object_error((t_object *)x, "No matrix stored. Use a list message first.");
+        return;
+    }
+    if (qte_eigencalc_params(x, &params) || qte_snapshot_path((t_object *)x, s, 1, path)) {
+        qte_eigencalc_release(x, i);
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    
+    uint64_t key = qte_eigencalc_key(x, in, &params);
+    t_qte_eigencalc_job *job = NULL;
+    if (x->cachesize > 0.0 && !qte_eigencalc_tracks(x, in, &params))
+        job = qte_eigencalc_cache_find(x, key, in->n);
+    // Not decomposed yet: solve here, then keep the result in the cache.
+    int cached = job != NULL;
+    if (!cached)
+        job = qte_eigencalc_job_new(x, in, &params);
+    qte_eigencalc_release(x, i);
+    if (!job)
+        return;
+    int err;
+    if (cached) {
+        err = qte_snapshot_write(path, job->n, job->m, job->w, params.vectors ? &job->Z : NULL, NULL, key);
+    } else {
+        job->key = key;
+        if (qte_eigencalc_job_run(x, job)) {
+            qte_eigencalc_job_recycle(x, job);
+            return;
+        }
+        t = qte_stats_lap(&x->stats, QTE_STAGE_COMPUTE, t);
+        err = qte_snapshot_write(path, job->n, job->m, job->w, params.vectors ? &job->Z : NULL, NULL, key);
+        qte_eigencalc_cache_insert(x, job);
+    }
+    if (err)
+        qte_snapshot_error((t_object *)x, err, path);
+    else
+        object_post((t_object *)x, "Eigenbasis written to %s", path);
+}
+
+void qte_eigencalc_read(t_qte_eigencalc *x, t_symbol *s) {
+    char path[MAX_PATH_CHARS];
+    if (qte_snapshot_path((t_object *)x, s, 0, path))
+        return;
+    double t = qte_stats_begin(&x->stats);
+    // A file that fails to open leaves the current snapshot loaded.
+    t_qte_snapshot snap;
+    qte_snapshot_init(&snap);
+    int err = qte_snapshot_open(&snap, path);
+    if (err) {
+        qte_snapshot_error((t_object *)x, err, path);
+        return;
+    }
+    qte_snapshot_close(&x->snap);
+    x->snap = snap;
+    const t_qte_snapshot_header *h = &x->snap.header;
+    t_qte_eigh_params params;
+    int i;
+    const t_qte_eigencalc_matrix *in;
+    if (h->n != x->n) {
+        qte_eigencalc_dim(x, (long)h->n);
+    } else if ((in = qte_eigencalc_acquire(x, &i))) {
+        if (!qte_eigencalc_params(x, &params) && qte_eigencalc_key(x, in, &params) != h->source_hash)
+            object_warn((t_object *)x, "%s was not made from the stored matrix with these settings", path);
+        qte_eigencalc_release(x, i);
+    }
+    qte_eigencalc_supersede(x);
+    t = qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+    qte_eigencalc_snapshot_output(x, t);
 }
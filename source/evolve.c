@@ -0,0 +1,430 @@
+/* qte.evolve.c – Fused time evolution for Max/MSP
+ *
+ * One object for the whole qte.quantumho -> qte.eigencalc -> qte.initstatecalc ->
+ * qte.timedev chain. It keeps every intermediate result in native memory:
+ *    1. the Hamiltonian H (n x n): the harmonic oscillator of qte.quantumho
+ *       (@hamiltonian oscillator, parameters @dim and @a), or a matrix received as a
+ *       list of 2*n*n floats (row-major) or a "jit_matrix <name>" (@hamiltonian input)
+ *    2. its eigenbasis (E_k, v_k), computed with zheevd
+ *    3. the coefficients c_k = <v_k|psi0> of the initial state, set with
+ *       "state" followed by 2*n floats (real, imag) of psi0 in the position basis
+ *    4. the trajectories psi_i(t) = sum_k c_k exp(-i E_k t) v_k[i] for
+ *       "time_settings tmin tmax tsteps"
+ *
+ * A bang redoes only the stages whose inputs changed since the last bang (a new
+ * initial state, for instance, skips the diagonalization) and outputs the
+ * trajectories in the qte.timedev format: for each component i in turn, the
+ * middle outlet sends the list (i, t0, |psi_i(t0)|, t1, |psi_i(t1)|, ...) and
+ * then the left outlet the list (i, t0, arg psi_i(t0), t1, arg psi_i(t1), ...).
+ *
+ * "stats" sends the latencies of the three stages a bang runs through: parse
+ * (the list, jit_matrix and state messages), compute (the stages 1-4 a bang
+ * redoes, up to and including the zgemm) and output (each trajectory list),
+ * out of the right outlet, which carries nothing else (see qte_stats_message).
+ */
+
+#include "ext.h"
+#include "ext_obex.h"
+#include "jit.common.h"
+#include "qte_core.h"
+#include "qte_core_max.h"
+#include <math.h>
+#include <stdlib.h>
+#include <complex.h>
+
+// Object structure
+typedef struct _qte_evolve {
+    t_object ob;
+    long n;                     // @dim
+    double a;                   // @a, oscillator potential parameter
+    t_symbol *hamiltonian;      // @hamiltonian: "oscillator" or "input"
+    double tmin;                // time_settings
+    double tmax;
+    long tsteps;
+    void *out_status;           // right: stats
+    void *out_mag;              // middle: magnitude trajectories
+    void *out_phase;            // left: phase trajectories
+
+    // Stage 1: Hamiltonians (row-major). Each source carries a version that is
+    // bumped whenever its contents change.
+    t_qte_cmatrix H_osc;
+    t_qte_cvector p2;           // first column of the oscillator's P^2
+    long osc_n;                 // dimension H_osc was built for (0 = not built)
+    double osc_a;               // potential parameter H_osc was built for
+    long osc_version;
+    t_qte_cmatrix H_in;         // received Hamiltonian (empty until input arrives)
+    long in_version;
+
+    // Stage 2: eigenbasis of the Hamiltonian identified by (eig_source, eig_version).
+    t_qte_cmatrix A;            // LAPACK input (column-major, destroyed)
+    t_qte_cmatrix Z;            // eigenvectors (column-major)
+    t_qte_eigh_work ws;         // LAPACK workspace, sized on the first solve of each n
+    t_qte_cmatrix V;            // eigenvectors (row-major)
+    double *w;                  // eigenvalues, eigenvalues_n entries allocated
+    long eigenvalues_n;
+    t_symbol *eig_source;
+    long eig_version;
+    long eig_valid;             // the basis matches (eig_source, eig_version)
+    long eig_stamp;             // bumped by every decomposition
+
+    // Stage 3: coefficients of the initial state in the eigenbasis eig_stamp.
+    t_qte_cvector psi0;
+    long state_version;
+    t_qte_cvector c;
+    long coeff_eig_stamp;
+    long coeff_state_version;
+
+    // Stage 4: trajectory scratch, kept between bangs.
+    t_qte_cmatrix Phi;          // m x tsteps phase factors
+    t_qte_cmatrix Psi;          // n x tsteps amplitudes
+    t_atom *out_list;           // 1 + 2*tsteps atoms
+    long out_list_size;
+    t_qte_stats stats;          // "stats" message / qte.profiler
+} t_qte_evolve;
+
+static t_class *qte_evolve_class = NULL;
+
+/* Function prototypes */
+void ext_main(void *r);
+void *qte_evolve_new(t_symbol *s, long argc, t_atom *argv);
+void  qte_evolve_free(t_qte_evolve *x);
+void  qte_evolve_assist(t_qte_evolve *x, void *b, long m, long a, char *s);
+void  qte_evolve_list(t_qte_evolve *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_evolve_jit_matrix(t_qte_evolve *x, t_symbol *s);
+void  qte_evolve_state(t_qte_evolve *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_evolve_time_settings(t_qte_evolve *x, double tmin, double tmax, long tsteps);
+void  qte_evolve_bang(t_qte_evolve *x);
+void  qte_evolve_stats(t_qte_evolve *x, t_symbol *s, long argc, t_atom *argv);
+
+/* ----------------------------------------------------------------------------
+   ext_main – class initialization
+---------------------------------------------------------------------------- */
+void ext_main(void *r) {
+    t_class *c = class_new("qte.evolve",
+                           (method)qte_evolve_new,
+                           (method)qte_evolve_free,
+                           sizeof(t_qte_evolve),
+                           0L, A_GIMME, 0);
+
+    class_addmethod(c, (method)qte_evolve_assist, "assist", A_CANT, 0);
+    class_addmethod(c, (method)qte_evolve_list, "list", A_GIMME, 0);
+    class_addmethod(c, (method)qte_evolve_jit_matrix, "jit_matrix", A_SYM, 0);
+    class_addmethod(c, (method)qte_evolve_state, "state", A_GIMME, 0);
+    class_addmethod(c, (method)qte_evolve_time_settings, "time_settings", A_FLOAT, A_FLOAT, A_LONG, 0);
+    class_addmethod(c, (method)qte_evolve_bang, "bang", 0);
+    class_addmethod(c, (method)qte_evolve_stats, "stats", A_GIMME, 0);
+
+    CLASS_ATTR_LONG(c, "dim", 0, t_qte_evolve, n);
+    CLASS_ATTR_FILTER_MIN(c, "dim", 1);
+    CLASS_ATTR_LABEL(c, "dim", 0, "Dimension");
+
+    CLASS_ATTR_DOUBLE(c, "a", 0, t_qte_evolve, a);
+    CLASS_ATTR_LABEL(c, "a", 0, "Oscillator Potential Parameter");
+
+    CLASS_ATTR_SYM(c, "hamiltonian", 0, t_qte_evolve, hamiltonian);
+    CLASS_ATTR_ENUM(c, "hamiltonian", 0, "oscillator input");
+    CLASS_ATTR_LABEL(c, "hamiltonian", 0, "Hamiltonian Source");
+
+    class_register(CLASS_BOX, c);
+    qte_evolve_class = c;
+}
+
+/* ----------------------------------------------------------------------------
+   Constructor / Destructor
+---------------------------------------------------------------------------- */
+void *qte_evolve_new(t_symbol *s, long argc, t_atom *argv) {
+    t_qte_evolve *x = (t_qte_evolve *)object_alloc(qte_evolve_class);
+    if (x) {
+        // Arguments: [dim] [a], then attributes.
+        long nargs = attr_args_offset(argc, argv);
+        x->n = 8;
+        x->a = 1.0;
+        if (nargs >= 1 && atom_getlong(argv) > 0)
+            x->n = atom_getlong(argv);
+        if (nargs >= 2)
+            x->a = atom_getfloat(argv + 1);
+        x->hamiltonian = gensym("oscillator");
+        x->tmin = 0.0;
+        x->tmax = 10.0;
+        x->tsteps = 100;
+
+        qte_cmatrix_init(&x->H_osc);
+        qte_cvector_init(&x->p2);
+        x->osc_n = 0;
+        x->osc_a = 0.0;
+        x->osc_version = 0;
+        qte_cmatrix_init(&x->H_in);
+        x->in_version = 0;
+
+        qte_cmatrix_init(&x->A);
+        qte_cmatrix_init(&x->Z);
+        qte_eigh_work_init(&x->ws);
+        qte_cmatrix_init(&x->V);
+        x->w = NULL;
+        x->eigenvalues_n = 0;
+        x->eig_source = NULL;
+        x->eig_version = 0;
+        x->eig_valid = 0;
+        x->eig_stamp = 0;
+
+        qte_cvector_init(&x->psi0);
+        x->state_version = 0;
+        qte_cvector_init(&x->c);
+        x->coeff_eig_stamp = 0;
+        x->coeff_state_version = 0;
+
+        qte_cmatrix_init(&x->Phi);
+        qte_cmatrix_init(&x->Psi);
+        x->out_list = NULL;
+        x->out_list_size = 0;
+
+        // Outlets are created right to left.
+        x->out_status = outlet_new((t_object *)x, NULL);
+        x->out_mag = outlet_new((t_object *)x, NULL);
+        x->out_phase = outlet_new((t_object *)x, NULL);
+        qte_stats_register((t_object *)x, &x->stats);
+        attr_args_process(x, argc, argv);
+    }
+    return x;
+}
+
+void qte_evolve_free(t_qte_evolve *x) {
+    qte_stats_unregister((t_object *)x);
+    qte_cmatrix_free(&x->H_osc);
+    qte_cvector_free(&x->p2);
+    qte_cmatrix_free(&x->H_in);
+    qte_cmatrix_free(&x->A);
+    qte_cmatrix_free(&x->Z);
+    qte_eigh_work_free(&x->ws);
+    qte_cmatrix_free(&x->V);
+    free(x->w);
+    qte_cvector_free(&x->psi0);
+    qte_cvector_free(&x->c);
+    qte_cmatrix_free(&x->Phi);
+    qte_cmatrix_free(&x->Psi);
+    if (x->out_list)
+        sysmem_freeptr(x->out_list);
+}
+
+/* ----------------------------------------------------------------------------
+   Assist method
+---------------------------------------------------------------------------- */
+void qte_evolve_assist(t_qte_evolve *x, void *b, long m, long a, char *s) {
+    if (m == 1)
+        sprintf(s, "bang, state (2*n floats), time_settings, Hamiltonian as list (2*n*n floats) or jit_matrix");
+    else if (a == 0)
+        sprintf(s, "Phase trajectories: i t0 arg psi_i(t0) t1 arg psi_i(t1) ...");
+    else if (a == 1)
+        sprintf(s, "Magnitude trajectories: i t0 |psi_i(t0)| t1 |psi_i(t1)| ...");
+    else
+        sprintf(s, "Status outlet: stats");
+}
+
+/* ----------------------------------------------------------------------------
+   Inputs
+---------------------------------------------------------------------------- */
+/* list – a Hamiltonian of 2*n*n floats (row-major, real/imag pairs); selects
+   @hamiltonian input. */
+void qte_evolve_list(t_qte_evolve *x, t_symbol *s, long argc, t_atom *argv) {
+    long n = x->n;
+    if (argc != 2 * n * n) {
+        object_error((t_object *)x, "Expected %ld floats for the Hamiltonian, got %ld", 2 * n * n, argc);
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    if (qte_cmatrix_resize(&x->H_in, n, n, QTE_ROW_MAJOR)) {
+        object_error((t_object *)x, "Memory allocation failed for the Hamiltonian");
+        qte_cmatrix_free(&x->H_in);
+        return;
+    }
+    qte_atoms_to_cmatrix(argc, argv, &x->H_in, QTE_ROW_MAJOR);
+    x->in_version++;
+    x->hamiltonian = gensym("input");
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+}
+
+/* jit_matrix – a square 2-plane float64 Hamiltonian; adopts its dimension and
+   selects @hamiltonian input. */
+void qte_evolve_jit_matrix(t_qte_evolve *x, t_symbol *s) {
+    long rows, cols;
+    if (qte_jit_matrix_dims(s, &rows, &cols) || rows != cols || rows < 1) {
+        object_error((t_object *)x, "Expected a square 2-plane float64 jit.matrix");
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    x->H_in.layout = QTE_ROW_MAJOR;
+    if (qte_jit_matrix_read(s, &x->H_in)) {
+        object_error((t_object *)x, "Could not read jit.matrix %s", s->s_name);
+        qte_cmatrix_free(&x->H_in);
+        return;
+    }
+    x->n = rows;
+    x->in_version++;
+    x->hamiltonian = gensym("input");
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+}
+
+/* state – the initial state psi0 as 2*n floats (real, imag). */
+void qte_evolve_state(t_qte_evolve *x, t_symbol *s, long argc, t_atom *argv) {
+    long n = x->n;
+    if (argc != 2 * n) {
+        object_error((t_object *)x, "Expected 2*%ld=%ld floats for the initial state", n, 2 * n);
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    if (qte_cvector_resize(&x->psi0, n)) {
+        object_error((t_object *)x, "Memory allocation failed for the initial state");
+        qte_cvector_free(&x->psi0);
+        return;
+    }
+    qte_atoms_to_cvector(argc, argv, &x->psi0);
+    x->state_version++;
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+}
+
+void qte_evolve_time_settings(t_qte_evolve *x, double tmin, double tmax, long tsteps) {
+    if (tsteps < 1) {
+        object_error((t_object *)x, "tsteps must be >= 1");
+        return;
+    }
+    x->tmin = tmin;
+    x->tmax = tmax;
+    x->tsteps = tsteps;
+}
+
+/* ----------------------------------------------------------------------------
+   Stages – each returns 0 when its result is current (recomputed or not).
+---------------------------------------------------------------------------- */
+/* Stage 1: the current Hamiltonian and its version. */
+static const t_qte_cmatrix *qte_evolve_hamiltonian(t_qte_evolve *x, long *version) {
+    long n = x->n;
+    if (x->hamiltonian == gensym("input")) {
+        if (!x->H_in.data || x->H_in.rows != n) {
+            object_error((t_object *)x, "No %ld x %ld Hamiltonian received (@hamiltonian input)", n, n);
+            return NULL;
+        }
+        *version = x->in_version;
+        return &x->H_in;
+    }
+    // Oscillator: a new n rebuilds the whole matrix, a new a only the diagonal.
+    if (x->osc_n != n) {
+        x->osc_n = 0;
+        if (qte_cmatrix_resize(&x->H_osc, n, n, QTE_ROW_MAJOR) || qte_cvector_resize(&x->p2, n)) {
+            object_error((t_object *)x, "Memory allocation failed for the Hamiltonian");
+            return NULL;
+        }
+        qte_oscillator_p2_column(x->p2.data, n);
+        qte_oscillator_kinetic(&x->H_osc, x->p2.data, 1);
+        qte_oscillator_potential(&x->H_osc, x->p2.data, x->a);
+        x->osc_n = n;
+        x->osc_a = x->a;
+        x->osc_version++;
+    } else if (x->osc_a != x->a) {
+        qte_oscillator_potential(&x->H_osc, x->p2.data, x->a);
+        x->osc_a = x->a;
+        x->osc_version++;
+    }
+    *version = x->osc_version;
+    return &x->H_osc;
+}
+
+/* Stage 2: eigenbasis of H, redone only when H changed. */
+static int qte_evolve_eigenbasis(t_qte_evolve *x, const t_qte_cmatrix *H, long version) {
+    if (x->eig_valid && x->eig_source == x->hamiltonian && x->eig_version == version)
+        return 0;
+    long n = H->rows, m = 0;
+    int info = 0;
+    t_qte_eigh_params p = { QTE_ZHEEVD, 1, 'A', 1, n, 0.0, 0.0 };
+    if (x->eigenvalues_n < n) {
+        free(x->w);
+        x->eigenvalues_n = 0;
+        x->w = (double *)malloc(n * sizeof(double));
+        if (!x->w) {
+            object_error((t_object *)x, "Memory allocation failed for eigenvalues");
+            return -1;
+        }
+        x->eigenvalues_n = n;
+    }
+    x->eig_valid = 0;
+    if (qte_cmatrix_copy(&x->A, H, QTE_COL_MAJOR)) {
+        object_error((t_object *)x, "Memory allocation failed for LAPACK matrix");
+        return -1;
+    }
+    int err = qte_eigh(&p, &x->A, x->w, &x->Z, &m, &x->ws, &info);
+    if (err == QTE_ERR_ALLOC) {
+        object_error((t_object *)x, "Memory allocation failed for LAPACK workspace");
+        return -1;
+    } else if (err) {
+        object_error((t_object *)x, "Eigen-decomposition failed: info=%d", info);
+        return -1;
+    }
+    if (qte_cmatrix_copy(&x->V, &x->Z, QTE_ROW_MAJOR)) {
+        object_error((t_object *)x, "Memory allocation failed for eigenvectors");
+        return -1;
+    }
+    x->eig_source = x->hamiltonian;
+    x->eig_version = version;
+    x->eig_valid = 1;
+    x->eig_stamp++;
+    return 0;
+}
+
+/* Stage 3: coefficients c = V^H psi0, redone when the basis or the state changed. */
+static int qte_evolve_coefficients(t_qte_evolve *x) {
+    if (!x->psi0.data || x->psi0.n != x->n) {
+        object_error((t_object *)x, "No initial state of dimension %ld (use state)", x->n);
+        return -1;
+    }
+    if (x->coeff_eig_stamp == x->eig_stamp && x->coeff_state_version == x->state_version)
+        return 0;
+    if (qte_project(&x->V, &x->psi0, &x->c)) {
+        object_error((t_object *)x, "Memory allocation failed for coefficients");
+        return -1;
+    }
+    x->coeff_eig_stamp = x->eig_stamp;
+    x->coeff_state_version = x->state_version;
+    return 0;
+}
+
+/* Stage 4: all time steps as one zgemm Psi = V * Phi, then the outlet lists. */
+static void qte_evolve_output(t_qte_evolve *x, double t) {
+    long n = x->n;
+    long m = x->V.cols;
+    long T = x->tsteps;
+    double dt = (T > 1) ? (x->tmax - x->tmin) / (T - 1) : 0.0;
+
+    if (qte_cmatrix_resize(&x->Phi, m, T, QTE_ROW_MAJOR) || qte_cmatrix_resize(&x->Psi, n, T, QTE_ROW_MAJOR)) {
+        object_error((t_object *)x, "Memory allocation failed for %ld time steps", T);
+        return;
+    }
+    if (qte_atoms_reserve(&x->out_list, &x->out_list_size, 1 + 2 * T, &x->stats)) {
+        object_error((t_object *)x, "Failed to allocate memory for output list");
+        return;
+    }
+    qte_phase_matrix(&x->Phi, x->w, x->c.data, x->tmin, dt);
+    qte_zgemm(QTE_NOTRANS, QTE_NOTRANS, 1.0, &x->V, &x->Phi, 0.0, &x->Psi);
+    t = qte_stats_lap(&x->stats, QTE_STAGE_COMPUTE, t);
+
+    qte_trajectory_lists(&x->Psi, x->tmin, dt, x->out_list, x->out_mag, x->out_phase, &x->stats, t);
+}
+
+/* ----------------------------------------------------------------------------
+   qte_evolve_bang – brings every stale stage up to date and outputs
+---------------------------------------------------------------------------- */
+void qte_evolve_bang(t_qte_evolve *x) {
+    long version = 0;
+    double t = qte_stats_begin(&x->stats);
+    const t_qte_cmatrix *H = qte_evolve_hamiltonian(x, &version);
+    if (!H)
+        return;
+    if (qte_evolve_eigenbasis(x, H, version))
+        return;
+    if (qte_evolve_coefficients(x))
+        return;
+    qte_evolve_output(x, t);
+}
+
+/* stats – latencies, bytes and atoms ("stats reset" clears them). */
+void qte_evolve_stats(t_qte_evolve *x, t_symbol *s, long argc, t_atom *argv) {
+    qte_stats_message((t_object *)x, &x->stats, x->out_status, argc, argv);
+}
@@ -1 +1,474 @@
-#include "ext.h"#include "ext_obex.h"#include <stdlib.h>// Our object structure (previously herm_comb)typedef struct _qte_hermcomb {    t_object ob;    long n;    // matrix dimension    void *out; // outlet pointer} t_qte_hermcomb;// Global class pointerstatic t_class *qte_hermcomb_class = NULL;// Function prototypesvoid *qte_hermcomb_new(t_symbol *s, long argc, t_atom *argv);void qte_hermcomb_free(t_qte_hermcomb *x);void qte_hermcomb_assist(t_qte_hermcomb *x, void *b, long m, long a, char *s);void qte_hermcomb_list(t_qte_hermcomb *x, t_symbol *s, long argc, t_atom *argv);// Main entry point, called by Max at load timevoid ext_main(void *r){    t_class *c;    // Register object name as "qte.hermcombiner"    c = class_new("qte.hermcombiner",                  (method)qte_hermcomb_new,                  (method)qte_hermcomb_free,                  sizeof(t_qte_hermcomb),                  0L,                  A_GIMME,                  0);    class_addmethod(c, (method)qte_hermcomb_list,   "list",   A_GIMME, 0);    class_addmethod(c, (method)qte_hermcomb_assist, "assist", A_CANT,  0);    class_register(CLASS_BOX, c);    qte_hermcomb_class = c; // Save the class pointer}// Constructorvoid *qte_hermcomb_new(t_symbol *s, long argc, t_atom *argv){    // Use the global pointer qte_hermcomb_class    t_qte_hermcomb *x = (t_qte_hermcomb *)object_alloc(qte_hermcomb_class);    if (x) {        x->n = 3; // default dimension        if (argc > 0 && atom_gettype(argv) == A_LONG) {            x->n = atom_getlong(argv);        }        x->out = outlet_new(x, NULL);    }    return x;}// Destructorvoid qte_hermcomb_free(t_qte_hermcomb *x){    // Nothing special to free}// Assist methodvoid qte_hermcomb_assist(t_qte_hermcomb *x, void *b, long m, long a, char *s){    if (m == 1) {        sprintf(s, "Input: List of numbers for matrices & coefficients");    } else {        sprintf(s, "Output: Combined Hermitian matrix as list");    }}// List method (combines two matrices with two coefficients)void qte_hermcomb_list(t_qte_hermcomb *x, t_symbol *s, long argc, t_atom *argv){    // For demonstration, we assume two matrices each with n*n numbers,    // followed by two coefficients (total 2*n*n + 2 floats).    long n = x->n;    if (argc != 2 * n * n + 2) {        object_post((t_object *)x, "Expected %ld numbers", 2 * n * n + 2);        return;    }    double *M1 = (double *)sysmem_newptr(n * n * sizeof(double));    double *M2 = (double *)sysmem_newptr(n * n * sizeof(double));    if (!M1 || !M2) {        object_error((t_object *)x, "Memory allocation failed");        if (M1) sysmem_freeptr(M1);        if (M2) sysmem_freeptr(M2);        return;    }    // Coefficients    double c1 = atom_getfloat(argv + 2 * n * n);    double c2 = atom_getfloat(argv + 2 * n * n + 1);    // Read M1 and M2    for (long i = 0; i < n * n; i++) {        M1[i] = atom_getfloat(argv + i);        M2[i] = atom_getfloat(argv + n * n + i);    }    // Output array    t_atom *out_list = (t_atom *)sysmem_newptr(n * n * sizeof(t_atom));    if (!out_list) {        object_error((t_object *)x, "Memory allocation failed for output");        sysmem_freeptr(M1);        sysmem_freeptr(M2);        return;    }    // Combine the matrices    for (long i = 0; i < n * n; i++) {        double val = c1 * M1[i] + c2 * M2[i];        atom_setfloat(out_list + i, val);    }    outlet_list(x->out, gensym("list"), n * n, out_list);    sysmem_freeptr(out_list);    sysmem_freeptr(M1);    sysmem_freeptr(M2);}
\ No newline at end of file
+/* qte.hermcombiner.c – Linear combination of Hermitian matrices for Max/MSP
+ *
+ * Resident operands: the matrices are sent once and kept, and short
+ * coefficient messages recompute H = sum_i c_i H_i into a persistent buffer.
+ *   "operand <name> <data>" stores (or replaces) the operand called name, a
+ *       symbol or number. data is n*n real numbers, n(n+1) floats in packed
+ *       storage (see qte.eigencalc), 2*n*n (real, imag) floats row-major, or
+ *       the name of a 2-plane float64 n x n jit.matrix. Operands keep the order
+ *       in which they were first defined; the first one fixes n when there is
+ *       none yet. A new operand starts with coefficient 0.
+ *   "coeffs c0 c1 ..." sets the coefficients in operand order (missing ones stay
+ *       as they are), "coeff <name> <c>" sets one; both recompute and output.
+ *   "bang" outputs the current combination, "remove <name>" and "clear" drop operands.
+ * The sum is one zaxpy per operand with a nonzero coefficient. @format list
+ * (default) sends 2*n*n floats, @format packed "packed <floats>" and
+ * @format matrix a 2-plane float64 jit.matrix, which involves no atoms at all.
+ *
+ * The original one-shot messages are still accepted:
+ *   list: two real matrices of n*n numbers followed by two coefficients.
+ *   packed: two packed matrices followed by two coefficients.
+ *
+ * "stats" reports the parse (operand), compute and output latencies on a
+ * right outlet of its own, away from the matrices (see qte_stats_message).
+ */
+
+#include "ext.h"
+#include "ext_obex.h"
+#include "jit.common.h"
+#include "qte_core.h"
+#include "qte_core_max.h"
+#include <stdlib.h>
+
+// One resident operand
+typedef struct _qte_hermcomb_operand {
+    t_symbol *name;
+    double coeff;
+    t_qte_cvector H;    // n*n entries, row-major
+} t_qte_hermcomb_operand;
+
+// Our object structure (previously herm_comb)
+typedef struct _qte_hermcomb {
+    t_object ob;
+    long n;    // matrix dimension
+    void *out; // outlet pointer
+    void *out_status; // right outlet: stats
+    t_symbol *format;       // output format for the operand combination: list, packed or matrix
+    t_qte_hermcomb_operand *ops;
+    long nops;
+    long ops_capacity;
+    t_qte_cvector sum;      // sum_i c_i H_i, n*n row-major
+    t_qte_cvector packed;   // upper triangle of sum for @format packed
+    t_atom *out_list;       // persistent output atoms
+    long out_list_size;
+    void *outmatrix;        // registered 2-plane float64 jit.matrix for @format matrix
+    t_symbol *outmatrix_name;
+    t_qte_stats stats;      // "stats" message / qte.profiler
+} t_qte_hermcomb;
+
+// Global class pointer
+static t_class *qte_hermcomb_class = NULL;
+
+// Function prototypes
+void *qte_hermcomb_new(t_symbol *s, long argc, t_atom *argv);
+void qte_hermcomb_free(t_qte_hermcomb *x);
+void qte_hermcomb_assist(t_qte_hermcomb *x, void *b, long m, long a, char *s);
+void qte_hermcomb_list(t_qte_hermcomb *x, t_symbol *s, long argc, t_atom *argv);
+void qte_hermcomb_packed(t_qte_hermcomb *x, t_symbol *s, long argc, t_atom *argv);
+void qte_hermcomb_operand(t_qte_hermcomb *x, t_symbol *s, long argc, t_atom *argv);
+void qte_hermcomb_coeffs(t_qte_hermcomb *x, t_symbol *s, long argc, t_atom *argv);
+void qte_hermcomb_coeff(t_qte_hermcomb *x, t_symbol *s, long argc, t_atom *argv);
+void qte_hermcomb_remove(t_qte_hermcomb *x, t_symbol *s, long argc, t_atom *argv);
+void qte_hermcomb_clear(t_qte_hermcomb *x);
+void qte_hermcomb_bang(t_qte_hermcomb *x);
+void qte_hermcomb_stats(t_qte_hermcomb *x, t_symbol *s, long argc, t_atom *argv);
+
+// Main entry point, called by Max at load time
+void ext_main(void *r)
+{
+    t_class *c;
+    // Register object name as "qte.hermcombiner"
+    c = class_new("qte.hermcombiner",
+                  (method)qte_hermcomb_new,
+                  (method)qte_hermcomb_free,
+                  sizeof(t_qte_hermcomb),
+                  0L,
+                  A_GIMME,
+                  0);
+
+    class_addmethod(c, (method)qte_hermcomb_list,    "list",    A_GIMME, 0);
+    class_addmethod(c, (method)qte_hermcomb_packed,  "packed",  A_GIMME, 0);
+    class_addmethod(c, (method)qte_hermcomb_operand, "operand", A_GIMME, 0);
+    class_addmethod(c, (method)qte_hermcomb_coeffs,  "coeffs",  A_GIMME, 0);
+    class_addmethod(c, (method)qte_hermcomb_coeff,   "coeff",   A_GIMME, 0);
+    class_addmethod(c, (method)qte_hermcomb_remove,  "remove",  A_GIMME, 0);
+    class_addmethod(c, (method)qte_hermcomb_clear,   "clear",   0);
+    class_addmethod(c, (method)qte_hermcomb_bang,    "bang",    0);
+    class_addmethod(c, (method)qte_hermcomb_stats,   "stats",   A_GIMME, 0);
+    class_addmethod(c, (method)qte_hermcomb_assist,  "assist",  A_CANT,  0);
+
+    CLASS_ATTR_SYM(c, "format", 0, t_qte_hermcomb, format);
+    CLASS_ATTR_ENUM(c, "format", 0, "list packed matrix");
+    CLASS_ATTR_LABEL(c, "format", 0, "Output Format (operands)");
+
+    class_register(CLASS_BOX, c);
+    qte_hermcomb_class = c; // Save the class pointer
+}
+
+// Constructor
+void *qte_hermcomb_new(t_symbol *s, long argc, t_atom *argv)
+{
+    // Use the global pointer qte_hermcomb_class
+    t_qte_hermcomb *x = (t_qte_hermcomb *)object_alloc(qte_hermcomb_class);
+    if (x) {
+        x->n = 3; // default dimension
+        if (attr_args_offset(argc, argv) > 0 && atom_gettype(argv) == A_LONG && atom_getlong(argv) > 0) {
+            x->n = atom_getlong(argv);
+        }
+        x->format = gensym("list");
+        x->ops = NULL;
+        x->nops = 0;
+        x->ops_capacity = 0;
+        qte_cvector_init(&x->sum);
+        qte_cvector_init(&x->packed);
+        x->out_list = NULL;
+        x->out_list_size = 0;
+        x->out_status = outlet_new(x, NULL);
+        x->out = outlet_new(x, NULL);
+        x->outmatrix = qte_jit_outmatrix_new(&x->outmatrix_name);
+        qte_stats_register((t_object *)x, &x->stats);
+        attr_args_process(x, argc, argv);
+    }
+    return x;
+}
+
+// Destructor
+void qte_hermcomb_free(t_qte_hermcomb *x)
+{
+    qte_stats_unregister((t_object *)x);
+    qte_hermcomb_clear(x);
+    free(x->ops);
+    qte_cvector_free(&x->sum);
+    qte_cvector_free(&x->packed);
+    if (x->out_list)
+        sysmem_freeptr(x->out_list);
+    if (x->outmatrix)
+        jit_object_free(x->outmatrix);
+}
+
+// Assist method
+void qte_hermcomb_assist(t_qte_hermcomb *x, void *b, long m, long a, char *s)
+{
+    if (m == 1) {
+        sprintf(s, "Input: operand <name> <matrix>, coeffs c0 c1 ..., coeff <name> <c>, bang; or a one-shot list / packed");
+    } else if (a == 0) {
+        sprintf(s, "Output: Combined Hermitian matrix as list, packed or jit_matrix (@format)");
+    } else {
+        sprintf(s, "Status outlet: stats");
+    }
+}
+
+// List method (combines two matrices with two coefficients)
+void qte_hermcomb_list(t_qte_hermcomb *x, t_symbol *s, long argc, t_atom *argv)
+{
+    // For demonstration, we assume two matrices each with n*n numbers,
+    // followed by two coefficients (total 2*n*n + 2 floats).
+    long n = x->n;
+    if (argc != 2 * n * n + 2) {
+        object_post((t_object *)x, "Expected %ld numbers", 2 * n * n + 2);
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+
+    // Coefficients
+    double c1 = atom_getfloat(argv + 2 * n * n);
+    double c2 = atom_getfloat(argv + 2 * n * n + 1);
+
+    if (qte_atoms_reserve(&x->out_list, &x->out_list_size, n * n, &x->stats)) {
+        object_error((t_object *)x, "Memory allocation failed for output");
+        return;
+    }
+
+    // Combine the matrices straight from the two halves of the input
+    for (long i = 0; i < n * n; i++) {
+        double val = c1 * atom_getfloat(argv + i) + c2 * atom_getfloat(argv + n * n + i);
+        atom_setfloat(x->out_list + i, val);
+    }
+
+    qte_stats_lap(&x->stats, QTE_STAGE_COMPUTE, t);
+    x->stats.atoms += n * n;
+    outlet_list(x->out, gensym("list"), n * n, x->out_list);
+}
+
+// Packed method: two complex Hermitian matrices in LAPACK packed storage
+// (upper triangle column by column, n(n+1) floats each) followed by the two
+// coefficients; outputs "packed" c1 * A + c2 * B. n follows from the length.
+void qte_hermcomb_packed(t_qte_hermcomb *x, t_symbol *s, long argc, t_atom *argv)
+{
+    long floats = (argc - 2) / 2;
+    long n = (argc < 2 || (argc - 2) % 4) ? -1 : qte_packed_dim(floats / 2);
+    if (n < 1) {
+        object_post((t_object *)x, "Expected 2 * n(n+1) + 2 numbers for packed input, received %ld", argc);
+        return;
+    }
+    if (x->nops && n != x->n) {
+        object_error((t_object *)x, "Packed input is %ld x %ld but the operands are %ld x %ld", n, n, x->n, x->n);
+        return;
+    }
+    if (n != x->n)
+        object_post((t_object *)x, "Dimension set to %ld", n);
+    x->n = n;
+    double t = qte_stats_begin(&x->stats);
+
+    double c1 = atom_getfloat(argv + 2 * floats);
+    double c2 = atom_getfloat(argv + 2 * floats + 1);
+
+    if (qte_atoms_reserve(&x->out_list, &x->out_list_size, floats, &x->stats)) {
+        object_error((t_object *)x, "Memory allocation failed for output");
+        return;
+    }
+
+    // Real and imaginary parts combine independently.
+    for (long i = 0; i < floats; i++) {
+        double val = c1 * atom_getfloat(argv + i) + c2 * atom_getfloat(argv + floats + i);
+        atom_setfloat(x->out_list + i, val);
+    }
+
+    qte_stats_lap(&x->stats, QTE_STAGE_COMPUTE, t);
+    x->stats.atoms += floats;
+    outlet_anything(x->out, gensym("packed"), floats, x->out_list);
+}
+
+// ---------------------------------------------------------------------------
+// Resident operands
+// ---------------------------------------------------------------------------
+
+// Operand names: a symbol, or a number standing for its text.
+static t_symbol *qte_hermcomb_name(const t_atom *a)
+{
+    char buf[32];
+    if (atom_gettype(a) == A_SYM)
+        return atom_getsym(a);
+    if (atom_gettype(a) == A_LONG)
+        snprintf(buf, sizeof(buf), "%ld", (long)atom_getlong(a));
+    else
+        snprintf(buf, sizeof(buf), "%g", atom_getfloat(a));
+    return gensym(buf);
+}
+
+static long qte_hermcomb_find(t_qte_hermcomb *x, t_symbol *name)
+{
+    for (long k = 0; k < x->nops; k++) {
+        if (x->ops[k].name == name)
+            return k;
+    }
+    return -1;
+}
+
+// Reads an operand given as a list (n*n real, n(n+1) packed or 2*n*n complex)
+// into H (n*n row-major).
+static int qte_hermcomb_read_list(t_qte_hermcomb *x, long argc, t_atom *argv, t_qte_cvector *H)
+{
+    long n = x->n;
+    if (qte_cvector_resize(H, n * n)) {
+        object_error((t_object *)x, "Memory allocation failed for operand storage");
+        return -1;
+    }
+    if (argc == 2 * n * n) {
+        qte_atoms_to_cvector(argc, argv, H);
+        return 0;
+    }
+    if (argc == n * n) {
+        for (long i = 0; i < n * n; i++)
+            H->data[i] = atom_getfloat(argv + i);
+        return 0;
+    }
+    if (argc == n * (n + 1)) {
+        t_qte_cvector AP;
+        t_qte_cmatrix A = { n, n, n, QTE_ROW_MAJOR, H->data, H->capacity };
+        qte_cvector_init(&AP);
+        int err = qte_cvector_resize(&AP, QTE_PACKED_SIZE(n));
+        if (!err) {
+            qte_atoms_to_cvector(argc, argv, &AP);
+            err = qte_packed_to_cmatrix(&AP, &A);
+        }
+        qte_cvector_free(&AP);
+        if (err)
+            object_error((t_object *)x, "Memory allocation failed for operand storage");
+        return err ? -1 : 0;
+    }
+    object_error((t_object *)x, "Expected %ld (real), %ld (packed) or %ld (complex) floats for a %ld x %ld operand, got %ld",
+                 n * n, n * (n + 1), 2 * n * n, n, n, argc);
+    return -1;
+}
+
+// operand <name> <data>
+void qte_hermcomb_operand(t_qte_hermcomb *x, t_symbol *s, long argc, t_atom *argv)
+{
+    if (argc < 2) {
+        object_error((t_object *)x, "Expected operand <name> followed by a matrix");
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    t_symbol *name = qte_hermcomb_name(argv);
+    long k = qte_hermcomb_find(x, name);
+    int only = x->nops == 0 || (x->nops == 1 && k == 0);
+    t_qte_cvector H;
+    qte_cvector_init(&H);
+
+    if (argc == 2 && atom_gettype(argv + 1) == A_SYM) {
+        t_symbol *mname = atom_getsym(argv + 1);
+        long rows, cols;
+        if (qte_jit_matrix_dims(mname, &rows, &cols) || rows != cols) {
+            object_error((t_object *)x, "Expected a square 2-plane float64 jit.matrix");
+            return;
+        }
+        if (rows != x->n && !only) {
+            object_error((t_object *)x, "Operand %s is %ld x %ld but the others are %ld x %ld",
+                         name->s_name, rows, rows, x->n, x->n);
+            return;
+        }
+        // The matrix rows are the row-major entries, read straight into H.
+        t_qte_cmatrix A;
+        qte_cmatrix_init(&A);
+        A.layout = QTE_ROW_MAJOR;
+        if (qte_jit_matrix_read(mname, &A)) {
+            object_error((t_object *)x, "Could not read jit.matrix %s", mname->s_name);
+            qte_cmatrix_free(&A);
+            return;
+        }
+        if (rows != x->n)
+            object_post((t_object *)x, "Dimension set to %ld", rows);
+        x->n = rows;
+        H.n = rows * rows;
+        H.data = A.data;
+        H.capacity = A.capacity;
+    } else if (qte_hermcomb_read_list(x, argc - 1, argv + 1, &H)) {
+        qte_cvector_free(&H);
+        return;
+    }
+
+    if (k < 0) {
+        if (x->nops == x->ops_capacity) {
+            long capacity = x->ops_capacity ? 2 * x->ops_capacity : 4;
+            t_qte_hermcomb_operand *ops = (t_qte_hermcomb_operand *)realloc(x->ops, capacity * sizeof(*ops));
+            if (!ops) {
+                object_error((t_object *)x, "Memory allocation failed for operand list");
+                qte_cvector_free(&H);
+                return;
+            }
+            x->ops = ops;
+            x->ops_capacity = capacity;
+        }
+        k = x->nops++;
+        x->ops[k].name = name;
+        x->ops[k].coeff = 0.0;
+    } else {
+        qte_cvector_free(&x->ops[k].H);
+    }
+    x->ops[k].H = H;
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+}
+
+// remove <name>
+void qte_hermcomb_remove(t_qte_hermcomb *x, t_symbol *s, long argc, t_atom *argv)
+{
+    if (argc < 1)
+        return;
+    t_symbol *name = qte_hermcomb_name(argv);
+    long k = qte_hermcomb_find(x, name);
+    if (k < 0) {
+        object_error((t_object *)x, "No operand %s", name->s_name);
+        return;
+    }
+    qte_cvector_free(&x->ops[k].H);
+    for (long j = k + 1; j < x->nops; j++)
+        x->ops[j - 1] = x->ops[j];
+    x->nops--;
+}
+
+// clear: drop every operand
+void qte_hermcomb_clear(t_qte_hermcomb *x)
+{
+    for (long k = 0; k < x->nops; k++)
+        qte_cvector_free(&x->ops[k].H);
+    x->nops = 0;
+}
+
+// coeffs c0 c1 ...: coefficients in operand order, then output
+void qte_hermcomb_coeffs(t_qte_hermcomb *x, t_symbol *s, long argc, t_atom *argv)
+{
+    if (argc > x->nops)
+        object_warn((t_object *)x, "%ld coefficients for %ld operands, extra ones ignored", argc, x->nops);
+    for (long k = 0; k < argc && k < x->nops; k++)
+        x->ops[k].coeff = atom_getfloat(argv + k);
+    qte_hermcomb_bang(x);
+}
+
+// coeff <name> <c>: one coefficient, then output
+void qte_hermcomb_coeff(t_qte_hermcomb *x, t_symbol *s, long argc, t_atom *argv)
+{
+    if (argc != 2) {
+        object_error((t_object *)x, "Expected coeff <name> <value>");
+        return;
+    }
+    t_symbol *name = qte_hermcomb_name(argv);
+    long k = qte_hermcomb_find(x, name);
+    if (k < 0) {
+        object_error((t_object *)x, "No operand %s", name->s_name);
+        return;
+    }
+    x->ops[k].coeff = atom_getfloat(argv + 1);
+    qte_hermcomb_bang(x);
+}
+
+// bang: recompute sum_i c_i H_i and output it
+void qte_hermcomb_bang(t_qte_hermcomb *x)
+{
+    long n = x->n;
+    if (!x->nops) {
+        object_error((t_object *)x, "No operands. Use operand <name> <matrix> first.");
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    if (qte_cvector_resize(&x->sum, n * n)) {
+        object_error((t_object *)x, "Memory allocation failed for the sum");
+        return;
+    }
+    qte_cvector_zero(&x->sum);
+    for (long k = 0; k < x->nops; k++) {
+        if (x->ops[k].coeff != 0.0)
+            qte_zaxpy(x->ops[k].coeff, &x->ops[k].H, &x->sum);
+    }
+    t = qte_stats_lap(&x->stats, QTE_STAGE_COMPUTE, t);
+
+    // Row-major n x n view of the sum.
+    t_qte_cmatrix S = { n, n, n, QTE_ROW_MAJOR, x->sum.data, x->sum.capacity };
+    if (x->format == gensym("matrix")) {
+        if (!x->outmatrix || qte_jit_matrix_write(x->outmatrix, &S)) {
+            object_error((t_object *)x, "Output jit.matrix has no data");
+            return;
+        }
+        t_atom a;
+        atom_setsym(&a, x->outmatrix_name);
+        qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t);
+        x->stats.atoms += 1;
+        outlet_anything(x->out, _jit_sym_jit_matrix, 1, &a);
+        return;
+    }
+    if (x->format == gensym("packed")) {
+        if (qte_packed_from_cmatrix(&x->packed, &S) || qte_atoms_reserve(&x->out_list, &x->out_list_size, 2 * x->packed.n, &x->stats)) {
+            object_error((t_object *)x, "Memory allocation failed for output");
+            return;
+        }
+        qte_atoms_from_cvector(x->out_list, &x->packed);
+        qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t);
+        x->stats.atoms += 2 * x->packed.n;
+        outlet_anything(x->out, gensym("packed"), 2 * x->packed.n, x->out_list);
+        return;
+    }
+    if (qte_atoms_reserve(&x->out_list, &x->out_list_size, 2 * n * n, &x->stats)) {
+        object_error((t_object *)x, "Memory allocation failed for output");
+        return;
+    }
+    qte_atoms_from_cvector(x->out_list, &x->sum);
+    qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t);
+    x->stats.atoms += 2 * n * n;
+    outlet_list(x->out, gensym("list"), 2 * n * n, x->out_list);
+}
+
+// stats: latencies, bytes and atoms ("stats reset" clears them)
+void qte_hermcomb_stats(t_qte_hermcomb *x, t_symbol *s, long argc, t_atom *argv)
+{
+    qte_stats_message((t_object *)x, &x->stats, x->out_status, argc, argv);
+}
@@ -1 +1,333 @@
-/* qte.hermitmaker.c – Hermitian Matrix Maker external for Max/MSP * * This external takes an input list representing an upper–triangular matrix * (n×n, provided in row–major order; the entries below the diagonal are assumed * to be zero and the diagonal entries are real) and outputs the full Hermitian matrix. * * The computation is: *   For i == j: *      H[i][j] = 2 * U[i][j] *   For i != j: *      H[i][j] = U[i][j] + U[j][i] * * The output is sent as a flat list. * * Compile with Xcode using the Max SDK. */#include "ext.h"#include "ext_obex.h"#include <stdlib.h>#include <stdio.h>/* ------------------------------------------------------------   Our object structure   ------------------------------------------------------------ */typedef struct _qte_hermitmaker {    t_object ob;    long n;        // Matrix dimension    void *out;     // Outlet pointer} t_qte_hermitmaker;/* Global class pointer */static t_class *qte_hermitmaker_class = NULL;/* Function prototypes */void *qte_hermitmaker_new(t_symbol *s, long argc, t_atom *argv);void qte_hermitmaker_free(t_qte_hermitmaker *x);void qte_hermitmaker_assist(t_qte_hermitmaker *x, void *b, long m, long a, char *s);void qte_hermitmaker_list(t_qte_hermitmaker *x, t_symbol *s, long argc, t_atom *argv);/* -------------------------------------------------------------------   Main entry point, called by Max at load time   ------------------------------------------------------------------- */void ext_main(void *r){    t_class *c = class_new("qte.hermitmaker",                       // name in Max                           (method)qte_hermitmaker_new,                           (method)qte_hermitmaker_free,                           sizeof(t_qte_hermitmaker),                           0L,                           A_GIMME,                           0);    class_addmethod(c, (method)qte_hermitmaker_list,   "list",   A_GIMME, 0);    class_addmethod(c, (method)qte_hermitmaker_assist, "assist", A_CANT,  0);    class_register(CLASS_BOX, c);    qte_hermitmaker_class = c;  // Save the class pointer}/* -------------------------------------------------------------------   Create a new instance of the object   ------------------------------------------------------------------- */void *qte_hermitmaker_new(t_symbol *s, long argc, t_atom *argv){    t_qte_hermitmaker *x = (t_qte_hermitmaker *)object_alloc(qte_hermitmaker_class);    if (x) {        // Default matrix dimension        x->n = 3;        if (argc > 0) {            if (atom_gettype(argv) == A_LONG)                x->n = atom_getlong(argv);            else if (atom_gettype(argv) == A_FLOAT)                x->n = (long)atom_getfloat(argv);        }        if (x->n <= 0)            x->n = 3;        // Create an outlet        x->out = outlet_new(x, NULL);    }    return x;}/* -------------------------------------------------------------------   Free the object (nothing to free in this simple example)   ------------------------------------------------------------------- */void qte_hermitmaker_free(t_qte_hermitmaker *x){    // No dynamic memory allocated}/* -------------------------------------------------------------------   Provide assistance messages for inlets/outlets   ------------------------------------------------------------------- */void qte_hermitmaker_assist(t_qte_hermitmaker *x, void *b, long m, long a, char *s){    if (m == 1) {        sprintf(s, "Input: List representing an upper-triangular matrix (%ld numbers)", x->n * x->n);    } else {        sprintf(s, "Output: Hermitian matrix as flat list (%ld numbers)", x->n * x->n);    }}/* -------------------------------------------------------------------   Process the input list message and output the Hermitian matrix   ------------------------------------------------------------------- */void qte_hermitmaker_list(t_qte_hermitmaker *x, t_symbol *s, long argc, t_atom *argv){    long n = x->n;    long total = n * n;    if (argc != total) {        object_post((t_object *)x, "Expected %ld numbers, received %ld", total, argc);        return;    }    // Allocate an output array for the Hermitian matrix    t_atom *out_list = (t_atom *)sysmem_newptr(total * sizeof(t_atom));    if (!out_list) {        object_error((t_object *)x, "Memory allocation failed");        return;    }    // For i == j: H[i][i] = 2 * U[i][i].    // For i != j: H[i][j] = U[i][j] + U[j][i].    for (long i = 0; i < n; i++) {        for (long j = 0; j < n; j++) {            long index = i * n + j;            double val;            if (i == j) {                val = 2.0 * atom_getfloat(argv + index);            } else {                double v1 = atom_getfloat(argv + index);                double v2 = atom_getfloat(argv + (j * n + i));                val = v1 + v2;            }            atom_setfloat(out_list + index, val);        }    }    // Output the resulting Hermitian matrix    outlet_list(x->out, gensym("list"), total, out_list);    sysmem_freeptr(out_list);}
\ No newline at end of file
+/* qte.hermitmaker.c – Hermitian Matrix Maker external for Max/MSP
+ *
+ * This external takes an input list representing an upper–triangular matrix
+ * (n×n, provided in row–major order; the entries below the diagonal are assumed
+ * to be zero and the diagonal entries are real) and outputs the full Hermitian matrix.
+ *
+ * The computation is:
+ *   For i == j:
+ *      H[i][j] = 2 * U[i][j]
+ *   For i != j:
+ *      H[i][j] = U[i][j] + U[j][i]
+ *
+ * The output is sent as a flat list.
+ *
+ * A "packed" message gives U as a complex upper triangle instead, column by
+ * column in LAPACK packed storage (entry i + j(j+1)/2 is U[i][j], i <= j), as
+ * n(n+1) floats (real, imag); n follows from the length and, like "dim <n>",
+ * becomes the dimension list inputs are read with (posted when it changes). Then H = U + U^H:
+ * H[i][j] = U[i][j] above the diagonal and H[i][i] = 2 * Re U[i][i].
+ *
+ * A "jit_matrix <name>" message gives U as a square 2-plane float64 jit.matrix
+ * (plane 0 = real, plane 1 = imag); n follows from its size, as for packed,
+ * and H = U + U^H.
+ *
+ * @format list (default) outputs H as a flat list: n*n numbers for a list
+ * input, 2*n*n (real, imag) row-major for a packed or jit.matrix input, the
+ * format qte.eigencalc reads. @format packed outputs "packed <floats>", the
+ * upper triangle of H in the same packed storage, about half as many numbers.
+ * @format matrix writes H into an n x n jit.matrix and sends "jit_matrix <name>".
+ *
+ * "stats" reports the parse and output latencies (see qte_stats_message)
+ * from the right outlet; the left one only ever carries the matrix.
+ *
+ * Compile with Xcode using the Max SDK.
+ */
+
+#include "ext.h"
+#include "ext_obex.h"
+#include "qte_core.h"
+#include "qte_core_max.h"
+#include "jit.common.h"
+#include <stdlib.h>
+#include <stdio.h>
+
+/* ------------------------------------------------------------
+   Our object structure
+   ------------------------------------------------------------ */
+typedef struct _qte_hermitmaker {
+    t_object ob;
+    long n;             // Matrix dimension
+    void *out;          // Outlet pointer
+    void *out_status;   // Right outlet: stats
+    t_symbol *format;   // Output format: "list", "packed" or "matrix"
+    void *outmatrix;    // Registered 2-plane float64 jit.matrix for @format matrix
+    t_symbol *outmatrix_name;
+    t_qte_cvector H;    // Upper triangle of H, packed
+    t_qte_cmatrix full; // H unpacked for complex list output
+    t_atom *out_list;   // Output atoms
+    long out_list_size;
+    t_qte_stats stats;  // "stats" message / qte.profiler
+} t_qte_hermitmaker;
+
+/* Global class pointer */
+static t_class *qte_hermitmaker_class = NULL;
+
+/* Function prototypes */
+void *qte_hermitmaker_new(t_symbol *s, long argc, t_atom *argv);
+void qte_hermitmaker_free(t_qte_hermitmaker *x);
+void qte_hermitmaker_assist(t_qte_hermitmaker *x, void *b, long m, long a, char *s);
+void qte_hermitmaker_list(t_qte_hermitmaker *x, t_symbol *s, long argc, t_atom *argv);
+void qte_hermitmaker_packed(t_qte_hermitmaker *x, t_symbol *s, long argc, t_atom *argv);
+void qte_hermitmaker_jit_matrix(t_qte_hermitmaker *x, t_symbol *s);
+void qte_hermitmaker_dim(t_qte_hermitmaker *x, long n);
+void qte_hermitmaker_stats(t_qte_hermitmaker *x, t_symbol *s, long argc, t_atom *argv);
+
+/* -------------------------------------------------------------------
+   Main entry point, called by Max at load time
+   ------------------------------------------------------------------- */
+void ext_main(void *r)
+{
+    t_class *c = class_new("qte.hermitmaker",                       // name in Max
+                           (method)qte_hermitmaker_new,
+                           (method)qte_hermitmaker_free,
+                           sizeof(t_qte_hermitmaker),
+                           0L,
+                           A_GIMME,
+                           0);
+
+    class_addmethod(c, (method)qte_hermitmaker_list,   "list",   A_GIMME, 0);
+    class_addmethod(c, (method)qte_hermitmaker_packed, "packed", A_GIMME, 0);
+    class_addmethod(c, (method)qte_hermitmaker_jit_matrix, "jit_matrix", A_SYM, 0);
+    class_addmethod(c, (method)qte_hermitmaker_dim,    "dim",    A_LONG,  0);
+    class_addmethod(c, (method)qte_hermitmaker_stats,  "stats",  A_GIMME, 0);
+    class_addmethod(c, (method)qte_hermitmaker_assist, "assist", A_CANT,  0);
+
+    CLASS_ATTR_SYM(c, "format", 0, t_qte_hermitmaker, format);
+    CLASS_ATTR_ENUM(c, "format", 0, "list packed matrix");
+    CLASS_ATTR_LABEL(c, "format", 0, "Output Format");
+
+    class_register(CLASS_BOX, c);
+    qte_hermitmaker_class = c;  // Save the class pointer
+}
+
+/* -------------------------------------------------------------------
+   Create a new instance of the object
+   ------------------------------------------------------------------- */
+void *qte_hermitmaker_new(t_symbol *s, long argc, t_atom *argv)
+{
+    t_qte_hermitmaker *x = (t_qte_hermitmaker *)object_alloc(qte_hermitmaker_class);
+    if (x) {
+        // Default matrix dimension
+        x->n = 3;
+        if (attr_args_offset(argc, argv) > 0) {
+            if (atom_gettype(argv) == A_LONG)
+                x->n = atom_getlong(argv);
+            else if (atom_gettype(argv) == A_FLOAT)
+                x->n = (long)atom_getfloat(argv);
+        }
+        if (x->n <= 0)
+            x->n = 3;
+        x->format = gensym("list");
+        qte_cvector_init(&x->H);
+        qte_cmatrix_init(&x->full);
+        x->out_list = NULL;
+        x->out_list_size = 0;
+
+        // Create the outlets, right to left
+        x->out_status = outlet_new(x, NULL);
+        x->out = outlet_new(x, NULL);
+        x->outmatrix = qte_jit_outmatrix_new(&x->outmatrix_name);
+        qte_stats_register((t_object *)x, &x->stats);
+        attr_args_process(x, argc, argv);
+    }
+    return x;
+}
+
+/* -------------------------------------------------------------------
+   Free the object
+   ------------------------------------------------------------------- */
+void qte_hermitmaker_free(t_qte_hermitmaker *x)
+{
+    qte_stats_unregister((t_object *)x);
+    if (x->outmatrix)
+        jit_object_free(x->outmatrix);
+    qte_cvector_free(&x->H);
+    qte_cmatrix_free(&x->full);
+    if (x->out_list)
+        sysmem_freeptr(x->out_list);
+}
+
+/* -------------------------------------------------------------------
+   Provide assistance messages for inlets/outlets
+   ------------------------------------------------------------------- */
+void qte_hermitmaker_assist(t_qte_hermitmaker *x, void *b, long m, long a, char *s)
+{
+    if (m == 1) {
+        sprintf(s, "Input: List representing an upper-triangular matrix (%ld numbers), packed (%ld numbers), jit_matrix or dim <n>",
+                x->n * x->n, x->n * (x->n + 1));
+    } else if (a == 0) {
+        sprintf(s, "Output: Hermitian matrix as flat list (%ld numbers), packed with @format packed, jit_matrix with @format matrix",
+                x->n * x->n);
+    } else {
+        sprintf(s, "Status outlet: stats");
+    }
+}
+
+/* -------------------------------------------------------------------
+   dim <n>: the dimension of list inputs; packed and jit_matrix inputs set
+   it from their size
+   ------------------------------------------------------------------- */
+void qte_hermitmaker_dim(t_qte_hermitmaker *x, long n)
+{
+    if (n <= 0) {
+        object_error((t_object *)x, "dim must be > 0");
+        return;
+    }
+    if (x->n == n)
+        return;
+    x->n = n;
+    object_post((t_object *)x, "Dimension set to %ld", n);
+}
+
+/* -------------------------------------------------------------------
+   Output x->H as "packed" (@format packed), "jit_matrix" (@format matrix)
+   or as a flat list, real (n*n) or complex (2*n*n)
+   ------------------------------------------------------------------- */
+static void qte_hermitmaker_output(t_qte_hermitmaker *x, int complex_list, double t)
+{
+    long n = x->n;
+    if (x->format == gensym("matrix")) {
+        x->full.layout = QTE_ROW_MAJOR;
+        if (qte_packed_to_cmatrix(&x->H, &x->full)) {
+            object_error((t_object *)x, "Memory allocation failed");
+            return;
+        }
+        if (qte_jit_matrix_write(x->outmatrix, &x->full)) {
+            object_error((t_object *)x, "No output jit.matrix available");
+            return;
+        }
+        t_atom a;
+        atom_setsym(&a, x->outmatrix_name);
+        qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t);
+        x->stats.atoms += 1;
+        outlet_anything(x->out, _jit_sym_jit_matrix, 1, &a);
+        return;
+    }
+    if (x->format == gensym("packed")) {
+        if (qte_atoms_reserve(&x->out_list, &x->out_list_size, 2 * x->H.n, &x->stats)) {
+            object_error((t_object *)x, "Memory allocation failed");
+            return;
+        }
+        qte_atoms_from_cvector(x->out_list, &x->H);
+        qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t);
+        x->stats.atoms += 2 * x->H.n;
+        outlet_anything(x->out, gensym("packed"), 2 * x->H.n, x->out_list);
+        return;
+    }
+
+    long total = complex_list ? 2 * n * n : n * n;
+    x->full.layout = QTE_ROW_MAJOR;
+    if (qte_atoms_reserve(&x->out_list, &x->out_list_size, total, &x->stats) || qte_packed_to_cmatrix(&x->H, &x->full)) {
+        object_error((t_object *)x, "Memory allocation failed");
+        return;
+    }
+    if (complex_list) {
+        qte_atoms_from_cmatrix(x->out_list, &x->full, QTE_ROW_MAJOR);
+    } else {
+        for (long i = 0; i < total; i++)
+            atom_setfloat(x->out_list + i, creal(x->full.data[i]));
+    }
+    qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t);
+    x->stats.atoms += total;
+    outlet_list(x->out, gensym("list"), total, x->out_list);
+}
+
+/* -------------------------------------------------------------------
+   Process the input list message and output the Hermitian matrix
+   ------------------------------------------------------------------- */
+void qte_hermitmaker_list(t_qte_hermitmaker *x, t_symbol *s, long argc, t_atom *argv)
+{
+    long n = x->n;
+    long total = n * n;
+    if (argc != total) {
+        object_post((t_object *)x, "Expected %ld numbers, received %ld", total, argc);
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    if (qte_cvector_resize(&x->H, QTE_PACKED_SIZE(n))) {
+        object_error((t_object *)x, "Memory allocation failed");
+        return;
+    }
+
+    // For i == j: H[i][i] = 2 * U[i][i].
+    // For i != j: H[i][j] = U[i][j] + U[j][i].
+    double complex *ap = x->H.data;
+    for (long j = 0; j < n; j++) {
+        for (long i = 0; i < j; i++)
+            *ap++ = atom_getfloat(argv + (i * n + j)) + atom_getfloat(argv + (j * n + i));
+        *ap++ = 2.0 * atom_getfloat(argv + (j * n + j));
+    }
+
+    // Output the resulting Hermitian matrix
+    t = qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+    qte_hermitmaker_output(x, 0, t);
+}
+
+/* -------------------------------------------------------------------
+   packed: U as a complex packed upper triangle, H = U + U^H
+   ------------------------------------------------------------------- */
+void qte_hermitmaker_packed(t_qte_hermitmaker *x, t_symbol *s, long argc, t_atom *argv)
+{
+    long n = (argc % 2) ? -1 : qte_packed_dim(argc / 2);
+    if (n < 1) {
+        object_post((t_object *)x, "Expected n(n+1) numbers for a packed matrix, received %ld", argc);
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    if (qte_cvector_resize(&x->H, argc / 2)) {
+        object_error((t_object *)x, "Memory allocation failed");
+        return;
+    }
+    qte_hermitmaker_dim(x, n);
+    qte_atoms_to_cvector(argc, argv, &x->H);
+
+    // The diagonal of U + U^H is 2 Re U[i][i]; entry (j, j) sits at j + j(j+1)/2.
+    for (long j = 0; j < n; j++) {
+        double complex *d = x->H.data + j + QTE_PACKED_SIZE(j);
+        *d = 2.0 * creal(*d);
+    }
+    t = qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+    qte_hermitmaker_output(x, 1, t);
+}
+
+/* -------------------------------------------------------------------
+   jit_matrix: U as a square 2-plane float64 matrix, H = U + U^H
+   ------------------------------------------------------------------- */
+void qte_hermitmaker_jit_matrix(t_qte_hermitmaker *x, t_symbol *s)
+{
+    long rows, cols;
+    if (qte_jit_matrix_dims(s, &rows, &cols) || rows != cols || rows < 1) {
+        object_post((t_object *)x, "Expected a square 2-plane float64 jit.matrix");
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    // The matrix rows copy straight into a row-major U, which full holds until
+    // the output overwrites it with H.
+    x->full.layout = QTE_ROW_MAJOR;
+    if (qte_jit_matrix_read(s, &x->full) || qte_cvector_resize(&x->H, QTE_PACKED_SIZE(rows))) {
+        object_error((t_object *)x, "Could not read jit.matrix %s", s->s_name);
+        return;
+    }
+    qte_hermitmaker_dim(x, rows);
+    long n = rows;
+    const double complex *U = x->full.data;
+    long ld = x->full.ld;
+    // H[i][j] = U[i][j] + conj(U[j][i]); the diagonal is 2 Re U[j][j].
+    double complex *ap = x->H.data;
+    for (long j = 0; j < n; j++) {
+        for (long i = 0; i < j; i++)
+            *ap++ = U[i * ld + j] + conj(U[j * ld + i]);
+        *ap++ = 2.0 * creal(U[j * ld + j]);
+    }
+    t = qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+    qte_hermitmaker_output(x, 1, t);
+}
+
+/* -------------------------------------------------------------------
+   stats: latencies, bytes and atoms ("stats reset" clears them)
+   ------------------------------------------------------------------- */
+void qte_hermitmaker_stats(t_qte_hermitmaker *x, t_symbol *s, long argc, t_atom *argv)
+{
+    qte_stats_message((t_object *)x, &x->stats, x->out_status, argc, argv);
+}
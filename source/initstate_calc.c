@@ -1 +1,318 @@
-#include "ext.h"#include "ext_obex.h"#include <stdlib.h>#include <math.h>/* -----------------------------------------------------------------------   Our object structure------------------------------------------------------------------------ */typedef struct _qte_initstatecalc {    t_object ob;    long n;         // number of eigenstates (and length of each state vector)    void *out;      // outlet pointer} t_qte_initstatecalc;/* Global class pointer */static t_class *qte_initstatecalc_class = NULL;/* Function prototypes */void *qte_initstatecalc_new(t_symbol *s, long argc, t_atom *argv);void qte_initstatecalc_free(t_qte_initstatecalc *x);void qte_initstatecalc_assist(t_qte_initstatecalc *x, void *b, long m, long a, char *s);void qte_initstatecalc_list(t_qte_initstatecalc *x, t_symbol *s, long argc, t_atom *argv);/* -----------------------------------------------------------------------   ext_main: Called by Max at load time------------------------------------------------------------------------ */void ext_main(void *r){    t_class *c;    // Rename from "initstate_calc" to "qte.initstatecalc"    c = class_new("qte.initstatecalc",                  (method)qte_initstatecalc_new,                  (method)qte_initstatecalc_free,                  sizeof(t_qte_initstatecalc),                  0L,                  A_GIMME,                  0);    class_addmethod(c, (method)qte_initstatecalc_list,   "list",   A_GIMME, 0);    class_addmethod(c, (method)qte_initstatecalc_assist, "assist", A_CANT,  0);    class_register(CLASS_BOX, c);    qte_initstatecalc_class = c; // Save the class pointer}/* -----------------------------------------------------------------------   Constructor------------------------------------------------------------------------ */void *qte_initstatecalc_new(t_symbol *s, long argc, t_atom *argv){    // Use the global pointer qte_initstatecalc_class    t_qte_initstatecalc *x = (t_qte_initstatecalc *)object_alloc(qte_initstatecalc_class);    if (x) {        x->n = 3; // default        if (argc > 0 && atom_gettype(argv) == A_LONG) {            x->n = atom_getlong(argv);        }        x->out = outlet_new(x, NULL);    }    return x;}/* -----------------------------------------------------------------------   Destructor------------------------------------------------------------------------ */void qte_initstatecalc_free(t_qte_initstatecalc *x){    // No dynamic resources to free}/* -----------------------------------------------------------------------   Assist method------------------------------------------------------------------------ */void qte_initstatecalc_assist(t_qte_initstatecalc *x, void *b, long m, long a, char *s){    if (m == 1)        sprintf(s, "Input: eigenstates & initial state vector");    else        sprintf(s, "Output: Coefficients R_k (each as a pair)");}/* -----------------------------------------------------------------------   List method: Calculate the coefficients for an initial state------------------------------------------------------------------------ */void qte_initstatecalc_list(t_qte_initstatecalc *x, t_symbol *s, long argc, t_atom *argv){    // For simplicity, assume:    // - First: n eigenstates, each with n pairs => n*n*2 numbers    // - Then: initial state vector => n*2 numbers    long n = x->n;    long eigen_count = n * n * 2;    long init_count  = n * 2;    if (argc != eigen_count + init_count) {        object_post((t_object *)x, "Expected %ld numbers", eigen_count + init_count);        return;    }    t_atom *out_list = (t_atom *)sysmem_newptr(n * 2 * sizeof(t_atom));    if (!out_list) {        object_error((t_object *)x, "Memory allocation failed");        return;    }    // For each eigenstate k, compute the Hermitian inner product with the initial state    for (long k = 0; k < n; k++) {        double re = 0, im = 0;        for (long i = 0; i < n; i++) {            double e_re = atom_getfloat(argv + (k * n * 2 + i * 2));            double e_im = atom_getfloat(argv + (k * n * 2 + i * 2 + 1));            double psi_re = atom_getfloat(argv + eigen_count + i * 2);            double psi_im = atom_getfloat(argv + eigen_count + i * 2 + 1);            // Hermitian inner product: <psi, e_k> = sum(conj(e_k[i]) * psi[i])            re += ( e_re * psi_re + e_im * psi_im );            im += ( e_re * psi_im - e_im * psi_re );        }        atom_setfloat(out_list + k * 2,     re);        atom_setfloat(out_list + k * 2 + 1, im);    }    outlet_list(x->out, gensym("list"), n * 2, out_list);    sysmem_freeptr(out_list);}
\ No newline at end of file
+/* qte.initstatecalc.c – Initial-state coefficients in an eigenbasis for Max/MSP
+ *
+ * Computes the coefficients c_k = <v_k|psi> of states psi in the eigenbasis
+ * v_0 .. v_{m-1} (m <= n, e.g. a subset from qte.eigencalc @range):
+ *    - eigenstates : 2*n*m floats, eigenvector k stored contiguously as (real, imag)
+ *                    pairs, exactly as qte.eigencalc outputs them, or
+ *                    "jit_matrix <name>" with n rows and one eigenvector per column
+ *                    (qte.eigencalc @format matrix). The basis stays on the object.
+ *    - list        : 2*n floats, one state against the stored basis, or the original
+ *                    2*n*n + 2*n floats (n eigenstates followed by the state)
+ *    - states      : 2*n*K floats (K states one after the other), or a jit.matrix
+ *                    name with n rows and one state per column
+ *
+ * All K*m coefficients of a batch come from one zgemm C = V^H S, with the K
+ * states as the columns of S. The outlet sends, per state, a list of 2*m floats
+ * (Re c_0, Im c_0, ...); with @format matrix a batch is sent instead as one
+ * 2-plane float64 jit.matrix with m rows and one coefficient vector per column.
+ *
+ * "stats" reports the parse, compute (zgemm) and output latencies from the
+ * right outlet (see qte_stats_message); each list of a batch counts as one
+ * output.
+ */
+
+#include "ext.h"
+#include "ext_obex.h"
+#include "jit.common.h"
+#include "qte_core.h"
+#include "qte_core_max.h"
+#include <stdlib.h>
+#include <math.h>
+
+/* -----------------------------------------------------------------------
+   Our object structure
+------------------------------------------------------------------------ */
+typedef struct _qte_initstatecalc {
+    t_object ob;
+    long n;                 // length of each state vector
+    void *out;              // outlet pointer
+    void *out_status;       // right outlet: stats
+    t_symbol *format;       // output format for states: "list" or "matrix"
+    void *outmatrix;        // registered 2-plane float64 jit.matrix for @format matrix
+    t_symbol *outmatrix_name;
+
+    t_qte_cmatrix V;        // eigenbasis, n x m column-major (empty until set)
+    t_qte_cmatrix S;        // states, n x K column-major
+    t_qte_cmatrix C;        // coefficients, m x K column-major
+    t_atom *out_list;       // 2*m atoms
+    long out_list_size;
+    t_qte_stats stats;      // "stats" message / qte.profiler
+} t_qte_initstatecalc;
+
+/* Global class pointer */
+static t_class *qte_initstatecalc_class = NULL;
+
+/* Function prototypes */
+void *qte_initstatecalc_new(t_symbol *s, long argc, t_atom *argv);
+void qte_initstatecalc_free(t_qte_initstatecalc *x);
+void qte_initstatecalc_assist(t_qte_initstatecalc *x, void *b, long m, long a, char *s);
+void qte_initstatecalc_list(t_qte_initstatecalc *x, t_symbol *s, long argc, t_atom *argv);
+void qte_initstatecalc_eigenstates(t_qte_initstatecalc *x, t_symbol *s, long argc, t_atom *argv);
+void qte_initstatecalc_jit_matrix(t_qte_initstatecalc *x, t_symbol *s);
+void qte_initstatecalc_states(t_qte_initstatecalc *x, t_symbol *s, long argc, t_atom *argv);
+void qte_initstatecalc_stats(t_qte_initstatecalc *x, t_symbol *s, long argc, t_atom *argv);
+
+/* -----------------------------------------------------------------------
+   ext_main: Called by Max at load time
+------------------------------------------------------------------------ */
+void ext_main(void *r)
+{
+    t_class *c;
+
+    c = class_new("qte.initstatecalc",
+                  (method)qte_initstatecalc_new,
+                  (method)qte_initstatecalc_free,
+                  sizeof(t_qte_initstatecalc),
+                  0L,
+                  A_GIMME,
+                  0);
+
+    class_addmethod(c, (method)qte_initstatecalc_list,        "list",        A_GIMME, 0);
+    class_addmethod(c, (method)qte_initstatecalc_eigenstates, "eigenstates", A_GIMME, 0);
+    class_addmethod(c, (method)qte_initstatecalc_jit_matrix,  "jit_matrix",  A_SYM,   0);
+    class_addmethod(c, (method)qte_initstatecalc_states,      "states",      A_GIMME, 0);
+    class_addmethod(c, (method)qte_initstatecalc_stats,       "stats",       A_GIMME, 0);
+    class_addmethod(c, (method)qte_initstatecalc_assist,      "assist",      A_CANT,  0);
+
+    CLASS_ATTR_SYM(c, "format", 0, t_qte_initstatecalc, format);
+    CLASS_ATTR_ENUM(c, "format", 0, "list matrix");
+    CLASS_ATTR_LABEL(c, "format", 0, "Batch Output Format");
+
+    class_register(CLASS_BOX, c);
+    qte_initstatecalc_class = c; // Save the class pointer
+}
+
+/* -----------------------------------------------------------------------
+   Constructor
+------------------------------------------------------------------------ */
+void *qte_initstatecalc_new(t_symbol *s, long argc, t_atom *argv)
+{
+    t_qte_initstatecalc *x = (t_qte_initstatecalc *)object_alloc(qte_initstatecalc_class);
+
+    if (x) {
+        x->n = 3; // default
+        if (attr_args_offset(argc, argv) > 0 && atom_gettype(argv) == A_LONG && atom_getlong(argv) > 0) {
+            x->n = atom_getlong(argv);
+        }
+        x->format = gensym("list");
+        qte_cmatrix_init(&x->V);
+        qte_cmatrix_init(&x->S);
+        qte_cmatrix_init(&x->C);
+        x->out_list = NULL;
+        x->out_list_size = 0;
+        x->out_status = outlet_new(x, NULL);
+        x->out = outlet_new(x, NULL);
+        x->outmatrix = qte_jit_outmatrix_new(&x->outmatrix_name);
+        qte_stats_register((t_object *)x, &x->stats);
+        attr_args_process(x, argc, argv);
+    }
+    return x;
+}
+
+/* -----------------------------------------------------------------------
+   Destructor
+------------------------------------------------------------------------ */
+void qte_initstatecalc_free(t_qte_initstatecalc *x)
+{
+    qte_stats_unregister((t_object *)x);
+    if (x->outmatrix)
+        jit_object_free(x->outmatrix);
+    qte_cmatrix_free(&x->V);
+    qte_cmatrix_free(&x->S);
+    qte_cmatrix_free(&x->C);
+    if (x->out_list)
+        sysmem_freeptr(x->out_list);
+}
+
+/* -----------------------------------------------------------------------
+   Assist method
+------------------------------------------------------------------------ */
+void qte_initstatecalc_assist(t_qte_initstatecalc *x, void *b, long m, long a, char *s)
+{
+    if (m == 1)
+        sprintf(s, "Input: eigenstates (list or jit_matrix), then a state (list) or a batch (states)");
+    else if (a == 0)
+        sprintf(s, "Output: Coefficients R_k (each as a pair) per state, or jit_matrix with @format matrix");
+    else
+        sprintf(s, "Status outlet: stats");
+}
+
+/* -----------------------------------------------------------------------
+   Coefficients C = V^H S of the states in S, then the output
+------------------------------------------------------------------------ */
+static void qte_initstatecalc_compute(t_qte_initstatecalc *x, int batch, double t)
+{
+    long m = x->V.cols, K = x->S.cols;
+    if (qte_cmatrix_resize(&x->C, m, K, QTE_COL_MAJOR)) {
+        object_error((t_object *)x, "Memory allocation failed for %ld x %ld coefficients", m, K);
+        return;
+    }
+    qte_zgemm(QTE_CONJTRANS, QTE_NOTRANS, 1.0, &x->V, &x->S, 0.0, &x->C);
+    t = qte_stats_lap(&x->stats, QTE_STAGE_COMPUTE, t);
+
+    if (batch && x->format == gensym("matrix")) {
+        if (!x->outmatrix || qte_jit_matrix_write(x->outmatrix, &x->C)) {
+            object_error((t_object *)x, "Output jit.matrix has no data.");
+            return;
+        }
+        t_atom a;
+        atom_setsym(&a, x->outmatrix_name);
+        qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t);
+        x->stats.atoms += 1;
+        outlet_anything(x->out, _jit_sym_jit_matrix, 1, &a);
+        return;
+    }
+    if (qte_atoms_reserve(&x->out_list, &x->out_list_size, 2 * m, &x->stats)) {
+        object_error((t_object *)x, "Memory allocation failed");
+        return;
+    }
+    // Column k of C holds the coefficients of state k.
+    for (long k = 0; k < K; k++) {
+        t_qte_cvector c = { m, x->C.data + k * x->C.ld, m };
+        qte_atoms_from_cvector(x->out_list, &c);
+        qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t);
+        x->stats.atoms += 2 * m;
+        outlet_list(x->out, gensym("list"), 2 * m, x->out_list);
+        t = qte_time_now();
+    }
+}
+
+static int qte_initstatecalc_have_basis(t_qte_initstatecalc *x)
+{
+    if (!x->V.data || x->V.rows != x->n || x->V.cols < 1) {
+        object_error((t_object *)x, "No eigenstates of dimension %ld set (use eigenstates)", x->n);
+        return 0;
+    }
+    return 1;
+}
+
+/* -----------------------------------------------------------------------
+   eigenstates <2*n*m floats>: the resident basis, one eigenvector after another
+------------------------------------------------------------------------ */
+static int qte_initstatecalc_set_basis(t_qte_initstatecalc *x, long argc, t_atom *argv)
+{
+    long n = x->n;
+    if (argc < 2 * n || argc % (2 * n) || argc / (2 * n) > n) {
+        object_error((t_object *)x, "Expected 2*n*m floats (m <= %ld) for eigenstates, got %ld", n, argc);
+        return -1;
+    }
+    if (qte_cmatrix_resize(&x->V, n, argc / (2 * n), QTE_COL_MAJOR)) {
+        object_error((t_object *)x, "Memory allocation failed for eigenstates");
+        qte_cmatrix_free(&x->V);
+        return -1;
+    }
+    qte_atoms_to_cmatrix(argc, argv, &x->V, QTE_COL_MAJOR);
+    return 0;
+}
+
+void qte_initstatecalc_eigenstates(t_qte_initstatecalc *x, t_symbol *s, long argc, t_atom *argv)
+{
+    double t = qte_stats_begin(&x->stats);
+    if (!qte_initstatecalc_set_basis(x, argc, argv))
+        qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+}
+
+/* jit_matrix – the basis as n rows with one eigenvector per column (qte.eigencalc
+   @format matrix); adopts its dimension. */
+void qte_initstatecalc_jit_matrix(t_qte_initstatecalc *x, t_symbol *s)
+{
+    long rows, cols;
+    if (qte_jit_matrix_dims(s, &rows, &cols) || rows < 1 || cols < 1 || cols > rows) {
+        object_error((t_object *)x, "Expected a 2-plane float64 jit.matrix with n rows and m <= n columns");
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    x->V.layout = QTE_COL_MAJOR;
+    if (qte_jit_matrix_read(s, &x->V)) {
+        object_error((t_object *)x, "Could not read jit.matrix %s", s->s_name);
+        qte_cmatrix_free(&x->V);
+        return;
+    }
+    x->n = rows;
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+}
+
+/* -----------------------------------------------------------------------
+   List method: one state against the stored basis, or the original message
+   of n eigenstates followed by the state
+------------------------------------------------------------------------ */
+void qte_initstatecalc_list(t_qte_initstatecalc *x, t_symbol *s, long argc, t_atom *argv)
+{
+    long n = x->n;
+    long eigen_count = n * n * 2;
+    long init_count  = n * 2;
+    double t = qte_stats_begin(&x->stats);
+
+    if (argc == eigen_count + init_count) {
+        if (qte_initstatecalc_set_basis(x, eigen_count, argv))
+            return;
+        argv += eigen_count;
+        argc = init_count;
+    } else if (argc != init_count) {
+        object_post((t_object *)x, "Expected %ld or %ld numbers", init_count, eigen_count + init_count);
+        return;
+    }
+    if (!qte_initstatecalc_have_basis(x))
+        return;
+    if (qte_cmatrix_resize(&x->S, n, 1, QTE_COL_MAJOR)) {
+        object_error((t_object *)x, "Memory allocation failed");
+        return;
+    }
+    qte_atoms_to_cmatrix(argc, argv, &x->S, QTE_COL_MAJOR);
+    t = qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+    qte_initstatecalc_compute(x, 0, t);
+}
+
+/* -----------------------------------------------------------------------
+   states <2*n*K floats> | states <jit.matrix name>: a batch of K states
+------------------------------------------------------------------------ */
+void qte_initstatecalc_states(t_qte_initstatecalc *x, t_symbol *s, long argc, t_atom *argv)
+{
+    long n = x->n;
+    if (!qte_initstatecalc_have_basis(x))
+        return;
+    double t = qte_stats_begin(&x->stats);
+    if (argc == 1 && atom_gettype(argv) == A_SYM) {
+        t_symbol *name = atom_getsym(argv);
+        long rows, cols;
+        if (qte_jit_matrix_dims(name, &rows, &cols) || rows != n || cols < 1) {
+            object_error((t_object *)x, "Expected a 2-plane float64 jit.matrix with %ld rows, one state per column", n);
+            return;
+        }
+        x->S.layout = QTE_COL_MAJOR;
+        if (qte_jit_matrix_read(name, &x->S)) {
+            object_error((t_object *)x, "Could not read jit.matrix %s", name->s_name);
+            return;
+        }
+    } else {
+        if (argc < 2 * n || argc % (2 * n)) {
+            object_error((t_object *)x, "Expected a multiple of 2*%ld=%ld floats for the states, got %ld", n, 2 * n, argc);
+            return;
+        }
+        if (qte_cmatrix_resize(&x->S, n, argc / (2 * n), QTE_COL_MAJOR)) {
+            object_error((t_object *)x, "Memory allocation failed for %ld states", argc / (2 * n));
+            return;
+        }
+        qte_atoms_to_cmatrix(argc, argv, &x->S, QTE_COL_MAJOR);
+    }
+    t = qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+    qte_initstatecalc_compute(x, 1, t);
+}
+
+/* -----------------------------------------------------------------------
+   stats: latencies, bytes and atoms ("stats reset" clears them)
+------------------------------------------------------------------------ */
+void qte_initstatecalc_stats(t_qte_initstatecalc *x, t_symbol *s, long argc, t_atom *argv)
+{
+    qte_stats_message((t_object *)x, &x->stats, x->out_status, argc, argv);
+}
@@ -0,0 +1,186 @@
+/* qte.profiler.c – Latency overview of every qte.* object for Max/MSP
+ *
+ * Every qte.* object times its message handlers in three stages (parse,
+ * compute, output; see t_qte_stats in qte_core.h) and registers the figures
+ * when it is created. qte.profiler reads all of them:
+ *    - bang   : for each live instance and stage, the message
+ *               <class> <id> <stage> count last mean max p99 (ms),
+ *               then <class> <id> bytes <n> atoms <n>
+ *    - report : posts one line per instance to the Max window, the instance
+ *               with the most total time first
+ *    - reset  : clears the counters of every instance
+ * The id is the instance's registration number, unique for the session, so
+ * several objects of the same class can be told apart (route <class> then
+ * route <id>).
+ */
+
+#include "ext.h"
+#include "ext_obex.h"
+#include "qte_core.h"
+#include "qte_core_max.h"
+#include <stdlib.h>
+
+/* ------------------------------------------------------------
+   Our object structure
+   ------------------------------------------------------------ */
+typedef struct _qte_profiler {
+    t_object ob;
+    void *out;      // Outlet pointer
+} t_qte_profiler;
+
+/* Global class pointer */
+static t_class *qte_profiler_class = NULL;
+
+/* ------------------------------------------------------------
+   Function prototypes
+   ------------------------------------------------------------ */
+void *qte_profiler_new(t_symbol *s, long argc, t_atom *argv);
+void qte_profiler_free(t_qte_profiler *x);
+void qte_profiler_assist(t_qte_profiler *x, void *b, long m, long a, char *s);
+void qte_profiler_bang(t_qte_profiler *x);
+void qte_profiler_report(t_qte_profiler *x);
+void qte_profiler_reset(t_qte_profiler *x);
+
+static const char *qte_profiler_stages[QTE_STAGES] = { "parse", "compute", "output" };
+
+/* ------------------------------------------------------------
+   Main entry point, called by Max at load time
+   ------------------------------------------------------------ */
+void ext_main(void *r)
+{
+    t_class *c = class_new("qte.profiler",
+                           (method)qte_profiler_new,
+                           (method)qte_profiler_free,
+                           sizeof(t_qte_profiler),
+                           0L,
+                           A_GIMME,
+                           0);
+
+    class_addmethod(c, (method)qte_profiler_bang,   "bang",   0);
+    class_addmethod(c, (method)qte_profiler_report, "report", 0);
+    class_addmethod(c, (method)qte_profiler_reset,  "reset",  0);
+    class_addmethod(c, (method)qte_profiler_assist, "assist", A_CANT, 0);
+
+    class_register(CLASS_BOX, c);
+    qte_profiler_class = c;
+}
+
+/* ------------------------------------------------------------
+   Create / free
+   ------------------------------------------------------------ */
+void *qte_profiler_new(t_symbol *s, long argc, t_atom *argv)
+{
+    t_qte_profiler *x = (t_qte_profiler *)object_alloc(qte_profiler_class);
+    if (x)
+        x->out = outlet_new(x, NULL);
+    return x;
+}
+
+void qte_profiler_free(t_qte_profiler *x)
+{
+}
+
+/* ------------------------------------------------------------
+   Assist
+   ------------------------------------------------------------ */
+void qte_profiler_assist(t_qte_profiler *x, void *b, long m, long a, char *s)
+{
+    if (m == 1)
+        sprintf(s, "bang: output the stats of every qte.* object, report: post them, reset: clear them");
+    else
+        sprintf(s, "<class> <id> <stage> count last mean max p99 (ms), <class> <id> bytes <n> atoms <n>");
+}
+
+/* ------------------------------------------------------------
+   bang – one message per instance and stage
+   ------------------------------------------------------------ */
+void qte_profiler_bang(t_qte_profiler *x)
+{
+    t_atom a[7];
+    for (t_qte_stats_entry *e = qte_stats_instances(); e; e = e->next) {
+        t_symbol *cls = object_classname(e->obj);
+        const t_qte_stats *st = e->stats;
+        atom_setlong(a, e->id);
+        for (int k = 0; k < QTE_STAGES; k++) {
+            const t_qte_latency *l = &st->stage[k];
+            atom_setsym(a + 1, gensym(qte_profiler_stages[k]));
+            atom_setlong(a + 2, (t_atom_long)l->count);
+            atom_setfloat(a + 3, 1e3 * l->last);
+            atom_setfloat(a + 4, l->count ? 1e3 * l->sum / (double)l->count : 0.0);
+            atom_setfloat(a + 5, 1e3 * l->max);
+            atom_setfloat(a + 6, 1e3 * qte_latency_quantile(l, 0.99));
+            outlet_anything(x->out, cls, 7, a);
+        }
+        atom_setsym(a + 1, gensym("bytes"));
+        atom_setlong(a + 2, (t_atom_long)st->bytes);
+        atom_setsym(a + 3, gensym("atoms"));
+        atom_setlong(a + 4, (t_atom_long)st->atoms);
+        outlet_anything(x->out, cls, 5, a);
+    }
+}
+
+/* ------------------------------------------------------------
+   report – a table in the Max window, most total time first
+   ------------------------------------------------------------ */
+static double qte_profiler_total(const t_qte_stats *st)
+{
+    double total = 0.0;
+    for (int k = 0; k < QTE_STAGES; k++)
+        total += st->stage[k].sum;
+    return total;
+}
+
+static int qte_profiler_compare(const void *a, const void *b)
+{
+    double ta = qte_profiler_total((*(const t_qte_stats_entry **)a)->stats);
+    double tb = qte_profiler_total((*(const t_qte_stats_entry **)b)->stats);
+    return (ta < tb) - (ta > tb);
+}
+
+void qte_profiler_report(t_qte_profiler *x)
+{
+    long count = 0;
+    for (t_qte_stats_entry *e = qte_stats_instances(); e; e = e->next)
+        count++;
+    if (!count) {
+        object_post((t_object *)x, "no qte.* objects");
+        return;
+    }
+    t_qte_stats_entry **sorted = (t_qte_stats_entry **)sysmem_newptr(count * sizeof(*sorted));
+    if (!sorted) {
+        object_error((t_object *)x, "Memory allocation failed");
+        return;
+    }
+    long i = 0;
+    for (t_qte_stats_entry *e = qte_stats_instances(); e; e = e->next)
+        sorted[i++] = e;
+    qsort(sorted, count, sizeof(*sorted), qte_profiler_compare);
+
+    object_post((t_object *)x, "%-18s %4s %10s | %-30s | %-30s | %-30s | %10s %10s",
+                "class", "id", "total ms",
+                "parse n / mean / p99 / max", "compute n / mean / p99 / max", "output n / mean / p99 / max",
+                "bytes", "atoms");
+    for (i = 0; i < count; i++) {
+        const t_qte_stats *st = sorted[i]->stats;
+        char cols[QTE_STAGES][64];
+        for (int k = 0; k < QTE_STAGES; k++) {
+            const t_qte_latency *l = &st->stage[k];
+            snprintf(cols[k], sizeof(cols[k]), "%llu / %.3f / %.3f / %.3f", (unsigned long long)l->count,
+                     l->count ? 1e3 * l->sum / (double)l->count : 0.0,
+                     1e3 * qte_latency_quantile(l, 0.99), 1e3 * l->max);
+        }
+        object_post((t_object *)x, "%-18s %4ld %10.3f | %-30s | %-30s | %-30s | %10llu %10llu",
+                    object_classname(sorted[i]->obj)->s_name, sorted[i]->id, 1e3 * qte_profiler_total(st),
+                    cols[0], cols[1], cols[2], (unsigned long long)st->bytes, (unsigned long long)st->atoms);
+    }
+    sysmem_freeptr(sorted);
+}
+
+/* ------------------------------------------------------------
+   reset – clears every instance's counters
+   ------------------------------------------------------------ */
+void qte_profiler_reset(t_qte_profiler *x)
+{
+    for (t_qte_stats_entry *e = qte_stats_instances(); e; e = e->next)
+        qte_stats_reset(e->stats);
+}
@@ -0,0 +1,278 @@
+/* qte.propagate.c – Krylov-subspace time evolution for Max/MSP
+ *
+ * Takes a Hamiltonian H (n x n) and an initial state psi0 directly and
+ * advances psi(t) = exp(-i H t) psi0 without diagonalizing H: each step
+ * projects H onto the Lanczos (Krylov) basis of the current state, of
+ * @krylov vectors, and exponentiates the small tridiagonal projection. A
+ * basis serves every time step its error estimate keeps within @tolerance
+ * (0 = the default, QTE_PROPAGATE_TOLERANCE); past that the state is advanced and a new basis built, so a step costs
+ * O(n^2 * @krylov) instead of the O(n^3) of a full eigen-decomposition. This
+ * pays off when H changes often or is large and only a short trajectory is
+ * needed; for long trajectories of a fixed H, qte.evolve is cheaper.
+ *
+ *    - H: a list of 2*n*n floats (row-major, real/imag pairs) or a
+ *      "jit_matrix <name>" (2-plane float64, adopts its dimension)
+ *    - "state" followed by 2*n floats (real, imag) of psi0
+ *    - "time_settings tmin tmax tsteps"
+ *
+ * A bang outputs the trajectories in the qte.timedev format: for each
+ * component i in turn, the middle outlet sends the list (i, t0, |psi_i(t0)|,
+ * t1, |psi_i(t1)|, ...) and then the left outlet the list (i, t0,
+ * arg psi_i(t0), t1, arg psi_i(t1), ...).
+ *
+ * The right outlet answers "stats" alone (see qte_stats_message). Parse
+ * covers storing H and psi0, compute the whole Krylov propagation of a bang,
+ * however many bases it builds, and output times each trajectory list.
+ */
+
+#include "ext.h"
+#include "ext_obex.h"
+#include "jit.common.h"
+#include "qte_core.h"
+#include "qte_core_max.h"
+#include <math.h>
+#include <stdlib.h>
+#include <complex.h>
+
+#define QTE_PROPAGATE_TOLERANCE 1e-10   // @tolerance 0: relative error per basis
+
+// Object structure
+typedef struct _qte_propagate {
+    t_object ob;
+    long n;                     // @dim
+    long krylov;                // @krylov, Lanczos basis size
+    double tolerance;           // @tolerance, relative error per basis, 0 = default
+    double tmin;                // time_settings
+    double tmax;
+    long tsteps;
+    void *out_status;           // right: stats
+    void *out_mag;              // middle: magnitude trajectories
+    void *out_phase;            // left: phase trajectories
+
+    t_qte_cmatrix H;            // Hamiltonian (row-major, empty until received)
+    t_qte_cvector psi0;         // initial state
+    t_qte_krylov K;             // Lanczos basis and its scratch
+    t_qte_cmatrix Psi;          // n x tsteps amplitudes
+    t_atom *out_list;           // 1 + 2*tsteps atoms
+    long out_list_size;
+    t_qte_stats stats;          // "stats" message / qte.profiler
+} t_qte_propagate;
+
+static t_class *qte_propagate_class = NULL;
+
+/* Function prototypes */
+void ext_main(void *r);
+void *qte_propagate_new(t_symbol *s, long argc, t_atom *argv);
+void  qte_propagate_free(t_qte_propagate *x);
+void  qte_propagate_assist(t_qte_propagate *x, void *b, long m, long a, char *s);
+void  qte_propagate_list(t_qte_propagate *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_propagate_jit_matrix(t_qte_propagate *x, t_symbol *s);
+void  qte_propagate_state(t_qte_propagate *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_propagate_time_settings(t_qte_propagate *x, double tmin, double tmax, long tsteps);
+void  qte_propagate_bang(t_qte_propagate *x);
+void  qte_propagate_stats(t_qte_propagate *x, t_symbol *s, long argc, t_atom *argv);
+
+/* ----------------------------------------------------------------------------
+   ext_main – class initialization
+---------------------------------------------------------------------------- */
+void ext_main(void *r) {
+    t_class *c = class_new("qte.propagate",
+                           (method)qte_propagate_new,
+                           (method)qte_propagate_free,
+                           sizeof(t_qte_propagate),
+                           0L, A_GIMME, 0);
+
+    class_addmethod(c, (method)qte_propagate_assist, "assist", A_CANT, 0);
+    class_addmethod(c, (method)qte_propagate_list, "list", A_GIMME, 0);
+    class_addmethod(c, (method)qte_propagate_jit_matrix, "jit_matrix", A_SYM, 0);
+    class_addmethod(c, (method)qte_propagate_state, "state", A_GIMME, 0);
+    class_addmethod(c, (method)qte_propagate_time_settings, "time_settings", A_FLOAT, A_FLOAT, A_LONG, 0);
+    class_addmethod(c, (method)qte_propagate_bang, "bang", 0);
+    class_addmethod(c, (method)qte_propagate_stats, "stats", A_GIMME, 0);
+
+    CLASS_ATTR_LONG(c, "dim", 0, t_qte_propagate, n);
+    CLASS_ATTR_FILTER_MIN(c, "dim", 1);
+    CLASS_ATTR_LABEL(c, "dim", 0, "Dimension");
+
+    CLASS_ATTR_LONG(c, "krylov", 0, t_qte_propagate, krylov);
+    CLASS_ATTR_FILTER_MIN(c, "krylov", 1);
+    CLASS_ATTR_LABEL(c, "krylov", 0, "Krylov Basis Size");
+
+    CLASS_ATTR_DOUBLE(c, "tolerance", 0, t_qte_propagate, tolerance);
+    CLASS_ATTR_FILTER_MIN(c, "tolerance", 0.0);
+    CLASS_ATTR_LABEL(c, "tolerance", 0, "Error Tolerance per Basis (0 = default)");
+
+    class_register(CLASS_BOX, c);
+    qte_propagate_class = c;
+}
+
+/* ----------------------------------------------------------------------------
+   Constructor / Destructor
+---------------------------------------------------------------------------- */
+void *qte_propagate_new(t_symbol *s, long argc, t_atom *argv) {
+    t_qte_propagate *x = (t_qte_propagate *)object_alloc(qte_propagate_class);
+    if (x) {
+        // Arguments: [dim], then attributes.
+        long nargs = attr_args_offset(argc, argv);
+        x->n = 8;
+        if (nargs >= 1 && atom_getlong(argv) > 0)
+            x->n = atom_getlong(argv);
+        x->krylov = 30;
+        x->tolerance = QTE_PROPAGATE_TOLERANCE;
+        x->tmin = 0.0;
+        x->tmax = 10.0;
+        x->tsteps = 100;
+
+        qte_cmatrix_init(&x->H);
+        qte_cvector_init(&x->psi0);
+        qte_krylov_init(&x->K);
+        qte_cmatrix_init(&x->Psi);
+        x->out_list = NULL;
+        x->out_list_size = 0;
+
+        // Outlets are created right to left.
+        x->out_status = outlet_new((t_object *)x, NULL);
+        x->out_mag = outlet_new((t_object *)x, NULL);
+        x->out_phase = outlet_new((t_object *)x, NULL);
+        qte_stats_register((t_object *)x, &x->stats);
+        attr_args_process(x, argc, argv);
+    }
+    return x;
+}
+
+void qte_propagate_free(t_qte_propagate *x) {
+    qte_stats_unregister((t_object *)x);
+    qte_cmatrix_free(&x->H);
+    qte_cvector_free(&x->psi0);
+    qte_krylov_free(&x->K);
+    qte_cmatrix_free(&x->Psi);
+    if (x->out_list)
+        sysmem_freeptr(x->out_list);
+}
+
+/* ----------------------------------------------------------------------------
+   Assist method
+---------------------------------------------------------------------------- */
+void qte_propagate_assist(t_qte_propagate *x, void *b, long m, long a, char *s) {
+    if (m == 1)
+        sprintf(s, "bang, state (2*n floats), time_settings, Hamiltonian as list (2*n*n floats) or jit_matrix");
+    else if (a == 0)
+        sprintf(s, "Phase trajectories: i t0 arg psi_i(t0) t1 arg psi_i(t1) ...");
+    else if (a == 1)
+        sprintf(s, "Magnitude trajectories: i t0 |psi_i(t0)| t1 |psi_i(t1)| ...");
+    else
+        sprintf(s, "Status outlet: stats");
+}
+
+/* ----------------------------------------------------------------------------
+   Inputs
+---------------------------------------------------------------------------- */
+/* list – a Hamiltonian of 2*n*n floats (row-major, real/imag pairs). */
+void qte_propagate_list(t_qte_propagate *x, t_symbol *s, long argc, t_atom *argv) {
+    long n = x->n;
+    if (argc != 2 * n * n) {
+        object_error((t_object *)x, "Expected %ld floats for the Hamiltonian, got %ld", 2 * n * n, argc);
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    if (qte_cmatrix_resize(&x->H, n, n, QTE_ROW_MAJOR)) {
+        object_error((t_object *)x, "Memory allocation failed for the Hamiltonian");
+        qte_cmatrix_free(&x->H);
+        return;
+    }
+    qte_atoms_to_cmatrix(argc, argv, &x->H, QTE_ROW_MAJOR);
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+}
+
+/* jit_matrix – a square 2-plane float64 Hamiltonian; adopts its dimension. */
+void qte_propagate_jit_matrix(t_qte_propagate *x, t_symbol *s) {
+    long rows, cols;
+    if (qte_jit_matrix_dims(s, &rows, &cols) || rows != cols || rows < 1) {
+        object_error((t_object *)x, "Expected a square 2-plane float64 jit.matrix");
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    x->H.layout = QTE_ROW_MAJOR;
+    if (qte_jit_matrix_read(s, &x->H)) {
+        object_error((t_object *)x, "Could not read jit.matrix %s", s->s_name);
+        qte_cmatrix_free(&x->H);
+        return;
+    }
+    x->n = rows;
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+}
+
+/* state – the initial state psi0 as 2*n floats (real, imag). */
+void qte_propagate_state(t_qte_propagate *x, t_symbol *s, long argc, t_atom *argv) {
+    long n = x->n;
+    if (argc != 2 * n) {
+        object_error((t_object *)x, "Expected 2*%ld=%ld floats for the initial state", n, 2 * n);
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    if (qte_cvector_resize(&x->psi0, n)) {
+        object_error((t_object *)x, "Memory allocation failed for the initial state");
+        qte_cvector_free(&x->psi0);
+        return;
+    }
+    qte_atoms_to_cvector(argc, argv, &x->psi0);
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+}
+
+void qte_propagate_time_settings(t_qte_propagate *x, double tmin, double tmax, long tsteps) {
+    if (tsteps < 1) {
+        object_error((t_object *)x, "tsteps must be >= 1");
+        return;
+    }
+    x->tmin = tmin;
+    x->tmax = tmax;
+    x->tsteps = tsteps;
+}
+
+/* ----------------------------------------------------------------------------
+   qte_propagate_bang – propagates psi0 over the time steps and outputs
+---------------------------------------------------------------------------- */
+void qte_propagate_bang(t_qte_propagate *x) {
+    long n = x->n;
+    long T = x->tsteps;
+    double dt = (T > 1) ? (x->tmax - x->tmin) / (T - 1) : 0.0;
+    if (!x->H.data || x->H.rows != n) {
+        object_error((t_object *)x, "No %ld x %ld Hamiltonian received", n, n);
+        return;
+    }
+    if (!x->psi0.data || x->psi0.n != n) {
+        object_error((t_object *)x, "No initial state of dimension %ld (use state)", n);
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    if (qte_cmatrix_resize(&x->Psi, n, T, QTE_ROW_MAJOR)) {
+        object_error((t_object *)x, "Memory allocation failed for %ld time steps", T);
+        return;
+    }
+    if (qte_atoms_reserve(&x->out_list, &x->out_list_size, 1 + 2 * T, &x->stats)) {
+        object_error((t_object *)x, "Failed to allocate memory for output list");
+        return;
+    }
+
+    long builds = 0;
+    int info = 0;
+    double tolerance = x->tolerance > 0.0 ? x->tolerance : QTE_PROPAGATE_TOLERANCE;
+    int err = qte_krylov_propagate(&x->K, &x->H, &x->psi0, x->tmin, dt, x->krylov, tolerance,
+                                   &x->Psi, &builds, &info);
+    if (err == QTE_ERR_ALLOC) {
+        object_error((t_object *)x, "Memory allocation failed for the Krylov basis");
+        return;
+    } else if (err == QTE_ERR_CONVERGE) {
+        object_warn((t_object *)x, "Some steps could not meet @tolerance %g", tolerance);
+    } else if (err) {
+        object_error((t_object *)x, "Krylov projection failed: info=%d", info);
+        return;
+    }
+    t = qte_stats_lap(&x->stats, QTE_STAGE_COMPUTE, t);
+    qte_trajectory_lists(&x->Psi, x->tmin, dt, x->out_list, x->out_mag, x->out_phase, &x->stats, t);
+}
+
+/* stats – latencies, bytes and atoms ("stats reset" clears them). */
+void qte_propagate_stats(t_qte_propagate *x, t_symbol *s, long argc, t_atom *argv) {
+    qte_stats_message((t_object *)x, &x->stats, x->out_status, argc, argv);
+}
@@ -0,0 +1,278 @@
+/* qte_bench.c – Standalone benchmark of the qte_core pipeline (no Max SDK)
+ *
+ * Runs the computational stages behind the qte.* externals for a sweep of
+ * dimensions n and time-step counts, and reports per stage:
+ *    - oscillator : H = 0.5*(P^2 + Q^2)                     (qte.quantumho)
+ *    - eigen      : zheevd eigen-decomposition of H          (qte.eigencalc)
+ *    - projection : c = V^H psi0 for a Gaussian wave packet  (qte.initstatecalc)
+ *    - evolution  : |psi_i(t)| and arg psi_i(t) for tsteps   (qte.timedev / qte.timedev~)
+ *                   time steps, as one zgemm V * Phi
+ *
+ * Usage: qte_bench [--nmin N] [--nmax N] [--tsteps T1,T2,...] [--repeat R] [--json]
+ *
+ * n sweeps the powers of two from --nmin (default 8) to --nmax (default 2048);
+ * the oscillator, eigen and projection stages do not depend on tsteps and are
+ * reported once per n. Output is CSV (default) or JSON lines, one record per
+ * (stage, n, tsteps), with the best wall time over --repeat runs, a stage-specific
+ * throughput, the bytes of working storage the stage holds, and the process's
+ * peak resident size so far.
+ */
+
+#include "qte_core.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/resource.h>
+
+#define QTE_BENCH_MAX_TSTEPS 16
+
+typedef struct _qte_bench_opts {
+    long nmin;
+    long nmax;
+    long tsteps[QTE_BENCH_MAX_TSTEPS];
+    long ntsteps;
+    long repeat;
+    int json;
+} t_qte_bench_opts;
+
+/* One measured stage run. */
+typedef struct _qte_bench_result {
+    const char *stage;
+    long n;
+    long tsteps;            // 0 for stages that do not depend on time steps
+    double seconds;         // best of opts->repeat runs
+    double throughput;      // per second, see unit
+    const char *unit;
+    double bytes;           // working storage held by the stage
+} t_qte_bench_result;
+
+static double qte_bench_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+static long qte_bench_peak_rss(void) {
+    struct rusage ru;
+    getrusage(RUSAGE_SELF, &ru);
+#ifdef __APPLE__
+    return (long)ru.ru_maxrss;          // bytes
+#else
+    return (long)ru.ru_maxrss * 1024;   // kilobytes
+#endif
+}
+
+static void qte_bench_report(const t_qte_bench_opts *opts, const t_qte_bench_result *r) {
+    if (opts->json) {
+        printf("{\"stage\":\"%s\",\"n\":%ld,\"tsteps\":%ld,\"seconds\":%.9g,"
+               "\"throughput\":%.6g,\"unit\":\"%s\",\"stage_bytes\":%.0f,\"peak_rss_bytes\":%ld}\n",
+               r->stage, r->n, r->tsteps, r->seconds, r->throughput, r->unit, r->bytes,
+               qte_bench_peak_rss());
+    } else {
+        printf("%s,%ld,%ld,%.9g,%.6g,%s,%.0f,%ld\n", r->stage, r->n, r->tsteps, r->seconds,
+               r->throughput, r->unit, r->bytes, qte_bench_peak_rss());
+    }
+    fflush(stdout);
+}
+
+/* ----------------------------------------------------------------------------
+   Pipeline state, reused across the stages of one n
+---------------------------------------------------------------------------- */
+typedef struct _qte_bench_state {
+    long n;
+    t_qte_cmatrix H;        // row-major Hamiltonian
+    t_qte_cvector p2;       // first column of P^2
+    t_qte_cmatrix A;        // column-major LAPACK input
+    t_qte_cmatrix Z;        // column-major eigenvectors
+    t_qte_eigh_work ws;     // LAPACK workspace, kept across repeats as the externals do
+    double *w;              // eigenvalues
+    t_qte_cmatrix V;        // row-major eigenvectors (as qte.timedev~ stores them)
+    t_qte_cvector psi0;     // initial state
+    t_qte_cvector c;        // its eigenbasis coefficients
+    t_qte_cmatrix Phi;      // m x tsteps phase matrix
+    t_qte_cmatrix Psi;      // n x tsteps amplitudes
+    double *mag;            // n x tsteps magnitudes
+    double *phase;          // n x tsteps phases
+} t_qte_bench_state;
+
+static void qte_bench_state_free(t_qte_bench_state *st) {
+    qte_cmatrix_free(&st->H);
+    qte_cvector_free(&st->p2);
+    qte_cmatrix_free(&st->A);
+    qte_cmatrix_free(&st->Z);
+    qte_eigh_work_free(&st->ws);
+    free(st->w);
+    qte_cmatrix_free(&st->V);
+    qte_cvector_free(&st->psi0);
+    qte_cvector_free(&st->c);
+    qte_cmatrix_free(&st->Phi);
+    qte_cmatrix_free(&st->Psi);
+    free(st->mag);
+    free(st->phase);
+    memset(st, 0, sizeof(*st));
+}
+
+static int qte_bench_oscillator(t_qte_bench_state *st) {
+    long n = st->n;
+    if (qte_cmatrix_resize(&st->H, n, n, QTE_ROW_MAJOR) || qte_cvector_resize(&st->p2, n))
+        return -1;
+    qte_oscillator_p2_column(st->p2.data, n);
+    qte_oscillator_kinetic(&st->H, st->p2.data, 1);
+    qte_oscillator_potential(&st->H, st->p2.data, 1.0);
+    return 0;
+}
+
+static int qte_bench_eigen(t_qte_bench_state *st) {
+    long n = st->n, m = 0;
+    int info = 0;
+    t_qte_eigh_params p = { QTE_ZHEEVD, 1, 'A', 1, n, 0.0, 0.0 };
+    if (!st->w && !(st->w = (double *)malloc(n * sizeof(double))))
+        return -1;
+    if (qte_cmatrix_copy(&st->A, &st->H, QTE_COL_MAJOR))
+        return -1;
+    if (qte_eigh(&p, &st->A, st->w, &st->Z, &m, &st->ws, &info))
+        return -1;
+    return qte_cmatrix_copy(&st->V, &st->Z, QTE_ROW_MAJOR);
+}
+
+static int qte_bench_projection(t_qte_bench_state *st) {
+    long n = st->n;
+    if (qte_cvector_resize(&st->psi0, n))
+        return -1;
+    // Gaussian wave packet centred off-axis, normalized.
+    double norm = 0.0;
+    for (long i = 0; i < n; i++) {
+        double u = (i - 0.3 * n) / (0.05 * n + 1.0);
+        st->psi0.data[i] = exp(-0.5 * u * u) * (cos(0.7 * i) + I * sin(0.7 * i));
+        norm += creal(st->psi0.data[i] * conj(st->psi0.data[i]));
+    }
+    norm = 1.0 / sqrt(norm);
+    for (long i = 0; i < n; i++)
+        st->psi0.data[i] *= norm;
+    return qte_project(&st->V, &st->psi0, &st->c);
+}
+
+static int qte_bench_evolution(t_qte_bench_state *st, long tsteps) {
+    long n = st->n, m = st->V.cols;
+    if (qte_cmatrix_resize(&st->Phi, m, tsteps, QTE_ROW_MAJOR) ||
+        qte_cmatrix_resize(&st->Psi, n, tsteps, QTE_ROW_MAJOR))
+        return -1;
+    free(st->mag);
+    free(st->phase);
+    st->mag = (double *)malloc(n * tsteps * sizeof(double));
+    st->phase = (double *)malloc(n * tsteps * sizeof(double));
+    if (!st->mag || !st->phase)
+        return -1;
+    qte_phase_matrix(&st->Phi, st->w, st->c.data, 0.0, 0.01);
+    if (qte_zgemm(QTE_NOTRANS, QTE_NOTRANS, 1.0, &st->V, &st->Phi, 0.0, &st->Psi))
+        return -1;
+    for (long i = 0; i < n * tsteps; i++) {
+        st->mag[i] = cabs(st->Psi.data[i]);
+        st->phase[i] = carg(st->Psi.data[i]);
+    }
+    return 0;
+}
+
+/* Times call over opts->repeat runs; the best run is kept. */
+#define QTE_BENCH_TIME(opts, best, call)                    \
+    do {                                                    \
+        (best) = INFINITY;                                  \
+        for (long r_ = 0; r_ < (opts)->repeat; r_++) {      \
+            double t0_ = qte_bench_now();                   \
+            if (call)                                       \
+                return -1;                                  \
+            double dt_ = qte_bench_now() - t0_;             \
+            if (dt_ < (best))                               \
+                (best) = dt_;                               \
+        }                                                   \
+    } while (0)
+
+static int qte_bench_run_n(const t_qte_bench_opts *opts, long n) {
+    t_qte_bench_state st;
+    memset(&st, 0, sizeof(st));
+    st.n = n;
+    double cs = sizeof(double complex);
+    t_qte_bench_result r;
+    double best;
+
+    QTE_BENCH_TIME(opts, best, qte_bench_oscillator(&st));
+    r = (t_qte_bench_result){ "oscillator", n, 0, best, n * n / best, "elements/s", (n * n + n) * cs };
+    qte_bench_report(opts, &r);
+
+    QTE_BENCH_TIME(opts, best, qte_bench_eigen(&st));
+    r = (t_qte_bench_result){ "eigen", n, 0, best, 1.0 / best, "decompositions/s",
+                              3 * n * n * cs + n * sizeof(double) };
+    qte_bench_report(opts, &r);
+
+    QTE_BENCH_TIME(opts, best, qte_bench_projection(&st));
+    r = (t_qte_bench_result){ "projection", n, 0, best, n * n / best, "elements/s", (n * n + 2 * n) * cs };
+    qte_bench_report(opts, &r);
+
+    for (long k = 0; k < opts->ntsteps; k++) {
+        long T = opts->tsteps[k];
+        QTE_BENCH_TIME(opts, best, qte_bench_evolution(&st, T));
+        r = (t_qte_bench_result){ "evolution", n, T, best, (double)T / best, "timesteps/s",
+                                  (n * n + 2.0 * n * T) * cs + 2.0 * n * T * sizeof(double) };
+        qte_bench_report(opts, &r);
+    }
+    qte_bench_state_free(&st);
+    return 0;
+}
+
+static void qte_bench_usage(void) {
+    fprintf(stderr, "usage: qte_bench [--nmin N] [--nmax N] [--tsteps T1,T2,...] [--repeat R] [--json]\n");
+}
+
+int main(int argc, char **argv) {
+    t_qte_bench_opts opts = { 8, 2048, { 256, 1024, 4096 }, 3, 3, 0 };
+
+    for (int i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+        if (!strcmp(arg, "--json")) {
+            opts.json = 1;
+        } else if (!strcmp(arg, "--nmin") && val) {
+            opts.nmin = atol(val);
+            i++;
+        } else if (!strcmp(arg, "--nmax") && val) {
+            opts.nmax = atol(val);
+            i++;
+        } else if (!strcmp(arg, "--repeat") && val) {
+            opts.repeat = atol(val);
+            i++;
+        } else if (!strcmp(arg, "--tsteps") && val) {
+            char *list = strdup(val);
+            opts.ntsteps = 0;
+            for (char *tok = strtok(list, ","); tok && opts.ntsteps < QTE_BENCH_MAX_TSTEPS;
+                 tok = strtok(NULL, ","))
+                opts.tsteps[opts.ntsteps++] = atol(tok);
+            free(list);
+            i++;
+        } else {
+            qte_bench_usage();
+            return 1;
+        }
+    }
+    if (opts.nmin < 1 || opts.nmax < opts.nmin || opts.repeat < 1) {
+        qte_bench_usage();
+        return 1;
+    }
+    for (long k = 0; k < opts.ntsteps; k++) {
+        if (opts.tsteps[k] < 1) {
+            qte_bench_usage();
+            return 1;
+        }
+    }
+
+    if (!opts.json)
+        printf("stage,n,tsteps,seconds,throughput,unit,stage_bytes,peak_rss_bytes\n");
+    for (long n = opts.nmin; n <= opts.nmax; n *= 2) {
+        if (qte_bench_run_n(&opts, n)) {
+            fprintf(stderr, "qte_bench: stage failed at n=%ld (out of memory?)\n", n);
+            return 1;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,2556 @@
+/* qte_core.c – Shared numerical core of the qte.* externals (see qte_core.h) */
+
+#include "qte_core.h"
+#include <Accelerate/Accelerate.h>
+#include <dispatch/dispatch.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+/* ----------------------------------------------------------------------------
+   Aligned allocation
+---------------------------------------------------------------------------- */
+static uint64_t qte_alloc_bytes = 0;   // see qte_alloc_total
+
+void *qte_aligned_alloc(size_t bytes) {
+    void *p = NULL;
+    if (bytes == 0)
+        bytes = QTE_ALIGNMENT;
+    if (posix_memalign(&p, QTE_ALIGNMENT, bytes) != 0)
+        return NULL;
+    __atomic_fetch_add(&qte_alloc_bytes, (uint64_t)bytes, __ATOMIC_RELAXED);
+    return p;
+}
+
+void qte_aligned_free(void *p) {
+    free(p);
+}
+
+/* ----------------------------------------------------------------------------
+   Hashing – a multiply/rotate mix over 64-bit words with a murmur-style finalizer.
+---------------------------------------------------------------------------- */
+static inline uint64_t qte_rotl64(uint64_t v, int r) {
+    return (v << r) | (v >> (64 - r));
+}
+
+static inline uint64_t qte_mix64(uint64_t h) {
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+uint64_t qte_hash64(const void *data, size_t bytes, uint64_t seed) {
+    const unsigned char *p = (const unsigned char *)data;
+    uint64_t h = seed ^ (bytes * 0x9e3779b97f4a7c15ULL);
+    size_t words = bytes / 8;
+    for (size_t k = 0; k < words; k++) {
+        uint64_t v;
+        memcpy(&v, p + 8 * k, 8);
+        h ^= qte_rotl64(v * 0x87c37b91114253d5ULL, 31) * 0x4cf5ad432745937fULL;
+        h = qte_rotl64(h, 27) * 5 + 0x52dce729;
+    }
+    uint64_t tail = 0;
+    memcpy(&tail, p + 8 * words, bytes - 8 * words);
+    h ^= qte_mix64(tail);
+    return qte_mix64(h);
+}
+
+/* ----------------------------------------------------------------------------
+   Multicore work (GCD)
+---------------------------------------------------------------------------- */
+long qte_threads(long requested) {
+    if (requested > 0)
+        return requested;
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    return ncpu > 0 ? ncpu : 1;
+}
+
+typedef struct _qte_parallel_job {
+    void *ctx;
+    void (*fn)(void *ctx, long i);
+} t_qte_parallel_job;
+
+static void qte_parallel_trampoline(void *job, size_t i) {
+    t_qte_parallel_job *j = (t_qte_parallel_job *)job;
+    j->fn(j->ctx, (long)i);
+}
+
+void qte_parallel_for(long count, void *ctx, void (*fn)(void *ctx, long i)) {
+    if (count <= 1) {
+        if (count == 1)
+            fn(ctx, 0);
+        return;
+    }
+    t_qte_parallel_job job = { ctx, fn };
+    dispatch_apply_f((size_t)count, dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0),
+                     &job, qte_parallel_trampoline);
+}
+
+/* ----------------------------------------------------------------------------
+   Published slots
+   Sequentially consistent throughout: a reader's pin and its second look at
+   pub, against the writer's publish and its look at the pins, is the one
+   ordering the scheme relies on.
+---------------------------------------------------------------------------- */
+void qte_slots_init(t_qte_slots *s) {
+    memset(s, 0, sizeof(*s));
+    s->pub = -1;
+}
+
+int qte_slots_acquire(t_qte_slots *s) {
+    for (;;) {
+        int i = __atomic_load_n(&s->pub, __ATOMIC_SEQ_CST);
+        if (i < 0)
+            return -1;
+        __atomic_fetch_add(&s->pins[i], 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&s->pub, __ATOMIC_SEQ_CST) == i)
+            return i;
+        // Published over between the load and the pin: the writer may refill it.
+        __atomic_fetch_sub(&s->pins[i], 1, __ATOMIC_SEQ_CST);
+    }
+}
+
+void qte_slots_release(t_qte_slots *s, int i) {
+    __atomic_fetch_sub(&s->pins[i], 1, __ATOMIC_SEQ_CST);
+}
+
+int qte_slots_idle(t_qte_slots *s, int i) {
+    return i != __atomic_load_n(&s->pub, __ATOMIC_SEQ_CST) &&
+           __atomic_load_n(&s->pins[i], __ATOMIC_SEQ_CST) == 0;
+}
+
+int qte_slots_claim(t_qte_slots *s) {
+    for (int i = 0; i < QTE_SLOTS; i++) {
+        if (qte_slots_idle(s, i))
+            return i;
+    }
+    return -1;
+}
+
+void qte_slots_publish(t_qte_slots *s, int i) {
+    s->gen[i] = ++s->count;
+    __atomic_store_n(&s->pub, i, __ATOMIC_SEQ_CST);
+}
+
+/* ----------------------------------------------------------------------------
+   Complex matrices
+---------------------------------------------------------------------------- */
+void qte_cmatrix_init(t_qte_cmatrix *A) {
+    A->rows = 0;
+    A->cols = 0;
+    A->ld = 0;
+    A->layout = QTE_ROW_MAJOR;
+    A->data = NULL;
+    A->capacity = 0;
+}
+
+void qte_cmatrix_free(t_qte_cmatrix *A) {
+    if (A->capacity)
+        qte_aligned_free(A->data);
+    qte_cmatrix_init(A);
+}
+
+int qte_cmatrix_reserve(t_qte_cmatrix *A, long capacity) {
+    if (capacity <= A->capacity)
+        return 0;
+    double complex *data = (double complex *)qte_aligned_alloc(capacity * sizeof(double complex));
+    if (!data)
+        return -1;
+    if (A->capacity)
+        qte_aligned_free(A->data);
+    A->data = data;
+    A->capacity = capacity;
+    return 0;
+}
+
+int qte_cmatrix_reshape(t_qte_cmatrix *A, long rows, long cols, t_qte_layout layout) {
+    if (rows < 0 || cols < 0 || rows * cols > A->capacity)
+        return -1;
+    A->rows = rows;
+    A->cols = cols;
+    A->layout = layout;
+    A->ld = (layout == QTE_ROW_MAJOR) ? cols : rows;
+    if (A->ld < 1)
+        A->ld = 1;
+    return 0;
+}
+
+int qte_cmatrix_resize(t_qte_cmatrix *A, long rows, long cols, t_qte_layout layout) {
+    if (rows < 0 || cols < 0 || qte_cmatrix_reserve(A, rows * cols))
+        return -1;
+    return qte_cmatrix_reshape(A, rows, cols, layout);
+}
+
+void qte_cmatrix_zero(t_qte_cmatrix *A) {
+    if (A->data)
+        memset(A->data, 0, A->rows * A->cols * sizeof(double complex));
+}
+
+int qte_cmatrix_copy(t_qte_cmatrix *dst, const t_qte_cmatrix *src, t_qte_layout layout) {
+    if (dst == src)
+        return -1;
+    if (qte_cmatrix_resize(dst, src->rows, src->cols, layout))
+        return -1;
+    if (src->layout == layout) {
+        // Same layout: copy each contiguous row (or column) at once.
+        long outer = (layout == QTE_ROW_MAJOR) ? src->rows : src->cols;
+        long inner = (layout == QTE_ROW_MAJOR) ? src->cols : src->rows;
+        for (long k = 0; k < outer; k++)
+            memcpy(dst->data + k * dst->ld, src->data + k * src->ld, inner * sizeof(double complex));
+        return 0;
+    }
+    // Layout change: walk the destination contiguously.
+    for (long i = 0; i < src->rows; i++)
+        for (long j = 0; j < src->cols; j++)
+            *qte_cmatrix_at(dst, i, j) = *qte_cmatrix_at(src, i, j);
+    return 0;
+}
+
+/* ----------------------------------------------------------------------------
+   Complex vectors
+---------------------------------------------------------------------------- */
+void qte_cvector_init(t_qte_cvector *v) {
+    v->n = 0;
+    v->data = NULL;
+    v->capacity = 0;
+}
+
+void qte_cvector_free(t_qte_cvector *v) {
+    if (v->capacity)
+        qte_aligned_free(v->data);
+    qte_cvector_init(v);
+}
+
+int qte_cvector_resize(t_qte_cvector *v, long n) {
+    if (n < 0)
+        return -1;
+    if (n > v->capacity) {
+        double complex *data = (double complex *)qte_aligned_alloc(n * sizeof(double complex));
+        if (!data)
+            return -1;
+        if (v->capacity)
+            qte_aligned_free(v->data);
+        v->data = data;
+        v->capacity = n;
+    }
+    v->n = n;
+    return 0;
+}
+
+void qte_cvector_zero(t_qte_cvector *v) {
+    if (v->data)
+        memset(v->data, 0, v->n * sizeof(double complex));
+}
+
+/* ----------------------------------------------------------------------------
+   Packed Hermitian matrices
+---------------------------------------------------------------------------- */
+long qte_packed_dim(long size) {
+    if (size < 1)
+        return -1;
+    long n = (long)((sqrt(8.0 * (double)size + 1.0) - 1.0) / 2.0 + 0.5);
+    return QTE_PACKED_SIZE(n) == size ? n : -1;
+}
+
+int qte_packed_from_cmatrix(t_qte_cvector *AP, const t_qte_cmatrix *A) {
+    long n = A->rows;
+    if (A->cols != n || qte_cvector_resize(AP, QTE_PACKED_SIZE(n)))
+        return QTE_ERR_ALLOC;
+    double complex *ap = AP->data;
+    for (long j = 0; j < n; j++) {
+        for (long i = 0; i <= j; i++)
+            *ap++ = *qte_cmatrix_at(A, i, j);
+    }
+    return 0;
+}
+
+int qte_packed_to_cmatrix(const t_qte_cvector *AP, t_qte_cmatrix *A) {
+    long n = qte_packed_dim(AP->n);
+    if (n < 0 || qte_cmatrix_resize(A, n, n, A->layout))
+        return QTE_ERR_ALLOC;
+    const double complex *ap = AP->data;
+    for (long j = 0; j < n; j++) {
+        for (long i = 0; i < j; i++) {
+            *qte_cmatrix_at(A, i, j) = ap[i];
+            *qte_cmatrix_at(A, j, i) = conj(ap[i]);
+        }
+        *qte_cmatrix_at(A, j, j) = creal(ap[j]);
+        ap += j + 1;
+    }
+    return 0;
+}
+
+/* ----------------------------------------------------------------------------
+   BLAS kernels
+---------------------------------------------------------------------------- */
+static enum CBLAS_TRANSPOSE qte_cblas_op(t_qte_op op) {
+    if (op == QTE_TRANS)
+        return CblasTrans;
+    if (op == QTE_CONJTRANS)
+        return CblasConjTrans;
+    return CblasNoTrans;
+}
+
+static enum CBLAS_ORDER qte_cblas_order(t_qte_layout layout) {
+    return layout == QTE_ROW_MAJOR ? CblasRowMajor : CblasColMajor;
+}
+
+int qte_zgemm(t_qte_op opA, t_qte_op opB, double complex alpha, const t_qte_cmatrix *A,
+              const t_qte_cmatrix *B, double complex beta, t_qte_cmatrix *C) {
+    long m = (opA == QTE_NOTRANS) ? A->rows : A->cols;
+    long k = (opA == QTE_NOTRANS) ? A->cols : A->rows;
+    long kb = (opB == QTE_NOTRANS) ? B->rows : B->cols;
+    long n = (opB == QTE_NOTRANS) ? B->cols : B->rows;
+    if (A->layout != C->layout || B->layout != C->layout || k != kb || C->rows != m || C->cols != n)
+        return -1;
+    if (m == 0 || n == 0)
+        return 0;
+    cblas_zgemm(qte_cblas_order(C->layout), qte_cblas_op(opA), qte_cblas_op(opB),
+                (int)m, (int)n, (int)k, &alpha, A->data, (int)A->ld, B->data, (int)B->ld,
+                &beta, C->data, (int)C->ld);
+    return 0;
+}
+
+int qte_zgemv(t_qte_op opA, double complex alpha, const t_qte_cmatrix *A,
+              const t_qte_cvector *x, double complex beta, t_qte_cvector *y) {
+    long m = (opA == QTE_NOTRANS) ? A->rows : A->cols;
+    long k = (opA == QTE_NOTRANS) ? A->cols : A->rows;
+    if (x->n != k || y->n != m)
+        return -1;
+    if (m == 0)
+        return 0;
+    cblas_zgemv(qte_cblas_order(A->layout), qte_cblas_op(opA), (int)A->rows, (int)A->cols,
+                &alpha, A->data, (int)A->ld, x->data, 1, &beta, y->data, 1);
+    return 0;
+}
+
+int qte_zaxpy(double complex alpha, const t_qte_cvector *x, t_qte_cvector *y) {
+    if (x->n != y->n)
+        return -1;
+    if (x->n > 0)
+        cblas_zaxpy((int)x->n, &alpha, x->data, 1, y->data, 1);
+    return 0;
+}
+
+/* ----------------------------------------------------------------------------
+   Oscillator Hamiltonian
+---------------------------------------------------------------------------- */
+/* Round a double to 5 decimal places. */
+static double qte_round5(double x) {
+    return round(x * 100000.0) / 100000.0;
+}
+
+/* P^2[j][l] = c[(j - l) mod n] with c[r] = (1/n) * sum_m m^2 w^(m r), w = exp(2πi/n).
+   The sum has the closed form (z = w^r != 1, z^n = 1)
+      sum_m m^2 z^m = (2n/(z - 1) + 1 - (n - 1)^2) / (1 - z),
+   so the column costs O(n) instead of two O(n^3) matrix products. */
+void qte_oscillator_p2_column(double complex *p2, long n) {
+    p2[0] = (n - 1) * (2.0 * n - 1) / 6.0;
+    for (long r = 1; r < n; r++) {
+        double angle = 2.0 * M_PI * r / n;
+        double complex z = cos(angle) + I * sin(angle);
+        p2[r] = (2.0 * n / (z - 1.0) + 1.0 - (double)(n - 1) * (n - 1)) / ((1.0 - z) * n);
+    }
+}
+
+typedef struct _qte_kinetic_task {
+    t_qte_cmatrix *H;
+    const double complex *p2;
+    long block;             // rows per task
+} t_qte_kinetic_task;
+
+static void qte_kinetic_rows(void *ctx, long task) {
+    t_qte_kinetic_task *k = (t_qte_kinetic_task *)ctx;
+    long n = k->H->rows;
+    long i1 = (task + 1) * k->block < n ? (task + 1) * k->block : n;
+    for (long i = task * k->block; i < i1; i++) {
+        for (long j = 0; j < n; j++) {
+            double complex val = 0.5 * k->p2[(i - j + n) % n];
+            *qte_cmatrix_at(k->H, i, j) = qte_round5(creal(val)) + I * qte_round5(cimag(val));
+        }
+    }
+}
+
+void qte_oscillator_kinetic(t_qte_cmatrix *H, const double complex *p2, long threads) {
+    long n = H->rows;
+    long tasks = (n >= QTE_PARALLEL_MIN_DIM && threads > 1) ? threads : 1;
+    t_qte_kinetic_task k = { H, p2, (n + tasks - 1) / tasks };
+    qte_parallel_for(tasks, &k, qte_kinetic_rows);
+}
+
+void qte_oscillator_potential(t_qte_cmatrix *H, const double complex *p2, double a) {
+    long n = H->rows;
+    for (long i = 0; i < n; i++) {
+        double q = a * ( -((n - 1) / 2.0) + i );
+        double complex val = 0.5 * (p2[0] + q * q);
+        *qte_cmatrix_at(H, i, i) = qte_round5(creal(val)) + I * qte_round5(cimag(val));
+    }
+}
+
+/* ----------------------------------------------------------------------------
+   Random Hermitian ensembles
+---------------------------------------------------------------------------- */
+#define QTE_RNG_BLOCK 64            // normal pairs transformed per vForce call
+
+static uint64_t qte_splitmix64(uint64_t *x) {
+    uint64_t z = (*x += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+void qte_rng_seed(t_qte_rng *r, uint64_t seed) {
+    for (int k = 0; k < 4; k++)
+        r->s[k] = qte_splitmix64(&seed);
+}
+
+uint64_t qte_rng_next(t_qte_rng *r) {
+    uint64_t *s = r->s;
+    uint64_t result = qte_rotl64(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = qte_rotl64(s[3], 45);
+    return result;
+}
+
+void qte_rng_uniform(t_qte_rng *r, double *u, long count) {
+    for (long i = 0; i < count; i++)
+        u[i] = (double)(qte_rng_next(r) >> 11) * 0x1.0p-53;
+}
+
+/* Box-Muller: pairs (sqrt(-2 ln u1) cos(2 pi u2), sqrt(-2 ln u1) sin(2 pi u2)),
+   with u1 in (0, 1] so the logarithm is finite. */
+void qte_rng_normal(t_qte_rng *r, double *z, long count) {
+    double rad[QTE_RNG_BLOCK], ang[QTE_RNG_BLOCK], c[QTE_RNG_BLOCK], s[QTE_RNG_BLOCK];
+    for (long done = 0; done < count; ) {
+        long pairs = (count - done + 1) / 2;
+        if (pairs > QTE_RNG_BLOCK)
+            pairs = QTE_RNG_BLOCK;
+        int np = (int)pairs;
+        for (long k = 0; k < pairs; k++) {
+            rad[k] = (double)((qte_rng_next(r) >> 11) + 1) * 0x1.0p-53;
+            ang[k] = (double)(qte_rng_next(r) >> 11) * (0x1.0p-53 * 2.0 * M_PI);
+        }
+        vvlog(rad, rad, &np);
+        for (long k = 0; k < pairs; k++)
+            rad[k] *= -2.0;
+        vvsqrt(rad, rad, &np);
+        vvsincos(s, c, ang, &np);
+        for (long k = 0; k < pairs && done < count; k++) {
+            z[done++] = rad[k] * c[k];
+            if (done < count)
+                z[done++] = rad[k] * s[k];
+        }
+    }
+}
+
+int qte_random_hermitian(t_qte_rng *r, t_qte_ensemble e, double scale, t_qte_cmatrix *H) {
+    long n = H->rows;
+    if (H->cols != n || H->layout != QTE_ROW_MAJOR)
+        return QTE_ERR_ALLOC;
+    double off = scale * M_SQRT1_2;
+    for (long i = 0; i < n; i++) {
+        // Row i from the diagonal on, seen as 2 * (n - i) doubles.
+        double complex *row = H->data + i * H->ld + i;
+        double *d = (double *)row;
+        long m = n - i;
+        if (e == QTE_ENSEMBLE_GUE) {
+            // Entry j takes the two variates stored at its own place.
+            qte_rng_normal(r, d, 2 * m);
+            row[0] = scale * d[0];
+            for (long j = 1; j < m; j++)
+                row[j] *= off;
+        } else {
+            // m real variates in d[0 .. m), spread backwards so none is
+            // overwritten before it is read.
+            if (e == QTE_ENSEMBLE_GOE)
+                qte_rng_normal(r, d, m);
+            else
+                qte_rng_uniform(r, d, m);
+            double sd = (e == QTE_ENSEMBLE_GOE) ? scale : 2.0 * scale;
+            double so = (e == QTE_ENSEMBLE_GOE) ? off : scale;
+            for (long j = m - 1; j > 0; j--)
+                row[j] = so * d[j];
+            row[0] = sd * d[0];
+        }
+        for (long j = i + 1; j < n; j++)
+            *qte_cmatrix_at(H, j, i) = conj(*qte_cmatrix_at(H, i, j));
+    }
+    return 0;
+}
+
+/* ----------------------------------------------------------------------------
+   Hermitian eigen-decomposition – each driver runs a workspace query unless
+   ws already holds the sizes for the same problem, then solves in the arrays
+   carved out of ws. zheev/zheevd return the eigenvectors in A, whose storage
+   is then swapped with Z's; zheevr writes the m selected ones into Z.
+---------------------------------------------------------------------------- */
+static void qte_cmatrix_swap(t_qte_cmatrix *A, t_qte_cmatrix *B) {
+    t_qte_cmatrix tmp = *A;
+    *A = *B;
+    *B = tmp;
+}
+
+typedef struct _qte_lapack_ws {
+    __CLPK_doublecomplex *work;
+    __CLPK_doublereal *rwork;
+    __CLPK_integer *iwork;
+    __CLPK_integer *isuppz;
+} t_qte_lapack_ws;
+
+void qte_eigh_work_init(t_qte_eigh_work *ws) {
+    memset(ws, 0, sizeof(*ws));
+}
+
+void qte_eigh_work_free(t_qte_eigh_work *ws) {
+    qte_aligned_free(ws->block);
+    qte_eigh_work_init(ws);
+}
+
+/* Identifies a workspace query: driver tag, jobz, range, n and kd (never 0). */
+static uint64_t qte_eigh_work_key(char tag, char jobz, char range, long n, long kd) {
+    long k[5] = { tag, jobz, range, n, kd };
+    return qte_hash64(k, sizeof(k), 0) | 1;
+}
+
+static void qte_eigh_work_sizes(t_qte_eigh_work *ws, uint64_t key, long lwork, long lrwork,
+                                long liwork, long lisuppz) {
+    ws->key = key;
+    ws->lwork = lwork > 1 ? lwork : 1;
+    ws->lrwork = lrwork > 1 ? lrwork : 1;
+    ws->liwork = liwork > 1 ? liwork : 1;
+    ws->lisuppz = lisuppz;
+}
+
+static size_t qte_align_bytes(size_t bytes) {
+    return (bytes + QTE_ALIGNMENT - 1) & ~(size_t)(QTE_ALIGNMENT - 1);
+}
+
+/* Points a at arrays of the recorded sizes, growing ws->block only when they
+   do not fit. */
+static int qte_eigh_work_carve(t_qte_eigh_work *ws, t_qte_lapack_ws *a) {
+    size_t b0 = qte_align_bytes(ws->lwork * sizeof(__CLPK_doublecomplex));
+    size_t b1 = qte_align_bytes(ws->lrwork * sizeof(__CLPK_doublereal));
+    size_t b2 = qte_align_bytes(ws->liwork * sizeof(__CLPK_integer));
+    size_t b3 = qte_align_bytes(ws->lisuppz * sizeof(__CLPK_integer));
+    if (b0 + b1 + b2 + b3 > ws->capacity) {
+        void *block = qte_aligned_alloc(b0 + b1 + b2 + b3);
+        if (!block)
+            return QTE_ERR_ALLOC;
+        qte_aligned_free(ws->block);
+        ws->block = block;
+        ws->capacity = b0 + b1 + b2 + b3;
+    }
+    char *p = (char *)ws->block;
+    a->work = (__CLPK_doublecomplex *)p;
+    a->rwork = (__CLPK_doublereal *)(p + b0);
+    a->iwork = (__CLPK_integer *)(p + b0 + b1);
+    a->isuppz = (__CLPK_integer *)(p + b0 + b1 + b2);
+    return 0;
+}
+
+static int qte_zheev(const t_qte_eigh_params *p, t_qte_cmatrix *A, double *w, t_qte_eigh_work *ws,
+                     int *info) {
+    char jobz = p->vectors ? 'V' : 'N';
+    char uplo = 'U'; // matrix is stored in the upper triangle
+    __CLPK_integer N = (__CLPK_integer)A->rows;
+    __CLPK_integer LDA = (__CLPK_integer)A->ld, linfo = 0;
+    __CLPK_doublecomplex *a = (__CLPK_doublecomplex *)A->data;
+    uint64_t key = qte_eigh_work_key('h', jobz, 'A', A->rows, A->ld);
+    if (ws->key != key) {
+        __CLPK_integer lwork = -1;
+        __CLPK_doublecomplex work_query;
+        __CLPK_doublereal rwork_query;
+        #pragma clang diagnostic push
+        #pragma clang diagnostic ignored "-Wdeprecated-declarations"
+        zheev_(&jobz, &uplo, &N, a, &LDA, w, &work_query, &lwork, &rwork_query, &linfo);
+        #pragma clang diagnostic pop
+        *info = (int)linfo;
+        if (linfo != 0)
+            return QTE_ERR_QUERY;
+        qte_eigh_work_sizes(ws, key, (long)work_query.r + 1, 3 * A->rows - 2, 0, 0);
+    }
+    t_qte_lapack_ws arr;
+    if (qte_eigh_work_carve(ws, &arr))
+        return QTE_ERR_ALLOC;
+    __CLPK_integer lwork = (__CLPK_integer)ws->lwork;
+
+    #pragma clang diagnostic push
+    #pragma clang diagnostic ignored "-Wdeprecated-declarations"
+    zheev_(&jobz, &uplo, &N, a, &LDA, w, arr.work, &lwork, arr.rwork, &linfo);
+    #pragma clang diagnostic pop
+    *info = (int)linfo;
+    return linfo ? QTE_ERR_SOLVE : 0;
+}
+
+/* zheevd – divide and conquer, much faster than zheev when eigenvectors are wanted. */
+static int qte_zheevd(const t_qte_eigh_params *p, t_qte_cmatrix *A, double *w, t_qte_eigh_work *ws,
+                      int *info) {
+    char jobz = p->vectors ? 'V' : 'N';
+    char uplo = 'U';
+    __CLPK_integer N = (__CLPK_integer)A->rows;
+    __CLPK_integer LDA = (__CLPK_integer)A->ld, linfo = 0;
+    __CLPK_doublecomplex *a = (__CLPK_doublecomplex *)A->data;
+    uint64_t key = qte_eigh_work_key('d', jobz, 'A', A->rows, A->ld);
+    if (ws->key != key) {
+        __CLPK_integer lwork = -1, lrwork = -1, liwork = -1;
+        __CLPK_doublecomplex work_query;
+        __CLPK_doublereal rwork_query;
+        __CLPK_integer iwork_query;
+        #pragma clang diagnostic push
+        #pragma clang diagnostic ignored "-Wdeprecated-declarations"
+        zheevd_(&jobz, &uplo, &N, a, &LDA, w, &work_query, &lwork, &rwork_query, &lrwork,
+                &iwork_query, &liwork, &linfo);
+        #pragma clang diagnostic pop
+        *info = (int)linfo;
+        if (linfo != 0)
+            return QTE_ERR_QUERY;
+        qte_eigh_work_sizes(ws, key, (long)work_query.r + 1, (long)rwork_query + 1, (long)iwork_query, 0);
+    }
+    t_qte_lapack_ws arr;
+    if (qte_eigh_work_carve(ws, &arr))
+        return QTE_ERR_ALLOC;
+    __CLPK_integer lwork = (__CLPK_integer)ws->lwork, lrwork = (__CLPK_integer)ws->lrwork;
+    __CLPK_integer liwork = (__CLPK_integer)ws->liwork;
+
+    #pragma clang diagnostic push
+    #pragma clang diagnostic ignored "-Wdeprecated-declarations"
+    zheevd_(&jobz, &uplo, &N, a, &LDA, w, arr.work, &lwork, arr.rwork, &lrwork, arr.iwork, &liwork,
+            &linfo);
+    #pragma clang diagnostic pop
+    *info = (int)linfo;
+    return linfo ? QTE_ERR_SOLVE : 0;
+}
+
+/* zheevr – MRRR: range 'A' (all), 'I' (indices il..iu, 1-based) or 'V' (values in (vl, vu]). */
+static int qte_zheevr(const t_qte_eigh_params *p, t_qte_cmatrix *A, double *w, t_qte_cmatrix *Z,
+                      long *m, t_qte_eigh_work *ws, int *info) {
+    char jobz = p->vectors ? 'V' : 'N';
+    char range = p->range;
+    char uplo = 'U';
+    __CLPK_integer N = (__CLPK_integer)A->rows;
+    __CLPK_integer LDA = (__CLPK_integer)A->ld, LDZ = N > 1 ? N : 1, linfo = 0;
+    __CLPK_integer il = (__CLPK_integer)p->il, iu = (__CLPK_integer)p->iu, M = N;
+    __CLPK_doublereal vl = p->vl, vu = p->vu, abstol = 0.0;
+    __CLPK_doublecomplex *a = (__CLPK_doublecomplex *)A->data;
+    if (qte_cmatrix_resize(Z, N, N, QTE_COL_MAJOR))
+        return QTE_ERR_ALLOC;
+    __CLPK_doublecomplex *z = (__CLPK_doublecomplex *)Z->data;
+    uint64_t key = qte_eigh_work_key('r', jobz, range, A->rows, A->ld);
+    if (ws->key != key) {
+        __CLPK_integer lwork = -1, lrwork = -1, liwork = -1;
+        __CLPK_doublecomplex work_query;
+        __CLPK_doublereal rwork_query;
+        __CLPK_integer iwork_query, isuppz_query[2];
+        #pragma clang diagnostic push
+        #pragma clang diagnostic ignored "-Wdeprecated-declarations"
+        zheevr_(&jobz, &range, &uplo, &N, a, &LDA, &vl, &vu, &il, &iu, &abstol,
+                &M, w, z, &LDZ, isuppz_query, &work_query, &lwork, &rwork_query, &lrwork,
+                &iwork_query, &liwork, &linfo);
+        #pragma clang diagnostic pop
+        *info = (int)linfo;
+        if (linfo != 0)
+            return QTE_ERR_QUERY;
+        qte_eigh_work_sizes(ws, key, (long)work_query.r + 1, (long)rwork_query + 1, (long)iwork_query,
+                            2 * (A->rows > 1 ? A->rows : 1));
+    }
+    t_qte_lapack_ws arr;
+    if (qte_eigh_work_carve(ws, &arr))
+        return QTE_ERR_ALLOC;
+    __CLPK_integer lwork = (__CLPK_integer)ws->lwork, lrwork = (__CLPK_integer)ws->lrwork;
+    __CLPK_integer liwork = (__CLPK_integer)ws->liwork;
+
+    #pragma clang diagnostic push
+    #pragma clang diagnostic ignored "-Wdeprecated-declarations"
+    zheevr_(&jobz, &range, &uplo, &N, a, &LDA, &vl, &vu, &il, &iu, &abstol,
+            &M, w, z, &LDZ, arr.isuppz, arr.work, &lwork, arr.rwork, &lrwork, arr.iwork, &liwork, &linfo);
+    #pragma clang diagnostic pop
+    *info = (int)linfo;
+    if (linfo != 0)
+        return QTE_ERR_SOLVE;
+    // Only the first m columns hold selected eigenvectors.
+    *m = M;
+    qte_cmatrix_reshape(Z, N, M, QTE_COL_MAJOR);
+    return 0;
+}
+
+static int qte_eigh_solve(const t_qte_eigh_params *p, t_qte_cmatrix *A, double *w, t_qte_cmatrix *Z,
+                          long *m, t_qte_eigh_work *ws, int *info) {
+    if (p->driver == QTE_ZHEEVR || p->range != 'A')
+        return qte_zheevr(p, A, w, Z, m, ws, info);
+
+    int err = (p->driver == QTE_ZHEEVD) ? qte_zheevd(p, A, w, ws, info) : qte_zheev(p, A, w, ws, info);
+    if (err)
+        return err;
+    // The eigenvectors overwrite A; swap storage with Z, so A keeps Z's old
+    // allocation for the next solve instead of the two being freed and reallocated.
+    *m = A->rows;
+    qte_cmatrix_swap(A, Z);
+    return 0;
+}
+
+int qte_eigh(const t_qte_eigh_params *p, t_qte_cmatrix *A, double *w, t_qte_cmatrix *Z,
+             long *m, t_qte_eigh_work *ws, int *info) {
+    *info = 0;
+    if (A->layout != QTE_COL_MAJOR || A->rows != A->cols)
+        return QTE_ERR_ALLOC;
+    t_qte_eigh_work once;
+    qte_eigh_work_init(&once);
+    int err = qte_eigh_solve(p, A, w, Z, m, ws ? ws : &once, info);
+    qte_eigh_work_free(&once);
+    return err;
+}
+
+void qte_eigh_select(const t_qte_eigh_params *p, double *w, t_qte_cmatrix *Z, long *m) {
+    long lo = 0, count = *m;
+    if (p->range == 'I') {
+        lo = p->il - 1;
+        count = p->iu - p->il + 1;
+        if (lo > *m)
+            lo = *m;
+        if (lo + count > *m)
+            count = *m - lo;
+    } else if (p->range == 'V') {
+        while (lo < *m && w[lo] <= p->vl)
+            lo++;
+        count = 0;
+        while (lo + count < *m && w[lo + count] <= p->vu)
+            count++;
+    }
+    if (lo > 0) {
+        memmove(w, w + lo, count * sizeof(double));
+        if (Z->data)
+            memmove(Z->data, Z->data + lo * Z->ld, count * Z->ld * sizeof(double complex));
+    }
+    if (Z->data)
+        qte_cmatrix_reshape(Z, Z->rows, count, QTE_COL_MAJOR);
+    *m = count;
+}
+
+static int qte_zhbevd(const t_qte_eigh_params *p, long kd, t_qte_cmatrix *AB, double *w,
+                      t_qte_cmatrix *Z, t_qte_eigh_work *ws, int *info) {
+    long n = AB->cols;
+    char jobz = p->vectors ? 'V' : 'N';
+    char uplo = 'U';
+    __CLPK_integer N = (__CLPK_integer)n, KD = (__CLPK_integer)kd;
+    __CLPK_integer LDAB = (__CLPK_integer)AB->ld, LDZ = (__CLPK_integer)(n > 0 ? n : 1), linfo = 0;
+    __CLPK_doublecomplex *ab = (__CLPK_doublecomplex *)AB->data;
+    __CLPK_doublecomplex zdummy;
+    __CLPK_doublecomplex *z = p->vectors ? (__CLPK_doublecomplex *)Z->data : &zdummy;
+    uint64_t key = qte_eigh_work_key('b', jobz, 'A', n, kd);
+    if (ws->key != key) {
+        __CLPK_integer lwork = -1, lrwork = -1, liwork = -1;
+        __CLPK_doublecomplex work_query;
+        __CLPK_doublereal rwork_query;
+        __CLPK_integer iwork_query;
+        #pragma clang diagnostic push
+        #pragma clang diagnostic ignored "-Wdeprecated-declarations"
+        zhbevd_(&jobz, &uplo, &N, &KD, ab, &LDAB, w, z, &LDZ, &work_query, &lwork, &rwork_query,
+                &lrwork, &iwork_query, &liwork, &linfo);
+        #pragma clang diagnostic pop
+        *info = (int)linfo;
+        if (linfo != 0)
+            return QTE_ERR_QUERY;
+        qte_eigh_work_sizes(ws, key, (long)work_query.r + 1, (long)rwork_query + 1, (long)iwork_query, 0);
+    }
+    t_qte_lapack_ws arr;
+    if (qte_eigh_work_carve(ws, &arr))
+        return QTE_ERR_ALLOC;
+    __CLPK_integer lwork = (__CLPK_integer)ws->lwork, lrwork = (__CLPK_integer)ws->lrwork;
+    __CLPK_integer liwork = (__CLPK_integer)ws->liwork;
+
+    #pragma clang diagnostic push
+    #pragma clang diagnostic ignored "-Wdeprecated-declarations"
+    zhbevd_(&jobz, &uplo, &N, &KD, ab, &LDAB, w, z, &LDZ, arr.work, &lwork, arr.rwork, &lrwork,
+            arr.iwork, &liwork, &linfo);
+    #pragma clang diagnostic pop
+    *info = (int)linfo;
+    return linfo ? QTE_ERR_SOLVE : 0;
+}
+
+int qte_eigh_band(const t_qte_eigh_params *p, long kd, t_qte_cmatrix *AB, double *w,
+                  t_qte_cmatrix *Z, t_qte_eigh_work *ws, int *info) {
+    long n = AB->cols;
+    *info = 0;
+    if (AB->layout != QTE_COL_MAJOR || AB->rows != kd + 1)
+        return QTE_ERR_ALLOC;
+    if (p->vectors) {
+        if (qte_cmatrix_resize(Z, n, n, QTE_COL_MAJOR))
+            return QTE_ERR_ALLOC;
+    } else {
+        qte_cmatrix_free(Z);
+    }
+    t_qte_eigh_work once;
+    qte_eigh_work_init(&once);
+    int err = qte_zhbevd(p, kd, AB, w, Z, ws ? ws : &once, info);
+    qte_eigh_work_free(&once);
+    return err;
+}
+
+static int qte_zhpevd(const t_qte_eigh_params *p, long n, t_qte_cvector *AP, double *w,
+                      t_qte_cmatrix *Z, t_qte_eigh_work *ws, int *info) {
+    char jobz = p->vectors ? 'V' : 'N';
+    char uplo = 'U';
+    __CLPK_integer N = (__CLPK_integer)n;
+    __CLPK_integer LDZ = (__CLPK_integer)(n > 0 ? n : 1), linfo = 0;
+    __CLPK_doublecomplex *ap = (__CLPK_doublecomplex *)AP->data;
+    __CLPK_doublecomplex zdummy;
+    __CLPK_doublecomplex *z = p->vectors ? (__CLPK_doublecomplex *)Z->data : &zdummy;
+    uint64_t key = qte_eigh_work_key('p', jobz, 'A', n, 0);
+    if (ws->key != key) {
+        __CLPK_integer lwork = -1, lrwork = -1, liwork = -1;
+        __CLPK_doublecomplex work_query;
+        __CLPK_doublereal rwork_query;
+        __CLPK_integer iwork_query;
+        #pragma clang diagnostic push
+        #pragma clang diagnostic ignored "-Wdeprecated-declarations"
+        zhpevd_(&jobz, &uplo, &N, ap, w, z, &LDZ, &work_query, &lwork, &rwork_query, &lrwork,
+                &iwork_query, &liwork, &linfo);
+        #pragma clang diagnostic pop
+        *info = (int)linfo;
+        if (linfo != 0)
+            return QTE_ERR_QUERY;
+        qte_eigh_work_sizes(ws, key, (long)work_query.r + 1, (long)rwork_query + 1, (long)iwork_query, 0);
+    }
+    t_qte_lapack_ws arr;
+    if (qte_eigh_work_carve(ws, &arr))
+        return QTE_ERR_ALLOC;
+    __CLPK_integer lwork = (__CLPK_integer)ws->lwork, lrwork = (__CLPK_integer)ws->lrwork;
+    __CLPK_integer liwork = (__CLPK_integer)ws->liwork;
+
+    #pragma clang diagnostic push
+    #pragma clang diagnostic ignored "-Wdeprecated-declarations"
+    zhpevd_(&jobz, &uplo, &N, ap, w, z, &LDZ, arr.work, &lwork, arr.rwork, &lrwork, arr.iwork, &liwork,
+            &linfo);
+    #pragma clang diagnostic pop
+    *info = (int)linfo;
+    return linfo ? QTE_ERR_SOLVE : 0;
+}
+
+int qte_eigh_packed(const t_qte_eigh_params *p, t_qte_cvector *AP, double *w, t_qte_cmatrix *Z,
+                    t_qte_eigh_work *ws, int *info) {
+    long n = qte_packed_dim(AP->n);
+    *info = 0;
+    if (n < 0)
+        return QTE_ERR_ALLOC;
+    if (p->vectors) {
+        if (qte_cmatrix_resize(Z, n, n, QTE_COL_MAJOR))
+            return QTE_ERR_ALLOC;
+    } else {
+        qte_cmatrix_free(Z);
+    }
+    t_qte_eigh_work once;
+    qte_eigh_work_init(&once);
+    int err = qte_zhpevd(p, n, AP, w, Z, ws ? ws : &once, info);
+    qte_eigh_work_free(&once);
+    return err;
+}
+
+/* ----------------------------------------------------------------------------
+   Block decomposition – union-find over the nonzeros of the upper triangle
+   groups the basis into blocks; each block is copied into R (column-major,
+   one after the other), decomposed there in place, and the eigenpairs of all
+   blocks are merged by value into w and Z.
+---------------------------------------------------------------------------- */
+void qte_eigh_split_init(t_qte_eigh_split *s) {
+    s->count = 0;
+    s->parity = 0;
+    s->perm = s->start = s->root = s->off = NULL;
+    s->wb = NULL;
+    s->buf_n = 0;
+    qte_cmatrix_init(&s->P);
+    qte_cvector_init(&s->R);
+    s->ws = NULL;
+    s->status = NULL;
+    s->ws_n = 0;
+}
+
+void qte_eigh_split_free(t_qte_eigh_split *s) {
+    free(s->perm);      // one allocation for perm, start, root, off and wb
+    qte_cmatrix_free(&s->P);
+    qte_cvector_free(&s->R);
+    for (long k = 0; k < s->ws_n; k++)
+        qte_eigh_work_free(&s->ws[k]);
+    free(s->ws);
+    free(s->status);
+    qte_eigh_split_init(s);
+}
+
+static int qte_split_buf(t_qte_eigh_split *s, long n) {
+    if (s->buf_n >= n)
+        return 0;
+    long *buf = (long *)malloc((4 * n + 1) * sizeof(long) + n * sizeof(double));
+    if (!buf)
+        return QTE_ERR_ALLOC;
+    free(s->perm);
+    s->perm = buf;
+    s->start = buf + n;
+    s->root = buf + 2 * n + 1;
+    s->off = buf + 3 * n + 1;
+    s->wb = (double *)(buf + 4 * n + 1);
+    s->buf_n = n;
+    return 0;
+}
+
+/* One workspace and status pair per thread. */
+static int qte_split_threads(t_qte_eigh_split *s, long tasks) {
+    if (s->ws_n >= tasks)
+        return 0;
+    t_qte_eigh_work *ws = (t_qte_eigh_work *)realloc(s->ws, tasks * sizeof(t_qte_eigh_work));
+    if (!ws)
+        return QTE_ERR_ALLOC;
+    s->ws = ws;
+    int *status = (int *)realloc(s->status, 2 * tasks * sizeof(int));
+    if (!status)
+        return QTE_ERR_ALLOC;
+    s->status = status;
+    for (long k = s->ws_n; k < tasks; k++)
+        qte_eigh_work_init(&s->ws[k]);
+    s->ws_n = tasks;
+    return 0;
+}
+
+/* Roots always carry the smallest index of their tree, so a parent precedes its children. */
+static long qte_split_find(long *root, long i) {
+    while (root[i] != i) {
+        root[i] = root[root[i]];
+        i = root[i];
+    }
+    return i;
+}
+
+static void qte_split_union(long *root, long i, long j) {
+    i = qte_split_find(root, i);
+    j = qte_split_find(root, j);
+    if (i < j)
+        root[j] = i;
+    else if (j < i)
+        root[i] = j;
+}
+
+/* Turns the forest in s->root into blocks (perm, start), numbered by their
+   smallest index, and returns their count. */
+static long qte_split_group(t_qte_eigh_split *s, long n) {
+    long *root = s->root, *start = s->start;
+    long count = 0;
+    // Parents are labelled before their children: root[i] becomes the block number.
+    for (long i = 0; i < n; i++)
+        root[i] = (root[i] == i) ? count++ : root[root[i]];
+    memset(start, 0, (count + 1) * sizeof(long));
+    for (long i = 0; i < n; i++)
+        start[root[i] + 1]++;
+    for (long k = 0; k < count; k++)
+        start[k + 1] += start[k];
+    for (long i = 0; i < n; i++)
+        s->perm[start[root[i]]++] = i;
+    for (long k = count; k > 0; k--)
+        start[k] = start[k - 1];
+    start[0] = 0;
+    s->count = count;
+    return count;
+}
+
+static double qte_split_cost(const t_qte_eigh_split *s) {
+    double cost = 0.0;
+    for (long k = 0; k < s->count; k++) {
+        double b = (double)(s->start[k + 1] - s->start[k]);
+        cost += b * b * b;
+    }
+    return cost;
+}
+
+/* A(i, j) from the upper triangle, the only part LAPACK reads. */
+static inline double complex qte_split_upper(const t_qte_cmatrix *A, long i, long j) {
+    return i <= j ? *qte_cmatrix_at(A, i, j) : conj(*qte_cmatrix_at(A, j, i));
+}
+
+/* Squared threshold below which an entry of A counts as zero. */
+static double qte_split_cut(const t_qte_cmatrix *A, double tol) {
+    double amax = 0.0;
+    for (long j = 0; j < A->cols; j++) {
+        for (long i = 0; i <= j; i++) {
+            double complex a = *qte_cmatrix_at(A, i, j);
+            double a2 = creal(a) * creal(a) + cimag(a) * cimag(a);
+            if (a2 > amax)
+                amax = a2;
+        }
+    }
+    return tol * tol * amax;
+}
+
+static long qte_split_dense(t_qte_eigh_split *s, const t_qte_cmatrix *A, double cut) {
+    long n = A->rows;
+    for (long i = 0; i < n; i++)
+        s->root[i] = i;
+    for (long j = 1; j < n; j++) {
+        for (long i = 0; i < j; i++) {
+            double complex a = *qte_cmatrix_at(A, i, j);
+            if (creal(a) * creal(a) + cimag(a) * cimag(a) > cut)
+                qte_split_union(s->root, i, j);
+        }
+    }
+    return qte_split_group(s, n);
+}
+
+long qte_packed_blocks(t_qte_eigh_split *s, const t_qte_cvector *AP, double tol) {
+    long n = qte_packed_dim(AP->n);
+    if (n < 1 || qte_split_buf(s, n))
+        return -1;
+    double amax = 0.0;
+    for (long k = 0; k < AP->n; k++) {
+        double a2 = creal(AP->data[k]) * creal(AP->data[k]) + cimag(AP->data[k]) * cimag(AP->data[k]);
+        if (a2 > amax)
+            amax = a2;
+    }
+    double cut = tol * tol * amax;
+    for (long i = 0; i < n; i++)
+        s->root[i] = i;
+    const double complex *ap = AP->data;
+    for (long j = 0; j < n; j++, ap++) {
+        for (long i = 0; i < j; i++, ap++) {
+            if (creal(*ap) * creal(*ap) + cimag(*ap) * cimag(*ap) > cut)
+                qte_split_union(s->root, i, j);
+        }
+    }
+    return qte_split_group(s, n);
+}
+
+/* Parity basis vector q = c0 e_i0 + c1 e_i1: the h = n/2 even combinations of
+   e_i and e_{n-1-i}, the middle vector if n is odd, then the h odd ones.
+   Returns the number of nonzeros (1 or 2). */
+static int qte_parity_vector(long n, long q, long *i0, long *i1, double *c0, double *c1) {
+    long h = n / 2, ne = n - h;
+    if (q >= h && q < ne) {
+        *i0 = *i1 = q;
+        *c0 = 1.0;
+        *c1 = 0.0;
+        return 1;
+    }
+    long i = q < h ? q : q - ne;
+    *i0 = i;
+    *i1 = n - 1 - i;
+    *c0 = M_SQRT1_2;
+    *c1 = q < h ? M_SQRT1_2 : -M_SQRT1_2;
+    return 2;
+}
+
+/* Upper triangle of P = U^H A U, two or four entries of A per entry. */
+static int qte_split_rotate(t_qte_eigh_split *s, const t_qte_cmatrix *A) {
+    long n = A->rows;
+    if (qte_cmatrix_resize(&s->P, n, n, QTE_COL_MAJOR))
+        return QTE_ERR_ALLOC;
+    for (long r = 0; r < n; r++) {
+        long j[2];
+        double cj[2];
+        int nj = qte_parity_vector(n, r, j, j + 1, cj, cj + 1);
+        for (long q = 0; q <= r; q++) {
+            long i[2];
+            double ci[2];
+            int ni = qte_parity_vector(n, q, i, i + 1, ci, ci + 1);
+            double complex sum = 0.0;
+            for (int a = 0; a < ni; a++)
+                for (int b = 0; b < nj; b++)
+                    sum += ci[a] * cj[b] * qte_split_upper(A, i[a], j[b]);
+            *qte_cmatrix_at(&s->P, q, r) = sum;
+        }
+    }
+    return 0;
+}
+
+typedef struct _qte_split_task {
+    t_qte_eigh_split *s;
+    const t_qte_cmatrix *M;         // A, or s->P for the parity split
+    t_qte_eigh_params p;            // range 'A', zheev or zheevd
+    long tasks;
+    t_qte_eigh_work *ws;            // the caller's workspace when tasks == 1
+} t_qte_split_task;
+
+/* Copies and decomposes blocks task, task + tasks, ..., in place in R. */
+static void qte_split_solve(void *ctx, long task) {
+    t_qte_split_task *t = (t_qte_split_task *)ctx;
+    t_qte_eigh_split *s = t->s;
+    t_qte_eigh_work *ws = t->tasks > 1 ? &s->ws[task] : t->ws;
+    int *status = t->tasks > 1 ? s->status + 2 * task : s->status;
+    status[0] = status[1] = 0;
+    for (long k = task; k < s->count && !status[0]; k += t->tasks) {
+        const long *idx = s->perm + s->start[k];
+        long b = s->start[k + 1] - s->start[k];
+        t_qte_cmatrix B = { b, b, b, QTE_COL_MAJOR, s->R.data + s->off[k], 0 };
+        for (long c = 0; c < b; c++)
+            for (long r = 0; r <= c; r++)
+                B.data[c * b + r] = qte_split_upper(t->M, idx[r], idx[c]);
+        // zheev/zheevd swap B into Z, so the eigenvectors stay in the block's place in R.
+        t_qte_cmatrix Z;
+        qte_cmatrix_init(&Z);
+        long m;
+        status[0] = qte_eigh_solve(&t->p, &B, s->wb + s->start[k], &Z, &m, ws, status + 1);
+    }
+}
+
+/* Merges the ascending eigenvalues of the blocks into w and, if vectors, the
+   eigenvectors (rotated back from the parity basis) into Z. */
+static int qte_split_merge(t_qte_eigh_split *s, const t_qte_cmatrix *A, int vectors, double *w,
+                           t_qte_cmatrix *Z) {
+    long n = A->rows;
+    long *cur = s->root;
+    if (vectors) {
+        if (qte_cmatrix_resize(Z, n, n, QTE_COL_MAJOR))
+            return QTE_ERR_ALLOC;
+        qte_cmatrix_zero(Z);
+    }
+    for (long k = 0; k < s->count; k++)
+        cur[k] = s->start[k];
+    for (long j = 0; j < n; j++) {
+        long kmin = -1;
+        for (long k = 0; k < s->count; k++) {
+            if (cur[k] < s->start[k + 1] && (kmin < 0 || s->wb[cur[k]] < s->wb[cur[kmin]]))
+                kmin = k;
+        }
+        w[j] = s->wb[cur[kmin]];
+        if (vectors) {
+            long b = s->start[kmin + 1] - s->start[kmin];
+            const long *idx = s->perm + s->start[kmin];
+            const double complex *v = s->R.data + s->off[kmin] + (cur[kmin] - s->start[kmin]) * b;
+            double complex *z = Z->data + j * Z->ld;
+            for (long r = 0; r < b; r++) {
+                if (!s->parity) {
+                    z[idx[r]] = v[r];
+                } else {
+                    long i0, i1;
+                    double c0, c1;
+                    qte_parity_vector(n, idx[r], &i0, &i1, &c0, &c1);
+                    z[i0] += c0 * v[r];
+                    if (i1 != i0)
+                        z[i1] += c1 * v[r];
+                }
+            }
+        }
+        cur[kmin]++;
+    }
+    return 0;
+}
+
+int qte_eigh_blocks(const t_qte_eigh_params *p, t_qte_eigh_split *s, t_qte_cmatrix *A, int parity,
+                    double tol, long threads, double *w, t_qte_cmatrix *Z, long *m,
+                    t_qte_eigh_work *ws, int *info) {
+    long n = A->rows;
+    *info = 0;
+    s->count = 1;
+    s->parity = 0;
+    if (A->layout != QTE_COL_MAJOR || A->cols != n)
+        return QTE_ERR_ALLOC;
+    if (n < 2 || qte_split_buf(s, n))
+        return qte_eigh(p, A, w, Z, m, ws, info);
+
+    // The parity split is kept only when it is cheaper than the plain one.
+    double cut = qte_split_cut(A, tol);
+    qte_split_dense(s, A, cut);
+    if (parity && !qte_split_rotate(s, A)) {
+        double cost = qte_split_cost(s);
+        qte_split_dense(s, &s->P, cut);
+        if (qte_split_cost(s) < cost)
+            s->parity = 1;
+        else
+            qte_split_dense(s, A, cut);
+    }
+    if (s->count == 1 && !s->parity)
+        return qte_eigh(p, A, w, Z, m, ws, info);
+
+    long size = 0;
+    for (long k = 0; k < s->count; k++) {
+        long b = s->start[k + 1] - s->start[k];
+        s->off[k] = size;
+        size += b * b;
+    }
+    long tasks = (n >= QTE_PARALLEL_MIN_DIM && threads > 1) ? threads : 1;
+    if (tasks > s->count)
+        tasks = s->count;
+    if (qte_cvector_resize(&s->R, size) || qte_split_threads(s, tasks))
+        return QTE_ERR_ALLOC;
+    t_qte_eigh_work once;
+    qte_eigh_work_init(&once);
+    t_qte_split_task t = { s, s->parity ? &s->P : A, *p, tasks, ws ? ws : &once };
+    t.p.driver = p->driver == QTE_ZHEEV ? QTE_ZHEEV : QTE_ZHEEVD;
+    t.p.range = 'A';
+    qte_parallel_for(tasks, &t, qte_split_solve);
+    qte_eigh_work_free(&once);
+    for (long k = 0; k < tasks; k++) {
+        if (s->status[2 * k]) {
+            *info = s->status[2 * k + 1];
+            return s->status[2 * k];
+        }
+    }
+    if (qte_split_merge(s, A, p->vectors, w, Z))
+        return QTE_ERR_ALLOC;
+    *m = n;
+    t_qte_cmatrix none;
+    qte_cmatrix_init(&none);
+    qte_eigh_select(p, w, p->vectors ? Z : &none, m);
+    return 0;
+}
+
+/* ----------------------------------------------------------------------------
+   Sparse Hermitian matrices
+---------------------------------------------------------------------------- */
+void qte_csr_init(t_qte_csr *S) {
+    S->n = 0;
+    S->nnz = 0;
+    S->rowptr = NULL;
+    S->col = NULL;
+    S->val = NULL;
+}
+
+void qte_csr_free(t_qte_csr *S) {
+    free(S->rowptr);
+    free(S->col);
+    qte_aligned_free(S->val);
+    qte_csr_init(S);
+}
+
+static int qte_csr_alloc(t_qte_csr *S, long n, long nnz) {
+    qte_csr_free(S);
+    S->rowptr = (long *)malloc((n + 1) * sizeof(long));
+    S->col = (long *)malloc((nnz > 0 ? nnz : 1) * sizeof(long));
+    S->val = (double complex *)qte_aligned_alloc(nnz * sizeof(double complex));
+    if (!S->rowptr || !S->col || !S->val) {
+        qte_csr_free(S);
+        return QTE_ERR_ALLOC;
+    }
+    S->n = n;
+    S->nnz = nnz;
+    return 0;
+}
+
+int qte_csr_copy(t_qte_csr *dst, const t_qte_csr *src) {
+    if (qte_csr_alloc(dst, src->n, src->nnz))
+        return QTE_ERR_ALLOC;
+    memcpy(dst->rowptr, src->rowptr, (src->n + 1) * sizeof(long));
+    memcpy(dst->col, src->col, src->nnz * sizeof(long));
+    memcpy(dst->val, src->val, src->nnz * sizeof(double complex));
+    return 0;
+}
+
+typedef struct _qte_triplet {
+    long row, col, seq;
+    double complex z;
+} t_qte_triplet;
+
+static int qte_triplet_cmp(const void *a, const void *b) {
+    const t_qte_triplet *p = (const t_qte_triplet *)a, *q = (const t_qte_triplet *)b;
+    if (p->row != q->row)
+        return p->row < q->row ? -1 : 1;
+    if (p->col != q->col)
+        return p->col < q->col ? -1 : 1;
+    return p->seq < q->seq ? -1 : (p->seq > q->seq);
+}
+
+int qte_csr_from_triplets(t_qte_csr *S, long n, long count, const long *i, const long *j,
+                          const double complex *z) {
+    t_qte_triplet *t = (t_qte_triplet *)malloc((2 * count > 0 ? 2 * count : 1) * sizeof(t_qte_triplet));
+    if (!t)
+        return QTE_ERR_ALLOC;
+    long nt = 0;
+    for (long k = 0; k < count; k++) {
+        if (i[k] < 0 || i[k] >= n || j[k] < 0 || j[k] >= n) {
+            free(t);
+            return QTE_ERR_ALLOC;
+        }
+        if (i[k] == j[k]) {
+            t[nt++] = (t_qte_triplet){ i[k], j[k], k, creal(z[k]) };
+        } else {
+            t[nt++] = (t_qte_triplet){ i[k], j[k], k, z[k] };
+            t[nt++] = (t_qte_triplet){ j[k], i[k], k, conj(z[k]) };
+        }
+    }
+    qsort(t, nt, sizeof(t_qte_triplet), qte_triplet_cmp);
+    // Sorted by position, then input order: the last of each run wins.
+    long nnz = 0;
+    for (long k = 0; k < nt; k++) {
+        if (k + 1 == nt || t[k + 1].row != t[k].row || t[k + 1].col != t[k].col)
+            t[nnz++] = t[k];
+    }
+    if (qte_csr_alloc(S, n, nnz)) {
+        free(t);
+        return QTE_ERR_ALLOC;
+    }
+    long k = 0;
+    for (long r = 0; r < n; r++) {
+        S->rowptr[r] = k;
+        while (k < nnz && t[k].row == r) {
+            S->col[k] = t[k].col;
+            S->val[k] = t[k].z;
+            k++;
+        }
+    }
+    S->rowptr[n] = nnz;
+    free(t);
+    return 0;
+}
+
+void qte_csr_matvec(const t_qte_csr *S, const double complex *x, double complex *y) {
+    for (long r = 0; r < S->n; r++) {
+        double complex acc = 0.0;
+        for (long k = S->rowptr[r]; k < S->rowptr[r + 1]; k++)
+            acc += S->val[k] * x[S->col[k]];
+        y[r] = acc;
+    }
+}
+
+int qte_csr_to_dense(const t_qte_csr *S, t_qte_cmatrix *A) {
+    if (qte_cmatrix_resize(A, S->n, S->n, A->layout))
+        return QTE_ERR_ALLOC;
+    qte_cmatrix_zero(A);
+    for (long r = 0; r < S->n; r++) {
+        for (long k = S->rowptr[r]; k < S->rowptr[r + 1]; k++)
+            *qte_cmatrix_at(A, r, S->col[k]) = S->val[k];
+    }
+    return 0;
+}
+
+/* ----------------------------------------------------------------------------
+   Lanczos (thick restart)
+   The basis Q holds up to mb vectors with S Q = Q T + b q e^T; T = Q^H S Q is
+   kept as a small real symmetric matrix, filled column by column from the
+   reorthogonalization coefficients, so restarted (arrowhead) and plain
+   (tridiagonal) phases are handled alike. When the basis is full, the lowest
+   kept Ritz vectors replace it and T becomes their diagonal of Ritz values.
+---------------------------------------------------------------------------- */
+#define QTE_LANCZOS_CHECK 10        // Ritz values are checked every this many steps
+#define QTE_LANCZOS_RESTARTS 200
+#define QTE_LANCZOS_PASSES 8        // deflated passes looking for missed degenerate copies
+
+/* Column view of the first cols vectors of the basis Q. */
+static t_qte_cmatrix qte_cmatrix_columns(const t_qte_cmatrix *Q, long cols) {
+    t_qte_cmatrix V = *Q;
+    V.cols = cols;
+    return V;
+}
+
+static double qte_cvector_norm(const t_qte_cvector *v) {
+    return cblas_dznrm2((int)v->n, v->data, 1);
+}
+
+/* Deterministic start (or restart) vector, so repeated solves agree exactly. */
+static void qte_lanczos_random(t_qte_cvector *v, uint64_t seed) {
+    uint64_t s = 0x9e3779b97f4a7c15ULL ^ seed;
+    for (long i = 0; i < v->n; i++) {
+        s = s * 6364136223846793005ULL + 1442695040888963407ULL;
+        double re = (double)(s >> 11) / 9007199254740992.0 - 0.5;
+        s = s * 6364136223846793005ULL + 1442695040888963407ULL;
+        double im = (double)(s >> 11) / 9007199254740992.0 - 0.5;
+        v->data[i] = re + I * im;
+    }
+}
+
+/* Ritz pairs of the leading j x j block of T (ld mb): theta ascending, the
+   eigenvectors in y (j x j column-major). */
+static int qte_lanczos_ritz(const double *T, long mb, long j, double *theta, double *y,
+                            double *work, long lwork, int *info) {
+    for (long c = 0; c < j; c++)
+        memcpy(y + c * j, T + c * mb, j * sizeof(double));
+    char jobz = 'V', uplo = 'U';
+    __CLPK_integer N = (__CLPK_integer)j, LDA = N, LWORK = (__CLPK_integer)lwork, linfo = 0;
+    #pragma clang diagnostic push
+    #pragma clang diagnostic ignored "-Wdeprecated-declarations"
+    dsyev_(&jobz, &uplo, &N, y, &LDA, theta, work, &LWORK, &linfo);
+    #pragma clang diagnostic pop
+    *info = (int)linfo;
+    return linfo ? QTE_ERR_SOLVE : 0;
+}
+
+/* Z = Q(:, 0:j) * y(:, 0:k) with y real (j x k, ld j); Y is complex scratch. */
+static int qte_lanczos_combine(const t_qte_cmatrix *Q, long j, const double *y, long k,
+                               t_qte_cmatrix *Y, t_qte_cmatrix *Z) {
+    t_qte_cmatrix V = qte_cmatrix_columns(Q, j);
+    if (qte_cmatrix_resize(Y, j, k, QTE_COL_MAJOR) || qte_cmatrix_resize(Z, Q->rows, k, QTE_COL_MAJOR))
+        return QTE_ERR_ALLOC;
+    for (long i = 0; i < j * k; i++)
+        Y->data[i] = y[i];
+    return qte_zgemm(QTE_NOTRANS, QTE_NOTRANS, 1.0, &V, Y, 0.0, Z);
+}
+
+typedef struct _qte_lanczos_state {
+    long mb;                // basis capacity
+    long keep;              // Ritz vectors kept across a restart
+    t_qte_cmatrix Q;        // n x mb basis
+    t_qte_cmatrix Y;        // complex copy of Ritz coefficients
+    t_qte_cmatrix R;        // n x keep restart scratch
+    t_qte_cvector v;        // the vector being added
+    t_qte_cvector h;        // its coefficients along Q
+    double *T;              // mb x mb projection Q^H S Q
+    double *y;              // mb x mb Ritz coefficients
+    double *theta;          // Ritz values
+    double *work;           // dsyev workspace
+    long lwork;
+    const t_qte_cmatrix *L; // locked Ritz vectors the basis is kept orthogonal to
+    long nlock;             // their number (0 = none)
+} t_qte_lanczos_state;
+
+/* v -= Q(:, 0:j) Q(:, 0:j)^H v, twice ("twice is enough"), after the same for
+   the locked vectors; T column j (if not NULL) accumulates the coefficients
+   along Q. */
+static void qte_lanczos_orthogonalize(t_qte_lanczos_state *st, long j, double *Tcol) {
+    t_qte_cmatrix V = qte_cmatrix_columns(&st->Q, j);
+    t_qte_cvector hv = st->h;
+    for (int pass = 0; pass < 2; pass++) {
+        if (st->nlock) {
+            t_qte_cmatrix Lv = qte_cmatrix_columns(st->L, st->nlock);
+            hv.n = st->nlock;
+            qte_zgemv(QTE_CONJTRANS, 1.0, &Lv, &st->v, 0.0, &hv);
+            qte_zgemv(QTE_NOTRANS, -1.0, &Lv, &hv, 1.0, &st->v);
+        }
+        if (!j)
+            continue;
+        hv.n = j;
+        qte_zgemv(QTE_CONJTRANS, 1.0, &V, &st->v, 0.0, &hv);
+        qte_zgemv(QTE_NOTRANS, -1.0, &V, &hv, 1.0, &st->v);
+        for (long i = 0; Tcol && i < j; i++)
+            Tcol[i] += creal(hv.data[i]);
+    }
+}
+
+/* Thick restart from the Ritz pairs (theta, y) of the full basis: the lowest
+   st->keep Ritz vectors become the basis and T their diagonal of Ritz values. */
+static int qte_lanczos_restart(t_qte_lanczos_state *st) {
+    long n = st->Q.rows, mb = st->mb, keep = st->keep;
+    if (qte_lanczos_combine(&st->Q, mb, st->y, keep, &st->Y, &st->R))
+        return QTE_ERR_ALLOC;
+    memcpy(st->Q.data, st->R.data, keep * n * sizeof(double complex));
+    memset(st->T, 0, mb * mb * sizeof(double));
+    for (long i = 0; i < keep; i++)
+        st->T[i * mb + i] = st->theta[i];
+    return 0;
+}
+
+/* One Lanczos run for the lowest k eigenpairs of S in the complement of the
+   locked vectors: w and the n x k Ritz vectors Z. */
+static int qte_lanczos_run(t_qte_lanczos_state *st, const t_qte_csr *S, long k, double tol,
+                           double *w, t_qte_cmatrix *Z, long *steps, int *info) {
+    long n = S->n, mb = st->mb, j = 0, restarts = 0;
+    double *T = st->T, *y = st->y;
+    double anorm = 1e-300;          // running estimate of ||S||
+
+    qte_lanczos_random(&st->v, (uint64_t)*steps);
+    qte_lanczos_orthogonalize(st, 0, NULL);
+    cblas_zdscal((int)n, 1.0 / qte_cvector_norm(&st->v), st->v.data, 1);
+    memcpy(st->Q.data, st->v.data, n * sizeof(double complex));
+
+    while (1) {
+        // Extend the basis by one vector: v = S q_j minus its components along Q.
+        qte_csr_matvec(S, st->Q.data + j * n, st->v.data);
+        memset(T + j * mb, 0, (j + 1) * sizeof(double));
+        qte_lanczos_orthogonalize(st, j + 1, T + j * mb);
+        for (long i = 0; i < j; i++)
+            T[i * mb + j] = T[j * mb + i];
+        double b = qte_cvector_norm(&st->v);
+        double an = fabs(T[j * mb + j]) + b;
+        if (an > anorm)
+            anorm = an;
+        j++;
+        (*steps)++;
+        // The basis spans an invariant subspace (b negligible against tol): its Ritz
+        // pairs are exact, but copies of degenerate eigenvalues lie outside it, so
+        // continue from a fresh vector.
+        int invariant = b <= 0.1 * tol * anorm;
+
+        if (j == mb || (j >= k && !invariant && j % QTE_LANCZOS_CHECK == 0)) {
+            int err = qte_lanczos_ritz(T, mb, j, st->theta, y, st->work, st->lwork, info);
+            if (err)
+                return err;
+            // An invariant basis is converged only once it fills the complement.
+            int converged = !invariant || j + st->nlock == n;
+            for (long i = 0; i < k && converged; i++) {
+                double scale = fabs(st->theta[i]) > 1.0 ? fabs(st->theta[i]) : 1.0;
+                converged = fabs(b * y[i * j + j - 1]) <= tol * scale;
+            }
+            if (converged || restarts == QTE_LANCZOS_RESTARTS) {
+                memcpy(w, st->theta, k * sizeof(double));
+                if (qte_lanczos_combine(&st->Q, j, y, k, &st->Y, Z))
+                    return QTE_ERR_ALLOC;
+                return converged ? 0 : QTE_ERR_CONVERGE;
+            }
+            if (j == mb) {
+                if (qte_lanczos_restart(st))
+                    return QTE_ERR_ALLOC;
+                j = st->keep;
+                restarts++;
+            }
+        }
+        if (invariant) {
+            qte_lanczos_random(&st->v, (uint64_t)*steps);
+            qte_lanczos_orthogonalize(st, j, NULL);
+            b = qte_cvector_norm(&st->v);
+        }
+        double complex *qn = st->Q.data + j * n;
+        for (long i = 0; i < n; i++)
+            qn[i] = st->v.data[i] / b;
+    }
+}
+
+/* Basis capacity mb for k wanted pairs: the wanted Ritz vectors and half of
+   the rest are kept across a restart. */
+static void qte_lanczos_size(t_qte_lanczos_state *st, long mb, long k) {
+    st->mb = mb < k ? k : mb;
+    st->keep = k + (st->mb - k) / 2;
+    if (st->keep >= st->mb)
+        st->keep = st->mb - 1;
+}
+
+/* Merges the kp pairs (wp, P) of a deflated pass into the k locked pairs
+   (w, Z), keeping the lowest k in ascending order. */
+static int qte_lanczos_merge(t_qte_lanczos_state *st, double *w, t_qte_cmatrix *Z, long k,
+                             const double *wp, const t_qte_cmatrix *P, long kp, double *wm) {
+    long n = Z->rows;
+    if (qte_cmatrix_resize(&st->R, n, k, QTE_COL_MAJOR))
+        return QTE_ERR_ALLOC;
+    for (long i = 0, a = 0, b = 0; i < k; i++) {
+        int take_p = b < kp && (a == k || wp[b] < w[a]);
+        const double complex *src = take_p ? qte_cmatrix_at(P, 0, b) : qte_cmatrix_at(Z, 0, a);
+        wm[i] = take_p ? wp[b++] : w[a++];
+        memcpy(qte_cmatrix_at(&st->R, 0, i), src, n * sizeof(double complex));
+    }
+    memcpy(w, wm, k * sizeof(double));
+    for (long i = 0; i < k; i++)
+        memcpy(qte_cmatrix_at(Z, 0, i), qte_cmatrix_at(&st->R, 0, i), n * sizeof(double complex));
+    return 0;
+}
+
+int qte_lanczos(const t_qte_csr *S, long k, long maxbasis, double tol, int vectors, double *w,
+                t_qte_cmatrix *Z, long *steps, int *info) {
+    long n = S->n;
+    *info = 0;
+    *steps = 0;
+    if (k < 1 || k > n)
+        return QTE_ERR_ALLOC;
+    t_qte_lanczos_state st;
+    memset(&st, 0, sizeof(st));
+    st.mb = maxbasis > 0 ? maxbasis : ((2 * k + 20 > 40) ? 2 * k + 20 : 40);
+    if (st.mb > n)
+        st.mb = n;
+    qte_lanczos_size(&st, st.mb, k);
+    st.lwork = 3 * st.mb;
+
+    long mb = st.mb;
+    double *rbuf = (double *)calloc(2 * mb * mb + mb + st.lwork + 2 * k, sizeof(double));
+    t_qte_cmatrix P;
+    qte_cmatrix_init(&P);
+    int err = QTE_ERR_ALLOC;
+    if (rbuf && !qte_cmatrix_resize(&st.Q, n, mb, QTE_COL_MAJOR) &&
+        !qte_cvector_resize(&st.v, n) && !qte_cvector_resize(&st.h, mb)) {
+        st.T = rbuf;
+        st.y = st.T + mb * mb;
+        st.theta = st.y + mb * mb;
+        st.work = st.theta + mb;
+        double *wp = st.work + st.lwork, *wm = wp + k;
+        err = qte_lanczos_run(&st, S, k, tol, w, Z, steps, info);
+        // A start vector reaches one copy of a degenerate eigenvalue (more only
+        // through rounding and the invariant-subspace restarts), and the
+        // residuals cannot tell that one is missing. So lock the k pairs found
+        // and run again from a fresh vector orthogonal to them: anything below
+        // w[k-1] it finds was missed and is merged in, until a pass finds none.
+        // A pass that fails leaves (w, Z) as the pairs converged so far.
+        long pass = 0;
+        for (; !err && k < n && pass < QTE_LANCZOS_PASSES; pass++) {
+            long kp = (n - k < k) ? n - k : k;
+            st.L = Z;
+            st.nlock = k;
+            qte_lanczos_size(&st, (mb < n - k) ? mb : n - k, kp);
+            if (qte_lanczos_run(&st, S, kp, tol, wp, &P, steps, info)) {
+                err = QTE_ERR_DEFLATE;
+                break;
+            }
+            double scale = fabs(w[k - 1]) > 1.0 ? fabs(w[k - 1]) : 1.0;
+            if (wp[0] >= w[k - 1] - tol * scale)
+                break;
+            if (qte_lanczos_merge(&st, w, Z, k, wp, &P, kp, wm))
+                err = QTE_ERR_DEFLATE;
+        }
+        if (!err && pass == QTE_LANCZOS_PASSES)
+            err = QTE_ERR_DEFLATE;
+        if (!vectors)
+            qte_cmatrix_free(Z);
+    }
+    qte_cmatrix_free(&P);
+    qte_cmatrix_free(&st.Q);
+    qte_cmatrix_free(&st.Y);
+    qte_cmatrix_free(&st.R);
+    qte_cvector_free(&st.v);
+    qte_cvector_free(&st.h);
+    free(rbuf);
+    return err;
+}
+
+/* ----------------------------------------------------------------------------
+   Eigenpair tracking
+---------------------------------------------------------------------------- */
+#define QTE_TRACK_GATE 0.3      // largest |B_jk| / |E_k - E_j| a correction may take
+
+void qte_eigh_tracker_init(t_qte_eigh_tracker *t) {
+    qte_cmatrix_init(&t->W);
+    qte_cmatrix_init(&t->B);
+    qte_cmatrix_init(&t->K);
+    t->buf = NULL;
+    t->buf_n = 0;
+}
+
+void qte_eigh_tracker_free(t_qte_eigh_tracker *t) {
+    qte_cmatrix_free(&t->W);
+    qte_cmatrix_free(&t->B);
+    qte_cmatrix_free(&t->K);
+    free(t->buf);
+    qte_eigh_tracker_init(t);
+}
+
+/* Scratch of n pivots, n permutation entries and n doubles. */
+static int qte_eigh_tracker_buf(t_qte_eigh_tracker *t, long n) {
+    if (t->buf_n >= n)
+        return 0;
+    void *buf = malloc(n * (sizeof(__CLPK_integer) + sizeof(long) + sizeof(double)));
+    if (!buf)
+        return QTE_ERR_ALLOC;
+    free(t->buf);
+    t->buf = buf;
+    t->buf_n = n;
+    return 0;
+}
+
+int qte_eigh_track(t_qte_eigh_tracker *t, const t_qte_cmatrix *H, double *w, t_qte_cmatrix *V,
+                   double tol, int maxiter, int *iters) {
+    long n = H->rows;
+    *iters = 0;
+    if (H->layout != QTE_COL_MAJOR || V->layout != QTE_COL_MAJOR || H->cols != n ||
+        V->rows != n || V->cols != n)
+        return QTE_ERR_ALLOC;
+    if (qte_cmatrix_resize(&t->W, n, n, QTE_COL_MAJOR) ||
+        qte_cmatrix_resize(&t->B, n, n, QTE_COL_MAJOR) ||
+        qte_cmatrix_resize(&t->K, n, n, QTE_COL_MAJOR) || qte_eigh_tracker_buf(t, n))
+        return QTE_ERR_ALLOC;
+    __CLPK_integer *ipiv = (__CLPK_integer *)t->buf;
+    double *shift = (double *)((long *)(ipiv + t->buf_n) + t->buf_n);
+
+    for (int it = 0;; it++) {
+        // Rayleigh-Ritz: B = V^H (H V).
+        qte_zgemm(QTE_NOTRANS, QTE_NOTRANS, 1.0, H, V, 0.0, &t->W);
+        qte_zgemm(QTE_CONJTRANS, QTE_NOTRANS, 1.0, V, &t->W, 0.0, &t->B);
+        double scale = 0.0, res = 0.0;
+        for (long k = 0; k < n; k++) {
+            w[k] = creal(t->B.data[k * n + k]);
+            if (fabs(w[k]) > scale)
+                scale = fabs(w[k]);
+        }
+        if (scale == 0.0)
+            scale = 1.0;
+        for (long k = 0; k < n; k++) {
+            double r = 0.0;
+            const double complex *col = t->B.data + k * n;
+            for (long j = 0; j < n; j++) {
+                if (j != k)
+                    r += creal(col[j] * conj(col[j]));
+            }
+            if (r > res)
+                res = r;
+        }
+        if (sqrt(res) <= tol * scale)
+            return 0;
+        if (it == maxiter)
+            return QTE_ERR_CONVERGE;
+
+        // First-order correction K (anti-Hermitian, zero diagonal), built into
+        // the Cayley system (I - K/2) Q = (I + K/2): K holds the left side, B the right.
+        // Couplings below `negligible` are left alone; together they stay under tol / 4.
+        double negligible = 0.25 * tol * scale / sqrt((double)n);
+        double knorm = 0.0;
+        for (long k = 0; k < n; k++) {
+            shift[k] = 0.0;
+            for (long j = 0; j < n; j++) {
+                double complex kjk = 0.0;
+                if (j != k) {
+                    double complex b = t->B.data[k * n + j];
+                    double gap = w[k] - w[j];
+                    if (cabs(b) > negligible) {
+                        if (cabs(b) > QTE_TRACK_GATE * fabs(gap))
+                            return QTE_ERR_CONVERGE;
+                        kjk = b / gap;
+                        knorm += creal(kjk * conj(kjk));
+                        shift[k] += creal(b * conj(b)) / gap;
+                    }
+                }
+                double complex delta = (j == k) ? 1.0 : 0.0;
+                t->K.data[k * n + j] = delta - 0.5 * kjk;
+                t->B.data[k * n + j] = delta + 0.5 * kjk;
+            }
+        }
+        __CLPK_integer N = (__CLPK_integer)n, linfo = 0;
+        #pragma clang diagnostic push
+        #pragma clang diagnostic ignored "-Wdeprecated-declarations"
+        zgesv_(&N, &N, (__CLPK_doublecomplex *)t->K.data, &N, ipiv,
+               (__CLPK_doublecomplex *)t->B.data, &N, &linfo);
+        #pragma clang diagnostic pop
+        if (linfo != 0)
+            return QTE_ERR_CONVERGE;
+        // V <- V Q
+        qte_zgemm(QTE_NOTRANS, QTE_NOTRANS, 1.0, V, &t->B, 0.0, &t->W);
+        qte_cmatrix_swap(V, &t->W);
+        (*iters)++;
+        // The correction leaves couplings of second order, below |K|_F times the
+        // residual; when that is already within tolerance, skip the check's two
+        // zgemm and take the eigenvalues to second order instead.
+        if (sqrt(knorm) * sqrt(res) <= 0.5 * tol * scale) {
+            for (long k = 0; k < n; k++)
+                w[k] += shift[k];
+            return 0;
+        }
+    }
+}
+
+int qte_eigh_align(t_qte_eigh_tracker *t, const t_qte_cmatrix *Vprev, double *w, t_qte_cmatrix *Z) {
+    long n = Z->rows;
+    if (Vprev->layout != QTE_COL_MAJOR || Z->layout != QTE_COL_MAJOR || Vprev->rows != n ||
+        Vprev->cols != n || Z->cols != n)
+        return QTE_ERR_ALLOC;
+    if (qte_cmatrix_resize(&t->B, n, n, QTE_COL_MAJOR) ||
+        qte_cmatrix_resize(&t->K, n, n, QTE_COL_MAJOR) || qte_eigh_tracker_buf(t, n))
+        return QTE_ERR_ALLOC;
+    long *perm = (long *)((__CLPK_integer *)t->buf + t->buf_n);
+    double *wtmp = (double *)(perm + t->buf_n);
+    // Overlaps O(k, j) = <vprev_k, z_j>.
+    qte_zgemm(QTE_CONJTRANS, QTE_NOTRANS, 1.0, Vprev, Z, 0.0, &t->B);
+
+    // Greedy matching, one previous eigenvector after the other; perm[j] = -1 marks
+    // a new eigenvector as still free.
+    for (long j = 0; j < n; j++)
+        perm[j] = -1;
+    for (long k = 0; k < n; k++) {
+        long best = -1;
+        double best_mag = -1.0;
+        for (long j = 0; j < n; j++) {
+            double mag = cabs(t->B.data[j * n + k]);
+            if (perm[j] < 0 && mag > best_mag) {
+                best = j;
+                best_mag = mag;
+            }
+        }
+        perm[best] = k;
+        double complex o = t->B.data[best * n + k];
+        double complex phase = best_mag > 0.0 ? conj(o) / best_mag : 1.0;
+        const double complex *src = Z->data + best * Z->ld;
+        double complex *dst = t->K.data + k * n;
+        for (long i = 0; i < n; i++)
+            dst[i] = src[i] * phase;
+        wtmp[k] = w[best];
+    }
+    memcpy(w, wtmp, n * sizeof(double));
+    qte_cmatrix_swap(Z, &t->K);
+    return 0;
+}
+
+/* ----------------------------------------------------------------------------
+   Projection and time evolution
+---------------------------------------------------------------------------- */
+int qte_project(const t_qte_cmatrix *V, const t_qte_cvector *psi0, t_qte_cvector *c) {
+    if (qte_cvector_resize(c, V->cols))
+        return QTE_ERR_ALLOC;
+    return qte_zgemv(QTE_CONJTRANS, 1.0, V, psi0, 0.0, c);
+}
+
+typedef struct _qte_weight {
+    double w;
+    long k;
+} t_qte_weight;
+
+static int qte_weight_cmp(const void *a, const void *b) {
+    const t_qte_weight *x = (const t_qte_weight *)a, *y = (const t_qte_weight *)b;
+    if (x->w != y->w)
+        return x->w < y->w ? 1 : -1;
+    return (x->k > y->k) - (x->k < y->k);
+}
+
+static int qte_index_cmp(const void *a, const void *b) {
+    long x = *(const long *)a, y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+long qte_truncate_weight(const double complex *c, long n, double tol, long maxterms,
+                         long *idx, double *dropped) {
+    t_qte_weight *order = (t_qte_weight *)malloc(n * sizeof(t_qte_weight));
+    if (n && !order)
+        return QTE_ERR_ALLOC;
+    double total = 0.0;
+    for (long k = 0; k < n; k++) {
+        order[k].w = creal(c[k]) * creal(c[k]) + cimag(c[k]) * cimag(c[k]);
+        order[k].k = k;
+        total += order[k].w;
+    }
+    qsort(order, n, sizeof(t_qte_weight), qte_weight_cmp);
+    long cap = (maxterms > 0 && maxterms < n) ? maxterms : n;
+    double target = (tol > 0.0) ? (1.0 - tol) * total : total;
+    double kept = 0.0;
+    long m = 0;
+    while (m < cap && (tol <= 0.0 || kept < target || m == 0)) {
+        kept += order[m].w;
+        idx[m] = order[m].k;
+        m++;
+    }
+    free(order);
+    qsort(idx, m, sizeof(long), qte_index_cmp);
+    *dropped = (m < n && total > kept) ? (total - kept) / total : 0.0;
+    return m;
+}
+
+void qte_phase_matrix(t_qte_cmatrix *Phi, const double *E, const double complex *c,
+                      double t0, double dt) {
+    long m = Phi->rows, T = Phi->cols;
+    // Step between consecutive time steps (s) and eigenpairs (k) in memory.
+    long sstep = (Phi->layout == QTE_ROW_MAJOR) ? 1 : Phi->ld;
+    long kstep = (Phi->layout == QTE_ROW_MAJOR) ? Phi->ld : 1;
+    for (long k = 0; k < m; k++) {
+        double complex *row = Phi->data + k * kstep;
+        double ph = -E[k] * dt;
+        double complex rk = cos(ph) + I * sin(ph);
+        double complex zk = 0.0;
+        for (long s = 0; s < T; s++) {
+            if (s % QTE_PHASE_ANCHOR == 0) {
+                ph = -E[k] * (t0 + s * dt);
+                zk = c[k] * (cos(ph) + I * sin(ph));
+            }
+            row[s * sstep] = zk;
+            zk *= rk;
+        }
+    }
+}
+
+#define QTE_PHASE_BLOCK 256     // eigenpairs per vvsincos call
+
+void qte_phase_columns(t_qte_cmatrix *Phi, const double *E, const double complex *c,
+                       const double *t) {
+    double ang[QTE_PHASE_BLOCK], sn[QTE_PHASE_BLOCK], cs[QTE_PHASE_BLOCK];
+    long m = Phi->rows, T = Phi->cols;
+    long sstep = (Phi->layout == QTE_ROW_MAJOR) ? 1 : Phi->ld;
+    long kstep = (Phi->layout == QTE_ROW_MAJOR) ? Phi->ld : 1;
+    for (long s = 0; s < T; s++) {
+        double complex *col = Phi->data + s * sstep;
+        for (long k0 = 0; k0 < m; k0 += QTE_PHASE_BLOCK) {
+            int nb = (int)(m - k0 < QTE_PHASE_BLOCK ? m - k0 : QTE_PHASE_BLOCK);
+            for (long k = 0; k < nb; k++)
+                ang[k] = -E[k0 + k] * t[s];
+            vvsincos(sn, cs, ang, &nb);
+            for (long k = 0; k < nb; k++)
+                col[(k0 + k) * kstep] = c[k0 + k] * (cs[k] + I * sn[k]);
+        }
+    }
+}
+
+/* The tiles of qte_trajectories: pass 1 fills rows of Phi, pass 2 computes
+   the Psi tile of one (component block, time block) pair. */
+typedef struct _qte_traj_task {
+    const t_qte_cmatrix *V;
+    const double *E;
+    const double complex *c;
+    double t0, dt;
+    t_qte_cmatrix *Phi, *Psi;
+    int polar;
+    long kblock;            // Phi rows per pass 1 task
+    long rchunks, rblock;   // component blocks of Psi
+    long tblock;            // time steps per block
+} t_qte_traj_task;
+
+static void qte_traj_phase(void *ctx, long task) {
+    t_qte_traj_task *q = (t_qte_traj_task *)ctx;
+    long m = q->Phi->rows;
+    long k0 = task * q->kblock;
+    long k1 = k0 + q->kblock < m ? k0 + q->kblock : m;
+    if (k0 >= k1)
+        return;
+    t_qte_cmatrix rows = qte_cmatrix_block(q->Phi, k0, 0, k1 - k0, q->Phi->cols);
+    qte_phase_matrix(&rows, q->E + k0, q->c + k0, q->t0, q->dt);
+}
+
+static void qte_traj_tile(void *ctx, long task) {
+    t_qte_traj_task *q = (t_qte_traj_task *)ctx;
+    long n = q->Psi->rows, T = q->Psi->cols;
+    long i0 = (task % q->rchunks) * q->rblock;
+    long s0 = (task / q->rchunks) * q->tblock;
+    long i1 = i0 + q->rblock < n ? i0 + q->rblock : n;
+    long s1 = s0 + q->tblock < T ? s0 + q->tblock : T;
+    if (i0 >= i1 || s0 >= s1)
+        return;
+    t_qte_cmatrix V = qte_cmatrix_block(q->V, i0, 0, i1 - i0, q->V->cols);
+    t_qte_cmatrix Phi = qte_cmatrix_block(q->Phi, 0, s0, q->Phi->rows, s1 - s0);
+    t_qte_cmatrix Psi = qte_cmatrix_block(q->Psi, i0, s0, i1 - i0, s1 - s0);
+    qte_zgemm(QTE_NOTRANS, QTE_NOTRANS, 1.0, &V, &Phi, 0.0, &Psi);
+    if (!q->polar)
+        return;
+    for (long i = 0; i < Psi.rows; i++) {
+        for (long s = 0; s < Psi.cols; s++) {
+            double complex *z = qte_cmatrix_at(&Psi, i, s);
+            *z = cabs(*z) + I * carg(*z);
+        }
+    }
+}
+
+int qte_trajectories(const t_qte_cmatrix *V, const double *E, const double complex *c,
+                     double t0, double dt, t_qte_cmatrix *Phi, t_qte_cmatrix *Psi,
+                     int polar, long threads) {
+    long n = V->rows, m = V->cols, T = Phi->cols;
+    if (Phi->rows != m || Psi->rows != n || Psi->cols != T ||
+        V->layout != Phi->layout || Phi->layout != Psi->layout)
+        return -1;
+    long P = (n >= QTE_PARALLEL_MIN_DIM && threads > 1) ? threads : 1;
+    t_qte_traj_task q = { V, E, c, t0, dt, Phi, Psi, polar, (m + P - 1) / P, 0, 0, 0 };
+    qte_parallel_for(P, &q, qte_traj_phase);
+
+    // About P tiles: time blocks of at least 16 steps, the rest split by component.
+    long tchunks = T / 16 < P ? T / 16 : P;
+    if (tchunks < 1)
+        tchunks = 1;
+    q.rchunks = (P + tchunks - 1) / tchunks;
+    if (q.rchunks > n / 16)
+        q.rchunks = n / 16 > 1 ? n / 16 : 1;
+    q.rblock = (n + q.rchunks - 1) / q.rchunks;
+    q.tblock = (T + tchunks - 1) / tchunks;
+    qte_parallel_for(q.rchunks * tchunks, &q, qte_traj_tile);
+    return 0;
+}
+
+/* ----------------------------------------------------------------------------
+   Observables in the eigenbasis
+---------------------------------------------------------------------------- */
+int qte_observable_basis(const t_qte_cmatrix *V, const t_qte_cmatrix *O, const double *d,
+                         t_qte_cmatrix *W, t_qte_cmatrix *Ob) {
+    long n = V->rows, m = V->cols;
+    if (O && (O->rows != n || O->cols != n || O->layout != V->layout))
+        return -1;
+    if (qte_cmatrix_resize(W, n, m, V->layout) || qte_cmatrix_resize(Ob, m, m, V->layout))
+        return -1;
+    if (O) {
+        qte_zgemm(QTE_NOTRANS, QTE_NOTRANS, 1.0, O, V, 0.0, W);
+    } else {
+        // W = diag(d) V scales row i of V by d_i.
+        long istep = (V->layout == QTE_ROW_MAJOR) ? V->ld : 1;
+        long kstep = (V->layout == QTE_ROW_MAJOR) ? 1 : V->ld;
+        long wistep = (W->layout == QTE_ROW_MAJOR) ? W->ld : 1;
+        long wkstep = (W->layout == QTE_ROW_MAJOR) ? 1 : W->ld;
+        for (long i = 0; i < n; i++) {
+            for (long k = 0; k < m; k++)
+                W->data[i * wistep + k * wkstep] = d[i] * V->data[i * istep + k * kstep];
+        }
+    }
+    return qte_zgemm(QTE_CONJTRANS, QTE_NOTRANS, 1.0, V, W, 0.0, Ob);
+}
+
+int qte_expectations(const t_qte_cmatrix *Ob, const double *d, const t_qte_cmatrix *Phi,
+                     t_qte_cmatrix *W, double *e) {
+    long m = Phi->rows, T = Phi->cols;
+    long kstep = (Phi->layout == QTE_ROW_MAJOR) ? Phi->ld : 1;
+    long sstep = (Phi->layout == QTE_ROW_MAJOR) ? 1 : Phi->ld;
+    memset(e, 0, T * sizeof(double));
+    if (!Ob) {
+        for (long k = 0; k < m; k++) {
+            const double complex *row = Phi->data + k * kstep;
+            for (long s = 0; s < T; s++) {
+                double complex z = row[s * sstep];
+                e[s] += d[k] * (creal(z) * creal(z) + cimag(z) * cimag(z));
+            }
+        }
+        return 0;
+    }
+    if (Ob->rows != m || Ob->cols != m || Ob->layout != Phi->layout ||
+        qte_cmatrix_resize(W, m, T, Phi->layout))
+        return -1;
+    qte_zgemm(QTE_NOTRANS, QTE_NOTRANS, 1.0, Ob, Phi, 0.0, W);
+    // Re conj(phi) . (Ob phi), row by row of both.
+    long wkstep = (W->layout == QTE_ROW_MAJOR) ? W->ld : 1;
+    long wsstep = (W->layout == QTE_ROW_MAJOR) ? 1 : W->ld;
+    for (long k = 0; k < m; k++) {
+        const double complex *row = Phi->data + k * kstep;
+        const double complex *wrow = W->data + k * wkstep;
+        for (long s = 0; s < T; s++) {
+            double complex z = row[s * sstep], w = wrow[s * wsstep];
+            e[s] += creal(z) * creal(w) + cimag(z) * cimag(w);
+        }
+    }
+    return 0;
+}
+
+/* ----------------------------------------------------------------------------
+   Krylov propagation
+   The basis is built with the same full reorthogonalization as qte_lanczos,
+   so T is assembled from the orthogonalization coefficients and exp(-i T tau)
+   comes from its dsyev eigenpairs.
+---------------------------------------------------------------------------- */
+#define QTE_KRYLOV_HALVINGS 52      // a step is halved at most this often
+
+void qte_krylov_init(t_qte_krylov *K) {
+    memset(K, 0, sizeof(*K));
+    qte_cmatrix_init(&K->Q);
+    qte_cvector_init(&K->h);
+    qte_cvector_init(&K->y);
+    qte_cvector_init(&K->x);
+}
+
+void qte_krylov_free(t_qte_krylov *K) {
+    qte_cmatrix_free(&K->Q);
+    qte_cvector_free(&K->h);
+    qte_cvector_free(&K->y);
+    qte_cvector_free(&K->x);
+    free(K->T);
+    qte_krylov_init(K);
+}
+
+static int qte_krylov_reserve(t_qte_krylov *K, long n, long m) {
+    if (qte_cmatrix_resize(&K->Q, n, m, QTE_COL_MAJOR) || qte_cvector_resize(&K->h, m) ||
+        qte_cvector_resize(&K->y, m) || qte_cvector_resize(&K->x, n))
+        return QTE_ERR_ALLOC;
+    if (K->mmax != m) {
+        free(K->T);
+        K->mmax = 0;
+        K->lwork = 3 * m;
+        K->T = (double *)malloc((2 * m * m + m + K->lwork) * sizeof(double));
+        if (!K->T)
+            return QTE_ERR_ALLOC;
+        K->Y = K->T + m * m;
+        K->theta = K->Y + m * m;
+        K->work = K->theta + m;
+        K->mmax = m;
+    }
+    return 0;
+}
+
+int qte_krylov_build(t_qte_krylov *K, const t_qte_cmatrix *H, const t_qte_cvector *v, long m,
+                     int *info) {
+    long n = v->n;
+    *info = 0;
+    if (H->rows != n || H->cols != n || n < 1)
+        return QTE_ERR_ALLOC;
+    if (m > n)
+        m = n;
+    if (m < 1)
+        m = 1;
+    if (qte_krylov_reserve(K, n, m))
+        return QTE_ERR_ALLOC;
+    double *T = K->T;
+    memset(T, 0, m * m * sizeof(double));
+    K->m = 0;
+    K->b = 0.0;
+    K->beta = qte_cvector_norm(v);
+    if (K->beta == 0.0)
+        return 0;
+
+    t_qte_lanczos_state st;     // only the fields qte_lanczos_orthogonalize uses
+    memset(&st, 0, sizeof(st));
+    st.Q = K->Q;
+    st.v = K->x;
+    st.h = K->h;
+    for (long i = 0; i < n; i++)
+        K->Q.data[i] = v->data[i] / K->beta;
+    double anorm = 1e-300;
+    for (long j = 0; j < m; j++) {
+        t_qte_cvector q = { n, K->Q.data + j * n, n };
+        qte_zgemv(QTE_NOTRANS, 1.0, H, &q, 0.0, &K->x);
+        qte_lanczos_orthogonalize(&st, j + 1, T + j * m);
+        for (long i = 0; i < j; i++)
+            T[i * m + j] = T[j * m + i];
+        double b = qte_cvector_norm(&K->x);
+        double an = fabs(T[j * m + j]) + b;
+        if (an > anorm)
+            anorm = an;
+        K->m = j + 1;
+        K->b = b;
+        // An invariant subspace: the basis is exact for every tau.
+        if (b <= 1e-14 * anorm) {
+            K->b = 0.0;
+            break;
+        }
+        if (j + 1 < m) {
+            double complex *qn = K->Q.data + (j + 1) * n;
+            for (long i = 0; i < n; i++)
+                qn[i] = K->x.data[i] / b;
+        }
+    }
+    return qte_lanczos_ritz(T, m, K->m, K->theta, K->Y, K->work, K->lwork, info);
+}
+
+/* K->y = exp(-i T tau) e_1; returns the relative error estimate. */
+static double qte_krylov_coefficients(t_qte_krylov *K, double tau) {
+    long m = K->m;
+    const double *Y = K->Y;
+    double complex *y = K->y.data;
+    double complex est = 0.0;
+    memset(y, 0, m * sizeof(double complex));
+    for (long l = 0; l < m; l++) {
+        const double *yl = Y + l * m;
+        double x = K->theta[l] * tau;
+        double complex e = cos(x) - I * sin(x);
+        // tau phi_1(-i theta tau), by its series where the quotient cancels.
+        double complex f = (fabs(x) < 1e-8) ? tau * (1.0 - 0.5 * I * x)
+                                             : (e - 1.0) / (-I * K->theta[l]);
+        double complex a = e * yl[0];
+        for (long r = 0; r < m; r++)
+            y[r] += a * yl[r];
+        est += f * yl[0] * yl[m - 1];
+    }
+    return K->b * cabs(est);
+}
+
+/* psi = |v| Q y for the coefficients just computed. */
+static void qte_krylov_combine(t_qte_krylov *K, t_qte_cvector *psi) {
+    t_qte_cmatrix V = qte_cmatrix_columns(&K->Q, K->m);
+    t_qte_cvector y = K->y;
+    y.n = K->m;
+    qte_zgemv(QTE_NOTRANS, K->beta, &V, &y, 0.0, psi);
+}
+
+double qte_krylov_expm(t_qte_krylov *K, double tau, t_qte_cvector *psi) {
+    if (qte_cvector_resize(psi, K->Q.rows))
+        return INFINITY;
+    if (K->m == 0) {
+        qte_cvector_zero(psi);
+        return 0.0;
+    }
+    double err = qte_krylov_coefficients(K, tau);
+    qte_krylov_combine(K, psi);
+    return err;
+}
+
+int qte_krylov_propagate(t_qte_krylov *K, const t_qte_cmatrix *H, const t_qte_cvector *psi0,
+                         double t0, double dt, long m, double tol, t_qte_cmatrix *Psi,
+                         long *builds, int *info) {
+    long n = psi0->n, T = Psi->cols;
+    long sstep = (Psi->layout == QTE_ROW_MAJOR) ? 1 : Psi->ld;
+    long istep = (Psi->layout == QTE_ROW_MAJOR) ? Psi->ld : 1;
+    t_qte_cvector state, psi;
+    qte_cvector_init(&state);
+    qte_cvector_init(&psi);
+    *builds = 0;
+    if (Psi->rows != n || qte_cvector_resize(&state, n) || qte_cvector_resize(&psi, n)) {
+        qte_cvector_free(&state);
+        qte_cvector_free(&psi);
+        return QTE_ERR_ALLOC;
+    }
+    memcpy(state.data, psi0->data, n * sizeof(double complex));
+
+    double tc = 0.0;            // time of the current basis
+    double lo = 0.0;            // largest offset from tc already accepted
+    int converged = 1;
+    int err = qte_krylov_build(K, H, &state, m, info);
+    (*builds)++;
+    for (long s = 0; s < T && !err; s++) {
+        while (!err) {
+            double tau = (t0 + s * dt) - tc, step = tau;
+            int halvings = 0;
+            double est = (K->m > 0) ? qte_krylov_coefficients(K, step) : 0.0;
+            while (est > tol && halvings < QTE_KRYLOV_HALVINGS) {
+                step *= 0.5;
+                halvings++;
+                if (lo != 0.0 && fabs(step) <= fabs(lo)) {
+                    // Advance as far as an earlier time step already reached.
+                    step = lo;
+                    est = qte_krylov_coefficients(K, step);
+                    break;
+                }
+                est = qte_krylov_coefficients(K, step);
+            }
+            if (est > tol) {
+                // No step meets tol (it is below rounding): take the full one.
+                converged = 0;
+                step = tau;
+                qte_krylov_coefficients(K, step);
+            }
+            if (K->m == 0)
+                qte_cvector_zero(&psi);
+            else
+                qte_krylov_combine(K, &psi);
+            if (step == tau) {
+                for (long i = 0; i < n; i++)
+                    Psi->data[i * istep + s * sstep] = psi.data[i];
+                lo = tau;
+                break;
+            }
+            memcpy(state.data, psi.data, n * sizeof(double complex));
+            tc += step;
+            lo = 0.0;
+            err = qte_krylov_build(K, H, &state, m, info);
+            (*builds)++;
+        }
+    }
+    qte_cvector_free(&state);
+    qte_cvector_free(&psi);
+    if (err)
+        return err;
+    return converged ? 0 : QTE_ERR_CONVERGE;
+}
+
+/* ----------------------------------------------------------------------------
+   Split-operator propagation – the state is kept split-complex (real and
+   imaginary parts in separate arrays) for vDSP between qte_strang_step's
+   entry and exit.
+---------------------------------------------------------------------------- */
+// buf holds QTE_SPLITOP_ARRAYS arrays of n doubles, in this order:
+enum { QTE_SO_RE, QTE_SO_IM, QTE_SO_ORE, QTE_SO_OIM, QTE_SO_KRE, QTE_SO_KIM,
+       QTE_SO_HRE, QTE_SO_HIM, QTE_SO_PRE, QTE_SO_PIM, QTE_SPLITOP_ARRAYS };
+
+void qte_strang_init(t_qte_strang *s) {
+    s->n = 0;
+    s->fwd = s->inv = NULL;
+    qte_cmatrix_init(&s->F);
+    qte_cvector_init(&s->tmp);
+    s->buf = NULL;
+    s->kin_dt = s->pot_dt = NAN;
+    s->pot_a = s->pot_f = 0.0;
+}
+
+void qte_strang_free(t_qte_strang *s) {
+    if (s->fwd)
+        vDSP_DFT_DestroySetupD((vDSP_DFT_SetupD)s->fwd);
+    if (s->inv)
+        vDSP_DFT_DestroySetupD((vDSP_DFT_SetupD)s->inv);
+    qte_cmatrix_free(&s->F);
+    qte_cvector_free(&s->tmp);
+    qte_aligned_free(s->buf);
+    qte_strang_init(s);
+}
+
+int qte_strang_setup(t_qte_strang *s, long n) {
+    if (n < 1)
+        return QTE_ERR_ALLOC;
+    if (s->n == n)
+        return 0;
+    qte_strang_free(s);
+    s->buf = (double *)qte_aligned_alloc(QTE_SPLITOP_ARRAYS * n * sizeof(double));
+    if (!s->buf)
+        return QTE_ERR_ALLOC;
+    s->fwd = vDSP_DFT_zop_CreateSetupD(NULL, (vDSP_Length)n, vDSP_DFT_FORWARD);
+    if (s->fwd)
+        s->inv = vDSP_DFT_zop_CreateSetupD((vDSP_DFT_SetupD)s->fwd, (vDSP_Length)n, vDSP_DFT_INVERSE);
+    if (!s->inv) {
+        // vDSP cannot do this length: F(j, k) = exp(-2 pi i jk / n), the inverse is conj(F).
+        if (s->fwd)
+            vDSP_DFT_DestroySetupD((vDSP_DFT_SetupD)s->fwd);
+        s->fwd = NULL;
+        if (qte_cmatrix_resize(&s->F, n, n, QTE_ROW_MAJOR) || qte_cvector_resize(&s->tmp, 2 * n)) {
+            qte_strang_free(s);
+            return QTE_ERR_ALLOC;
+        }
+        for (long j = 0; j < n; j++) {
+            for (long k = 0; k < n; k++) {
+                double angle = -2.0 * M_PI * (double)((j * k) % n) / n;
+                s->F.data[j * n + k] = cos(angle) + I * sin(angle);
+            }
+        }
+    }
+    s->n = n;
+    return 0;
+}
+
+/* (ORE, OIM) = DFT of (RE, IM), or (RE, IM) = inverse DFT of (ORE, OIM), unnormalized. */
+static void qte_strang_dft(t_qte_strang *s, int inverse) {
+    long n = s->n;
+    double *in_re = s->buf + (inverse ? QTE_SO_ORE : QTE_SO_RE) * n;
+    double *in_im = s->buf + (inverse ? QTE_SO_OIM : QTE_SO_IM) * n;
+    double *out_re = s->buf + (inverse ? QTE_SO_RE : QTE_SO_ORE) * n;
+    double *out_im = s->buf + (inverse ? QTE_SO_IM : QTE_SO_OIM) * n;
+    if (s->fwd) {
+        vDSP_DFT_ExecuteD((vDSP_DFT_SetupD)(inverse ? s->inv : s->fwd), in_re, in_im, out_re, out_im);
+        return;
+    }
+    t_qte_cvector x = { n, s->tmp.data, 0 }, y = { n, s->tmp.data + n, 0 };
+    DSPDoubleSplitComplex in = { in_re, in_im }, out = { out_re, out_im };
+    vDSP_ztocD(&in, 1, (DSPDoubleComplex *)x.data, 2, (vDSP_Length)n);
+    qte_zgemv(inverse ? QTE_CONJTRANS : QTE_NOTRANS, 1.0, &s->F, &x, 0.0, &y);
+    vDSP_ctozD((const DSPDoubleComplex *)y.data, 2, &out, 1, (vDSP_Length)n);
+}
+
+/* (re, im) = (cos theta, sin theta) for theta_j = scale * v_j. */
+static void qte_strang_phases(double *re, double *im, const double *v, double scale, long n) {
+    for (long j = 0; j < n; j++) {
+        double theta = scale * v[j];
+        re[j] = cos(theta);
+        im[j] = sin(theta);
+    }
+}
+
+/* Kinetic factors e^{-i m^2 dt / 2} / n (the 1/n of the inverse DFT folded in)
+   and the half and full potential factors, each rebuilt when its parameters change. */
+static void qte_strang_factors(t_qte_strang *s, double a, double f, double dt) {
+    long n = s->n;
+    double *v = s->buf + QTE_SO_ORE * n;    // scratch until the first DFT
+    if (dt != s->kin_dt) {
+        for (long m = 0; m < n; m++)
+            v[m] = 0.5 * (double)m * (double)m;
+        qte_strang_phases(s->buf + QTE_SO_KRE * n, s->buf + QTE_SO_KIM * n, v, -dt, n);
+        for (long m = 0; m < n; m++) {
+            s->buf[QTE_SO_KRE * n + m] /= n;
+            s->buf[QTE_SO_KIM * n + m] /= n;
+        }
+        s->kin_dt = dt;
+    }
+    if (dt != s->pot_dt || a != s->pot_a || f != s->pot_f) {
+        for (long j = 0; j < n; j++) {
+            double q = a * (-((n - 1) / 2.0) + j);
+            v[j] = 0.5 * q * q + f * q;
+        }
+        qte_strang_phases(s->buf + QTE_SO_HRE * n, s->buf + QTE_SO_HIM * n, v, -0.5 * dt, n);
+        qte_strang_phases(s->buf + QTE_SO_PRE * n, s->buf + QTE_SO_PIM * n, v, -dt, n);
+        s->pot_dt = dt;
+        s->pot_a = a;
+        s->pot_f = f;
+    }
+}
+
+int qte_strang_step(t_qte_strang *s, t_qte_cvector *psi, double a, double f, double dt, long steps) {
+    long n = s->n;
+    if (!s->buf || psi->n != n)
+        return QTE_ERR_ALLOC;
+    if (steps < 1)
+        return 0;
+    qte_strang_factors(s, a, f, dt);
+    double *b = s->buf;
+    DSPDoubleSplitComplex z = { b + QTE_SO_RE * n, b + QTE_SO_IM * n };
+    DSPDoubleSplitComplex zo = { b + QTE_SO_ORE * n, b + QTE_SO_OIM * n };
+    DSPDoubleSplitComplex kin = { b + QTE_SO_KRE * n, b + QTE_SO_KIM * n };
+    DSPDoubleSplitComplex half = { b + QTE_SO_HRE * n, b + QTE_SO_HIM * n };
+    DSPDoubleSplitComplex full = { b + QTE_SO_PRE * n, b + QTE_SO_PIM * n };
+    vDSP_Length len = (vDSP_Length)n;
+
+    vDSP_ctozD((const DSPDoubleComplex *)psi->data, 2, &z, 1, len);
+    vDSP_zvmulD(&half, 1, &z, 1, &z, 1, len, 1);
+    for (long k = 0; k < steps; k++) {
+        qte_strang_dft(s, 0);
+        vDSP_zvmulD(&kin, 1, &zo, 1, &zo, 1, len, 1);
+        qte_strang_dft(s, 1);
+        // The closing half step of V and the opening one of the next step, merged.
+        vDSP_zvmulD(k + 1 < steps ? &full : &half, 1, &z, 1, &z, 1, len, 1);
+    }
+    vDSP_ztocD(&z, 1, (DSPDoubleComplex *)psi->data, 2, len);
+    return 0;
+}
+
+/* ----------------------------------------------------------------------------
+   Eigenbasis snapshots
+---------------------------------------------------------------------------- */
+typedef char qte_snapshot_header_is_128_bytes[sizeof(t_qte_snapshot_header) == 128 ? 1 : -1];
+
+static uint64_t qte_snapshot_align(uint64_t offset) {
+    return (offset + QTE_ALIGNMENT - 1) & ~(uint64_t)(QTE_ALIGNMENT - 1);
+}
+
+/* Writes count bytes at offset (zero padding from the current position). */
+static int qte_snapshot_put(FILE *f, uint64_t *pos, uint64_t offset, const void *data, size_t count) {
+    static const char zeros[QTE_ALIGNMENT] = { 0 };
+    while (*pos < offset) {
+        size_t k = (size_t)(offset - *pos) < sizeof(zeros) ? (size_t)(offset - *pos) : sizeof(zeros);
+        if (fwrite(zeros, 1, k, f) != k)
+            return QTE_ERR_IO;
+        *pos += k;
+    }
+    if (count && fwrite(data, 1, count, f) != count)
+        return QTE_ERR_IO;
+    *pos += count;
+    return 0;
+}
+
+int qte_snapshot_write(const char *path, long n, long m, const double *w, const t_qte_cmatrix *V,
+                       const t_qte_cvector *c, uint64_t source_hash) {
+    if (n < 1 || m < 0 || m > n || (V && (V->rows != n || V->cols != m)) || (c && c->n != m))
+        return QTE_ERR_ALLOC;
+    t_qte_snapshot_header h;
+    memset(&h, 0, sizeof(h));
+    memcpy(h.magic, QTE_SNAPSHOT_MAGIC, sizeof(QTE_SNAPSHOT_MAGIC));
+    h.version = QTE_SNAPSHOT_VERSION;
+    h.flags = (V ? QTE_SNAPSHOT_VECTORS : 0) | (c ? QTE_SNAPSHOT_COEFF : 0);
+    h.n = n;
+    h.m = m;
+    h.layout = V ? V->layout : QTE_COL_MAJOR;
+    h.source_hash = source_hash;
+    h.offset[0] = qte_snapshot_align(sizeof(h));
+    h.offset[1] = qte_snapshot_align(h.offset[0] + m * sizeof(double));
+    h.offset[2] = qte_snapshot_align(h.offset[1] + (V ? n * m * sizeof(double complex) : 0));
+
+    size_t len = strlen(path);
+    char *tmp = (char *)malloc(len + 5);
+    if (!tmp)
+        return QTE_ERR_ALLOC;
+    memcpy(tmp, path, len);
+    memcpy(tmp + len, ".tmp", 5);
+    FILE *f = fopen(tmp, "wb");
+    int err = f ? 0 : QTE_ERR_IO;
+    uint64_t pos = 0;
+    if (!err)
+        err = qte_snapshot_put(f, &pos, 0, &h, sizeof(h));
+    if (!err)
+        err = qte_snapshot_put(f, &pos, h.offset[0], w, m * sizeof(double));
+    if (!err && V) {
+        // Compact: one contiguous row (or column) at a time, whatever V's ld.
+        long outer = (V->layout == QTE_ROW_MAJOR) ? V->rows : V->cols;
+        long inner = (V->layout == QTE_ROW_MAJOR) ? V->cols : V->rows;
+        for (long k = 0; k < outer && !err; k++)
+            err = qte_snapshot_put(f, &pos, k ? pos : h.offset[1], V->data + k * V->ld,
+                                   inner * sizeof(double complex));
+    }
+    if (!err && c)
+        err = qte_snapshot_put(f, &pos, h.offset[2], c->data, m * sizeof(double complex));
+    if (f && fclose(f) && !err)
+        err = QTE_ERR_IO;
+    if (!err && rename(tmp, path))
+        err = QTE_ERR_IO;
+    if (err && f) {
+        int saved = errno;      // for the caller's message
+        remove(tmp);
+        errno = saved;
+    }
+    free(tmp);
+    return err;
+}
+
+void qte_snapshot_init(t_qte_snapshot *s) {
+    s->base = NULL;
+    s->size = 0;
+    memset(&s->header, 0, sizeof(s->header));
+    s->w = NULL;
+    qte_cmatrix_init(&s->V);
+    qte_cvector_init(&s->c);
+}
+
+/* Validates a mapped header against the file size. */
+static int qte_snapshot_check(const t_qte_snapshot_header *h, size_t size) {
+    if (memcmp(h->magic, QTE_SNAPSHOT_MAGIC, sizeof(QTE_SNAPSHOT_MAGIC)) || h->version != QTE_SNAPSHOT_VERSION)
+        return QTE_ERR_FORMAT;
+    if (h->n < 1 || h->m < 0 || h->m > h->n || (h->layout != QTE_ROW_MAJOR && h->layout != QTE_COL_MAJOR))
+        return QTE_ERR_FORMAT;
+    uint64_t need[3] = { (uint64_t)h->m * sizeof(double),
+                         (h->flags & QTE_SNAPSHOT_VECTORS) ? (uint64_t)h->n * h->m * sizeof(double complex) : 0,
+                         (h->flags & QTE_SNAPSHOT_COEFF) ? (uint64_t)h->m * sizeof(double complex) : 0 };
+    for (int k = 0; k < 3; k++) {
+        if (!need[k])
+            continue;
+        if (h->offset[k] % QTE_ALIGNMENT || h->offset[k] < sizeof(*h) || h->offset[k] > size
+            || need[k] > size - h->offset[k])
+            return QTE_ERR_FORMAT;
+    }
+    return 0;
+}
+
+int qte_snapshot_open(t_qte_snapshot *s, const char *path) {
+    qte_snapshot_close(s);
+    int fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return QTE_ERR_IO;
+    struct stat st;
+    if (fstat(fd, &st)) {
+        close(fd);
+        return QTE_ERR_IO;
+    }
+    if (st.st_size < (off_t)sizeof(t_qte_snapshot_header)) {
+        close(fd);
+        return QTE_ERR_FORMAT;
+    }
+    size_t size = (size_t)st.st_size;
+    void *base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd);      // the mapping keeps the file
+    if (base == MAP_FAILED)
+        return QTE_ERR_IO;
+    const t_qte_snapshot_header *h = (const t_qte_snapshot_header *)base;
+    int err = qte_snapshot_check(h, size);
+    if (err) {
+        munmap(base, size);
+        return err;
+    }
+    s->base = base;
+    s->size = size;
+    s->header = *h;
+    char *p = (char *)base;
+    long n = (long)h->n, m = (long)h->m;
+    s->w = (double *)(p + h->offset[0]);
+    if (h->flags & QTE_SNAPSHOT_VECTORS) {
+        s->V.rows = n;
+        s->V.cols = m;
+        s->V.layout = (t_qte_layout)h->layout;
+        s->V.ld = (s->V.layout == QTE_ROW_MAJOR) ? (m > 0 ? m : 1) : n;
+        s->V.data = (double complex *)(p + h->offset[1]);
+    }
+    if (h->flags & QTE_SNAPSHOT_COEFF) {
+        s->c.n = m;
+        s->c.data = (double complex *)(p + h->offset[2]);
+    }
+    return 0;
+}
+
+void qte_snapshot_close(t_qte_snapshot *s) {
+    if (s->base)
+        munmap(s->base, s->size);
+    qte_snapshot_init(s);
+}
+
+/* ----------------------------------------------------------------------------
+   Instrumentation
+---------------------------------------------------------------------------- */
+double qte_time_now(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + 1e-9 * (double)ts.tv_nsec;
+}
+
+uint64_t qte_alloc_total(void) {
+    return __atomic_load_n(&qte_alloc_bytes, __ATOMIC_RELAXED);
+}
+
+void qte_stats_reset(t_qte_stats *s) {
+    memset(s, 0, sizeof(*s));
+}
+
+void qte_latency_add(t_qte_latency *l, double seconds) {
+    long bin = 0;
+    if (seconds > QTE_LATENCY_MIN) {
+        bin = (long)(QTE_LATENCY_STEPS * log2(seconds / QTE_LATENCY_MIN));
+        if (bin >= QTE_LATENCY_BINS)
+            bin = QTE_LATENCY_BINS - 1;
+    }
+    l->hist[bin]++;
+    l->count++;
+    l->last = seconds;
+    l->sum += seconds;
+    if (seconds > l->max)
+        l->max = seconds;
+}
+
+double qte_latency_quantile(const t_qte_latency *l, double q) {
+    if (!l->count)
+        return 0.0;
+    uint64_t target = (uint64_t)ceil(q * (double)l->count), seen = 0;
+    for (long bin = 0; bin < QTE_LATENCY_BINS; bin++) {
+        seen += l->hist[bin];
+        if (seen >= target) {
+            double edge = QTE_LATENCY_MIN * exp2((double)(bin + 1) / QTE_LATENCY_STEPS);
+            return edge < l->max ? edge : l->max;
+        }
+    }
+    return l->max;
+}
+
+double qte_stats_begin(t_qte_stats *s) {
+    s->mark = qte_alloc_total();
+    return qte_time_now();
+}
+
+double qte_stats_lap(t_qte_stats *s, t_qte_stage stage, double t0) {
+    double now = qte_time_now();
+    uint64_t mark = qte_alloc_total();
+    qte_latency_add(&s->stage[stage], now - t0);
+    s->bytes += mark - s->mark;
+    s->mark = mark;
+    return now;
+}
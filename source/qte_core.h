@@ -0,0 +1,646 @@
+/* qte_core.h – Shared numerical core of the qte.* externals
+ *
+ * Contiguous, 64-byte aligned complex matrices and vectors, the BLAS/LAPACK
+ * kernels the externals build on, and the computational stages of the
+ * pipeline (oscillator Hamiltonian, eigen-decomposition, projection onto the
+ * eigenbasis, time evolution). A matrix is a single allocation tagged with
+ * its layout, so it can be handed to BLAS/LAPACK (column-major) or copied
+ * row by row into a jit.matrix (row-major) without any pointer chasing.
+ *
+ * This header does not depend on the Max SDK, so the stages can be driven
+ * outside Max (see qte_bench.c); the conversions to and from atoms and
+ * jit.matrix live in qte_core_max.h.
+ *
+ * Functions that can fail return 0 on success and QTE_ERR_ALLOC (-1) on
+ * failure (allocation or a shape mismatch); qte_eigh additionally reports
+ * LAPACK errors. The calling external reports the error.
+ */
+
+#ifndef QTE_CORE_H
+#define QTE_CORE_H
+
+#include <complex.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#define QTE_ALIGNMENT 64
+
+#define QTE_ERR_ALLOC  -1   // allocation failure or shape mismatch
+#define QTE_ERR_QUERY  -2   // LAPACK workspace query failed (see info)
+#define QTE_ERR_SOLVE  -3   // LAPACK decomposition failed (see info)
+#define QTE_ERR_CONVERGE -4 // eigenpair tracking did not converge
+#define QTE_ERR_IO     -5   // snapshot file could not be opened, mapped or written (see errno)
+#define QTE_ERR_FORMAT -6   // not a snapshot, unsupported version or truncated
+#define QTE_ERR_DEFLATE -7  // Lanczos pairs converged, the search for missed copies did not finish
+
+typedef enum _qte_layout {
+    QTE_ROW_MAJOR = 0,      // element (i, j) at data[i*ld + j]
+    QTE_COL_MAJOR = 1       // element (i, j) at data[j*ld + i] (BLAS/LAPACK order)
+} t_qte_layout;
+
+typedef enum _qte_op {
+    QTE_NOTRANS = 0,
+    QTE_TRANS = 1,
+    QTE_CONJTRANS = 2
+} t_qte_op;
+
+typedef struct _qte_cmatrix {
+    long rows;
+    long cols;
+    long ld;                // Leading dimension: cols if row-major, rows if column-major
+    t_qte_layout layout;
+    double complex *data;   // QTE_ALIGNMENT-aligned, capacity elements
+    long capacity;
+} t_qte_cmatrix;
+
+typedef struct _qte_cvector {
+    long n;
+    double complex *data;   // QTE_ALIGNMENT-aligned, capacity elements
+    long capacity;
+} t_qte_cvector;
+
+/* Aligned allocation (QTE_ALIGNMENT bytes); free with qte_aligned_free. */
+void *qte_aligned_alloc(size_t bytes);
+void  qte_aligned_free(void *p);
+
+/* Fast 64-bit hash of a block of memory (8 bytes per step), for content-keyed caches. */
+uint64_t qte_hash64(const void *data, size_t bytes, uint64_t seed);
+
+/* ----------------------------------------------------------------------------
+   Multicore work (GCD)
+   qte_parallel_for runs fn(ctx, i) for i = 0 .. count-1 through dispatch_apply
+   on the global concurrent queue and returns once all of them have finished.
+   Each i writes its own part of the result, so the outcome (and the order in
+   which an object outputs it afterwards) does not depend on the schedule.
+   count <= 1 runs inline. Objects resolve their @threads with qte_threads
+   (0 = one per core) and split nothing below QTE_PARALLEL_MIN_DIM, where the
+   dispatch overhead would outweigh the work.
+---------------------------------------------------------------------------- */
+#define QTE_PARALLEL_MIN_DIM 64
+
+long qte_threads(long requested);
+void qte_parallel_for(long count, void *ctx, void (*fn)(void *ctx, long i));
+
+/* ----------------------------------------------------------------------------
+   Published slots
+   Lock-free handover of data from one writer to its readers. The writer fills
+   a slot no reader holds (qte_slots_claim) and publishes it with one atomic
+   store; a reader pins the published slot (qte_slots_acquire) and reads it
+   undisturbed, however often the writer publishes meanwhile, until it
+   releases it. A reader only retries when a publish lands between its load
+   and its pin. The writer never waits: when every other slot is still
+   pinned by readers of older contents, which takes more than one reader (or
+   readers nested on one thread), the claim fails and the writer reports it
+   or falls back, leaving the published contents as they were. gen[i]
+   numbers the publish that put out slot i, so a reader can tell new contents
+   from those it cached results for.
+---------------------------------------------------------------------------- */
+#define QTE_SLOTS 3
+
+typedef struct _qte_slots {
+    int pub;                    // published slot, -1 before the first publish
+    int pins[QTE_SLOTS];        // readers holding each slot
+    uint64_t gen[QTE_SLOTS];    // publish number of each slot's contents
+    uint64_t count;             // publishes so far
+} t_qte_slots;
+
+void qte_slots_init(t_qte_slots *s);
+/* Reader: pins and returns the published slot, -1 if nothing is published yet. */
+int  qte_slots_acquire(t_qte_slots *s);
+void qte_slots_release(t_qte_slots *s, int i);
+/* Writer: a slot neither published nor pinned, free to fill and publish; -1 if
+   readers hold every other slot. Only the writer claims, so no reader reads
+   the slot until the writer publishes it. */
+int  qte_slots_claim(t_qte_slots *s);
+/* Writer: whether slot i may be refilled (or freed) now. */
+int  qte_slots_idle(t_qte_slots *s, int i);
+void qte_slots_publish(t_qte_slots *s, int i);
+
+/* ----------------------------------------------------------------------------
+   Complex matrices
+   A zero-initialized struct (or qte_cmatrix_init) is an empty matrix.
+   resize keeps the allocation whenever it is large enough, so repeated
+   resizes to the same or a smaller shape never allocate; reshape never
+   allocates and fails instead. Neither preserves the contents. A matrix with
+   capacity 0 and data set is a view of storage it does not own (a block, a
+   snapshot): free only forgets it and resize gives it storage of its own.
+---------------------------------------------------------------------------- */
+void qte_cmatrix_init(t_qte_cmatrix *A);
+void qte_cmatrix_free(t_qte_cmatrix *A);
+int  qte_cmatrix_resize(t_qte_cmatrix *A, long rows, long cols, t_qte_layout layout);
+int  qte_cmatrix_reshape(t_qte_cmatrix *A, long rows, long cols, t_qte_layout layout);
+int  qte_cmatrix_reserve(t_qte_cmatrix *A, long capacity);
+void qte_cmatrix_zero(t_qte_cmatrix *A);
+/* Copies src into dst (resized) with dst's storage in the given layout. */
+int  qte_cmatrix_copy(t_qte_cmatrix *dst, const t_qte_cmatrix *src, t_qte_layout layout);
+
+static inline double complex *qte_cmatrix_at(const t_qte_cmatrix *A, long i, long j) {
+    return A->layout == QTE_ROW_MAJOR ? A->data + i * A->ld + j : A->data + j * A->ld + i;
+}
+
+/* The rows x cols block of A starting at (i0, j0), sharing A's storage. The view
+   owns nothing (capacity 0) and must not outlive A. */
+static inline t_qte_cmatrix qte_cmatrix_block(const t_qte_cmatrix *A, long i0, long j0, long rows, long cols) {
+    t_qte_cmatrix B = { rows, cols, A->ld, A->layout, qte_cmatrix_at(A, i0, j0), 0 };
+    return B;
+}
+
+/* ----------------------------------------------------------------------------
+   Complex vectors
+   Views (capacity 0) behave as for matrices.
+---------------------------------------------------------------------------- */
+void qte_cvector_init(t_qte_cvector *v);
+void qte_cvector_free(t_qte_cvector *v);
+int  qte_cvector_resize(t_qte_cvector *v, long n);
+void qte_cvector_zero(t_qte_cvector *v);
+
+/* ----------------------------------------------------------------------------
+   Packed Hermitian matrices
+   The upper triangle column by column (LAPACK 'U' packed storage):
+   AP[i + j (j + 1) / 2] = A(i, j) for 0 <= i <= j < n, QTE_PACKED_SIZE(n)
+   entries in a complex vector, about half of the n x n matrix.
+---------------------------------------------------------------------------- */
+#define QTE_PACKED_SIZE(n) ((n) * ((n) + 1) / 2)
+
+/* n such that QTE_PACKED_SIZE(n) == size, or -1 if there is none. */
+long qte_packed_dim(long size);
+/* AP (resized) = upper triangle of the square matrix A, in any layout. */
+int  qte_packed_from_cmatrix(t_qte_cvector *AP, const t_qte_cmatrix *A);
+/* A (resized to n x n, A's layout kept) = the Hermitian matrix held in AP;
+   the lower triangle is mirrored and diagonal imaginary parts are dropped. */
+int  qte_packed_to_cmatrix(const t_qte_cvector *AP, t_qte_cmatrix *A);
+
+/* ----------------------------------------------------------------------------
+   BLAS kernels
+   All matrix operands must share the same layout; shapes are checked.
+---------------------------------------------------------------------------- */
+/* C = alpha * op(A) * op(B) + beta * C */
+int qte_zgemm(t_qte_op opA, t_qte_op opB, double complex alpha, const t_qte_cmatrix *A,
+              const t_qte_cmatrix *B, double complex beta, t_qte_cmatrix *C);
+/* y = alpha * op(A) * x + beta * y */
+int qte_zgemv(t_qte_op opA, double complex alpha, const t_qte_cmatrix *A,
+              const t_qte_cvector *x, double complex beta, t_qte_cvector *y);
+/* y = alpha * x + y */
+int qte_zaxpy(double complex alpha, const t_qte_cvector *x, t_qte_cvector *y);
+
+/* ----------------------------------------------------------------------------
+   Oscillator Hamiltonian (qte.quantumho)
+   H = 0.5 * (P^2 + Q^2) with P = F diag(0..n-1) Finv and
+   Q = diag(a * (-(n - 1)/2 + i)), entries rounded to 5 decimals.
+   P^2 is circulant; p2 is its first column (length n).
+---------------------------------------------------------------------------- */
+void qte_oscillator_p2_column(double complex *p2, long n);
+/* Writes the P^2 part of every entry of the n x n matrix H, rows spread over
+   up to threads cores (see qte_threads). */
+void qte_oscillator_kinetic(t_qte_cmatrix *H, const double complex *p2, long threads);
+/* Rewrites only the diagonal of H for the potential parameter a. */
+void qte_oscillator_potential(t_qte_cmatrix *H, const double complex *p2, double a);
+
+/* ----------------------------------------------------------------------------
+   Random Hermitian ensembles (qte.randherm)
+   A per-instance xoshiro256** generator, so draws are reproducible per seed
+   and instances never share a sequence. Normal variates come in blocks
+   (Box-Muller through vForce), never one libc call per number.
+---------------------------------------------------------------------------- */
+typedef struct _qte_rng {
+    uint64_t s[4];
+} t_qte_rng;
+
+typedef enum _qte_ensemble {
+    QTE_ENSEMBLE_UNIFORM = 0,   // real symmetric, diagonal 2U, off-diagonal U, U ~ [0, 1)
+    QTE_ENSEMBLE_GOE = 1,       // real symmetric Gaussian
+    QTE_ENSEMBLE_GUE = 2        // complex Hermitian Gaussian
+} t_qte_ensemble;
+
+/* Seeds the four state words from seed through splitmix64. */
+void     qte_rng_seed(t_qte_rng *r, uint64_t seed);
+uint64_t qte_rng_next(t_qte_rng *r);
+/* count doubles uniform in [0, 1). */
+void     qte_rng_uniform(t_qte_rng *r, double *u, long count);
+/* count standard normal doubles. */
+void     qte_rng_normal(t_qte_rng *r, double *z, long count);
+/* Fills the n x n row-major H with a draw from ensemble e, scaled by scale.
+   GOE and GUE follow the density exp(-tr H^2 / 2): diagonal entries N(0, 1),
+   off-diagonal real (GOE) or real and imaginary parts (GUE) N(0, 1/2). Each
+   row's upper part is generated in place, then mirrored. */
+int qte_random_hermitian(t_qte_rng *r, t_qte_ensemble e, double scale, t_qte_cmatrix *H);
+
+/* ----------------------------------------------------------------------------
+   Hermitian eigen-decomposition (qte.eigencalc)
+---------------------------------------------------------------------------- */
+typedef enum _qte_eigh_driver {
+    QTE_ZHEEV = 0,          // QR iteration
+    QTE_ZHEEVD = 1,         // divide and conquer
+    QTE_ZHEEVR = 2          // MRRR, the only driver that can compute a subset
+} t_qte_eigh_driver;
+
+typedef struct _qte_eigh_params {
+    t_qte_eigh_driver driver;
+    int vectors;            // 1 = eigenvalues and eigenvectors, 0 = eigenvalues only
+    char range;             // 'A' (all), 'I' (indices il..iu) or 'V' (values in (vl, vu])
+    long il, iu;            // 1-based index range (zheevr)
+    double vl, vu;          // value range (zheevr)
+} t_qte_eigh_params;
+
+/* LAPACK workspace kept between solves: the sizes of the last workspace query
+   (skipped while the driver, job and dimension stay the same) and one aligned
+   block holding work, rwork, iwork and isuppz. Not thread-safe; give every
+   concurrent caller its own. */
+typedef struct _qte_eigh_work {
+    uint64_t key;               // identifies the last query, 0 = none
+    long lwork, lrwork, liwork, lisuppz;
+    void *block;
+    size_t capacity;            // bytes in block
+} t_qte_eigh_work;
+
+void qte_eigh_work_init(t_qte_eigh_work *ws);
+void qte_eigh_work_free(t_qte_eigh_work *ws);
+
+/* Decomposes the n x n column-major Hermitian matrix A (upper triangle used,
+   destroyed). w (length n) receives the m eigenvalues in ascending order and, if
+   p->vectors, Z the n x m column-major eigenvectors. zheev and zheevd swap the
+   storage of A and Z, so A comes back holding Z's previous allocation. ws
+   (NULL = a one-off workspace) is reused across calls. Returns 0, QTE_ERR_ALLOC,
+   QTE_ERR_QUERY or QTE_ERR_SOLVE; *info holds the LAPACK info code. */
+int qte_eigh(const t_qte_eigh_params *p, t_qte_cmatrix *A, double *w, t_qte_cmatrix *Z,
+             long *m, t_qte_eigh_work *ws, int *info);
+
+/* Keeps the eigenpairs p selects ('I': indices il..iu, 'V': values in (vl, vu])
+   out of the *m ascending eigenpairs in w and Z (n x *m column-major, or empty),
+   moving them to the front. 'A' keeps everything. */
+void qte_eigh_select(const t_qte_eigh_params *p, double *w, t_qte_cmatrix *Z, long *m);
+
+/* Decomposes the n x n Hermitian band matrix with kd superdiagonals held in
+   LAPACK upper band storage AB ((kd + 1) x n column-major, AB(kd + i - j, j) =
+   A(i, j) for j - kd <= i <= j; destroyed) with zhbevd, in O(kd n^2) instead of
+   O(n^3). All n eigenvalues go to w and, if p->vectors, the eigenvectors to Z
+   (n x n column-major); apply qte_eigh_select for a subset. ws as for qte_eigh. */
+int qte_eigh_band(const t_qte_eigh_params *p, long kd, t_qte_cmatrix *AB, double *w,
+                  t_qte_cmatrix *Z, t_qte_eigh_work *ws, int *info);
+
+/* Decomposes the Hermitian matrix held in packed storage AP (destroyed) with
+   zhpevd, without unpacking or transposing it. All n eigenvalues go to w and,
+   if p->vectors, the eigenvectors to Z (n x n column-major); apply
+   qte_eigh_select for a subset. ws as for qte_eigh. */
+int qte_eigh_packed(const t_qte_eigh_params *p, t_qte_cvector *AP, double *w, t_qte_cmatrix *Z,
+                    t_qte_eigh_work *ws, int *info);
+
+/* ----------------------------------------------------------------------------
+   Block decomposition
+   A matrix whose nonzero entries (|A_ij| > tol max|A|) connect the basis into
+   several disconnected groups is block diagonal after a permutation, and each
+   block can be decomposed on its own: sum_k n_k^3 instead of n^3. Optionally
+   the parity split is tried as well: with the basis reflected (i -> n-1-i),
+   u_i = (e_i +- e_{n-1-i}) / sqrt 2 turns a reflection-symmetric matrix
+   (A(i, j) = A(n-1-i, n-1-j), a real potential on a centred grid, say) into
+   an even and an odd block, which may split further. Whichever of the two
+   splits is cheaper is used. qte.quantumho's H is not such a matrix: its
+   momenta run over 0..n-1, not a range symmetric about 0, so the reflection
+   takes P^2 to its complex conjugate and no parity blocks are found.
+---------------------------------------------------------------------------- */
+typedef struct _qte_eigh_split {
+    long count;             // blocks used by the last solve (1 = whole matrix)
+    int parity;             // 1 if they are blocks of the parity-rotated matrix
+    long *perm;             // basis indices, block after block, ascending within a block
+    long *start;            // count + 1 offsets into perm
+    long *root;             // union-find forest, then the merge cursors
+    long *off;              // offset of each block in R
+    double *wb;             // eigenvalues, block after block
+    long buf_n;
+    t_qte_cmatrix P;        // the parity-rotated matrix U^H A U
+    t_qte_cvector R;        // each block, then its eigenvectors, one after the other
+    t_qte_eigh_work *ws;    // one workspace per thread (threads > 1)
+    int *status;            // error and info code of each thread
+    long ws_n;
+} t_qte_eigh_split;
+
+void qte_eigh_split_init(t_qte_eigh_split *s);
+void qte_eigh_split_free(t_qte_eigh_split *s);
+/* Number of disconnected blocks of the Hermitian matrix held in packed storage
+   AP (no rotation), or -1 if the scratch cannot be allocated. A cheap test of
+   whether unpacking AP for qte_eigh_blocks pays off. */
+long qte_packed_blocks(t_qte_eigh_split *s, const t_qte_cvector *AP, double tol);
+/* qte_eigh for a matrix that may split into blocks (parity: try the parity
+   split as well). When it does not, A is passed to qte_eigh unchanged.
+   Otherwise each block is decomposed with zheevd (zheev if p->driver is
+   QTE_ZHEEV), spread over threads when there are several blocks and n >=
+   QTE_PARALLEL_MIN_DIM, and the eigenpairs are merged in ascending order into
+   w and Z (n x n column-major, zero outside the block of each eigenvector)
+   before qte_eigh_select applies p's range. A is not modified on that path.
+   s->count and s->parity tell which path was taken. */
+int qte_eigh_blocks(const t_qte_eigh_params *p, t_qte_eigh_split *s, t_qte_cmatrix *A, int parity,
+                    double tol, long threads, double *w, t_qte_cmatrix *Z, long *m,
+                    t_qte_eigh_work *ws, int *info);
+
+/* ----------------------------------------------------------------------------
+   Sparse Hermitian matrices and Lanczos
+   Compressed sparse rows holding both triangles, so a product is one pass
+   over the nonzeros.
+---------------------------------------------------------------------------- */
+typedef struct _qte_csr {
+    long n;
+    long nnz;
+    long *rowptr;           // n + 1 offsets into col / val
+    long *col;              // column of each nonzero, ascending within a row
+    double complex *val;
+} t_qte_csr;
+
+void qte_csr_init(t_qte_csr *S);
+void qte_csr_free(t_qte_csr *S);
+int  qte_csr_copy(t_qte_csr *dst, const t_qte_csr *src);
+/* Builds the n x n Hermitian matrix whose entries (i[k], j[k]) are z[k]: each
+   off-diagonal entry also sets (j, i) to conj(z), diagonal entries keep their
+   real part, and a repeated position takes the last value. Indices are 0-based. */
+int  qte_csr_from_triplets(t_qte_csr *S, long n, long count, const long *i, const long *j,
+                           const double complex *z);
+/* y = S x */
+void qte_csr_matvec(const t_qte_csr *S, const double complex *x, double complex *y);
+/* A = S as a dense n x n matrix (resized, A's layout kept). */
+int  qte_csr_to_dense(const t_qte_csr *S, t_qte_cmatrix *A);
+
+/* Lowest k eigenpairs of S by thick-restart Lanczos with full
+   reorthogonalization: a basis of up to maxbasis vectors (0 = max(2k + 20, 40),
+   at most n) is grown until every Ritz residual |b y_ji| is within
+   tol * max(|theta_i|, 1), and restarted from its lowest Ritz vectors when full.
+   Ritz pairs come from the small real projection Q^H S Q (dsyev). One start
+   vector reaches only one copy of a degenerate eigenvalue, and the residuals
+   cannot show that others are missing, so the converged pairs are then locked
+   and the run repeated from a fresh random vector orthogonal to them; Ritz
+   values below the k-th it finds are merged in, until a pass finds none. A
+   copy is missed only if every start vector misses its eigenspace. w (length
+   >= k) receives the k eigenvalues in ascending order and, if vectors, Z
+   (initialized; used as scratch otherwise) the n x k column-major Ritz
+   vectors. Returns 0, QTE_ERR_ALLOC, QTE_ERR_SOLVE (dsyev, see info) or
+   QTE_ERR_CONVERGE with the best approximations in w and Z. A pass that fails
+   (or QTE_LANCZOS_PASSES passes that all find more) returns QTE_ERR_DEFLATE
+   with the converged pairs found so far in w and Z, which may then lack copies
+   of a degenerate eigenvalue. *steps counts the products S v.
+   Storage is O(n * maxbasis + nnz), never O(n^2). */
+int qte_lanczos(const t_qte_csr *S, long k, long maxbasis, double tol, int vectors, double *w,
+                t_qte_cmatrix *Z, long *steps, int *info);
+
+/* ----------------------------------------------------------------------------
+   Eigenpair tracking for slowly varying Hamiltonians
+   qte_eigh_track refines the previous eigenvectors V (n x n, column-major,
+   unitary) for a new H by Rayleigh-Ritz in the old basis: with B = V^H H V,
+   the residual of v_k is exactly the off-diagonal part of column k of B. While
+   it exceeds tol * max|E|, V is rotated by the Cayley transform of the
+   first-order correction K_jk = B_jk / (E_k - E_j), which is unitary, keeps
+   each eigenvector's phase and converges quadratically. Each check costs two
+   zgemm and each correction one zgesv and one zgemm, with no tridiagonal
+   reduction; the final check is skipped when the correction is predicted to
+   meet tol, so a small change of H costs a single check and correction.
+   Near-degenerate or crossing levels (|B_jk| comparable with the gap) make it
+   return QTE_ERR_CONVERGE, as does exceeding maxiter corrections; the caller
+   then decomposes from scratch and matches the result to the previous
+   eigenvectors with qte_eigh_align.
+---------------------------------------------------------------------------- */
+typedef struct _qte_eigh_tracker {
+    t_qte_cmatrix W;        // n x n scratch (H V, then V Q)
+    t_qte_cmatrix B;        // n x n scratch (V^H H V, then the Cayley solution)
+    t_qte_cmatrix K;        // n x n scratch (the Cayley system / permuted Z)
+    void *buf;              // pivots, permutation and eigenvalue scratch
+    long buf_n;
+} t_qte_eigh_tracker;
+
+void qte_eigh_tracker_init(t_qte_eigh_tracker *t);
+void qte_eigh_tracker_free(t_qte_eigh_tracker *t);
+/* On success w holds the eigenvalues in the order of V's columns and *iters
+   the number of corrections applied (0 if V was already converged). H is not
+   modified. */
+int qte_eigh_track(t_qte_eigh_tracker *t, const t_qte_cmatrix *H, double *w, t_qte_cmatrix *V,
+                   double tol, int maxiter, int *iters);
+/* Reorders and rephases the m = n eigenpairs (w, Z) so that column k of Z is
+   the eigenvector with the largest overlap with column k of Vprev, with that
+   overlap real and positive. */
+int qte_eigh_align(t_qte_eigh_tracker *t, const t_qte_cmatrix *Vprev, double *w, t_qte_cmatrix *Z);
+
+/* ----------------------------------------------------------------------------
+   Projection and time evolution (qte.initstatecalc / qte.timedev)
+---------------------------------------------------------------------------- */
+/* c = V^H psi0: coefficients of psi0 in the eigenbasis V (n x m); c is resized to m. */
+int qte_project(const t_qte_cmatrix *V, const t_qte_cvector *psi0, t_qte_cvector *c);
+/* Truncation by weight: selects the fewest coefficients, largest |c_k|^2 first,
+   whose weight reaches (1 - tol) of the total (all n with tol <= 0), at most
+   maxterms of them (no cap with maxterms <= 0). Their indices go to idx (n
+   entries) in ascending order, the weight left out, relative to the total, to
+   *dropped: ||psi - psi_kept|| / ||psi|| = sqrt(*dropped) at every t. Returns
+   the number kept, or QTE_ERR_ALLOC. */
+long qte_truncate_weight(const double complex *c, long n, double tol, long maxterms,
+                         long *idx, double *dropped);
+/* Fills the m x T phase matrix Phi(k, s) = c_k exp(-i E_k (t0 + s dt)) (any layout,
+   shape already set) with a per-step rotation, re-anchored exactly every
+   QTE_PHASE_ANCHOR steps. psi(t_s) for every step is then one zgemm V * Phi. */
+#define QTE_PHASE_ANCHOR 256
+void qte_phase_matrix(t_qte_cmatrix *Phi, const double *E, const double complex *c,
+                      double t0, double dt);
+/* The same for T arbitrary times t[0..T-1]: Phi(k, s) = c_k exp(-i E_k t[s]),
+   each column computed directly (vvsincos), with no rotation to accumulate.
+   For random access ("at <t>" in qte.timedev) rather than a grid. */
+void qte_phase_columns(t_qte_cmatrix *Phi, const double *E, const double complex *c,
+                       const double *t);
+/* Psi (n x T) = V (n x m) * Phi, with Phi (m x T) filled by qte_phase_matrix;
+   Phi and Psi already shaped, all three in the same layout. With polar set,
+   every entry of Psi is then replaced by |psi| + i arg psi. With threads > 1
+   (and n >= QTE_PARALLEL_MIN_DIM) the rows of Phi, then (component x time
+   block) tiles of Psi, each a zgemm plus its polar conversion, are spread
+   over the cores; Phi comes out the same as serially. */
+int  qte_trajectories(const t_qte_cmatrix *V, const double *E, const double complex *c,
+                      double t0, double dt, t_qte_cmatrix *Phi, t_qte_cmatrix *Psi,
+                      int polar, long threads);
+
+/* Observables: <psi(t)|O|psi(t)> = phi^H Ob phi, with phi = V^H psi(t) a column
+   of Phi and Ob = V^H O V the observable in the eigenbasis, built once per
+   eigenbasis. Every time step then costs O(m^2) (O(m) for a diagonal Ob), no
+   matter how many components psi has. */
+/* Ob (m x m) = V^H O V for the n x n observable O, or V^H diag(d) V when O is
+   NULL (d real, length n, e.g. the position grid). V, O and Ob share a layout;
+   W is resized to n x m scratch. Returns 0 or -1 (shapes, allocation). */
+int  qte_observable_basis(const t_qte_cmatrix *V, const t_qte_cmatrix *O, const double *d,
+                          t_qte_cmatrix *W, t_qte_cmatrix *Ob);
+/* e[s] = Re phi_s^H Ob phi_s for each of the T columns phi_s of Phi (m x T);
+   W is resized to m x T scratch in Phi's layout. With Ob NULL, the observable
+   is diag(d) in the eigenbasis (d length m, e.g. the energies E_k):
+   e[s] = sum_k d_k |Phi(k, s)|^2, with no scratch. */
+int  qte_expectations(const t_qte_cmatrix *Ob, const double *d, const t_qte_cmatrix *Phi,
+                      t_qte_cmatrix *W, double *e);
+
+/* ----------------------------------------------------------------------------
+   Krylov propagation (qte.propagate)
+   exp(-i H tau) v without diagonalizing H: in the Lanczos basis Q (n x m) of
+   (H, v), with T = Q^H H Q tridiagonal, exp(-i H tau) v ~ |v| Q exp(-i T tau) e_1.
+   The relative error is estimated as b |e_m^T tau phi_1(-i T tau) e_1|, with b
+   the coupling of Q to the next Lanczos vector and phi_1(z) = (e^z - 1) / z.
+   A basis costs m products H v (O(n^2 m) for a dense H); every further time
+   it serves costs O(m^2) for the estimate and one n x m product.
+---------------------------------------------------------------------------- */
+typedef struct _qte_krylov {
+    long m;                 // basis size built (fewer than asked for an invariant subspace)
+    long mmax;              // basis size the buffers hold
+    double beta;            // |v|
+    double b;               // coupling to the next basis vector (0: exact)
+    t_qte_cmatrix Q;        // n x mmax basis, column-major
+    t_qte_cvector h;        // orthogonalization coefficients
+    t_qte_cvector y;        // basis coefficients of the propagated vector
+    t_qte_cvector x;        // the vector being added, then the propagated state
+    double *T;              // mmax x mmax projection Q^H H Q
+    double *Y;              // its eigenvectors (m x m)
+    double *theta;          // its eigenvalues
+    double *work;           // dsyev workspace
+    long lwork;
+} t_qte_krylov;
+
+void qte_krylov_init(t_qte_krylov *K);
+void qte_krylov_free(t_qte_krylov *K);
+/* Builds the basis of up to m vectors for the n x n Hermitian H (any layout)
+   and v. Returns 0, QTE_ERR_ALLOC or QTE_ERR_SOLVE (dsyev, see info). */
+int qte_krylov_build(t_qte_krylov *K, const t_qte_cmatrix *H, const t_qte_cvector *v, long m,
+                     int *info);
+/* psi = exp(-i H tau) v from the last basis (psi resized to n); returns the
+   relative error estimate. */
+double qte_krylov_expm(t_qte_krylov *K, double tau, t_qte_cvector *psi);
+/* Column s of Psi (n x T, any layout, shape already set) receives
+   psi(t0 + s dt) = exp(-i H (t0 + s dt)) psi0. A basis is kept for as long as
+   its error estimate stays within tol; past that the step is halved, the
+   state advanced to the largest accepted time and a new basis of m vectors
+   built there. Returns 0, an error of qte_krylov_build, or QTE_ERR_CONVERGE
+   if some step could not meet tol (the trajectory is still complete);
+   *builds counts the bases. */
+int qte_krylov_propagate(t_qte_krylov *K, const t_qte_cmatrix *H, const t_qte_cvector *psi0,
+                         double t0, double dt, long m, double tol, t_qte_cmatrix *Psi,
+                         long *builds, int *info);
+
+/* ----------------------------------------------------------------------------
+   Split-operator propagation (qte.splitop)
+   For H = 0.5 P^2 + V with the oscillator's P^2 = F diag(m^2) F^-1 (m = 0 ..
+   n-1, F the DFT of qte_oscillator_p2_column) and V diagonal in position, one
+   Strang step of length dt is
+      psi <- e^{-i V dt/2} F e^{-i m^2 dt/2} F^-1 e^{-i V dt/2} psi:
+   two DFTs and diagonal phase factors, O(n log n) without an eigenbasis,
+   exactly unitary and accurate to O(dt^3) per step. The half steps of V
+   between two steps are merged into one. The potential is
+      V_j = 0.5 q_j^2 + f q_j,   q_j = a (-(n - 1)/2 + j),
+   qte.quantumho's oscillator (without its rounding to 5 decimals) driven by
+   a force f; a and f may change from one call to the next, and the phase
+   factors are rebuilt only when they (or dt) do. The DFTs run on vDSP when it
+   supports n (k 2^p with k = 1, 3, 5 or 15 and p >= 3), otherwise as a
+   product with the n x n DFT matrix, O(n^2) per step.
+---------------------------------------------------------------------------- */
+typedef struct _qte_strang {
+    long n;
+    void *fwd, *inv;        // vDSP DFT setups, NULL when vDSP cannot do n
+    t_qte_cmatrix F;        // DFT matrix (n x n) otherwise
+    t_qte_cvector tmp;      // its product
+    double *buf;            // split-complex state, DFT output and phase factors
+    double kin_dt;          // dt the kinetic factors were built for
+    double pot_a, pot_f, pot_dt;
+} t_qte_strang;
+
+void qte_strang_init(t_qte_strang *s);
+void qte_strang_free(t_qte_strang *s);
+/* Prepares s for dimension n (nothing to do if it already is). */
+int  qte_strang_setup(t_qte_strang *s, long n);
+/* Advances psi (length n) by steps Strang steps of dt in the potential of (a, f). */
+int  qte_strang_step(t_qte_strang *s, t_qte_cvector *psi, double a, double f, double dt, long steps);
+
+/* ----------------------------------------------------------------------------
+   Eigenbasis snapshots ("write" / "read" on qte.eigencalc and qte.timedev)
+   A fixed 128-byte header, then the m eigenvalues, the n x m eigenvectors
+   (compact, in the header's layout) and optionally m coefficients, each
+   section 64-byte aligned. Everything is native (little-endian) doubles, so
+   a snapshot is opened by mapping the file, checking the header and pointing
+   views into the mapping: no parsing and no copy, the pages load on first use.
+   The mapping is private, so writes through the views stay in this process.
+   source_hash identifies what was decomposed (qte.eigencalc: the matrix and
+   the solver settings), 0 if unknown.
+---------------------------------------------------------------------------- */
+#define QTE_SNAPSHOT_MAGIC "QTESNAP"
+#define QTE_SNAPSHOT_VERSION 1
+#define QTE_SNAPSHOT_VECTORS 1  // flags: eigenvectors present
+#define QTE_SNAPSHOT_COEFF 2    //        coefficients present
+
+typedef struct _qte_snapshot_header {
+    char magic[8];          // QTE_SNAPSHOT_MAGIC, NUL terminated
+    uint32_t version;
+    uint32_t flags;
+    int64_t n;              // eigenvector length
+    int64_t m;              // eigenpairs
+    int32_t layout;         // t_qte_layout of the eigenvectors
+    int32_t reserved;
+    uint64_t source_hash;
+    uint64_t offset[3];     // byte offsets of the eigenvalues, eigenvectors, coefficients
+    uint8_t pad[56];
+} t_qte_snapshot_header;
+
+typedef struct _qte_snapshot {
+    void *base;             // the mapping, NULL when closed
+    size_t size;
+    t_qte_snapshot_header header;
+    double *w;              // m eigenvalues
+    t_qte_cmatrix V;        // n x m view, empty without QTE_SNAPSHOT_VECTORS
+    t_qte_cvector c;        // m coefficients view, empty without QTE_SNAPSHOT_COEFF
+} t_qte_snapshot;
+
+/* Writes w (m doubles), V (n x m, any layout, NULL for none) and c (m entries,
+   NULL for none) to path, through a temporary file renamed over path, so a
+   reader never maps a half-written snapshot. Returns 0, QTE_ERR_ALLOC (shape)
+   or QTE_ERR_IO. */
+int  qte_snapshot_write(const char *path, long n, long m, const double *w, const t_qte_cmatrix *V,
+                        const t_qte_cvector *c, uint64_t source_hash);
+void qte_snapshot_init(t_qte_snapshot *s);
+/* Maps path and sets the views; s is closed first. Returns 0, QTE_ERR_IO or
+   QTE_ERR_FORMAT (s stays closed on failure). */
+int  qte_snapshot_open(t_qte_snapshot *s, const char *path);
+/* Unmaps the file; views taken from s are invalid afterwards. */
+void qte_snapshot_close(t_qte_snapshot *s);
+
+/* ----------------------------------------------------------------------------
+   Instrumentation ("stats" message, qte.profiler)
+   Each object keeps a t_qte_stats and times its message handlers in three
+   stages with qte_stats_begin / qte_stats_lap. Latencies also go into a
+   logarithmic histogram (QTE_LATENCY_STEPS bins per octave from
+   QTE_LATENCY_MIN seconds) from which p99 is read, so recording costs O(1)
+   and no memory. bytes counts qte_core storage (qte_aligned_alloc) allocated
+   by the external's module inside timed sections; atoms counts the atoms the
+   object sent.
+---------------------------------------------------------------------------- */
+#define QTE_LATENCY_MIN 1e-7
+#define QTE_LATENCY_STEPS 8
+#define QTE_LATENCY_BINS 256
+
+typedef enum _qte_stage {
+    QTE_STAGE_PARSE = 0,    // reading input (atoms, jit.matrix) into storage
+    QTE_STAGE_COMPUTE = 1,  // the numerical work
+    QTE_STAGE_OUTPUT = 2,   // building the output, up to the outlet call (which runs the
+                            // objects downstream, so it is not included)
+    QTE_STAGES = 3
+} t_qte_stage;
+
+typedef struct _qte_latency {
+    uint64_t count;
+    double last, sum, max;  // seconds
+    uint32_t hist[QTE_LATENCY_BINS];
+} t_qte_latency;
+
+typedef struct _qte_stats {
+    t_qte_latency stage[QTE_STAGES];
+    uint64_t bytes;
+    uint64_t atoms;
+    uint64_t mark;          // qte_alloc_total() when the current section started
+} t_qte_stats;
+
+/* Monotonic time in seconds. */
+double   qte_time_now(void);
+/* Bytes allocated by qte_aligned_alloc in this module so far. */
+uint64_t qte_alloc_total(void);
+void     qte_stats_reset(t_qte_stats *s);
+void     qte_latency_add(t_qte_latency *l, double seconds);
+/* Latency below which a fraction q of the recorded calls fall (bin upper edge, at most max). */
+double   qte_latency_quantile(const t_qte_latency *l, double q);
+/* Starts a timed section; returns the time to pass to qte_stats_lap. */
+double   qte_stats_begin(t_qte_stats *s);
+/* Records the time since t0 for stage and returns the current time, so
+   consecutive stages chain: t = qte_stats_lap(s, QTE_STAGE_PARSE, t). */
+double   qte_stats_lap(t_qte_stats *s, t_qte_stage stage, double t0);
+
+#endif
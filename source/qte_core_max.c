@@ -0,0 +1,340 @@
+/* qte_core_max.c – Max-side conversions for the qte_core types (see qte_core_max.h) */
+
+#include "qte_core_max.h"
+#include "ext_obex.h"
+#include "jit.common.h"
+#include <errno.h>
+#include <string.h>
+
+/* ----------------------------------------------------------------------------
+   Atom lists
+---------------------------------------------------------------------------- */
+int qte_atoms_to_cmatrix(long argc, const t_atom *argv, t_qte_cmatrix *A, t_qte_layout order) {
+    long rows = A->rows, cols = A->cols;
+    if (argc != 2 * rows * cols)
+        return -1;
+    const t_atom *ap = argv;
+    if (order == QTE_ROW_MAJOR) {
+        for (long i = 0; i < rows; i++) {
+            for (long j = 0; j < cols; j++, ap += 2)
+                *qte_cmatrix_at(A, i, j) = atom_getfloat(ap) + I * atom_getfloat(ap + 1);
+        }
+    } else {
+        for (long j = 0; j < cols; j++) {
+            for (long i = 0; i < rows; i++, ap += 2)
+                *qte_cmatrix_at(A, i, j) = atom_getfloat(ap) + I * atom_getfloat(ap + 1);
+        }
+    }
+    return 0;
+}
+
+void qte_atoms_from_cmatrix(t_atom *argv, const t_qte_cmatrix *A, t_qte_layout order) {
+    long rows = A->rows, cols = A->cols;
+    t_atom *ap = argv;
+    if (order == QTE_ROW_MAJOR) {
+        for (long i = 0; i < rows; i++) {
+            for (long j = 0; j < cols; j++, ap += 2) {
+                double complex z = *qte_cmatrix_at(A, i, j);
+                atom_setfloat(ap, creal(z));
+                atom_setfloat(ap + 1, cimag(z));
+            }
+        }
+    } else {
+        for (long j = 0; j < cols; j++) {
+            for (long i = 0; i < rows; i++, ap += 2) {
+                double complex z = *qte_cmatrix_at(A, i, j);
+                atom_setfloat(ap, creal(z));
+                atom_setfloat(ap + 1, cimag(z));
+            }
+        }
+    }
+}
+
+int qte_atoms_to_cvector(long argc, const t_atom *argv, t_qte_cvector *v) {
+    if (argc != 2 * v->n)
+        return -1;
+    for (long k = 0; k < v->n; k++)
+        v->data[k] = atom_getfloat(argv + 2 * k) + I * atom_getfloat(argv + 2 * k + 1);
+    return 0;
+}
+
+void qte_atoms_from_cvector(t_atom *argv, const t_qte_cvector *v) {
+    for (long k = 0; k < v->n; k++) {
+        atom_setfloat(argv + 2 * k, creal(v->data[k]));
+        atom_setfloat(argv + 2 * k + 1, cimag(v->data[k]));
+    }
+}
+
+int qte_atoms_reserve(t_atom **list, long *list_size, long size, t_qte_stats *stats) {
+    if (*list_size >= size)
+        return 0;
+    if (*list)
+        sysmem_freeptr(*list);
+    *list_size = 0;
+    *list = (t_atom *)sysmem_newptr(size * sizeof(t_atom));
+    if (!*list)
+        return -1;
+    *list_size = size;
+    stats->bytes += size * sizeof(t_atom);
+    return 0;
+}
+
+/* ----------------------------------------------------------------------------
+   Trajectory lists (the qte.timedev "compute" format)
+---------------------------------------------------------------------------- */
+void qte_trajectory_lists(const t_qte_cmatrix *Psi, double tmin, double dt, t_atom *list,
+                          void *out_mag, void *out_phase, t_qte_stats *stats, double t) {
+    long n = Psi->rows, T = Psi->cols;
+    long size = 1 + 2 * T;
+    // The phase line reuses the atoms of the magnitude line, so the times
+    // are written once per component.
+    for (long i = 0; i < n; i++) {
+        const double complex *row = Psi->data + i * Psi->ld;
+        atom_setlong(list, i);
+        for (long s = 0; s < T; s++) {
+            atom_setfloat(list + 1 + 2 * s, tmin + s * dt);
+            atom_setfloat(list + 2 + 2 * s, cabs(row[s]));
+        }
+        qte_stats_lap(stats, QTE_STAGE_OUTPUT, t);
+        outlet_list(out_mag, gensym("list"), size, list);
+        t = qte_time_now();
+        for (long s = 0; s < T; s++)
+            atom_setfloat(list + 2 + 2 * s, carg(row[s]));
+        qte_stats_lap(stats, QTE_STAGE_OUTPUT, t);
+        outlet_list(out_phase, gensym("list"), size, list);
+        t = qte_time_now();
+    }
+    stats->atoms += 2 * n * size;
+}
+
+/* ----------------------------------------------------------------------------
+   jit.matrix transport – each jit.matrix row is a contiguous run of
+   interleaved (real, imag) cells, i.e. one row of double complex.
+---------------------------------------------------------------------------- */
+void *qte_jit_outmatrix_new(t_symbol **name) {
+    t_jit_matrix_info info;
+    jit_matrix_info_default(&info);
+    info.type = _jit_sym_float64;
+    info.planecount = 2;
+    info.dimcount = 2;
+    info.dim[0] = 1;
+    info.dim[1] = 1;
+    void *m = jit_object_new(_jit_sym_jit_matrix, &info);
+    if (!m)
+        return NULL;
+    *name = jit_symbol_unique();
+    return jit_object_register(m, *name);
+}
+
+static void *qte_jit_matrix_find(t_symbol *name, t_jit_matrix_info *info) {
+    void *m = jit_object_findregistered(name);
+    if (!m || !jit_object_method(m, _jit_sym_class_jit_matrix))
+        return NULL;
+    jit_object_method(m, _jit_sym_getinfo, info);
+    if (info->type != _jit_sym_float64 || info->planecount != 2 || info->dimcount != 2)
+        return NULL;
+    return m;
+}
+
+int qte_jit_matrix_dims(t_symbol *name, long *rows, long *cols) {
+    t_jit_matrix_info info;
+    if (!qte_jit_matrix_find(name, &info))
+        return -1;
+    *rows = info.dim[1];
+    *cols = info.dim[0];
+    return 0;
+}
+
+int qte_jit_matrix_read(t_symbol *name, t_qte_cmatrix *A) {
+    t_jit_matrix_info info;
+    void *m = qte_jit_matrix_find(name, &info);
+    if (!m)
+        return -1;
+    char *bp = NULL;
+    long savelock = (long)jit_object_method(m, _jit_sym_lock, 1);
+    jit_object_method(m, _jit_sym_getinfo, &info);
+    jit_object_method(m, _jit_sym_getdata, &bp);
+    long rows = info.dim[1], cols = info.dim[0];
+    if (!bp || qte_cmatrix_resize(A, rows, cols, A->layout)) {
+        jit_object_method(m, _jit_sym_lock, savelock);
+        return -1;
+    }
+    for (long i = 0; i < rows; i++) {
+        const double complex *row = (const double complex *)(bp + i * info.dimstride[1]);
+        if (A->layout == QTE_ROW_MAJOR) {
+            memcpy(A->data + i * A->ld, row, cols * sizeof(double complex));
+        } else {
+            for (long j = 0; j < cols; j++)
+                A->data[j * A->ld + i] = row[j];
+        }
+    }
+    jit_object_method(m, _jit_sym_lock, savelock);
+    return 0;
+}
+
+int qte_jit_matrix_write(void *matrix, const t_qte_cmatrix *A) {
+    if (!matrix)
+        return -1;
+    t_jit_matrix_info info;
+    char *bp = NULL;
+    long rows = A->rows, cols = A->cols;
+    long savelock = (long)jit_object_method(matrix, _jit_sym_lock, 1);
+    jit_object_method(matrix, _jit_sym_getinfo, &info);
+    if (info.dim[0] != cols || info.dim[1] != rows) {
+        info.dim[0] = cols;
+        info.dim[1] = rows;
+        jit_object_method(matrix, _jit_sym_setinfo, &info);
+        jit_object_method(matrix, _jit_sym_getinfo, &info);
+    }
+    jit_object_method(matrix, _jit_sym_getdata, &bp);
+    if (!bp) {
+        jit_object_method(matrix, _jit_sym_lock, savelock);
+        return -1;
+    }
+    for (long i = 0; i < rows; i++) {
+        double complex *row = (double complex *)(bp + i * info.dimstride[1]);
+        if (A->layout == QTE_ROW_MAJOR) {
+            memcpy(row, A->data + i * A->ld, cols * sizeof(double complex));
+        } else {
+            for (long j = 0; j < cols; j++)
+                row[j] = A->data[j * A->ld + i];
+        }
+    }
+    jit_object_method(matrix, _jit_sym_lock, savelock);
+    return 0;
+}
+
+/* ----------------------------------------------------------------------------
+   Snapshot files
+---------------------------------------------------------------------------- */
+int qte_snapshot_path(t_object *x, t_symbol *name, int write, char *path) {
+    if (!name || name == gensym("")) {
+        object_error(x, "%s needs a file name", write ? "write" : "read");
+        return -1;
+    }
+    // "Macintosh HD:/..." or "/Users/...": already absolute.
+    if (strchr(name->s_name, ':') || name->s_name[0] == '/') {
+        if (path_nameconform(name->s_name, path, PATH_STYLE_NATIVE, PATH_TYPE_BOOT)) {
+            object_error(x, "%s: bad path", name->s_name);
+            return -1;
+        }
+        return 0;
+    }
+    char filename[MAX_PATH_CHARS];
+    short vol = path_getdefault();
+    strncpy(filename, name->s_name, MAX_PATH_CHARS - 1);
+    filename[MAX_PATH_CHARS - 1] = 0;
+    if (!write) {
+        t_fourcc type;
+        if (locatefile_extended(filename, &vol, &type, NULL, 0)) {
+            object_error(x, "%s: file not found", name->s_name);
+            return -1;
+        }
+    }
+    if (path_toabsolutesystempath(vol, filename, path)) {
+        object_error(x, "%s: bad path", name->s_name);
+        return -1;
+    }
+    return 0;
+}
+
+void qte_snapshot_error(t_object *x, int err, const char *path) {
+    if (err == QTE_ERR_FORMAT)
+        object_error(x, "%s: not a qte snapshot (or an unsupported version)", path);
+    else if (err == QTE_ERR_IO)
+        object_error(x, "%s: %s", path, strerror(errno));
+    else
+        object_error(x, "%s: memory allocation failed", path);
+}
+
+/* ----------------------------------------------------------------------------
+   Instrumentation
+---------------------------------------------------------------------------- */
+#define QTE_STATS_REGISTRY_VERSION 1
+
+typedef struct _qte_stats_registry {
+    long version;
+    long next_id;
+    t_qte_stats_entry *head;
+} t_qte_stats_registry;
+
+static t_qte_stats_registry *qte_stats_registry(int create) {
+    t_symbol *key = gensym("__qte_stats_registry");
+    t_qte_stats_registry *r = (t_qte_stats_registry *)key->s_thing;
+    if (!r && create) {
+        r = (t_qte_stats_registry *)sysmem_newptrclear(sizeof(*r));
+        if (r) {
+            r->version = QTE_STATS_REGISTRY_VERSION;
+            key->s_thing = (struct object *)r;
+        }
+    }
+    return (r && r->version == QTE_STATS_REGISTRY_VERSION) ? r : NULL;
+}
+
+void qte_stats_register(t_object *x, t_qte_stats *s) {
+    qte_stats_reset(s);
+    t_qte_stats_registry *r = qte_stats_registry(1);
+    t_qte_stats_entry *e = r ? (t_qte_stats_entry *)sysmem_newptr(sizeof(*e)) : NULL;
+    if (!e)
+        return;
+    e->obj = x;
+    e->stats = s;
+    e->id = r->next_id++;
+    e->next = r->head;
+    r->head = e;
+}
+
+void qte_stats_unregister(t_object *x) {
+    t_qte_stats_registry *r = qte_stats_registry(0);
+    if (!r)
+        return;
+    for (t_qte_stats_entry **ep = &r->head; *ep; ep = &(*ep)->next) {
+        if ((*ep)->obj == x) {
+            t_qte_stats_entry *e = *ep;
+            *ep = e->next;
+            sysmem_freeptr(e);
+            return;
+        }
+    }
+}
+
+t_qte_stats_entry *qte_stats_instances(void) {
+    t_qte_stats_registry *r = qte_stats_registry(0);
+    return r ? r->head : NULL;
+}
+
+void qte_stats_message(t_object *x, t_qte_stats *s, void *outlet, long argc, t_atom *argv) {
+    static const char *names[QTE_STAGES] = { "parse", "compute", "output" };
+    if (argc > 0 && atom_getsym(argv) == gensym("reset")) {
+        qte_stats_reset(s);
+        return;
+    }
+    t_atom a[6];
+    for (int k = 0; k < QTE_STAGES; k++) {
+        const t_qte_latency *l = &s->stage[k];
+        double mean = l->count ? l->sum / (double)l->count : 0.0;
+        double p99 = qte_latency_quantile(l, 0.99);
+        if (!outlet) {
+            object_post(x, "stats %s %llu calls, last %.3f mean %.3f max %.3f p99 %.3f ms", names[k],
+                        (unsigned long long)l->count, 1e3 * l->last, 1e3 * mean, 1e3 * l->max, 1e3 * p99);
+            continue;
+        }
+        atom_setsym(a, gensym(names[k]));
+        atom_setlong(a + 1, (t_atom_long)l->count);
+        atom_setfloat(a + 2, 1e3 * l->last);
+        atom_setfloat(a + 3, 1e3 * mean);
+        atom_setfloat(a + 4, 1e3 * l->max);
+        atom_setfloat(a + 5, 1e3 * p99);
+        outlet_anything(outlet, gensym("stats"), 6, a);
+    }
+    if (!outlet) {
+        object_post(x, "stats bytes %llu atoms %llu", (unsigned long long)s->bytes, (unsigned long long)s->atoms);
+        return;
+    }
+    atom_setsym(a, gensym("bytes"));
+    atom_setlong(a + 1, (t_atom_long)s->bytes);
+    outlet_anything(outlet, gensym("stats"), 2, a);
+    atom_setsym(a, gensym("atoms"));
+    atom_setlong(a + 1, (t_atom_long)s->atoms);
+    outlet_anything(outlet, gensym("stats"), 2, a);
+}
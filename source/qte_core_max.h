@@ -0,0 +1,77 @@
+/* qte_core_max.h – Max-side conversions for the qte_core types
+ *
+ * Complex matrices travel between qte.* objects either as flat lists of
+ * (real, imag) float pairs or as 2-plane float64 jit.matrix objects
+ * (plane 0 = real, plane 1 = imag, dim[0] = columns, dim[1] = rows).
+ * These helpers move t_qte_cmatrix / t_qte_cvector data in and out of both.
+ *
+ * "order" names the element order of the atom list: QTE_ROW_MAJOR lists the
+ * rows one after the other, QTE_COL_MAJOR the columns (e.g. one eigenvector
+ * after the other). It is independent of the matrix's own storage layout.
+ *
+ * Like qte_core, these return 0 on success and -1 on failure.
+ */
+
+#ifndef QTE_CORE_MAX_H
+#define QTE_CORE_MAX_H
+
+#include "ext.h"
+#include "qte_core.h"
+
+/* Atom lists: 2 floats per element; the shape of A (or v) must already be set. */
+int  qte_atoms_to_cmatrix(long argc, const t_atom *argv, t_qte_cmatrix *A, t_qte_layout order);
+void qte_atoms_from_cmatrix(t_atom *argv, const t_qte_cmatrix *A, t_qte_layout order);
+int  qte_atoms_to_cvector(long argc, const t_atom *argv, t_qte_cvector *v);
+void qte_atoms_from_cvector(t_atom *argv, const t_qte_cvector *v);
+/* Makes sure *list (sysmem, reused from call to call) holds size atoms, adding
+   a new allocation to stats->bytes. */
+int  qte_atoms_reserve(t_atom **list, long *list_size, long size, t_qte_stats *stats);
+
+/* Sends the trajectories Psi (n x T row-major, row i = psi_i at tmin + s dt) in the
+   qte.timedev format: for each component i, (i, t0, |psi_i(t0)|, t1, ...) from
+   out_mag, then (i, t0, arg psi_i(t0), ...) from out_phase. list holds 1 + 2*T
+   atoms; the output stage of stats is timed from t. */
+void qte_trajectory_lists(const t_qte_cmatrix *Psi, double tmin, double dt, t_atom *list,
+                          void *out_mag, void *out_phase, t_qte_stats *stats, double t);
+
+/* jit.matrix transport */
+void *qte_jit_outmatrix_new(t_symbol **name);
+/* Shape of the named matrix; fails unless it is a 2-plane float64 2D jit.matrix. */
+int   qte_jit_matrix_dims(t_symbol *name, long *rows, long *cols);
+/* Reads the named matrix into A, resized to its shape (keeping A's layout). */
+int   qte_jit_matrix_read(t_symbol *name, t_qte_cmatrix *A);
+/* Writes A into the registered matrix, resizing it to A's shape. */
+int   qte_jit_matrix_write(void *matrix, const t_qte_cmatrix *A);
+
+/* Snapshot files – resolves the argument of a "write" / "read" message to a
+   native absolute path (MAX_PATH_CHARS): an absolute name is only conformed, a
+   relative one is looked up in the search path (read) or placed in the default
+   folder (write). Reports a failure for x. */
+int   qte_snapshot_path(t_object *x, t_symbol *name, int write, char *path);
+/* Posts the error of a failed qte_snapshot_open / qte_snapshot_write. */
+void  qte_snapshot_error(t_object *x, int err, const char *path);
+
+/* Instrumentation – every qte.* object registers its t_qte_stats in its
+   constructor and unregisters it in its destructor, both on the main thread.
+   Each external links its own copy of this code, so the list of live
+   instances hangs off a symbol's s_thing, where all of them and qte.profiler
+   find the same one. */
+typedef struct _qte_stats_entry {
+    t_object *obj;
+    t_qte_stats *stats;
+    long id;                        // registration number, unique for the session
+    struct _qte_stats_entry *next;
+} t_qte_stats_entry;
+
+void qte_stats_register(t_object *x, t_qte_stats *s);
+void qte_stats_unregister(t_object *x);
+/* Live instances, newest first. */
+t_qte_stats_entry *qte_stats_instances(void);
+/* The "stats" message: sends "stats <stage> count last mean max p99" (ms) for
+   parse, compute and output, then "stats bytes <n>" and "stats atoms <n>".
+   "stats reset" clears the counters instead. Every qte.* object passes its
+   right (status) outlet; with none, the same lines are posted to the Max
+   window for x. */
+void qte_stats_message(t_object *x, t_qte_stats *s, void *outlet, long argc, t_atom *argv);
+
+#endif
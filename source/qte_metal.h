@@ -0,0 +1,76 @@
+/* qte_metal.h – Optional Metal backend of the qte_core time evolution
+ *
+ * Psi = V * Phi on the GPU, for qte.timedev @backend metal. The GPU has no
+ * double precision, so only the product runs there: the phases
+ * c_k exp(-i E_k t) are still built on the CPU in double (qte_phase_matrix),
+ * where single precision would lose E_k t for large t, and are rounded to
+ * float only as factors of modulus <= |c_k|. The complex product is one
+ * real single-precision matrix multiplication (MetalPerformanceShaders) of
+ *
+ *    [Re V  -Im V]   [Re Phi]   [Re Psi]
+ *    [Im V   Re V] * [Im Phi] = [Im Psi]
+ *
+ * followed by a kernel that turns each amplitude into |psi| and arg psi, so
+ * the results carry about 7 significant digits, the precision of a buffer~.
+ * The realified V stays resident in a GPU buffer between calls, keyed by the
+ * caller, and is uploaded again only when the key or the shape changes. Time
+ * steps go through in blocks of QTE_METAL_TIME_BLOCK columns, so the GPU
+ * storage does not grow with tsteps.
+ *
+ * The backend is built as its own target (qte_metal, qte_metal.m), which
+ * defines QTE_METAL for the externals linking it. Without it the functions
+ * below are inline stubs that report no device, and callers stay on the
+ * CPU. A context is not thread-safe; give every concurrent caller its own.
+ */
+
+#ifndef QTE_METAL_H
+#define QTE_METAL_H
+
+#include "qte_core.h"
+
+// Below this many components the CPU zgemm beats the upload and dispatch.
+#define QTE_METAL_MIN_DIM 256
+#define QTE_METAL_TIME_BLOCK 1024
+
+typedef struct _qte_metal t_qte_metal;
+
+#ifdef QTE_METAL
+
+/* Whether a Metal device is present. */
+int          qte_metal_available(void);
+/* A context on the default device, NULL if there is none or it cannot be set up. */
+t_qte_metal *qte_metal_new(void);
+void         qte_metal_free(t_qte_metal *g);
+/* Psi (n x T) = V (n x m) * Phi (m x T), then every entry replaced by
+   |psi| + i arg psi, as qte_trajectories with polar set. All three
+   row-major, shapes already set; Phi as filled by qte_phase_matrix. key
+   identifies the contents of V: while it and V's shape stay the same, the
+   resident copy is used and V is not read. Returns 0,
+   QTE_ERR_ALLOC (shapes, GPU storage) or QTE_ERR_SOLVE (the GPU reported an
+   error); Psi is incomplete on failure. */
+int          qte_metal_trajectories(t_qte_metal *g, uint64_t key, const t_qte_cmatrix *V,
+                                    const t_qte_cmatrix *Phi, t_qte_cmatrix *Psi);
+
+#else
+
+static inline int qte_metal_available(void) {
+    return 0;
+}
+
+static inline t_qte_metal *qte_metal_new(void) {
+    return NULL;
+}
+
+static inline void qte_metal_free(t_qte_metal *g) {
+    (void)g;
+}
+
+static inline int qte_metal_trajectories(t_qte_metal *g, uint64_t key, const t_qte_cmatrix *V,
+                                         const t_qte_cmatrix *Phi, t_qte_cmatrix *Psi) {
+    (void)g, (void)key, (void)V, (void)Phi, (void)Psi;
+    return QTE_ERR_SOLVE;
+}
+
+#endif
+
+#endif
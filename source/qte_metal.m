@@ -0,0 +1,271 @@
+/* qte_metal.m – Metal backend of the qte_core time evolution (see qte_metal.h)
+ *
+ * Psi = V * Phi as one single-precision MPSMatrixMultiplication of the
+ * realified matrices, and a kernel that writes |psi| and arg psi, per block
+ * of QTE_METAL_TIME_BLOCK time steps. Every buffer lives in shared storage,
+ * so filling Phi and reading the result back are plain loops on the CPU.
+ * The device and the kernel are set up once per process, each context keeps
+ * a command queue, the resident V and the block buffers. Built without ARC.
+ */
+
+#import <Foundation/Foundation.h>
+#import <Metal/Metal.h>
+#import <MetalPerformanceShaders/MetalPerformanceShaders.h>
+
+#include "qte_metal.h"
+#include <complex.h>
+#include <string.h>
+
+// |psi| and arg psi from the realified Psi: rows i and n + i of psi hold
+// the real and imaginary parts of component i. dims = (n, steps, ld).
+static const char *qte_metal_source =
+    "#include <metal_stdlib>\n"
+    "using namespace metal;\n"
+    "kernel void qte_polar(device const float *psi [[buffer(0)]],\n"
+    "                      device float2 *out [[buffer(1)]],\n"
+    "                      constant uint3 &dims [[buffer(2)]],\n"
+    "                      uint2 gid [[thread_position_in_grid]]) {\n"
+    "    if (gid.x >= dims.y || gid.y >= dims.x)\n"
+    "        return;\n"
+    "    float re = psi[gid.y * dims.z + gid.x];\n"
+    "    float im = psi[(gid.y + dims.x) * dims.z + gid.x];\n"
+    "    out[gid.y * dims.y + gid.x] = float2(length(float2(re, im)), atan2(im, re));\n"
+    "}\n";
+
+static id<MTLDevice> qte_metal_device = nil;
+static id<MTLComputePipelineState> qte_metal_polar = nil;
+
+// Once per process: the default device, if MPS supports it, and the kernel.
+static void qte_metal_setup(void) {
+    static dispatch_once_t once;
+    dispatch_once(&once, ^{
+        @autoreleasepool {
+            id<MTLDevice> device = MTLCreateSystemDefaultDevice();
+            if (!device)
+                return;
+            if (!MPSSupportsMTLDevice(device)) {
+                [device release];
+                return;
+            }
+            MTLCompileOptions *options = [[MTLCompileOptions alloc] init];
+            options.fastMathEnabled = NO;       // full-accuracy atan2
+            NSError *error = nil;
+            id<MTLLibrary> library = [device newLibraryWithSource:[NSString stringWithUTF8String:qte_metal_source]
+                                                          options:options
+                                                            error:&error];
+            [options release];
+            id<MTLFunction> function = library ? [library newFunctionWithName:@"qte_polar"] : nil;
+            id<MTLComputePipelineState> polar =
+                function ? [device newComputePipelineStateWithFunction:function error:&error] : nil;
+            [function release];
+            [library release];
+            if (!polar) {
+                [device release];
+                return;
+            }
+            qte_metal_polar = polar;
+            qte_metal_device = device;
+        }
+    });
+}
+
+struct _qte_metal {
+    id<MTLCommandQueue> queue;
+
+    // Resident eigenstates [[Re V, -Im V], [Im V, Re V]], 2n x 2m floats.
+    id<MTLBuffer> V;
+    long vn;
+    long vm;
+    size_t v_row;              // bytes per row
+    uint64_t key;
+    int resident;              // V holds the matrix of key
+
+    // Per block: Phi realified (2m x block), Psi realified (2n x block), polar Psi (n x block).
+    id<MTLBuffer> phi;
+    id<MTLBuffer> psi;
+    id<MTLBuffer> out;
+    long bn;                   // n and m they are sized for
+    long bm;
+    size_t block_row;          // bytes per row of phi and psi
+};
+
+int qte_metal_available(void) {
+    qte_metal_setup();
+    return qte_metal_device != nil;
+}
+
+t_qte_metal *qte_metal_new(void) {
+    qte_metal_setup();
+    if (!qte_metal_device)
+        return NULL;
+    t_qte_metal *g = (t_qte_metal *)calloc(1, sizeof(*g));
+    if (!g)
+        return NULL;
+    g->queue = [qte_metal_device newCommandQueue];
+    if (!g->queue) {
+        free(g);
+        return NULL;
+    }
+    return g;
+}
+
+static void qte_metal_release_blocks(t_qte_metal *g) {
+    [g->phi release];
+    [g->psi release];
+    [g->out release];
+    g->phi = g->psi = g->out = nil;
+    g->bn = g->bm = 0;
+}
+
+void qte_metal_free(t_qte_metal *g) {
+    if (!g)
+        return;
+    [g->V release];
+    qte_metal_release_blocks(g);
+    [g->queue release];
+    free(g);
+}
+
+/* Uploads V unless the resident copy is that of key. */
+static int qte_metal_upload(t_qte_metal *g, uint64_t key, const t_qte_cmatrix *V) {
+    long n = V->rows, m = V->cols;
+    if (g->resident && g->key == key && g->vn == n && g->vm == m)
+        return 0;
+    g->resident = 0;
+    if (!g->V || g->vn != n || g->vm != m) {
+        [g->V release];
+        g->v_row = [MPSMatrixDescriptor rowBytesFromColumns:2 * m dataType:MPSDataTypeFloat32];
+        g->V = [qte_metal_device newBufferWithLength:2 * n * g->v_row options:MTLResourceStorageModeShared];
+        if (!g->V)
+            return QTE_ERR_ALLOC;
+        g->vn = n;
+        g->vm = m;
+    }
+    char *base = (char *)[g->V contents];
+    for (long i = 0; i < n; i++) {
+        const double complex *src = V->data + i * V->ld;
+        float *top = (float *)(base + i * g->v_row);
+        float *bottom = (float *)(base + (n + i) * g->v_row);
+        for (long k = 0; k < m; k++) {
+            float re = (float)creal(src[k]), im = (float)cimag(src[k]);
+            top[k] = re;
+            top[m + k] = -im;
+            bottom[k] = im;
+            bottom[m + k] = re;
+        }
+    }
+    g->key = key;
+    g->resident = 1;
+    return 0;
+}
+
+static int qte_metal_reserve_blocks(t_qte_metal *g, long n, long m) {
+    if (g->phi && g->bn == n && g->bm == m)
+        return 0;
+    qte_metal_release_blocks(g);
+    g->block_row = [MPSMatrixDescriptor rowBytesFromColumns:QTE_METAL_TIME_BLOCK dataType:MPSDataTypeFloat32];
+    g->phi = [qte_metal_device newBufferWithLength:2 * m * g->block_row options:MTLResourceStorageModeShared];
+    g->psi = [qte_metal_device newBufferWithLength:2 * n * g->block_row options:MTLResourceStorageModeShared];
+    g->out = [qte_metal_device newBufferWithLength:n * QTE_METAL_TIME_BLOCK * 2 * sizeof(float)
+                                           options:MTLResourceStorageModeShared];
+    if (!g->phi || !g->psi || !g->out) {
+        qte_metal_release_blocks(g);
+        return QTE_ERR_ALLOC;
+    }
+    g->bn = n;
+    g->bm = m;
+    return 0;
+}
+
+int qte_metal_trajectories(t_qte_metal *g, uint64_t key, const t_qte_cmatrix *V,
+                           const t_qte_cmatrix *Phi, t_qte_cmatrix *Psi) {
+    long n = V->rows, m = V->cols, tsteps = Phi->cols;
+    if (!g || V->layout != QTE_ROW_MAJOR || Phi->layout != QTE_ROW_MAJOR || Psi->layout != QTE_ROW_MAJOR ||
+        Phi->rows != m || Psi->rows != n || Psi->cols != tsteps)
+        return QTE_ERR_ALLOC;
+    if (n <= 0 || tsteps <= 0)
+        return 0;
+    int err = qte_metal_upload(g, key, V);
+    if (!err)
+        err = qte_metal_reserve_blocks(g, n, m);
+    if (err)
+        return err;
+
+    NSUInteger width = qte_metal_polar.threadExecutionWidth;
+    NSUInteger height = qte_metal_polar.maxTotalThreadsPerThreadgroup / width;
+    MPSMatrixDescriptor *vdesc = [MPSMatrixDescriptor matrixDescriptorWithRows:2 * n
+                                                                       columns:2 * m
+                                                                      rowBytes:g->v_row
+                                                                      dataType:MPSDataTypeFloat32];
+    MPSMatrix *vmat = [[MPSMatrix alloc] initWithBuffer:g->V descriptor:vdesc];
+    MPSMatrixMultiplication *gemm = nil;
+    long gemm_steps = 0;
+    for (long s0 = 0; s0 < tsteps && !err; s0 += QTE_METAL_TIME_BLOCK) {
+        @autoreleasepool {
+            long steps = s0 + QTE_METAL_TIME_BLOCK < tsteps ? QTE_METAL_TIME_BLOCK : tsteps - s0;
+            char *phi = (char *)[g->phi contents];
+            for (long k = 0; k < m; k++) {
+                const double complex *src = Phi->data + k * Phi->ld + s0;
+                float *re = (float *)(phi + k * g->block_row);
+                float *im = (float *)(phi + (m + k) * g->block_row);
+                for (long t = 0; t < steps; t++) {
+                    re[t] = (float)creal(src[t]);
+                    im[t] = (float)cimag(src[t]);
+                }
+            }
+            if (steps != gemm_steps) {     // only the last block is shorter
+                [gemm release];
+                gemm = [[MPSMatrixMultiplication alloc] initWithDevice:qte_metal_device
+                                                         transposeLeft:NO
+                                                        transposeRight:NO
+                                                            resultRows:2 * n
+                                                         resultColumns:steps
+                                                       interiorColumns:2 * m
+                                                                 alpha:1.0
+                                                                  beta:0.0];
+                gemm_steps = steps;
+            }
+            MPSMatrix *phimat = [[[MPSMatrix alloc]
+                initWithBuffer:g->phi
+                    descriptor:[MPSMatrixDescriptor matrixDescriptorWithRows:2 * m
+                                                                     columns:steps
+                                                                    rowBytes:g->block_row
+                                                                    dataType:MPSDataTypeFloat32]] autorelease];
+            MPSMatrix *psimat = [[[MPSMatrix alloc]
+                initWithBuffer:g->psi
+                    descriptor:[MPSMatrixDescriptor matrixDescriptorWithRows:2 * n
+                                                                     columns:steps
+                                                                    rowBytes:g->block_row
+                                                                    dataType:MPSDataTypeFloat32]] autorelease];
+
+            id<MTLCommandBuffer> cmd = [g->queue commandBuffer];
+            [gemm encodeToCommandBuffer:cmd leftMatrix:vmat rightMatrix:phimat resultMatrix:psimat];
+            id<MTLComputeCommandEncoder> enc = [cmd computeCommandEncoder];
+            uint32_t dims[4] = { (uint32_t)n, (uint32_t)steps, (uint32_t)(g->block_row / sizeof(float)), 0 };
+            [enc setComputePipelineState:qte_metal_polar];
+            [enc setBuffer:g->psi offset:0 atIndex:0];
+            [enc setBuffer:g->out offset:0 atIndex:1];
+            [enc setBytes:dims length:sizeof(dims) atIndex:2];
+            [enc dispatchThreadgroups:MTLSizeMake((steps + width - 1) / width, (n + height - 1) / height, 1)
+                threadsPerThreadgroup:MTLSizeMake(width, height, 1)];
+            [enc endEncoding];
+            [cmd commit];
+            [cmd waitUntilCompleted];
+            if (cmd.status != MTLCommandBufferStatusCompleted) {
+                err = QTE_ERR_SOLVE;
+                continue;
+            }
+
+            const float *out = (const float *)[g->out contents];
+            for (long i = 0; i < n; i++) {
+                const float *src = out + 2 * i * steps;
+                double complex *dst = Psi->data + i * Psi->ld + s0;
+                for (long t = 0; t < steps; t++)
+                    dst[t] = src[2 * t] + I * src[2 * t + 1];
+            }
+        }
+    }
+    [gemm release];
+    [vmat release];
+    return err;
+}
@@ -0,0 +1,495 @@
+/* qte_tests.c – Standalone checks of the qte_core numerics (no Max SDK)
+ *
+ * Each case compares a fast path of qte_core with a plain reference built
+ * from the dense zheevd decomposition:
+ *    - lanczos   : lowest eigenpairs of a sparse matrix whose eigenvalues come
+ *                  in threes, every copy found                 (qte.eigencalc @sparse)
+ *    - blocks    : block and parity splits against one zheevd (qte.eigencalc @blocks)
+ *    - truncate  : fewest coefficients reaching a weight, capped by maxterms
+ *                                                              (qte.timedev @truncate)
+ *    - krylov    : exp(-i H t) v from a Krylov basis against the eigenbasis
+ *                                                              (qte.propagate)
+ *    - strang    : split-operator steps against exact evolution, with the
+ *                  error falling as dt^2                       (qte.splitop)
+ *    - snapshot  : write / open round trip and a rejected file (write / read)
+ *
+ * Usage: qte_tests
+ *
+ * Prints one line per case and returns 0 if every check passed, 1 otherwise.
+ * Registered with CTest in CMakeLists.txt.
+ */
+
+#include "qte_core.h"
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+static long qte_tests_failures;
+
+#define QTE_TESTS_CHECK(cond, ...)                          \
+    do {                                                    \
+        if (!(cond)) {                                      \
+            fprintf(stderr, "  %s:%d: ", __FILE__, __LINE__);\
+            fprintf(stderr, __VA_ARGS__);                   \
+            fprintf(stderr, "\n");                          \
+            qte_tests_failures++;                           \
+        }                                                   \
+    } while (0)
+
+/* ----------------------------------------------------------------------------
+   Dense references
+---------------------------------------------------------------------------- */
+/* All eigenpairs of the Hermitian H (any layout) by zheevd: w (n) ascending,
+   Z (n x n column-major). */
+static int qte_tests_eigh(const t_qte_cmatrix *H, double *w, t_qte_cmatrix *Z) {
+    long n = H->rows, m = 0;
+    int info = 0;
+    t_qte_eigh_params p = { QTE_ZHEEVD, 1, 'A', 1, n, 0.0, 0.0 };
+    t_qte_cmatrix A;
+    qte_cmatrix_init(&A);
+    int err = qte_cmatrix_copy(&A, H, QTE_COL_MAJOR);
+    if (!err)
+        err = qte_eigh(&p, &A, w, Z, &m, NULL, &info);
+    qte_cmatrix_free(&A);
+    return err ? err : (m == n ? 0 : QTE_ERR_SOLVE);
+}
+
+/* psi = exp(-i H t) psi0 through the eigenbasis of H. */
+static int qte_tests_exact(const t_qte_cmatrix *H, const t_qte_cvector *psi0, double t,
+                           t_qte_cvector *psi) {
+    long n = H->rows;
+    double *w = (double *)malloc(n * sizeof(double));
+    t_qte_cmatrix Z;
+    t_qte_cvector c;
+    qte_cmatrix_init(&Z);
+    qte_cvector_init(&c);
+    int err = w ? qte_tests_eigh(H, w, &Z) : QTE_ERR_ALLOC;
+    if (!err)
+        err = qte_project(&Z, psi0, &c);
+    if (!err) {
+        for (long k = 0; k < n; k++)
+            c.data[k] *= cexp(-I * w[k] * t);
+        err = qte_cvector_resize(psi, n);
+    }
+    if (!err)
+        err = qte_zgemv(QTE_NOTRANS, 1.0, &Z, &c, 0.0, psi);
+    free(w);
+    qte_cmatrix_free(&Z);
+    qte_cvector_free(&c);
+    return err;
+}
+
+/* max_k |H z_k - w_k z_k| over the m columns of Z (column-major). */
+static double qte_tests_residual(const t_qte_cmatrix *H, const double *w, const t_qte_cmatrix *Z,
+                                 long m) {
+    long n = H->rows;
+    double worst = 0.0;
+    for (long k = 0; k < m; k++) {
+        double r = 0.0;
+        for (long i = 0; i < n; i++) {
+            double complex s = -w[k] * *qte_cmatrix_at(Z, i, k);
+            for (long j = 0; j < n; j++)
+                s += *qte_cmatrix_at(H, i, j) * *qte_cmatrix_at(Z, j, k);
+            r += creal(s * conj(s));
+        }
+        if (sqrt(r) > worst)
+            worst = sqrt(r);
+    }
+    return worst;
+}
+
+/* max |Z^H Z - I| over the first m columns. */
+static double qte_tests_orthonormality(const t_qte_cmatrix *Z, long m) {
+    long n = Z->rows;
+    double worst = 0.0;
+    for (long a = 0; a < m; a++) {
+        for (long b = 0; b < m; b++) {
+            double complex s = (a == b) ? -1.0 : 0.0;
+            for (long i = 0; i < n; i++)
+                s += conj(*qte_cmatrix_at(Z, i, a)) * *qte_cmatrix_at(Z, i, b);
+            if (cabs(s) > worst)
+                worst = cabs(s);
+        }
+    }
+    return worst;
+}
+
+/* |x - y| / |y| */
+static double qte_tests_distance(const double complex *x, const double complex *y, long n) {
+    double d = 0.0, s = 0.0;
+    for (long i = 0; i < n; i++) {
+        d += creal((x[i] - y[i]) * conj(x[i] - y[i]));
+        s += creal(y[i] * conj(y[i]));
+    }
+    return sqrt(d / s);
+}
+
+/* A normalized Gaussian wave packet of width sigma at centre, momentum k. */
+static void qte_tests_packet(t_qte_cvector *psi, double centre, double sigma, double k) {
+    double norm = 0.0;
+    for (long i = 0; i < psi->n; i++) {
+        double u = (i - centre) / sigma;
+        psi->data[i] = exp(-0.5 * u * u) * cexp(I * k * i);
+        norm += creal(psi->data[i] * conj(psi->data[i]));
+    }
+    for (long i = 0; i < psi->n; i++)
+        psi->data[i] /= sqrt(norm);
+}
+
+/* ----------------------------------------------------------------------------
+   Cases
+---------------------------------------------------------------------------- */
+/* Three identical tridiagonal blocks: every eigenvalue is threefold, which a
+   single Lanczos start vector cannot resolve. */
+static void qte_tests_lanczos(void) {
+    const long b = 20, copies = 3, n = b * copies, k = 7;
+    long count = 0, steps = 0;
+    long *ri = (long *)malloc(2 * n * sizeof(long));
+    long *ci = (long *)malloc(2 * n * sizeof(long));
+    double complex *z = (double complex *)malloc(2 * n * sizeof(double complex));
+    double *w = (double *)malloc(n * sizeof(double));
+    double *wref = (double *)malloc(n * sizeof(double));
+    t_qte_csr S;
+    t_qte_cmatrix H, Z, Zref;
+    qte_csr_init(&S);
+    qte_cmatrix_init(&H);
+    qte_cmatrix_init(&Z);
+    qte_cmatrix_init(&Zref);
+    int info = 0;
+
+    for (long c = 0; c < copies; c++) {
+        for (long i = 0; i < b; i++) {
+            long g = c * b + i;
+            ri[count] = ci[count] = g;
+            z[count++] = 0.1 * i;
+            if (i + 1 < b) {
+                ri[count] = g;
+                ci[count] = g + 1;
+                z[count++] = 0.3 * I;
+            }
+        }
+    }
+    QTE_TESTS_CHECK(!qte_csr_from_triplets(&S, n, count, ri, ci, z), "qte_csr_from_triplets failed");
+    QTE_TESTS_CHECK(!qte_csr_to_dense(&S, &H) && !qte_tests_eigh(&H, wref, &Zref),
+                    "dense reference failed");
+
+    int err = qte_lanczos(&S, k, 0, 1e-12, 1, w, &Z, &steps, &info);
+    QTE_TESTS_CHECK(err == 0, "qte_lanczos returned %d", err);
+    if (!err) {
+        for (long i = 0; i < k; i++)
+            QTE_TESTS_CHECK(fabs(w[i] - wref[i]) < 1e-9, "eigenvalue %ld: %.15g, expected %.15g",
+                            i, w[i], wref[i]);
+        double r = qte_tests_residual(&H, w, &Z, k);
+        double o = qte_tests_orthonormality(&Z, k);
+        QTE_TESTS_CHECK(r < 1e-8, "residual %g", r);
+        QTE_TESTS_CHECK(o < 1e-10, "eigenvectors not orthonormal (%g)", o);
+    }
+
+    free(ri);
+    free(ci);
+    free(z);
+    free(w);
+    free(wref);
+    qte_csr_free(&S);
+    qte_cmatrix_free(&H);
+    qte_cmatrix_free(&Z);
+    qte_cmatrix_free(&Zref);
+}
+
+static void qte_tests_split_case(const t_qte_cmatrix *H, int parity, const char *what) {
+    long n = H->rows, m = 0;
+    int info = 0;
+    t_qte_eigh_params p = { QTE_ZHEEVD, 1, 'A', 1, n, 0.0, 0.0 };
+    t_qte_eigh_split s;
+    t_qte_cmatrix A, Z, Zref;
+    double *w = (double *)malloc(n * sizeof(double));
+    double *wref = (double *)malloc(n * sizeof(double));
+    qte_eigh_split_init(&s);
+    qte_cmatrix_init(&A);
+    qte_cmatrix_init(&Z);
+    qte_cmatrix_init(&Zref);
+
+    QTE_TESTS_CHECK(!qte_tests_eigh(H, wref, &Zref), "%s: dense reference failed", what);
+    QTE_TESTS_CHECK(!qte_cmatrix_copy(&A, H, QTE_COL_MAJOR), "%s: copy failed", what);
+    int err = qte_eigh_blocks(&p, &s, &A, parity, 1e-12, 1, w, &Z, &m, NULL, &info);
+    QTE_TESTS_CHECK(err == 0 && m == n, "%s: qte_eigh_blocks returned %d (m = %ld)", what, err, m);
+    QTE_TESTS_CHECK(s.count > 1 && s.parity == parity, "%s: %ld blocks, parity %d", what, s.count,
+                    s.parity);
+    if (!err && m == n) {
+        for (long i = 0; i < n; i++)
+            QTE_TESTS_CHECK(fabs(w[i] - wref[i]) < 1e-10, "%s: eigenvalue %ld: %.15g, expected %.15g",
+                            what, i, w[i], wref[i]);
+        double r = qte_tests_residual(H, w, &Z, n);
+        double o = qte_tests_orthonormality(&Z, n);
+        QTE_TESTS_CHECK(r < 1e-10, "%s: residual %g", what, r);
+        QTE_TESTS_CHECK(o < 1e-10, "%s: eigenvectors not orthonormal (%g)", what, o);
+    }
+
+    free(w);
+    free(wref);
+    qte_eigh_split_free(&s);
+    qte_cmatrix_free(&A);
+    qte_cmatrix_free(&Z);
+    qte_cmatrix_free(&Zref);
+}
+
+static void qte_tests_blocks(void) {
+    const long n = 40;
+    t_qte_rng rng;
+    t_qte_cmatrix G, H;
+    qte_cmatrix_init(&G);
+    qte_cmatrix_init(&H);
+    qte_rng_seed(&rng, 7);
+    if (qte_cmatrix_resize(&G, n, n, QTE_ROW_MAJOR) || qte_cmatrix_resize(&H, n, n, QTE_ROW_MAJOR) ||
+        qte_random_hermitian(&rng, QTE_ENSEMBLE_GUE, 1.0, &G)) {
+        QTE_TESTS_CHECK(0, "setup failed");
+        goto out;
+    }
+
+    // Even and odd indices never couple: two interleaved blocks.
+    for (long i = 0; i < n; i++)
+        for (long j = 0; j < n; j++)
+            *qte_cmatrix_at(&H, i, j) = ((i + j) % 2) ? 0.0 : *qte_cmatrix_at(&G, i, j);
+    qte_tests_split_case(&H, 0, "interleaved blocks");
+
+    // Dense but reflection symmetric: A(i, j) = A(n-1-i, n-1-j).
+    for (long i = 0; i < n; i++)
+        for (long j = 0; j < n; j++)
+            *qte_cmatrix_at(&H, i, j) =
+                0.5 * (*qte_cmatrix_at(&G, i, j) + *qte_cmatrix_at(&G, n - 1 - i, n - 1 - j));
+    qte_tests_split_case(&H, 1, "parity blocks");
+
+out:
+    qte_cmatrix_free(&G);
+    qte_cmatrix_free(&H);
+}
+
+static void qte_tests_truncate(void) {
+    // Weights 0.01, 0.64, 0.09, 0.25 of 0.99.
+    const double complex c[4] = { 0.1, 0.8 * I, -0.3, 0.3 + 0.4 * I };
+    long idx[4];
+    double dropped = -1.0;
+
+    long kept = qte_truncate_weight(c, 4, 0.05, 0, idx, &dropped);
+    QTE_TESTS_CHECK(kept == 3 && idx[0] == 1 && idx[1] == 2 && idx[2] == 3,
+                    "tol 0.05: kept %ld", kept);
+    QTE_TESTS_CHECK(fabs(dropped - 0.01 / 0.99) < 1e-14, "tol 0.05: dropped %g", dropped);
+
+    kept = qte_truncate_weight(c, 4, 0.05, 2, idx, &dropped);
+    QTE_TESTS_CHECK(kept == 2 && idx[0] == 1 && idx[1] == 3, "maxterms 2: kept %ld", kept);
+    QTE_TESTS_CHECK(fabs(dropped - 0.10 / 0.99) < 1e-14, "maxterms 2: dropped %g", dropped);
+
+    kept = qte_truncate_weight(c, 4, 0.0, 0, idx, &dropped);
+    QTE_TESTS_CHECK(kept == 4 && dropped == 0.0, "tol 0: kept %ld, dropped %g", kept, dropped);
+}
+
+static void qte_tests_krylov(void) {
+    const long n = 80, steps = 8;
+    const double dt = 0.5;
+    t_qte_rng rng;
+    t_qte_krylov K;
+    t_qte_cmatrix H, Psi;
+    t_qte_cvector v, psi, ref;
+    long builds = 0;
+    int info = 0;
+    qte_krylov_init(&K);
+    qte_cmatrix_init(&H);
+    qte_cmatrix_init(&Psi);
+    qte_cvector_init(&v);
+    qte_cvector_init(&psi);
+    qte_cvector_init(&ref);
+    qte_rng_seed(&rng, 11);
+    if (qte_cmatrix_resize(&H, n, n, QTE_ROW_MAJOR) || qte_cvector_resize(&v, n) ||
+        qte_cmatrix_resize(&Psi, n, steps, QTE_COL_MAJOR) ||
+        qte_random_hermitian(&rng, QTE_ENSEMBLE_GUE, 1.0 / sqrt((double)n), &H)) {
+        QTE_TESTS_CHECK(0, "setup failed");
+        goto out;
+    }
+    qte_tests_packet(&v, 0.4 * n, 4.0, 0.5);
+
+    int err = qte_krylov_build(&K, &H, &v, 30, &info);
+    QTE_TESTS_CHECK(err == 0, "qte_krylov_build returned %d", err);
+    if (!err) {
+        double est = qte_krylov_expm(&K, 1.0, &psi);
+        QTE_TESTS_CHECK(!qte_tests_exact(&H, &v, 1.0, &ref), "dense reference failed");
+        double d = qte_tests_distance(psi.data, ref.data, n);
+        QTE_TESTS_CHECK(d < 1e-10 && est < 1e-8, "expm: error %g, estimate %g", d, est);
+    }
+
+    err = qte_krylov_propagate(&K, &H, &v, 0.0, dt, 20, 1e-10, &Psi, &builds, &info);
+    QTE_TESTS_CHECK(err == 0, "qte_krylov_propagate returned %d", err);
+    for (long s = 0; s < steps && !err; s++) {
+        t_qte_cmatrix col = qte_cmatrix_block(&Psi, 0, s, n, 1);
+        QTE_TESTS_CHECK(!qte_tests_exact(&H, &v, s * dt, &ref), "dense reference failed");
+        double d = qte_tests_distance(col.data, ref.data, n);
+        QTE_TESTS_CHECK(d < 1e-8, "propagate: step %ld error %g (%ld bases)", s, d, builds);
+    }
+
+out:
+    qte_krylov_free(&K);
+    qte_cmatrix_free(&H);
+    qte_cmatrix_free(&Psi);
+    qte_cvector_free(&v);
+    qte_cvector_free(&psi);
+    qte_cvector_free(&ref);
+}
+
+/* The Hamiltonian qte_strang_step splits: 0.5 F^-1 diag(m^2) F + diag(V). */
+static int qte_tests_strang_hamiltonian(t_qte_cmatrix *H, long n, double a, double f) {
+    if (qte_cmatrix_resize(H, n, n, QTE_ROW_MAJOR))
+        return QTE_ERR_ALLOC;
+    for (long j = 0; j < n; j++) {
+        for (long l = 0; l < n; l++) {
+            double complex s = 0.0;
+            for (long m = 0; m < n; m++)
+                s += 0.5 * m * m * cexp(2.0 * M_PI * I * (double)(m * (j - l)) / n);
+            *qte_cmatrix_at(H, j, l) = s / n;
+        }
+        double q = a * (-((n - 1) / 2.0) + j);
+        *qte_cmatrix_at(H, j, j) += 0.5 * q * q + f * q;
+    }
+    return 0;
+}
+
+static void qte_tests_strang(void) {
+    const long n = 16;
+    const double a = 0.3, f = 0.2, t = 0.1;
+    t_qte_strang s;
+    t_qte_cmatrix H;
+    t_qte_cvector psi0, psi, ref;
+    double err[2] = { 0.0, 0.0 };
+    qte_strang_init(&s);
+    qte_cmatrix_init(&H);
+    qte_cvector_init(&psi0);
+    qte_cvector_init(&psi);
+    qte_cvector_init(&ref);
+    if (qte_strang_setup(&s, n) || qte_tests_strang_hamiltonian(&H, n, a, f) ||
+        qte_cvector_resize(&psi0, n) || qte_cvector_resize(&psi, n)) {
+        QTE_TESTS_CHECK(0, "setup failed");
+        goto out;
+    }
+    qte_tests_packet(&psi0, 0.5 * n, 2.5, 2.0 * M_PI * 2.0 / n);
+    QTE_TESTS_CHECK(!qte_tests_exact(&H, &psi0, t, &ref), "dense reference failed");
+
+    for (int r = 0; r < 2; r++) {
+        long steps = 100L << r;
+        memcpy(psi.data, psi0.data, n * sizeof(double complex));
+        int e = qte_strang_step(&s, &psi, a, f, t / steps, steps);
+        QTE_TESTS_CHECK(e == 0, "qte_strang_step returned %d", e);
+        double norm = 0.0;
+        for (long i = 0; i < n; i++)
+            norm += creal(psi.data[i] * conj(psi.data[i]));
+        QTE_TESTS_CHECK(fabs(norm - 1.0) < 1e-12, "%ld steps: norm %.15g", steps, norm);
+        err[r] = qte_tests_distance(psi.data, ref.data, n);
+    }
+    QTE_TESTS_CHECK(err[0] < 1e-3, "error %g at dt = %g", err[0], t / 100);
+    QTE_TESTS_CHECK(err[1] > 0.2 * err[0] && err[1] < 0.3 * err[0],
+                    "halving dt took the error from %g to %g, not by 4", err[0], err[1]);
+
+out:
+    qte_strang_free(&s);
+    qte_cmatrix_free(&H);
+    qte_cvector_free(&psi0);
+    qte_cvector_free(&psi);
+    qte_cvector_free(&ref);
+}
+
+static void qte_tests_snapshot(void) {
+    const long n = 12, m = 5;
+    const uint64_t hash = 0x0123456789abcdefULL;
+    char path[64], bad[64];
+    double w[5];
+    t_qte_cmatrix V;
+    t_qte_cvector c;
+    t_qte_snapshot snap;
+    qte_cmatrix_init(&V);
+    qte_cvector_init(&c);
+    qte_snapshot_init(&snap);
+    snprintf(path, sizeof(path), "qte_tests_%ld.snap", (long)getpid());
+    snprintf(bad, sizeof(bad), "qte_tests_%ld.bad", (long)getpid());
+    if (qte_cmatrix_resize(&V, n, m, QTE_ROW_MAJOR) || qte_cvector_resize(&c, m)) {
+        QTE_TESTS_CHECK(0, "setup failed");
+        goto out;
+    }
+    for (long k = 0; k < m; k++) {
+        w[k] = -1.5 + 0.75 * k;
+        c.data[k] = cexp(I * k) / (k + 1);
+        for (long i = 0; i < n; i++)
+            *qte_cmatrix_at(&V, i, k) = (i + 1) + I * (k - 2);
+    }
+
+    int err = qte_snapshot_write(path, n, m, w, &V, &c, hash);
+    QTE_TESTS_CHECK(err == 0, "qte_snapshot_write returned %d", err);
+    err = qte_snapshot_open(&snap, path);
+    QTE_TESTS_CHECK(err == 0, "qte_snapshot_open returned %d", err);
+    if (!err) {
+        const t_qte_snapshot_header *h = &snap.header;
+        QTE_TESTS_CHECK(h->n == n && h->m == m && h->source_hash == hash &&
+                        h->flags == (QTE_SNAPSHOT_VECTORS | QTE_SNAPSHOT_COEFF),
+                        "header: n %lld, m %lld, flags %u", (long long)h->n, (long long)h->m,
+                        h->flags);
+        QTE_TESTS_CHECK(snap.V.rows == n && snap.V.cols == m && snap.c.n == m,
+                        "views: V %ld x %ld, c %ld", snap.V.rows, snap.V.cols, snap.c.n);
+        if (snap.V.rows == n && snap.V.cols == m && snap.c.n == m) {
+            for (long k = 0; k < m; k++) {
+                QTE_TESTS_CHECK(snap.w[k] == w[k], "eigenvalue %ld differs", k);
+                QTE_TESTS_CHECK(snap.c.data[k] == c.data[k], "coefficient %ld differs", k);
+                for (long i = 0; i < n; i++)
+                    QTE_TESTS_CHECK(*qte_cmatrix_at(&snap.V, i, k) == *qte_cmatrix_at(&V, i, k),
+                                    "eigenvector entry (%ld, %ld) differs", i, k);
+            }
+        }
+        qte_snapshot_close(&snap);
+    }
+
+    // A file that is not a snapshot is rejected and leaves the snapshot closed.
+    FILE *fp = fopen(bad, "wb");
+    if (fp) {
+        char junk[sizeof(t_qte_snapshot_header)];
+        memset(junk, 'x', sizeof(junk));
+        fwrite(junk, 1, sizeof(junk), fp);
+        fclose(fp);
+    }
+    err = qte_snapshot_open(&snap, bad);
+    QTE_TESTS_CHECK(err == QTE_ERR_FORMAT && !snap.base, "bad file: qte_snapshot_open returned %d",
+                    err);
+
+out:
+    remove(path);
+    remove(bad);
+    qte_snapshot_close(&snap);
+    qte_cmatrix_free(&V);
+    qte_cvector_free(&c);
+}
+
+/* ----------------------------------------------------------------------------
+   Main
+---------------------------------------------------------------------------- */
+typedef struct _qte_tests_case {
+    const char *name;
+    void (*run)(void);
+} t_qte_tests_case;
+
+int main(void) {
+    static const t_qte_tests_case cases[] = {
+        { "lanczos", qte_tests_lanczos },
+        { "blocks", qte_tests_blocks },
+        { "truncate", qte_tests_truncate },
+        { "krylov", qte_tests_krylov },
+        { "strang", qte_tests_strang },
+        { "snapshot", qte_tests_snapshot },
+    };
+    long failed = 0;
+
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        long before = qte_tests_failures;
+        cases[i].run();
+        int ok = qte_tests_failures == before;
+        printf("%-10s %s\n", cases[i].name, ok ? "ok" : "FAILED");
+        failed += !ok;
+    }
+    fflush(stdout);
+    return failed ? 1 : 0;
+}
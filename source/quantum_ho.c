@@ -11,10 +11,25 @@
  *
  * The result is output as a flat list of 2*n*n numbers:
  * (Re[M[0][0]], Im[M[0][0]], Re[M[0][1]], Im[M[0][1]], ...)
+ *
+ * With @format matrix the result is instead written into a 2-plane float64
+ * n×n jit.matrix (plane 0 = real, plane 1 = imag) and sent as
+ * "jit_matrix <name>", so the next qte.* stage can read it in place.
+ * With @format packed it is sent as "packed <floats>": the upper triangle in
+ * LAPACK packed storage, n(n+1) floats, which qte.eigencalc decomposes directly.
+ *
+ * @threads spreads the rows of the P^2 fill over the cores (0 = one per core,
+ * 1 = single-threaded); below QTE_PARALLEL_MIN_DIM the work is not split.
+ *
+ * "stats" reports the compute (building H) and output latencies from the
+ * right outlet (see qte_stats_message).
  */
 
 #include "ext.h"
 #include "ext_obex.h"
+#include "jit.common.h"
+#include "qte_core.h"
+#include "qte_core_max.h"
 #include <math.h>
 #include <stdlib.h>
 #include <complex.h>
@@ -27,6 +42,19 @@ typedef struct _qte_quantumho {
     long n;         // Matrix dimension
     double a;       // Potential parameter
     void *out;      // Outlet pointer
+    void *out_status; // Right outlet: stats
+    t_symbol *format;         // Output format: "list", "matrix" or "packed"
+    void *outmatrix;          // Registered 2-plane float64 jit.matrix for @format matrix
+    t_symbol *outmatrix_name;
+    t_qte_cmatrix H;          // Cached Hamiltonian, row-major n x n
+    t_qte_cvector p2;         // Cached first column of P^2
+    t_qte_cvector packed;     // Upper triangle of H for @format packed
+    t_atom *out_list;         // Output atoms, reused across bangs
+    long out_list_size;
+    long H_n;                 // Dimension H was built for
+    double H_a;               // Potential parameter H was built for
+    long threads;             // @threads, 0 = one per core
+    t_qte_stats stats;        // "stats" message / qte.profiler
 } t_qte_quantumho;
 
 /* Global class pointer */
@@ -39,173 +67,35 @@ void *qte_quantumho_new(t_symbol *s, long argc, t_atom *argv);
 void qte_quantumho_free(t_qte_quantumho *x);
 void qte_quantumho_assist(t_qte_quantumho *x, void *b, long m, long a, char *s);
 void qte_quantumho_bang(t_qte_quantumho *x);
+void qte_quantumho_stats(t_qte_quantumho *x, t_symbol *s, long argc, t_atom *argv);
 
-/* Helper: Allocate an n x n matrix of double complex numbers. */
-static double complex **alloc_complex_matrix(long n) {
-    double complex **matrix = (double complex **)malloc(n * sizeof(double complex *));
-    if (!matrix)
-        return NULL;
-    for (long i = 0; i < n; i++) {
-        matrix[i] = (double complex *)calloc(n, sizeof(double complex));
-        if (!matrix[i]) {
-            for (long j = 0; j < i; j++)
-                free(matrix[j]);
-            free(matrix);
-            return NULL;
-        }
-    }
-    return matrix;
-}
-
-/* Helper: Free an n x n complex matrix. */
-static void free_complex_matrix(double complex **matrix, long n) {
-    if (matrix) {
-        for (long i = 0; i < n; i++)
-            free(matrix[i]);
-        free(matrix);
-    }
-}
-
-/* Helper: Compute the Fourier matrix F (n x n) */
-static void compute_fourier_matrix(double complex **F, long n) {
-    double norm = 1.0 / sqrt((double)n);
-    for (long k = 0; k < n; k++) {
-        for (long l = 0; l < n; l++) {
-            double angle = 2.0 * M_PI * k * l / n;
-            F[k][l] = norm * (cos(angle) + I * sin(angle));
-        }
-    }
-}
-
-/* Helper: Conjugate transpose Finv[i][j] = conj(F[j][i]). */
-static void compute_conjugate_transpose(double complex **F, double complex **Finv, long n) {
-    for (long i = 0; i < n; i++) {
-        for (long j = 0; j < n; j++) {
-            Finv[i][j] = conj(F[j][i]);
-        }
-    }
-}
-
-/* Helper: Multiply diag(D) with a matrix M. diag(D) * M means
-   result[i][j] = D[i] * M[i][j]. */
-static void multiply_diag_matrix(double *D, double complex **M, double complex **result, long n) {
-    for (long i = 0; i < n; i++) {
-        for (long j = 0; j < n; j++) {
-            result[i][j] = D[i] * M[i][j];
-        }
-    }
-}
-
-/* Helper: Multiply two n x n complex matrices A and B, store in result. */
-static void multiply_complex_matrices(double complex **A, double complex **B, double complex **result, long n) {
-    for (long i = 0; i < n; i++) {
-        for (long j = 0; j < n; j++) {
-            double complex sum = 0.0 + 0.0 * I;
-            for (long k = 0; k < n; k++) {
-                sum += A[i][k] * B[k][j];
-            }
-            result[i][j] = sum;
-        }
-    }
-}
-
-/* Helper: Round a double to 5 decimal places. */
-static double round5(double x) {
-    return round(x * 100000.0) / 100000.0;
-}
-
-/* Compute the Hamiltonian matrix H = 0.5 * (P^2 + Q^2),
- * with new definitions:
+/* Compute the Hamiltonian matrix H = 0.5 * (P^2 + Q^2) into x->H,
+ * with
  *   P = F * diag(PImpulse) * Finv,
  *   Q[i] = a * ( -((n - 1)/2) + i )
- */
-static double complex **compute_hamiltonian(t_qte_quantumho *x) {
+ * (see qte_oscillator_* in qte_core). The result is cached per (n, a): a new n
+ * rebuilds the whole matrix, a new a only the diagonal Q^2 term. */
+static int compute_hamiltonian(t_qte_quantumho *x) {
     long n = x->n;
     double a = x->a;
-    
-    // Allocate the final matrix H and temp matrices
-    double complex **H = alloc_complex_matrix(n);
-    double complex **F = alloc_complex_matrix(n);
-    double complex **Finv = alloc_complex_matrix(n);
-    double complex **P_temp = alloc_complex_matrix(n);
-    double complex **P = alloc_complex_matrix(n);
-    double complex **P2 = alloc_complex_matrix(n);
-    if (!H || !F || !Finv || !P_temp || !P || !P2) {
-        // Clean up if any allocation fails
-        if (H)    free_complex_matrix(H, n);
-        if (F)    free_complex_matrix(F, n);
-        if (Finv) free_complex_matrix(Finv, n);
-        if (P_temp) free_complex_matrix(P_temp, n);
-        if (P)    free_complex_matrix(P, n);
-        if (P2)   free_complex_matrix(P2, n);
-        return NULL;
-    }
-    
-    // Build the Fourier transform and its conjugate transpose
-    compute_fourier_matrix(F, n);
-    compute_conjugate_transpose(F, Finv, n);
-    
-    // Create the diagonal vector for the momentum impulse: [0, 1, ..., n-1]
-    double *PImpulse = (double *)malloc(n * sizeof(double));
-    if (!PImpulse) {
-        free_complex_matrix(H, n);
-        free_complex_matrix(F, n);
-        free_complex_matrix(Finv, n);
-        free_complex_matrix(P_temp, n);
-        free_complex_matrix(P, n);
-        free_complex_matrix(P2, n);
-        return NULL;
-    }
-    for (long i = 0; i < n; i++) {
-        PImpulse[i] = (double)i;
-    }
-    
-    // P_temp = diag(PImpulse) * Finv
-    // This yields diag(...) * Finv in P_temp
-    multiply_diag_matrix(PImpulse, Finv, P_temp, n);
-    
-    // P = F * P_temp = F * (diag(...) * Finv)
-    // => F diag(...) Finv
-    multiply_complex_matrices(F, P_temp, P, n);
-    
-    // P^2 = P * P
-    multiply_complex_matrices(P, P, P2, n);
-    
-    // Q diagonal: Q[i] = a * ( -((n - 1)/2) + i )
-    double *Q_diag = (double *)malloc(n * sizeof(double));
-    for (long i = 0; i < n; i++) {
-        Q_diag[i] = a * ( -((n - 1) / 2.0) + i );
-    }
-    
-    // Finally, build H = 0.5*( P^2 + Q^2 ) on the diagonal.
-    // Off-diagonal = 0.5 * P^2[i][j].
-    // Diagonal gets an added Q^2.
-    for (long i = 0; i < n; i++) {
-        for (long j = 0; j < n; j++) {
-            double complex qterm = 0.0;
-            if (i == j) {
-                double q2 = Q_diag[i] * Q_diag[i];
-                qterm = q2 + 0.0 * I;
-            }
-            double complex val = 0.5 * (P2[i][j] + qterm);
-            
-            // Round real & imaginary parts
-            double rpart = round5(creal(val));
-            double ipart = round5(cimag(val));
-            H[i][j] = rpart + I * ipart;
-        }
+    t_qte_cmatrix *H = &x->H;
+
+    if (H->data && n == x->H_n && a == x->H_a)
+        return 0;
+
+    if (!H->data || n != x->H_n) {
+        x->H_n = 0;
+        if (qte_cmatrix_resize(H, n, n, QTE_ROW_MAJOR) || qte_cvector_resize(&x->p2, n))
+            return -1;
+        x->H_n = n;
+        qte_oscillator_p2_column(x->p2.data, n);
+        qte_oscillator_kinetic(H, x->p2.data, qte_threads(x->threads));
     }
-    
-    // Cleanup
-    free(PImpulse);
-    free(Q_diag);
-    free_complex_matrix(F, n);
-    free_complex_matrix(Finv, n);
-    free_complex_matrix(P_temp, n);
-    free_complex_matrix(P, n);
-    free_complex_matrix(P2, n);
-    
-    return H;
+
+    // Diagonal gets an added Q^2
+    qte_oscillator_potential(H, x->p2.data, a);
+    x->H_a = a;
+    return 0;
 }
 
 /* -------------------------------------------------------------------
@@ -225,7 +115,24 @@ void ext_main(void *r) {
                   0);
     
     class_addmethod(c, (method)qte_quantumho_bang, "bang", 0);
+    class_addmethod(c, (method)qte_quantumho_stats, "stats", A_GIMME, 0);
     class_addmethod(c, (method)qte_quantumho_assist, "assist", A_CANT, 0);
+
+    CLASS_ATTR_LONG(c, "dim", 0, t_qte_quantumho, n);
+    CLASS_ATTR_FILTER_MIN(c, "dim", 1);
+    CLASS_ATTR_LABEL(c, "dim", 0, "Dimension");
+
+    CLASS_ATTR_DOUBLE(c, "a", 0, t_qte_quantumho, a);
+    CLASS_ATTR_LABEL(c, "a", 0, "Potential Parameter");
+
+    CLASS_ATTR_SYM(c, "format", 0, t_qte_quantumho, format);
+    CLASS_ATTR_ENUM(c, "format", 0, "list matrix packed");
+    CLASS_ATTR_LABEL(c, "format", 0, "Output Format");
+
+    CLASS_ATTR_LONG(c, "threads", 0, t_qte_quantumho, threads);
+    CLASS_ATTR_FILTER_MIN(c, "threads", 0);
+    CLASS_ATTR_LABEL(c, "threads", 0, "Threads (0 = one per core)");
+
     class_register(CLASS_BOX, c);
     qte_quantumho_class = c;
 }
@@ -236,62 +143,117 @@ void *qte_quantumho_new(t_symbol *s, long argc, t_atom *argv) {
     if (x) {
         x->n = 8;   // default dimension
         x->a = 1.0; // default potential parameter
-        if (argc >= 1) {
+        x->format = gensym("list");
+        qte_cmatrix_init(&x->H);
+        qte_cvector_init(&x->p2);
+        qte_cvector_init(&x->packed);
+        x->out_list = NULL;
+        x->out_list_size = 0;
+        x->H_n = 0;
+        x->H_a = 0.0;
+        x->threads = 0;
+        long nargs = attr_args_offset(argc, argv);
+        if (nargs >= 1) {
             if (atom_gettype(argv) == A_LONG) {
                 x->n = atom_getlong(argv);
             } else if (atom_gettype(argv) == A_FLOAT) {
                 x->n = (long)atom_getfloat(argv);
             }
         }
-        if (argc >= 2) {
+        if (nargs >= 2) {
             x->a = atom_getfloat(argv + 1);
         }
+        x->out_status = outlet_new(x, NULL);
         x->out = outlet_new(x, NULL);
+        x->outmatrix = qte_jit_outmatrix_new(&x->outmatrix_name);
+        qte_stats_register((t_object *)x, &x->stats);
+        attr_args_process(x, argc, argv);
     }
     return x;
 }
 
 /* Destructor */
 void qte_quantumho_free(t_qte_quantumho *x) {
-    // Nothing special to free
+    qte_stats_unregister((t_object *)x);
+    if (x->outmatrix)
+        jit_object_free(x->outmatrix);
+    qte_cmatrix_free(&x->H);
+    qte_cvector_free(&x->p2);
+    qte_cvector_free(&x->packed);
+    if (x->out_list)
+        sysmem_freeptr(x->out_list);
 }
 
 /* Assist: Provide inlet/outlet assistance */
 void qte_quantumho_assist(t_qte_quantumho *x, void *b, long m, long a, char *s) {
     if (m == 1) // inlet
         sprintf(s, "Bang to compute Hamiltonian");
-    else        // outlet
-        sprintf(s, "Outputs real,imag pairs of H as a list");
+    else if (a == 0) // outlets
+        sprintf(s, "Outputs real,imag pairs of H as a list (jit_matrix with @format matrix, packed with @format packed)");
+    else
+        sprintf(s, "Status outlet: stats");
+}
+
+/* Write H into the output jit.matrix and send "jit_matrix <name>". */
+static void qte_quantumho_output_matrix(t_qte_quantumho *x, double t) {
+    if (!x->outmatrix) {
+        object_error((t_object *)x, "No output jit.matrix available");
+        return;
+    }
+    if (qte_jit_matrix_write(x->outmatrix, &x->H)) {
+        object_error((t_object *)x, "Output jit.matrix has no data");
+        return;
+    }
+    t_atom a;
+    atom_setsym(&a, x->outmatrix_name);
+    qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t);
+    x->stats.atoms += 1;
+    outlet_anything(x->out, _jit_sym_jit_matrix, 1, &a);
 }
 
 /* Bang method: compute & output Hamiltonian as real/imag pairs */
 void qte_quantumho_bang(t_qte_quantumho *x) {
     long n = x->n;
-    double complex **H = compute_hamiltonian(x);
-    if (!H) {
+    if (n < 1) {
+        object_error((t_object *)x, "Invalid dimension: %ld", n);
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    if (compute_hamiltonian(x)) {
         object_error((t_object *)x, "Failed to compute Hamiltonian (out of memory?)");
         return;
     }
-    // 2 floats (real, imag) per matrix entry
-    long list_size = 2 * n * n;
-    t_atom *out_list = (t_atom *)sysmem_newptr(list_size * sizeof(t_atom));
-    if (!out_list) {
+    t = qte_stats_lap(&x->stats, QTE_STAGE_COMPUTE, t);
+    if (x->format == gensym("matrix")) {
+        qte_quantumho_output_matrix(x, t);
+        return;
+    }
+    int packed = x->format == gensym("packed");
+    if (packed && qte_packed_from_cmatrix(&x->packed, &x->H)) {
+        object_error((t_object *)x, "Failed to allocate memory for packed output");
+        return;
+    }
+    // 2 floats (real, imag) per matrix entry, or per upper-triangle entry when packed
+    long list_size = packed ? 2 * x->packed.n : 2 * n * n;
+    if (qte_atoms_reserve(&x->out_list, &x->out_list_size, list_size, &x->stats)) {
         object_error((t_object *)x, "Failed to allocate memory for output list");
-        free_complex_matrix(H, n);
         return;
     }
     
     // Flatten real & imaginary parts
-    for (long i = 0; i < n; i++) {
-        for (long j = 0; j < n; j++) {
-            long idx = 2 * (i * n + j);
-            atom_setfloat(out_list + idx,      creal(H[i][j]));
-            atom_setfloat(out_list + idx + 1,  cimag(H[i][j]));
-        }
-    }
-    outlet_list(x->out, gensym("list"), list_size, out_list);
-    
-    sysmem_freeptr(out_list);
-    free_complex_matrix(H, n);
+    if (packed)
+        qte_atoms_from_cvector(x->out_list, &x->packed);
+    else
+        qte_atoms_from_cmatrix(x->out_list, &x->H, QTE_ROW_MAJOR);
+    qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t);
+    x->stats.atoms += list_size;
+    if (packed)
+        outlet_anything(x->out, gensym("packed"), list_size, x->out_list);
+    else
+        outlet_list(x->out, gensym("list"), list_size, x->out_list);
 }
 
+/* stats: latencies, bytes and atoms of this instance ("stats reset" clears them) */
+void qte_quantumho_stats(t_qte_quantumho *x, t_symbol *s, long argc, t_atom *argv) {
+    qte_stats_message((t_object *)x, &x->stats, x->out_status, argc, argv);
+}
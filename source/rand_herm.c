@@ -1 +1,285 @@
-#include "ext.h"#include "ext_obex.h"#include <stdlib.h>////////////////////////////////////////////////////////////////////////////////// Our object structure////////////////////////////////////////////////////////////////////////////////typedef struct _qte_randherm {    t_object ob;    long n;        // matrix dimension    void *out;     // outlet pointer} t_qte_randherm;////////////////////////////////////////////////////////////////////////////////// Global class pointer////////////////////////////////////////////////////////////////////////////////static t_class *qte_randherm_class = NULL;////////////////////////////////////////////////////////////////////////////////// Function prototypes////////////////////////////////////////////////////////////////////////////////void *qte_randherm_new(t_symbol *s, long argc, t_atom *argv);void qte_randherm_free(t_qte_randherm *x);void qte_randherm_assist(t_qte_randherm *x, void *b, long m, long a, char *s);void qte_randherm_bang(t_qte_randherm *x);////////////////////////////////////////////////////////////////////////////////// ext_main: Called by Max at load time////////////////////////////////////////////////////////////////////////////////void ext_main(void *r){    t_class *c;    // Name our object "qte.randherm"    c = class_new("qte.randherm",                  (method)qte_randherm_new,                  (method)qte_randherm_free,                  sizeof(t_qte_randherm),                  0L,                  A_GIMME,                  0);        class_addmethod(c, (method)qte_randherm_bang,   "bang",   0);    class_addmethod(c, (method)qte_randherm_assist, "assist", A_CANT, 0);        class_register(CLASS_BOX, c);    qte_randherm_class = c; // Save the class pointer}////////////////////////////////////////////////////////////////////////////////// Constructor////////////////////////////////////////////////////////////////////////////////void *qte_randherm_new(t_symbol *s, long argc, t_atom *argv){    // Use the global pointer qte_randherm_class    t_qte_randherm *x = (t_qte_randherm *)object_alloc(qte_randherm_class);    if (x) {        x->n = 3; // default dimension        if (argc > 0 && atom_gettype(argv) == A_LONG)            x->n = atom_getlong(argv);                x->out = outlet_new(x, NULL);    }    return x;}////////////////////////////////////////////////////////////////////////////////// Destructor////////////////////////////////////////////////////////////////////////////////void qte_randherm_free(t_qte_randherm *x){    // Nothing special to free}////////////////////////////////////////////////////////////////////////////////// Assistance method////////////////////////////////////////////////////////////////////////////////void qte_randherm_assist(t_qte_randherm *x, void *b, long m, long a, char *s){    if (m == 1) {        sprintf(s, "Bang to generate a random Hermitian matrix");    } else {        sprintf(s, "Output: Hermitian matrix as flat list");    }}////////////////////////////////////////////////////////////////////////////////// Bang method: Generate & output a random Hermitian matrix////////////////////////////////////////////////////////////////////////////////void qte_randherm_bang(t_qte_randherm *x){    long n = x->n;    t_atom *out_list = (t_atom *)sysmem_newptr(n * n * sizeof(t_atom));    double *mat = (double *)sysmem_newptr(n * n * sizeof(double));        if (!out_list || !mat) {        object_error((t_object *)x, "Memory allocation failed");        if (out_list) sysmem_freeptr(out_list);        if (mat) sysmem_freeptr(mat);        return;    }    // Fill upper triangle with random numbers    for (long i = 0; i < n; i++) {        for (long j = 0; j < n; j++) {            if (i <= j)                mat[i*n + j] = ((double)rand() / (double)RAND_MAX);            else                mat[i*n + j] = 0; // lower triangle will be set by symmetry        }    }    // Form Hermitian matrix: for diagonal, H[i][i] = 2 * U[i][i]; for i<j, sum them.    for (long i = 0; i < n; i++) {        for (long j = 0; j < n; j++) {            double val;            if (i == j) {                val = 2.0 * mat[i*n + j];            } else if (i < j) {                val = mat[i*n + j] + mat[j*n + i];            } else {                val = 0; // for the lower triangle, or you can apply symmetry if needed            }            atom_setfloat(out_list + (i*n + j), val);        }    }    outlet_list(x->out, gensym("list"), n*n, out_list);        sysmem_freeptr(out_list);    sysmem_freeptr(mat);}
\ No newline at end of file
+/* qte.randherm.c – Random Hermitian matrix generator for Max/MSP
+ *
+ * A bang draws one n x n matrix from @ensemble:
+ *    - uniform : real symmetric, diagonal 2U and off-diagonal U with U uniform in
+ *                [0, 1) (the original qte.randherm matrix, now with both triangles),
+ *                output as a flat list of n*n numbers
+ *    - goe     : Gaussian orthogonal ensemble, real symmetric
+ *    - gue     : Gaussian unitary ensemble, complex Hermitian
+ * GOE and GUE follow exp(-tr H^2 / 2) scaled by @scale and are output as 2*n*n
+ * floats (row-major, real/imag pairs), the format qte.eigencalc reads.
+ *
+ * "batch K" draws K matrices in one go. With @format matrix they arrive as one
+ * 2-plane float64 jit.matrix of K*n rows and n columns (matrix k in rows
+ * k*n .. k*n + n - 1), otherwise as K lists. A single bang with @format matrix
+ * sends an n x n jit.matrix.
+ *
+ * Every instance has its own generator (xoshiro256**, see qte_core.h). @seed
+ * reseeds it: a nonzero seed reproduces the same sequence of draws, 0 (the
+ * default) picks a seed unique to the instance.
+ *
+ * "stats" reports the compute (drawing) and output latencies from the right
+ * outlet (see qte_stats_message); each matrix of a batch counts as one output.
+ */
+
+#include "ext.h"
+#include "ext_obex.h"
+#include "jit.common.h"
+#include "qte_core.h"
+#include "qte_core_max.h"
+#include <stdlib.h>
+#include <time.h>
+
+////////////////////////////////////////////////////////////////////////////////
+// Our object structure
+////////////////////////////////////////////////////////////////////////////////
+typedef struct _qte_randherm {
+    t_object ob;
+    long n;                  // matrix dimension
+    void *out;               // outlet pointer
+    void *out_status;        // right outlet: stats
+    t_symbol *ensemble;      // @ensemble: uniform, goe or gue
+    double scale;            // @scale
+    long seed;               // @seed (0 = unique per instance)
+    t_symbol *format;        // @format: list or matrix
+    void *outmatrix;         // registered 2-plane float64 jit.matrix for @format matrix
+    t_symbol *outmatrix_name;
+    t_qte_rng rng;
+    t_qte_cmatrix H;         // K*n x n row-major draws
+    t_atom *out_list;        // 2*n*n atoms
+    long out_list_size;
+    t_qte_stats stats;       // "stats" message / qte.profiler
+} t_qte_randherm;
+
+////////////////////////////////////////////////////////////////////////////////
+// Global class pointer
+////////////////////////////////////////////////////////////////////////////////
+static t_class *qte_randherm_class = NULL;
+static uint64_t qte_randherm_instances = 0;
+
+////////////////////////////////////////////////////////////////////////////////
+// Function prototypes
+////////////////////////////////////////////////////////////////////////////////
+void *qte_randherm_new(t_symbol *s, long argc, t_atom *argv);
+void qte_randherm_free(t_qte_randherm *x);
+void qte_randherm_assist(t_qte_randherm *x, void *b, long m, long a, char *s);
+void qte_randherm_bang(t_qte_randherm *x);
+void qte_randherm_batch(t_qte_randherm *x, long count);
+void qte_randherm_stats(t_qte_randherm *x, t_symbol *s, long argc, t_atom *argv);
+t_max_err qte_randherm_seed_set(t_qte_randherm *x, void *attr, long argc, t_atom *argv);
+
+////////////////////////////////////////////////////////////////////////////////
+// ext_main: Called by Max at load time
+////////////////////////////////////////////////////////////////////////////////
+void ext_main(void *r)
+{
+    t_class *c;
+    // Name our object "qte.randherm"
+    c = class_new("qte.randherm",
+                  (method)qte_randherm_new,
+                  (method)qte_randherm_free,
+                  sizeof(t_qte_randherm),
+                  0L,
+                  A_GIMME,
+                  0);
+
+    class_addmethod(c, (method)qte_randherm_bang,   "bang",   0);
+    class_addmethod(c, (method)qte_randherm_batch,  "batch",  A_LONG, 0);
+    class_addmethod(c, (method)qte_randherm_stats,  "stats",  A_GIMME, 0);
+    class_addmethod(c, (method)qte_randherm_assist, "assist", A_CANT, 0);
+
+    CLASS_ATTR_LONG(c, "dim", 0, t_qte_randherm, n);
+    CLASS_ATTR_FILTER_MIN(c, "dim", 1);
+    CLASS_ATTR_LABEL(c, "dim", 0, "Dimension");
+
+    CLASS_ATTR_SYM(c, "ensemble", 0, t_qte_randherm, ensemble);
+    CLASS_ATTR_ENUM(c, "ensemble", 0, "uniform goe gue");
+    CLASS_ATTR_LABEL(c, "ensemble", 0, "Ensemble");
+
+    CLASS_ATTR_DOUBLE(c, "scale", 0, t_qte_randherm, scale);
+    CLASS_ATTR_LABEL(c, "scale", 0, "Scale (GOE/GUE)");
+
+    CLASS_ATTR_LONG(c, "seed", 0, t_qte_randherm, seed);
+    CLASS_ATTR_ACCESSORS(c, "seed", NULL, qte_randherm_seed_set);
+    CLASS_ATTR_LABEL(c, "seed", 0, "Seed (0 = per instance)");
+
+    CLASS_ATTR_SYM(c, "format", 0, t_qte_randherm, format);
+    CLASS_ATTR_ENUM(c, "format", 0, "list matrix");
+    CLASS_ATTR_LABEL(c, "format", 0, "Output Format");
+
+    class_register(CLASS_BOX, c);
+    qte_randherm_class = c; // Save the class pointer
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Seeding: a fixed seed reproduces the draws, 0 mixes the instance address,
+// an instance counter and the clock, so no two instances share a sequence.
+////////////////////////////////////////////////////////////////////////////////
+static void qte_randherm_reseed(t_qte_randherm *x)
+{
+    uint64_t seed = (uint64_t)x->seed;
+    if (!seed) {
+        uint64_t parts[3] = { (uint64_t)(uintptr_t)x, ++qte_randherm_instances, (uint64_t)time(NULL) };
+        seed = qte_hash64(parts, sizeof(parts), (uint64_t)clock());
+    }
+    qte_rng_seed(&x->rng, seed);
+}
+
+t_max_err qte_randherm_seed_set(t_qte_randherm *x, void *attr, long argc, t_atom *argv)
+{
+    if (argc && argv) {
+        x->seed = atom_getlong(argv);
+        qte_randherm_reseed(x);
+    }
+    return MAX_ERR_NONE;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Constructor
+////////////////////////////////////////////////////////////////////////////////
+void *qte_randherm_new(t_symbol *s, long argc, t_atom *argv)
+{
+    // Use the global pointer qte_randherm_class
+    t_qte_randherm *x = (t_qte_randherm *)object_alloc(qte_randherm_class);
+    if (x) {
+        x->n = 3; // default dimension
+        if (attr_args_offset(argc, argv) > 0 && atom_gettype(argv) == A_LONG && atom_getlong(argv) > 0)
+            x->n = atom_getlong(argv);
+        x->ensemble = gensym("uniform");
+        x->scale = 1.0;
+        x->seed = 0;
+        x->format = gensym("list");
+        qte_cmatrix_init(&x->H);
+        x->out_list = NULL;
+        x->out_list_size = 0;
+        qte_randherm_reseed(x);
+
+        x->out_status = outlet_new(x, NULL);
+        x->out = outlet_new(x, NULL);
+        x->outmatrix = qte_jit_outmatrix_new(&x->outmatrix_name);
+        qte_stats_register((t_object *)x, &x->stats);
+        attr_args_process(x, argc, argv);
+    }
+    return x;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Destructor
+////////////////////////////////////////////////////////////////////////////////
+void qte_randherm_free(t_qte_randherm *x)
+{
+    qte_stats_unregister((t_object *)x);
+    if (x->outmatrix)
+        jit_object_free(x->outmatrix);
+    qte_cmatrix_free(&x->H);
+    if (x->out_list)
+        sysmem_freeptr(x->out_list);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Assistance method
+////////////////////////////////////////////////////////////////////////////////
+void qte_randherm_assist(t_qte_randherm *x, void *b, long m, long a, char *s)
+{
+    if (m == 1) {
+        sprintf(s, "Bang to generate a random Hermitian matrix, batch <K> for K of them");
+    } else if (a == 0) {
+        sprintf(s, "Output: Hermitian matrix as flat list, or jit_matrix with @format matrix");
+    } else {
+        sprintf(s, "Status outlet: stats");
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Draw count matrices into x->H and output them
+////////////////////////////////////////////////////////////////////////////////
+static t_qte_ensemble qte_randherm_ensemble(t_qte_randherm *x)
+{
+    if (x->ensemble == gensym("goe"))
+        return QTE_ENSEMBLE_GOE;
+    if (x->ensemble == gensym("gue"))
+        return QTE_ENSEMBLE_GUE;
+    return QTE_ENSEMBLE_UNIFORM;
+}
+
+static void qte_randherm_draw(t_qte_randherm *x, long count)
+{
+    long n = x->n;
+    t_qte_ensemble e = qte_randherm_ensemble(x);
+    double t = qte_stats_begin(&x->stats);
+    if (qte_cmatrix_resize(&x->H, count * n, n, QTE_ROW_MAJOR)) {
+        object_error((t_object *)x, "Memory allocation failed for %ld matrices", count);
+        return;
+    }
+    for (long k = 0; k < count; k++) {
+        t_qte_cmatrix Hk = { n, n, n, QTE_ROW_MAJOR, x->H.data + k * n * n, n * n };
+        qte_random_hermitian(&x->rng, e, x->scale, &Hk);
+    }
+    t = qte_stats_lap(&x->stats, QTE_STAGE_COMPUTE, t);
+
+    if (x->format == gensym("matrix")) {
+        if (!x->outmatrix || qte_jit_matrix_write(x->outmatrix, &x->H)) {
+            object_error((t_object *)x, "Output jit.matrix has no data.");
+            return;
+        }
+        t_atom a;
+        atom_setsym(&a, x->outmatrix_name);
+        qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t);
+        x->stats.atoms += 1;
+        outlet_anything(x->out, _jit_sym_jit_matrix, 1, &a);
+        return;
+    }
+
+    // The uniform ensemble keeps the original real n*n list.
+    long size = (e == QTE_ENSEMBLE_UNIFORM) ? n * n : 2 * n * n;
+    if (size > 32767) {
+        object_error((t_object *)x, "%ld values are too many for a list, use @format matrix", size);
+        return;
+    }
+    if (qte_atoms_reserve(&x->out_list, &x->out_list_size, size, &x->stats)) {
+        object_error((t_object *)x, "Memory allocation failed");
+        return;
+    }
+    for (long k = 0; k < count; k++) {
+        t_qte_cmatrix Hk = { n, n, n, QTE_ROW_MAJOR, x->H.data + k * n * n, n * n };
+        if (e == QTE_ENSEMBLE_UNIFORM) {
+            for (long i = 0; i < n * n; i++)
+                atom_setfloat(x->out_list + i, creal(Hk.data[i]));
+        } else {
+            qte_atoms_from_cmatrix(x->out_list, &Hk, QTE_ROW_MAJOR);
+        }
+        qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t);
+        x->stats.atoms += size;
+        outlet_list(x->out, gensym("list"), size, x->out_list);
+        // The next list is timed from here, leaving out the objects downstream.
+        t = qte_time_now();
+    }
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// Bang method: Generate & output a random Hermitian matrix
+////////////////////////////////////////////////////////////////////////////////
+void qte_randherm_bang(t_qte_randherm *x)
+{
+    qte_randherm_draw(x, 1);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// batch <K>: K matrices at once
+////////////////////////////////////////////////////////////////////////////////
+void qte_randherm_batch(t_qte_randherm *x, long count)
+{
+    if (count < 1) {
+        object_error((t_object *)x, "batch needs a count >= 1");
+        return;
+    }
+    qte_randherm_draw(x, count);
+}
+
+////////////////////////////////////////////////////////////////////////////////
+// stats: latencies, bytes and atoms ("stats reset" clears them)
+////////////////////////////////////////////////////////////////////////////////
+void qte_randherm_stats(t_qte_randherm *x, t_symbol *s, long argc, t_atom *argv)
+{
+    qte_stats_message((t_object *)x, &x->stats, x->out_status, argc, argv);
+}
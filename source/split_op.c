@@ -0,0 +1,377 @@
+/* qte.splitop.c – Split-operator time evolution of the oscillator for Max/MSP
+ *
+ * Propagates a state in qte.quantumho's Hamiltonian H = 0.5 (P^2 + Q^2),
+ * optionally driven by a force, without diagonalizing anything: P^2 is
+ * diagonal in the Fourier basis and Q in position, so each step of the
+ * Strang splitting is two DFTs (vDSP) and diagonal phase factors, O(n log n)
+ * (see qte_strang_step). The potential is
+ *
+ *    V_j = 0.5 q_j^2 + @drive * q_j,   q_j = @a * (-(n - 1)/2 + j),
+ *
+ * and @a and @drive may be changed at any time: a changed value applies from
+ * the next step on, with no re-diagonalization, which an eigenbasis
+ * (qte.timedev) cannot offer. Every time step is divided into @substeps
+ * split steps; the error of a time step shrinks with the square of that
+ * number. H is qte.quantumho's matrix without its rounding to 5 decimals.
+ *
+ *    - "state" followed by 2*n floats (real, imag) of psi0 in the position basis
+ *    - "time_settings tmin tmax tsteps"
+ *
+ * A bang propagates psi0 over the whole window and outputs the trajectories
+ * in the qte.timedev format: for each component i in turn, the middle outlet
+ * sends the list (i, t0, |psi_i(t0)|, t1, |psi_i(t1)|, ...) and then the left
+ * outlet the list (i, t0, arg psi_i(t0), t1, arg psi_i(t1), ...). It also
+ * rewinds the stream.
+ *
+ * Streaming: "step" advances the current state by one time step with the
+ * current @a and @drive and emits it as one frame, the middle outlet sending
+ * (t, |psi_0(t)|, ..., |psi_{n-1}(t)|) and then the left outlet (t, arg
+ * psi_0(t), ...); the first frame after "state", "rewind" or a bang is psi0
+ * at tmin.
+ * "start [frames]" rewinds and emits a frame every @interval ms, tsteps frames
+ * by default, 0 for an open-ended run; "stop" halts the clock. The run goes
+ * on past tmax as long as frames are requested.
+ *
+ * "stats" goes to the right outlet, kept free of frames so that a running
+ * clock never interleaves with the report (see qte_stats_message). Compute
+ * counts a bang's whole window and every step, clocked or not, and output
+ * counts every list or frame sent; parse is the "state" message.
+ */
+
+#include "ext.h"
+#include "ext_obex.h"
+#include "qte_core.h"
+#include "qte_core_max.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <complex.h>
+
+// Object structure
+typedef struct _qte_splitop_obj {
+    t_object ob;
+    long n;                     // @dim
+    double a;                   // @a, oscillator potential parameter
+    double drive;               // @drive, force on the oscillator
+    long substeps;              // @substeps, split steps per time step
+    double tmin;                // time_settings
+    double tmax;
+    long tsteps;
+    void *out_status;           // right: stats
+    void *out_mag;              // middle: magnitudes
+    void *out_phase;            // left: phases
+
+    t_qte_strang prop;          // DFT setups and phase factors
+    t_qte_cvector psi0;         // initial state (empty until received)
+    t_qte_cvector psi;          // current state: the trajectory, then the stream
+    t_qte_cmatrix Psi;          // n x tsteps amplitudes
+    // Streaming
+    long frame;                 // frames emitted since the last rewind
+    void *clock;
+    double interval;            // @interval, ms between clocked frames
+    long frames_left;           // clocked frames still to emit (-1: open-ended)
+    t_atom *out_list;           // 1 + 2*tsteps (or 1 + n) atoms
+    long out_list_size;
+    t_qte_stats stats;          // "stats" message / qte.profiler
+} t_qte_splitop_obj;
+
+static t_class *qte_splitop_class = NULL;
+
+/* Function prototypes */
+void ext_main(void *r);
+void *qte_splitop_new(t_symbol *s, long argc, t_atom *argv);
+void  qte_splitop_obj_free(t_qte_splitop_obj *x);
+void  qte_splitop_assist(t_qte_splitop_obj *x, void *b, long m, long a, char *s);
+void  qte_splitop_state(t_qte_splitop_obj *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_splitop_time_settings(t_qte_splitop_obj *x, double tmin, double tmax, long tsteps);
+void  qte_splitop_bang(t_qte_splitop_obj *x);
+void  qte_splitop_step_frame(t_qte_splitop_obj *x);
+void  qte_splitop_start(t_qte_splitop_obj *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_splitop_stop(t_qte_splitop_obj *x);
+void  qte_splitop_rewind(t_qte_splitop_obj *x);
+void  qte_splitop_tick(t_qte_splitop_obj *x);
+void  qte_splitop_stats(t_qte_splitop_obj *x, t_symbol *s, long argc, t_atom *argv);
+
+/* ----------------------------------------------------------------------------
+   ext_main – class initialization
+---------------------------------------------------------------------------- */
+void ext_main(void *r) {
+    t_class *c = class_new("qte.splitop",
+                           (method)qte_splitop_new,
+                           (method)qte_splitop_obj_free,
+                           sizeof(t_qte_splitop_obj),
+                           0L, A_GIMME, 0);
+
+    class_addmethod(c, (method)qte_splitop_assist, "assist", A_CANT, 0);
+    class_addmethod(c, (method)qte_splitop_state, "state", A_GIMME, 0);
+    class_addmethod(c, (method)qte_splitop_time_settings, "time_settings", A_FLOAT, A_FLOAT, A_LONG, 0);
+    class_addmethod(c, (method)qte_splitop_bang, "bang", 0);
+    // Streaming
+    class_addmethod(c, (method)qte_splitop_step_frame, "step", 0);
+    class_addmethod(c, (method)qte_splitop_start, "start", A_GIMME, 0);
+    class_addmethod(c, (method)qte_splitop_stop, "stop", 0);
+    class_addmethod(c, (method)qte_splitop_rewind, "rewind", 0);
+    class_addmethod(c, (method)qte_splitop_stats, "stats", A_GIMME, 0);
+
+    CLASS_ATTR_LONG(c, "dim", 0, t_qte_splitop_obj, n);
+    CLASS_ATTR_FILTER_MIN(c, "dim", 1);
+    CLASS_ATTR_LABEL(c, "dim", 0, "Dimension");
+
+    CLASS_ATTR_DOUBLE(c, "a", 0, t_qte_splitop_obj, a);
+    CLASS_ATTR_LABEL(c, "a", 0, "Potential Parameter a");
+
+    CLASS_ATTR_DOUBLE(c, "drive", 0, t_qte_splitop_obj, drive);
+    CLASS_ATTR_LABEL(c, "drive", 0, "Driving Force");
+
+    CLASS_ATTR_LONG(c, "substeps", 0, t_qte_splitop_obj, substeps);
+    CLASS_ATTR_FILTER_MIN(c, "substeps", 1);
+    CLASS_ATTR_LABEL(c, "substeps", 0, "Split Steps per Time Step");
+
+    CLASS_ATTR_DOUBLE(c, "interval", 0, t_qte_splitop_obj, interval);
+    CLASS_ATTR_FILTER_MIN(c, "interval", 1.0);
+    CLASS_ATTR_LABEL(c, "interval", 0, "Streaming Interval (ms)");
+
+    class_register(CLASS_BOX, c);
+    qte_splitop_class = c;
+}
+
+/* ----------------------------------------------------------------------------
+   Constructor / Destructor
+---------------------------------------------------------------------------- */
+void *qte_splitop_new(t_symbol *s, long argc, t_atom *argv) {
+    t_qte_splitop_obj *x = (t_qte_splitop_obj *)object_alloc(qte_splitop_class);
+    if (x) {
+        // Arguments: [dim], then attributes.
+        long nargs = attr_args_offset(argc, argv);
+        x->n = 8;
+        if (nargs >= 1 && atom_getlong(argv) > 0)
+            x->n = atom_getlong(argv);
+        x->a = 1.0;
+        x->drive = 0.0;
+        x->substeps = 10;
+        x->tmin = 0.0;
+        x->tmax = 10.0;
+        x->tsteps = 100;
+
+        qte_strang_init(&x->prop);
+        qte_cvector_init(&x->psi0);
+        qte_cvector_init(&x->psi);
+        qte_cmatrix_init(&x->Psi);
+        x->frame = 0;
+        x->clock = clock_new(x, (method)qte_splitop_tick);
+        x->interval = 20.0;
+        x->frames_left = 0;
+        x->out_list = NULL;
+        x->out_list_size = 0;
+
+        // Outlets are created right to left.
+        x->out_status = outlet_new((t_object *)x, NULL);
+        x->out_mag = outlet_new((t_object *)x, NULL);
+        x->out_phase = outlet_new((t_object *)x, NULL);
+        qte_stats_register((t_object *)x, &x->stats);
+        attr_args_process(x, argc, argv);
+    }
+    return x;
+}
+
+void qte_splitop_obj_free(t_qte_splitop_obj *x) {
+    qte_stats_unregister((t_object *)x);
+    if (x->clock)
+        object_free(x->clock);
+    qte_strang_free(&x->prop);
+    qte_cvector_free(&x->psi0);
+    qte_cvector_free(&x->psi);
+    qte_cmatrix_free(&x->Psi);
+    if (x->out_list)
+        sysmem_freeptr(x->out_list);
+}
+
+/* ----------------------------------------------------------------------------
+   Assist method
+---------------------------------------------------------------------------- */
+void qte_splitop_assist(t_qte_splitop_obj *x, void *b, long m, long a, char *s) {
+    if (m == 1)
+        sprintf(s, "bang, state (2*n floats), time_settings, step, start [frames], stop, rewind");
+    else if (a == 0)
+        sprintf(s, "Phases: i t0 arg psi_i(t0) t1 arg psi_i(t1) ..., or frames t arg psi_0(t) ...");
+    else if (a == 1)
+        sprintf(s, "Magnitudes: i t0 |psi_i(t0)| t1 |psi_i(t1)| ..., or frames t |psi_0(t)| ...");
+    else
+        sprintf(s, "Status outlet: stats");
+}
+
+/* ----------------------------------------------------------------------------
+   Inputs
+---------------------------------------------------------------------------- */
+/* state – the initial state psi0 as 2*n floats (real, imag); rewinds the stream. */
+void qte_splitop_state(t_qte_splitop_obj *x, t_symbol *s, long argc, t_atom *argv) {
+    long n = x->n;
+    if (argc != 2 * n) {
+        object_error((t_object *)x, "Expected 2*%ld=%ld floats for the initial state", n, 2 * n);
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    if (qte_cvector_resize(&x->psi0, n)) {
+        object_error((t_object *)x, "Memory allocation failed for the initial state");
+        qte_cvector_free(&x->psi0);
+        return;
+    }
+    qte_atoms_to_cvector(argc, argv, &x->psi0);
+    x->frame = 0;
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+}
+
+void qte_splitop_time_settings(t_qte_splitop_obj *x, double tmin, double tmax, long tsteps) {
+    if (tsteps < 1) {
+        object_error((t_object *)x, "tsteps must be >= 1");
+        return;
+    }
+    x->tmin = tmin;
+    x->tmax = tmax;
+    x->tsteps = tsteps;
+}
+
+/* ----------------------------------------------------------------------------
+   Propagation
+---------------------------------------------------------------------------- */
+/* Makes sure out_list holds size atoms. */
+static int qte_splitop_reserve(t_qte_splitop_obj *x, long size) {
+    if (qte_atoms_reserve(&x->out_list, &x->out_list_size, size, &x->stats)) {
+        object_error((t_object *)x, "Failed to allocate memory for output list");
+        return -1;
+    }
+    return 0;
+}
+
+static double qte_splitop_dt(t_qte_splitop_obj *x) {
+    return (x->tsteps > 1) ? (x->tmax - x->tmin) / (x->tsteps - 1) : 0.0;
+}
+
+/* Checks psi0 and prepares the propagator for the current dimension. */
+static int qte_splitop_ready(t_qte_splitop_obj *x) {
+    long n = x->n;
+    if (!x->psi0.data || x->psi0.n != n) {
+        object_error((t_object *)x, "No initial state of dimension %ld (use state)", n);
+        return -1;
+    }
+    if (qte_strang_setup(&x->prop, n) || qte_cvector_resize(&x->psi, n)) {
+        object_error((t_object *)x, "Memory allocation failed for the propagator");
+        return -1;
+    }
+    return 0;
+}
+
+/* Advances x->psi by one time step of dt with the current @a and @drive. */
+static void qte_splitop_advance(t_qte_splitop_obj *x, double dt) {
+    qte_strang_step(&x->prop, &x->psi, x->a, x->drive, dt / x->substeps, x->substeps);
+}
+
+/* bang – the whole window from psi0. The trajectory is computed in x->psi, so
+   the stream is rewound: the next frame is psi0 at tmin. */
+void qte_splitop_bang(t_qte_splitop_obj *x) {
+    long n = x->n;
+    long T = x->tsteps;
+    double dt = qte_splitop_dt(x);
+    if (qte_splitop_ready(x))
+        return;
+    double t = qte_stats_begin(&x->stats);
+    if (qte_cmatrix_resize(&x->Psi, n, T, QTE_ROW_MAJOR)) {
+        object_error((t_object *)x, "Memory allocation failed for %ld time steps", T);
+        return;
+    }
+    if (qte_splitop_reserve(x, 1 + 2 * T))
+        return;
+
+    memcpy(x->psi.data, x->psi0.data, n * sizeof(double complex));
+    for (long s = 0; s < T; s++) {
+        if (s)
+            qte_splitop_advance(x, dt);
+        for (long i = 0; i < n; i++)
+            x->Psi.data[i * x->Psi.ld + s] = x->psi.data[i];
+    }
+    x->frame = 0;
+    t = qte_stats_lap(&x->stats, QTE_STAGE_COMPUTE, t);
+    qte_trajectory_lists(&x->Psi, x->tmin, dt, x->out_list, x->out_mag, x->out_phase, &x->stats, t);
+}
+
+/* ----------------------------------------------------------------------------
+   Streaming: one frame per time step
+---------------------------------------------------------------------------- */
+/* Advances the stream by one time step (psi0 itself for the first frame) and
+   emits the frame at t = tmin + frame*dt. */
+static int qte_splitop_emit_frame(t_qte_splitop_obj *x) {
+    long n = x->n;
+    if (qte_splitop_ready(x))
+        return -1;
+    if (qte_splitop_reserve(x, 1 + n))
+        return -1;
+    double dt = qte_splitop_dt(x);
+    double t0 = qte_stats_begin(&x->stats);
+    if (x->frame == 0)
+        memcpy(x->psi.data, x->psi0.data, n * sizeof(double complex));
+    else
+        qte_splitop_advance(x, dt);
+    double t = x->tmin + x->frame * dt;
+    x->frame++;
+    t0 = qte_stats_lap(&x->stats, QTE_STAGE_COMPUTE, t0);
+
+    t_atom *list = x->out_list;
+    atom_setfloat(list, t);
+    for (long i = 0; i < n; i++)
+        atom_setfloat(list + 1 + i, cabs(x->psi.data[i]));
+    qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t0);
+    outlet_list(x->out_mag, gensym("list"), 1 + n, list);
+    t0 = qte_time_now();
+    for (long i = 0; i < n; i++)
+        atom_setfloat(list + 1 + i, carg(x->psi.data[i]));
+    qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t0);
+    outlet_list(x->out_phase, gensym("list"), 1 + n, list);
+    x->stats.atoms += 2 * (1 + n);
+    return 0;
+}
+
+/* step – the next frame. */
+void qte_splitop_step_frame(t_qte_splitop_obj *x) {
+    qte_splitop_emit_frame(x);
+}
+
+/* start [frames] – from tmin, one frame now and one every @interval ms:
+   tsteps frames by default, 0 for no limit. */
+void qte_splitop_start(t_qte_splitop_obj *x, t_symbol *s, long argc, t_atom *argv) {
+    long frames = (argc >= 1) ? atom_getlong(argv) : x->tsteps;
+    if (frames < 0) {
+        object_error((t_object *)x, "start: frames must be >= 0");
+        return;
+    }
+    clock_unset(x->clock);
+    x->frame = 0;
+    x->frames_left = frames ? frames : -1;
+    qte_splitop_tick(x);
+}
+
+void qte_splitop_stop(t_qte_splitop_obj *x) {
+    clock_unset(x->clock);
+    x->frames_left = 0;
+}
+
+void qte_splitop_rewind(t_qte_splitop_obj *x) {
+    x->frame = 0;
+}
+
+void qte_splitop_tick(t_qte_splitop_obj *x) {
+    if (x->frames_left == 0)
+        return;
+    if (qte_splitop_emit_frame(x)) {
+        x->frames_left = 0;
+        return;
+    }
+    if (x->frames_left > 0)
+        x->frames_left--;
+    if (x->frames_left != 0)
+        clock_fdelay(x->clock, x->interval);
+}
+
+/* stats – latencies, bytes and atoms ("stats reset" clears them). */
+void qte_splitop_stats(t_qte_splitop_obj *x, t_symbol *s, long argc, t_atom *argv) {
+    qte_stats_message((t_object *)x, &x->stats, x->out_status, argc, argv);
+}
@@ -1 +1,1792 @@
-#include "ext.h"#include "ext_obex.h"#include <math.h>#include <stdlib.h>#include <complex.h>// Our object structuretypedef struct _qte_timedev {    t_object ob;    // user data    long n;                 // dimension    double tmin;    double tmax;    long   tsteps;    double         *eigenvalues;   // array of n real    double complex *coeff;         // array of n complex    double complex **eigenstates;  // array of n, each row n complex    // outlets    void *out_magn;   // left outlet    void *out_phase;  // right outlet} t_qte_timedev;// Global class pointerstatic t_class *qte_timedev_class = NULL;// Prototypesvoid *qte_timedev_new(t_symbol *s, long argc, t_atom *argv);void  qte_timedev_free(t_qte_timedev *x);void  qte_timedev_assist(t_qte_timedev *x, void *b, long m, long a, char *s);// Message handlers: "dim", "time_settings", "set_eigenvalues", "set_coeff", "set_eigenstates", "compute"void  qte_timedev_dim(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv);void  qte_timedev_time_settings(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv);void  qte_timedev_set_eigenvalues(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv);void  qte_timedev_set_coeff(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv);void  qte_timedev_set_eigenstates(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv);void  qte_timedev_compute(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv);// The actual time evolution functionstatic void qte_timedev_do_compute(t_qte_timedev *x);// ext_mainvoid ext_main(void *r){    t_class *c = class_new("qte.timedev",                           (method)qte_timedev_new,                           (method)qte_timedev_free,                           sizeof(t_qte_timedev),                           0L, A_GIMME, 0);    // Assist method    class_addmethod(c, (method)qte_timedev_assist, "assist", A_CANT, 0);    // Our custom messages on the single inlet    class_addmethod(c, (method)qte_timedev_dim,           "dim",           A_GIMME, 0);    class_addmethod(c, (method)qte_timedev_time_settings, "time_settings", A_GIMME, 0);    class_addmethod(c, (method)qte_timedev_set_eigenvalues, "set_eigenvalues", A_GIMME, 0);    class_addmethod(c, (method)qte_timedev_set_coeff,       "set_coeff",      A_GIMME, 0);    class_addmethod(c, (method)qte_timedev_set_eigenstates, "set_eigenstates",A_GIMME, 0);    // Final "compute" message triggers the output    class_addmethod(c, (method)qte_timedev_compute,       "compute",       A_GIMME, 0);    class_register(CLASS_BOX, c);    qte_timedev_class = c;}// Constructorvoid *qte_timedev_new(t_symbol *s, long argc, t_atom *argv){    t_qte_timedev *x = (t_qte_timedev*)object_alloc(qte_timedev_class);    if (!x) return NULL;    // defaults    x->n      = 4;    x->tmin   = 0.0;    x->tmax   = 5.0;    x->tsteps = 20;    x->eigenvalues  = NULL;    x->coeff        = NULL;    x->eigenstates  = NULL;    // single inlet => automatically created as leftmost    // we don't need inlet_new for the default inlet    // two outlets    x->out_magn  = outlet_new((t_object*)x, NULL);    x->out_phase = outlet_new((t_object*)x, NULL);    return (x);}// Destructorvoid qte_timedev_free(t_qte_timedev *x){    if (x->eigenstates) {        for (long k=0; k<x->n; k++) {            free(x->eigenstates[k]);        }        free(x->eigenstates);    }    if (x->eigenvalues) {        free(x->eigenvalues);    }    if (x->coeff) {        free(x->coeff);    }}// Assist methodvoid qte_timedev_assist(t_qte_timedev *x, void *b, long m, long a, char *s){    if (m==1) {        sprintf(s, "Messages: dim <n>, time_settings <tmin> <tmax> <tsteps>, set_eigenvalues, set_coeff, set_eigenstates, compute");    } else {        switch(a) {            case 0: sprintf(s, "Phases"); break;            case 1: sprintf(s, "Magnitudes"); break;        }    }}/* ------------------------------------------------------------------   1) dim <n>------------------------------------------------------------------ */void qte_timedev_dim(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv){    if (argc >= 1) {        long tmp = atom_getlong(argv);        if (tmp > 0) {            x->n = tmp;            // you might want to free old data if dimension changes            if (x->eigenstates) {                for (long k=0; k<x->n; k++) {                    free(x->eigenstates[k]);                }                free(x->eigenstates);                x->eigenstates = NULL;            }            if (x->eigenvalues) { free(x->eigenvalues); x->eigenvalues=NULL; }            if (x->coeff) { free(x->coeff); x->coeff=NULL; }            object_post((t_object*)x, "dimension set to %ld", x->n);        }    }}/* ------------------------------------------------------------------   2) time_settings <tmin> <tmax> <tsteps>------------------------------------------------------------------ */void qte_timedev_time_settings(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv){    if (argc < 3) {        object_error((t_object*)x, "time_settings needs 3 arguments: tmin tmax tsteps");        return;    }    x->tmin   = atom_getfloat(argv);    x->tmax   = atom_getfloat(argv+1);    x->tsteps = atom_getlong(argv+2);    if (x->tsteps < 2) x->tsteps=2;    object_post((t_object*)x, "time_settings: tmin=%.2f, tmax=%.2f, tsteps=%ld", x->tmin, x->tmax, x->tsteps);}/* ------------------------------------------------------------------   3) set_eigenvalues <n floats>------------------------------------------------------------------ */void qte_timedev_set_eigenvalues(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv){    if (argc != x->n) {        object_error((t_object*)x, "Expected %ld floats for eigenvalues", x->n);        return;    }    if (!x->eigenvalues) {        x->eigenvalues = (double*)malloc(x->n * sizeof(double));    }    for (long i=0; i<x->n; i++) {        x->eigenvalues[i] = atom_getfloat(argv + i);    }    object_post((t_object*)x, "Eigenvalues set");}/* ------------------------------------------------------------------   4) set_coeff <2*n floats> => n complex------------------------------------------------------------------ */void qte_timedev_set_coeff(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv){    if (argc != 2*x->n) {        object_error((t_object*)x, "Expected 2*%ld=%ld floats for init coeff", x->n, 2*x->n);        return;    }    if (!x->coeff) {        x->coeff = (double complex*)malloc(x->n*sizeof(double complex));    }    for (long i=0; i<x->n; i++) {        double re = atom_getfloat(argv + 2*i);        double im = atom_getfloat(argv + 2*i + 1);        x->coeff[i] = re + im*I;    }    object_post((t_object*)x, "Coefficients set");}/* ------------------------------------------------------------------   5) set_eigenstates <2*n*n floats>------------------------------------------------------------------ */void qte_timedev_set_eigenstates(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv){    long n = x->n;    if (argc != 2*n*n) {        object_error((t_object*)x, "Expected 2*n*n=%ld floats for eigenstates", 2*n*n);        return;    }    if (!x->eigenstates) {        x->eigenstates = (double complex**)malloc(n*sizeof(double complex*));        for (long k=0; k<n; k++) {            x->eigenstates[k] = (double complex*)malloc(n*sizeof(double complex));        }    }    // We'll interpret them in row-major: for k=0..(n-1), for i=0..(n-1) => index=2*(k*n + i)    for (long k=0; k<n; k++) {        for (long i=0; i<n; i++) {            long idx = 2*(k*n + i);            double re = atom_getfloat(argv + idx);            double im = atom_getfloat(argv + idx + 1);            x->eigenstates[k][i] = re + im*I;        }    }    object_post((t_object*)x, "Eigenstates set");}/* ------------------------------------------------------------------   6) compute => do the time evolution & output------------------------------------------------------------------ */void qte_timedev_compute(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv){    // check everything    if (!x->eigenvalues || !x->coeff || !x->eigenstates) {        object_error((t_object*)x, "Need eigenvalues, coeff, eigenstates first");        return;    }    // do it    qte_timedev_do_compute(x);}/* ------------------------------------------------------------------   The actual time evolution------------------------------------------------------------------ */static void qte_timedev_do_compute(t_qte_timedev *x){    long n = x->n;    if (n<=0) return;    long tsteps = x->tsteps;    if (tsteps<2) tsteps=2;    double dt = (x->tmax - x->tmin)/(tsteps-1);    // We'll produce for each "track" i in [0..n-1] lines for magn & phase    for (long i=0; i<n; i++) {        // 1 + 2*tsteps items => track index, then pairs (time, value)        t_atom *mag_line   = (t_atom*)sysmem_newptr((1 + 2*tsteps)*sizeof(t_atom));        t_atom *phase_line = (t_atom*)sysmem_newptr((1 + 2*tsteps)*sizeof(t_atom));        if (!mag_line || !phase_line) {            if (mag_line) sysmem_freeptr(mag_line);            if (phase_line) sysmem_freeptr(phase_line);            object_error((t_object*)x, "Memory allocation failed for output lines");            return;        }        // First item => i        atom_setlong(mag_line, i);        atom_setlong(phase_line, i);        // compute for each time step        for (long t=0; t<tsteps; t++){            double time = x->tmin + t*dt;            double complex accum = 0.0 + 0.0*I;            // \Psi(i, time) = sum_k [coeff[k]* e^{- i eigenvalues[k]*time} * eigenstates[k][i]]            for (long k=0; k<n; k++){                double ev = x->eigenvalues[k];                double complex factor = cexp(-I * ev * time);                accum += x->coeff[k]*factor*x->eigenstates[k][i];            }            double mag   = cabs(accum);            double phase = carg(accum);            long idx = 1 + 2*t;            atom_setfloat(mag_line   + idx,   time);            atom_setfloat(mag_line   + idx+1, mag);            atom_setfloat(phase_line + idx,   time);            atom_setfloat(phase_line + idx+1, phase);        }        // Output        outlet_list(x->out_magn,  gensym("list"), (1 + 2*tsteps), mag_line);        outlet_list(x->out_phase, gensym("list"), (1 + 2*tsteps), phase_line);        sysmem_freeptr(mag_line);        sysmem_freeptr(phase_line);    }    object_post((t_object*)x, "Time development done.");}
\ No newline at end of file
+/* qte.timedev.c – Time development of a state in a given eigenbasis for Max/MSP
+ *
+ * Takes the eigen-data of a Hamiltonian, all n eigenpairs or m < n of them
+ * (e.g. a subset from qte.eigencalc @range)
+ *    - set_eigenvalues : m floats E_k
+ *    - set_coeff       : 2*m floats, the complex coefficients c_k of the initial state
+ *    - set_eigenstates : 2*n*m floats, eigenvector k stored contiguously as
+ *                        (real, imag) pairs, exactly as qte.eigencalc outputs them
+ *                        (or "jit_matrix <name>", an n x m 2-plane float64 matrix
+ *                        with one eigenvector per column, qte.eigencalc @format matrix)
+ * and, on "compute", evaluates
+ *
+ *    psi_i(t) = sum_k c_k * exp(-i E_k t) * v_k[i]
+ *
+ * for the tsteps times of "time_settings tmin tmax tsteps". All time steps are
+ * computed at once: the phase factors form an m x tsteps matrix Phi (built with
+ * a per-step rotation, see qte_phase_matrix) and a single zgemm Psi = V * Phi
+ * against the contiguous eigenstate matrix yields every amplitude. For each
+ * component i the second outlet then sends (i, t0, |psi_i(t0)|, t1, |psi_i(t1)|, ...)
+ * and the left outlet (i, t0, arg psi_i(t0), t1, arg psi_i(t1), ...).
+ * @threads spreads the rows of Phi and then (component x time block) tiles of
+ * Psi, each one zgemm plus its magnitudes and phases, over the cores
+ * (qte_trajectories; 0 = one per core, 1 = single-threaded). Below
+ * QTE_PARALLEL_MIN_DIM components the work is not split. The lists are sent
+ * afterwards on the calling thread in the usual order.
+ *
+ * GPU: @backend metal moves Psi = V * Phi and the magnitudes and phases onto
+ * the GPU (qte_metal.h, built as the qte_metal target), from
+ * QTE_METAL_MIN_DIM components on; smaller bases, frames and "at" stay on the
+ * CPU. Phi is still built in double here. Each scratch keeps its V resident
+ * on the GPU until its basis changes (set_eigenstates, read, a new
+ * truncation), so a compute after new coefficients or time settings uploads
+ * only Phi. The GPU computes in single precision, about 7 digits, as much as
+ * a buffer~ holds. On a build without it, or when the GPU fails, compute
+ * runs on the CPU. The Hamiltonian is not built here, and qte.quantumho
+ * builds it on the CPU: O(n^2) from cached columns, too little for a GPU.
+ *
+ * Buffers: with @magbuffer and/or @phasebuffer naming a buffer~, compute
+ * writes that trajectory into it instead of sending lists: one channel per
+ * component and one sample per time step (the buffer~ is resized to tsteps
+ * frames and n channels when it does not match), locked once for the whole
+ * write. The outlet of a plane sent to a buffer~ then sends a bang, so
+ * playback can start. The two planes need two buffer~s: compute refuses to
+ * write both into the same one. With both planes in buffer~s and no observable set, the
+ * trajectory is computed and written in blocks of time steps, so long windows
+ * at large n need no n x tsteps scratch.
+ *
+ * Streaming: instead of the whole window at once, "step" (or bang) emits the
+ * next time step as one frame, the second outlet sending (t, |psi_0(t)|, ...,
+ * |psi_{n-1}(t)|) and then the left outlet (t, arg psi_0(t), ...). "start
+ * [frames]" rewinds to tmin and emits a frame every @interval ms: tsteps
+ * frames by default, 0 for an open-ended run past tmax. "stop" halts the
+ * clock and "rewind" returns to tmin. Only the current phase factors are
+ * kept, advanced by the same per-step rotation, so memory does not depend
+ * on the length of the run and the first frame comes out immediately.
+ *
+ * Random access: "at <t> [t ...]" emits a frame for each of the given times
+ * in the same format, without touching the stream, e.g. for a playhead
+ * scrubbing at UI rate. The phase vector (c_k exp(-i E_k t)) of every time
+ * is computed directly (qte_phase_columns) and all of them go through one
+ * zgemm with the eigenstates, O(n^2) per time.
+ *
+ * Snapshots: "write <file>" saves the eigenvalues, eigenstates and (if set)
+ * coefficients to a snapshot file (see qte_snapshot_write); "read <file>"
+ * loads one, adopting its n and m, and a snapshot written by qte.eigencalc
+ * (with eigenvectors, full spectrum or @range subset) works too. The
+ * eigenstates of a row-major snapshot (written by qte.timedev) are used in
+ * place from the mapped file; the column-major eigenvectors of a qte.eigencalc
+ * snapshot are transposed once on load. Coefficients missing from the file
+ * keep their current value.
+ *
+ * Observables: "observable <name> ..." defines an observable O whose
+ * expectation <psi(t)|O|psi(t)> is sent from the third outlet as
+ * "<name> t0 <O>(t0) t1 <O>(t1) ..." on compute and "<name> t <O>(t)" for each
+ * streamed frame, ahead of the component lists:
+ *    - observable <name> <2*n*n floats> : a Hermitian matrix, row-major
+ *                                         (real, imag) pairs as qte.eigencalc reads them
+ *    - observable <name> diag <n floats> : a diagonal observable, e.g. the position
+ *                                          grid of qte.quantumho, or a 1 at component
+ *                                          i and 0 elsewhere for the population |psi_i|^2
+ *    - observable <name> energy          : the Hamiltonian, sum_k E_k |c_k|^2
+ *    - unobserve <name> removes one, unobserve alone all of them
+ * O is taken into the eigenbasis once (Ob = V^H O V, redone when the
+ * eigenstates change), so each time step costs O(n^2) (O(n) for energy) and
+ * one number, without forming psi. @components 0 skips the per-component
+ * trajectories (lists and buffer~s) and outputs the observables only. A
+ * "dim" change drops the observables.
+ *
+ * Truncation: most initial states overlap only few eigenstates. With
+ * @tolerance eps > 0 the evolution keeps just the fewest eigenpairs, largest
+ * |c_k|^2 first, that hold a weight of at least 1 - eps of the coefficients,
+ * and with @maxterms at most that many (either alone works too).
+ * compute, at, the stream and the observables then run over those m terms,
+ * so their cost scales with m instead of n. The selection is redone when
+ * the eigen-data or the attributes change, and each new one is posted once,
+ * with the weight left out, delta: psi is then off by sqrt(delta) * ||psi||
+ * at every t.
+ *
+ * Concurrent updates: the eigenvalues, coefficients, eigenstates and the set
+ * of observables are each kept in published slots (t_qte_slots). set_*, read,
+ * dim and observable fill a version that no compute, frame, "at" or write is
+ * reading, then publish it with one atomic store. Those readers pin the
+ * versions current when they start and keep them until they end, and each
+ * works in a scratch of its own (one for the main thread, one for the
+ * scheduler), so the truncation, Ob and the output lists of one never move
+ * under the other. With overdrive on, the UI can thus send new eigen-data
+ * while the scheduler computes or streams, with no defer, no locks and no
+ * torn reads: a compute in progress finishes on the data it started with, and
+ * the next one picks up the new. Each piece keeps at most QTE_SLOTS versions;
+ * the writer never waits for a reader, so when every other version is still
+ * pinned the update is refused ("still in use, try again") and the published
+ * data stays as it was. set_* themselves, the observables, the attributes and
+ * the time settings are meant to come from one thread at a time.
+ *
+ * The fourth, rightmost outlet is the status outlet: "stats" reports there
+ * (see qte_stats_message), so its lines never mix with trajectories, frames
+ * or observables. Parse times the set_* messages, compute a compute, frame or
+ * "at" up to its lists, and each list or buffer~ write counts as one output.
+ */
+
+#include "ext.h"
+#include "ext_obex.h"
+#include "qte_core.h"
+#include "qte_core_max.h"
+#include "qte_metal.h"
+#include "ext_buffer.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <complex.h>
+
+// Kinds of observable ("observable <name> ...")
+typedef enum _qte_timedev_kind {
+    QTE_TIMEDEV_MATRIX = 0,    // O, n x n row-major
+    QTE_TIMEDEV_DIAG = 1,      // diag(d)
+    QTE_TIMEDEV_ENERGY = 2     // the Hamiltonian, diag(E) in the eigenbasis
+} t_qte_timedev_kind;
+
+// One observable. It is never changed once defined and is shared by every
+// published set that lists it; the last set to drop it frees it.
+typedef struct _qte_timedev_observable {
+    t_symbol *name;
+    t_qte_timedev_kind kind;
+    t_qte_cmatrix O;           // QTE_TIMEDEV_MATRIX
+    double *d;                 // QTE_TIMEDEV_DIAG, n entries
+    long id;                   // unique within the object, keys the cached V^H O V
+    long refs;                 // sets listing it (writer side only)
+} t_qte_timedev_observable;
+
+// One published version of the observables ("observable", "unobserve").
+typedef struct _qte_timedev_obsset {
+    long n;                    // dimension they were defined for
+    t_qte_timedev_observable **obs;
+    long nobs;
+    long capacity;
+} t_qte_timedev_obsset;
+
+// One version of one piece of the eigen-data (see t_qte_timedev_field).
+typedef struct _qte_timedev_slot {
+    long n;                    // dimension of the contents, 0 = not set
+    long m;                    // eigenpairs they hold (E and c: m entries, V: n x m)
+    double *E;                 // eigenvalues
+    long E_size;
+    t_qte_cvector c;           // coefficients
+    t_qte_cmatrix V;           // eigenstates
+    t_qte_snapshot snap;       // mapped file V may point into ("read")
+} t_qte_timedev_slot;
+
+// The published versions of the eigenvalues, the coefficients or the eigenstates.
+typedef struct _qte_timedev_field {
+    t_qte_slots slots;
+    t_qte_timedev_slot slot[QTE_SLOTS];
+} t_qte_timedev_field;
+
+// The versions a compute, frame or "at" has pinned, and what they hold, with
+// the settings it runs with. Each call keeps its own on the stack.
+typedef struct _qte_timedev_view {
+    int slot[4];               // in x->eig, x->coeff, x->states, x->obs_slots (-1: none)
+    uint64_t gen[3];
+    long n;
+    long m;
+    const double *E;
+    const double complex *c;
+    const t_qte_cmatrix *V;
+    t_qte_timedev_observable *const *obs;
+    long nobs;
+    double tmin;
+    double dt;
+    long tsteps;
+    long components;
+} t_qte_timedev_view;
+
+// V^H O V of one observable in the basis of a scratch.
+typedef struct _qte_timedev_obcache {
+    long id;                   // observable it holds, 0 = none
+    long stamp;                // basis_stamp of the scratch it was computed in
+    t_qte_cmatrix Ob;
+} t_qte_timedev_obcache;
+
+// Everything a compute, frame or "at" writes while it runs. Each call claims
+// a scratch of its own (qte_timedev_scratch_claim), so readers on different
+// threads, or one nested in another's output, never share one.
+typedef struct _qte_timedev_scratch {
+    int busy;
+    int temporary;             // allocated for one call, all others being busy
+
+    // Truncation (@tolerance / @maxterms) and the basis everything runs in:
+    // V (n x m), E and c are the full eigen-data or the kept terms.
+    long *terms;               // indices of the kept eigenpairs, n entries
+    long nterms;               // their count; 0 = select again
+    uint64_t terms_gen[3];     // versions, @tolerance and @maxterms of the selection
+    double terms_tol;
+    long terms_max;
+    long scratch_n;            // length of terms, Et and frame_list
+    t_qte_cmatrix Vt;          // kept eigenstates, n x nterms row-major
+    double *Et;                // kept eigenvalues, n entries
+    t_qte_cvector ct;          // kept coefficients
+    const t_qte_cmatrix *V;
+    const double *E;
+    const double complex *c;
+    long m;
+    long basis_stamp;          // bumped whenever the basis V changes
+
+    // Observables in that basis, their expectations (nobs x steps) and the
+    // scratch of qte_observable_basis / qte_expectations.
+    t_qte_timedev_obcache *ob;
+    long ob_capacity;
+    double *expect;
+    long expect_size;
+    t_qte_cmatrix obs_w;
+
+    t_qte_cmatrix phi;         // m x steps phase factors
+    t_qte_cmatrix psi;         // n x steps amplitudes, as |psi| + i arg psi
+    t_qte_metal *gpu;          // @backend metal: context holding this scratch's V, NULL until used
+    t_atom *out_list;          // 1 + 2*tsteps atoms
+    long out_list_size;
+
+    // Stream: z holds the phase factors of frame zframe of stream epoch zepoch.
+    t_qte_cvector z;           // z_k = c_k exp(-i E_k t_s)
+    t_qte_cvector rot;         // exp(-i E_k dt)
+    double rot_dt;             // dt the rotations were built for
+    long zframe;               // -1 = none
+    long zepoch;
+    t_qte_cvector amp;         // psi(t_s)
+    t_atom *frame_list;        // 1 + n atoms
+    double *at_times;          // times of the last "at"
+    long at_times_size;
+} t_qte_timedev_scratch;
+
+#define QTE_TIMEDEV_SCRATCH 2      // one for the main thread, one for the scheduler
+
+// Object structure
+typedef struct _qte_timedev {
+    t_object ob;
+    long n;                    // Dimension
+    double tmin;
+    double tmax;
+    long tsteps;
+
+    // Eigen-data, each piece published in slots of its own (t_qte_slots):
+    // set_*, read and dim fill a slot no compute, frame or "at" is reading and
+    // publish it; those pin the current versions for as long as they run.
+    t_qte_timedev_field eig;   // E_k, length m
+    t_qte_timedev_field coeff; // c_k, length m
+    // Eigenstates V, n x m row-major: V(i, k) = v_k[i], so component i of every
+    // time step is one row of Psi = V * Phi.
+    t_qte_timedev_field states;
+    uint64_t source_hash;      // of the snapshot read, kept by "write"; 0 once set_* changes the data
+
+    double tolerance;          // @tolerance: keep a weight of 1 - tolerance, 0 = all
+    long maxterms;             // @maxterms: keep at most this many, 0 = no cap
+    uint64_t notice_key;       // selection last posted ("Keeping m of n"), 0 = none, shared by the scratches
+
+    // Observables, published like the eigen-data.
+    t_qte_slots obs_slots;
+    t_qte_timedev_obsset obs_set[QTE_SLOTS];
+    long obs_id;               // ids handed out so far
+    long components;           // @components: 0 = observables only
+
+    // Scratch of the readers, claimed per call.
+    t_qte_timedev_scratch scratch[QTE_TIMEDEV_SCRATCH];
+    long threads;              // @threads, 0 = one per core
+    t_symbol *backend;         // @backend: "cpu" or "metal" (Psi = V * Phi on the GPU)
+    t_symbol *magbuffer;       // @magbuffer / @phasebuffer: buffer~ names, "" = lists
+    t_symbol *phasebuffer;
+    t_buffer_ref *magref;
+    t_buffer_ref *phaseref;
+
+    // Streaming: the index of the next frame, claimed atomically by each frame,
+    // and the epoch, bumped by start, rewind and time_settings so that every
+    // scratch rebuilds its phase factors exactly.
+    void *clock;
+    double interval;           // @interval, ms between clocked frames
+    long frame;                // index s of the next frame, t = tmin + s*dt
+    long frames_left;          // clocked frames still to emit (-1: open-ended)
+    long stream_epoch;
+
+    void *out_status;          // right outlet: stats
+    void *out_obs;             // third outlet
+    void *out_magn;            // second outlet
+    void *out_phase;           // left outlet
+    t_qte_stats stats;         // "stats" message / qte.profiler
+} t_qte_timedev;
+
+static t_class *qte_timedev_class = NULL;
+
+/* Function prototypes */
+void ext_main(void *r);
+void *qte_timedev_new(t_symbol *s, long argc, t_atom *argv);
+void  qte_timedev_free(t_qte_timedev *x);
+void  qte_timedev_assist(t_qte_timedev *x, void *b, long m, long a, char *s);
+
+// Message handlers: "dim", "time_settings", "set_eigenvalues", "set_coeff", "set_eigenstates", "compute"
+void  qte_timedev_dim(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_timedev_time_settings(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_timedev_set_eigenvalues(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_timedev_set_coeff(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_timedev_set_eigenstates(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_timedev_jit_matrix(t_qte_timedev *x, t_symbol *s);
+void  qte_timedev_compute(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_timedev_step(t_qte_timedev *x);
+void  qte_timedev_start(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_timedev_stop(t_qte_timedev *x);
+void  qte_timedev_rewind(t_qte_timedev *x);
+void  qte_timedev_tick(t_qte_timedev *x);
+void  qte_timedev_at(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_timedev_stats(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_timedev_write(t_qte_timedev *x, t_symbol *s);
+t_max_err qte_timedev_notify(t_qte_timedev *x, t_symbol *s, t_symbol *msg, void *sender, void *data);
+t_max_err qte_timedev_magbuffer_set(t_qte_timedev *x, void *attr, long argc, t_atom *argv);
+t_max_err qte_timedev_phasebuffer_set(t_qte_timedev *x, void *attr, long argc, t_atom *argv);
+t_max_err qte_timedev_backend_set(t_qte_timedev *x, void *attr, long argc, t_atom *argv);
+void  qte_timedev_read(t_qte_timedev *x, t_symbol *s);
+void  qte_timedev_observable(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_timedev_unobserve(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv);
+
+// The actual time evolution function
+static void qte_timedev_do_compute(t_qte_timedev *x, const t_qte_timedev_view *v, t_qte_timedev_scratch *sc);
+
+/* ----------------------------------------------------------------------------
+   ext_main – class initialization
+---------------------------------------------------------------------------- */
+void ext_main(void *r) {
+    t_class *c = class_new("qte.timedev",
+                           (method)qte_timedev_new,
+                           (method)qte_timedev_free,
+                           sizeof(t_qte_timedev),
+                           0L, A_GIMME, 0);
+
+    class_addmethod(c, (method)qte_timedev_assist, "assist", A_CANT, 0);
+    class_addmethod(c, (method)qte_timedev_dim, "dim", A_GIMME, 0);
+    class_addmethod(c, (method)qte_timedev_time_settings, "time_settings", A_GIMME, 0);
+    class_addmethod(c, (method)qte_timedev_set_eigenvalues, "set_eigenvalues", A_GIMME, 0);
+    class_addmethod(c, (method)qte_timedev_set_coeff, "set_coeff", A_GIMME, 0);
+    class_addmethod(c, (method)qte_timedev_set_eigenstates, "set_eigenstates", A_GIMME, 0);
+    class_addmethod(c, (method)qte_timedev_jit_matrix, "jit_matrix", A_SYM, 0);
+    // "compute" triggers the output
+    class_addmethod(c, (method)qte_timedev_compute, "compute", A_GIMME, 0);
+    // Streaming, one frame per time step
+    class_addmethod(c, (method)qte_timedev_step, "step", 0);
+    class_addmethod(c, (method)qte_timedev_step, "bang", 0);
+    class_addmethod(c, (method)qte_timedev_start, "start", A_GIMME, 0);
+    class_addmethod(c, (method)qte_timedev_stop, "stop", 0);
+    class_addmethod(c, (method)qte_timedev_rewind, "rewind", 0);
+    class_addmethod(c, (method)qte_timedev_at, "at", A_GIMME, 0);
+    class_addmethod(c, (method)qte_timedev_stats, "stats", A_GIMME, 0);
+    class_addmethod(c, (method)qte_timedev_write, "write", A_DEFSYM, 0);
+    class_addmethod(c, (method)qte_timedev_read, "read", A_DEFSYM, 0);
+    class_addmethod(c, (method)qte_timedev_notify, "notify", A_CANT, 0);
+    // Expectation values instead of (or besides) the components
+    class_addmethod(c, (method)qte_timedev_observable, "observable", A_GIMME, 0);
+    class_addmethod(c, (method)qte_timedev_unobserve, "unobserve", A_GIMME, 0);
+
+    CLASS_ATTR_DOUBLE(c, "interval", 0, t_qte_timedev, interval);
+    CLASS_ATTR_FILTER_MIN(c, "interval", 1.0);
+    CLASS_ATTR_LABEL(c, "interval", 0, "Streaming Interval (ms)");
+
+    CLASS_ATTR_LONG(c, "threads", 0, t_qte_timedev, threads);
+    CLASS_ATTR_FILTER_MIN(c, "threads", 0);
+    CLASS_ATTR_LABEL(c, "threads", 0, "Threads (0 = one per core)");
+
+    CLASS_ATTR_SYM(c, "backend", 0, t_qte_timedev, backend);
+    CLASS_ATTR_ENUM(c, "backend", 0, "cpu metal");
+    CLASS_ATTR_ACCESSORS(c, "backend", NULL, qte_timedev_backend_set);
+    CLASS_ATTR_LABEL(c, "backend", 0, "Compute Backend");
+
+    CLASS_ATTR_DOUBLE(c, "tolerance", 0, t_qte_timedev, tolerance);
+    CLASS_ATTR_FILTER_CLIP(c, "tolerance", 0.0, 1.0);
+    CLASS_ATTR_LABEL(c, "tolerance", 0, "Truncation: Weight Left Out (0 = all terms)");
+
+    CLASS_ATTR_LONG(c, "maxterms", 0, t_qte_timedev, maxterms);
+    CLASS_ATTR_FILTER_MIN(c, "maxterms", 0);
+    CLASS_ATTR_LABEL(c, "maxterms", 0, "Truncation: Most Terms Kept (0 = no cap)");
+
+    CLASS_ATTR_LONG(c, "components", 0, t_qte_timedev, components);
+    CLASS_ATTR_STYLE_LABEL(c, "components", 0, "onoff", "Output Component Trajectories");
+
+    CLASS_ATTR_SYM(c, "magbuffer", 0, t_qte_timedev, magbuffer);
+    CLASS_ATTR_ACCESSORS(c, "magbuffer", NULL, qte_timedev_magbuffer_set);
+    CLASS_ATTR_LABEL(c, "magbuffer", 0, "Magnitude buffer~ (one channel per component)");
+
+    CLASS_ATTR_SYM(c, "phasebuffer", 0, t_qte_timedev, phasebuffer);
+    CLASS_ATTR_ACCESSORS(c, "phasebuffer", NULL, qte_timedev_phasebuffer_set);
+    CLASS_ATTR_LABEL(c, "phasebuffer", 0, "Phase buffer~ (one channel per component)");
+
+    class_register(CLASS_BOX, c);
+    qte_timedev_class = c;
+}
+
+/* ----------------------------------------------------------------------------
+   Storage helpers
+---------------------------------------------------------------------------- */
+static void qte_timedev_unref(t_qte_timedev_observable *o) {
+    if (--o->refs > 0)
+        return;
+    qte_cmatrix_free(&o->O);
+    free(o->d);
+    free(o);
+}
+
+static void qte_timedev_obsset_clear(t_qte_timedev_obsset *set) {
+    for (long j = 0; j < set->nobs; j++)
+        qte_timedev_unref(set->obs[j]);
+    set->nobs = 0;
+}
+
+/* Writer side: the published observables, NULL if none were ever published. */
+static t_qte_timedev_obsset *qte_timedev_obs_current(t_qte_timedev *x) {
+    return x->obs_slots.pub >= 0 ? x->obs_set + x->obs_slots.pub : NULL;
+}
+
+/* Writer side: a set no reader holds, listing the published observables with
+   room for one more, to change and then publish. NULL when out of memory, or
+   with *i = -1 when readers hold every other set. */
+static t_qte_timedev_obsset *qte_timedev_obs_claim(t_qte_timedev *x, int *i) {
+    const t_qte_timedev_obsset *cur = qte_timedev_obs_current(x);
+    long nobs = cur ? cur->nobs : 0;
+    *i = qte_slots_claim(&x->obs_slots);
+    if (*i < 0)
+        return NULL;
+    t_qte_timedev_obsset *set = x->obs_set + *i;
+    qte_timedev_obsset_clear(set);
+    if (set->capacity < nobs + 1) {
+        long capacity = set->capacity ? 2 * set->capacity : 4;
+        while (capacity < nobs + 1)
+            capacity *= 2;
+        t_qte_timedev_observable **obs =
+            (t_qte_timedev_observable **)realloc(set->obs, capacity * sizeof(*obs));
+        if (!obs)
+            return NULL;
+        set->obs = obs;
+        set->capacity = capacity;
+    }
+    for (long j = 0; j < nobs; j++) {
+        set->obs[j] = cur->obs[j];
+        set->obs[j]->refs++;
+    }
+    set->nobs = nobs;
+    return set;
+}
+
+/* Writer side: publishes set i for the current dimension and drops the
+   versions no reader holds, so a replaced observable goes as soon as no
+   compute, frame or "at" uses it. */
+static void qte_timedev_obs_publish(t_qte_timedev *x, int i) {
+    x->obs_set[i].n = x->n;
+    qte_slots_publish(&x->obs_slots, i);
+    for (i = 0; i < QTE_SLOTS; i++) {
+        if (qte_slots_idle(&x->obs_slots, i))
+            qte_timedev_obsset_clear(x->obs_set + i);
+    }
+}
+
+/* Writer side: publishes the claimed set i empty. */
+static void qte_timedev_observables_clear(t_qte_timedev *x, int i) {
+    qte_timedev_obsset_clear(x->obs_set + i);
+    qte_timedev_obs_publish(x, i);
+}
+
+static void qte_timedev_slot_free(t_qte_timedev_slot *slot) {
+    free(slot->E);
+    slot->E = NULL;
+    slot->E_size = 0;
+    qte_cvector_free(&slot->c);
+    qte_cmatrix_free(&slot->V);
+    qte_snapshot_close(&slot->snap);
+    slot->n = 0;
+    slot->m = 0;
+}
+
+static void qte_timedev_field_init(t_qte_timedev_field *f) {
+    qte_slots_init(&f->slots);
+    for (int i = 0; i < QTE_SLOTS; i++) {
+        t_qte_timedev_slot *slot = f->slot + i;
+        slot->n = 0;
+        slot->m = 0;
+        slot->E = NULL;
+        slot->E_size = 0;
+        qte_cvector_init(&slot->c);
+        qte_cmatrix_init(&slot->V);
+        qte_snapshot_init(&slot->snap);
+    }
+}
+
+static void qte_timedev_field_free(t_qte_timedev_field *f) {
+    for (int i = 0; i < QTE_SLOTS; i++)
+        qte_timedev_slot_free(f->slot + i);
+}
+
+/* Writer side: a slot of f that no reader holds, to fill and then publish;
+   NULL when readers hold every other slot. */
+static t_qte_timedev_slot *qte_timedev_claim(t_qte_timedev_field *f, int *i) {
+    *i = qte_slots_claim(&f->slots);
+    return *i >= 0 ? f->slot + *i : NULL;
+}
+
+static void qte_timedev_publish(t_qte_timedev_field *f, int i, long n, long m) {
+    f->slot[i].n = n;
+    f->slot[i].m = m;
+    qte_slots_publish(&f->slots, i);
+}
+
+/* Writer side: publishes the claimed slot i of f as not set and frees the
+   versions no reader holds; the others go once they are claimed again. */
+static void qte_timedev_field_clear(t_qte_timedev_field *f, int i) {
+    qte_timedev_slot_free(f->slot + i);
+    qte_timedev_publish(f, i, 0, 0);
+    for (i = 0; i < QTE_SLOTS; i++) {
+        if (qte_slots_idle(&f->slots, i))
+            qte_timedev_slot_free(f->slot + i);
+    }
+}
+
+/* Reader side: pins the current eigenvalues, coefficients, eigenstates and
+   observables in *v, with the time settings and @components, for a compute,
+   frame or "at". Fails, holding nothing, unless the eigen-data is set for the
+   same dimension and number of eigenpairs. Every successful acquire is paired
+   with a release. */
+static int qte_timedev_acquire(t_qte_timedev *x, t_qte_timedev_view *v) {
+    t_qte_timedev_field *f[3] = { &x->eig, &x->coeff, &x->states };
+    int set = 1, agree = 1;
+    for (int j = 0; j < 3; j++) {
+        v->slot[j] = qte_slots_acquire(&f[j]->slots);
+        if (v->slot[j] < 0 || f[j]->slot[v->slot[j]].n == 0) {
+            set = 0;
+            continue;
+        }
+        v->gen[j] = f[j]->slots.gen[v->slot[j]];
+        if (set && (f[j]->slot[v->slot[j]].n != f[0]->slot[v->slot[0]].n ||
+                    f[j]->slot[v->slot[j]].m != f[0]->slot[v->slot[0]].m))
+            agree = 0;
+    }
+    if (!set || !agree) {
+        if (!set)
+            object_error((t_object *)x, "Need eigenvalues, coeff, eigenstates first");
+        else
+            object_error((t_object *)x, "Eigenvalues, coeff and eigenstates disagree: %ld, %ld and %ld eigenpairs",
+                         x->eig.slot[v->slot[0]].m, x->coeff.slot[v->slot[1]].m, x->states.slot[v->slot[2]].m);
+        for (int j = 0; j < 3; j++) {
+            if (v->slot[j] >= 0)
+                qte_slots_release(&f[j]->slots, v->slot[j]);
+        }
+        return -1;
+    }
+    v->n = x->eig.slot[v->slot[0]].n;
+    v->m = x->eig.slot[v->slot[0]].m;
+    v->E = x->eig.slot[v->slot[0]].E;
+    v->c = x->coeff.slot[v->slot[1]].c.data;
+    v->V = &x->states.slot[v->slot[2]].V;
+    // Observables of another dimension (a dim or read in between) are left out.
+    v->slot[3] = qte_slots_acquire(&x->obs_slots);
+    const t_qte_timedev_obsset *obs = v->slot[3] >= 0 ? x->obs_set + v->slot[3] : NULL;
+    v->obs = obs ? obs->obs : NULL;
+    v->nobs = (obs && obs->n == v->n) ? obs->nobs : 0;
+    v->tmin = x->tmin;
+    v->tsteps = x->tsteps;
+    v->dt = (x->tmax - x->tmin) / (v->tsteps - 1);
+    v->components = x->components;
+    return 0;
+}
+
+static void qte_timedev_release(t_qte_timedev *x, const t_qte_timedev_view *v) {
+    qte_slots_release(&x->eig.slots, v->slot[0]);
+    qte_slots_release(&x->coeff.slots, v->slot[1]);
+    qte_slots_release(&x->states.slots, v->slot[2]);
+    if (v->slot[3] >= 0)
+        qte_slots_release(&x->obs_slots, v->slot[3]);
+}
+
+static void qte_timedev_scratch_init(t_qte_timedev_scratch *sc) {
+    memset(sc, 0, sizeof(*sc));
+    qte_cmatrix_init(&sc->Vt);
+    qte_cvector_init(&sc->ct);
+    qte_cmatrix_init(&sc->obs_w);
+    qte_cmatrix_init(&sc->phi);
+    qte_cmatrix_init(&sc->psi);
+    qte_cvector_init(&sc->z);
+    qte_cvector_init(&sc->rot);
+    qte_cvector_init(&sc->amp);
+    sc->zframe = -1;
+}
+
+static void qte_timedev_scratch_free(t_qte_timedev_scratch *sc) {
+    free(sc->terms);
+    free(sc->Et);
+    qte_cmatrix_free(&sc->Vt);
+    qte_cvector_free(&sc->ct);
+    for (long j = 0; j < sc->ob_capacity; j++)
+        qte_cmatrix_free(&sc->ob[j].Ob);
+    free(sc->ob);
+    free(sc->expect);
+    qte_cmatrix_free(&sc->obs_w);
+    qte_cmatrix_free(&sc->phi);
+    qte_cmatrix_free(&sc->psi);
+    qte_metal_free(sc->gpu);
+    if (sc->out_list)
+        sysmem_freeptr(sc->out_list);
+    qte_cvector_free(&sc->z);
+    qte_cvector_free(&sc->rot);
+    qte_cvector_free(&sc->amp);
+    if (sc->frame_list)
+        sysmem_freeptr(sc->frame_list);
+    free(sc->at_times);
+}
+
+/* A scratch for one compute, frame or "at": a free one of the object's, which
+   keeps its selection and caches between calls, else (all busy, say an "at"
+   sent from the output of a compute) one for this call only. NULL when out
+   of memory. Every claim is paired with a qte_timedev_scratch_release. */
+static t_qte_timedev_scratch *qte_timedev_scratch_claim(t_qte_timedev *x) {
+    for (int i = 0; i < QTE_TIMEDEV_SCRATCH; i++) {
+        if (!__atomic_exchange_n(&x->scratch[i].busy, 1, __ATOMIC_SEQ_CST))
+            return x->scratch + i;
+    }
+    t_qte_timedev_scratch *sc = (t_qte_timedev_scratch *)malloc(sizeof(*sc));
+    if (!sc) {
+        object_error((t_object *)x, "Memory allocation failed for scratch");
+        return NULL;
+    }
+    qte_timedev_scratch_init(sc);
+    sc->busy = 1;
+    sc->temporary = 1;
+    return sc;
+}
+
+static void qte_timedev_scratch_release(t_qte_timedev_scratch *sc) {
+    if (sc->temporary) {
+        qte_timedev_scratch_free(sc);
+        free(sc);
+        return;
+    }
+    __atomic_store_n(&sc->busy, 0, __ATOMIC_SEQ_CST);
+}
+
+/* ----------------------------------------------------------------------------
+   Constructor / Destructor
+---------------------------------------------------------------------------- */
+void *qte_timedev_new(t_symbol *s, long argc, t_atom *argv) {
+    t_qte_timedev *x = (t_qte_timedev *)object_alloc(qte_timedev_class);
+    if (!x)
+        return NULL;
+
+    // defaults
+    x->tmin = 0.0;
+    x->tmax = 5.0;
+    x->tsteps = 20;
+
+    x->n = 4;
+    qte_timedev_field_init(&x->eig);
+    qte_timedev_field_init(&x->coeff);
+    qte_timedev_field_init(&x->states);
+    x->source_hash = 0;
+    x->tolerance = 0.0;
+    x->maxterms = 0;
+    x->notice_key = 0;
+    qte_slots_init(&x->obs_slots);
+    for (int i = 0; i < QTE_SLOTS; i++) {
+        x->obs_set[i].n = 0;
+        x->obs_set[i].obs = NULL;
+        x->obs_set[i].nobs = 0;
+        x->obs_set[i].capacity = 0;
+    }
+    x->obs_id = 0;
+    x->components = 1;
+    for (int i = 0; i < QTE_TIMEDEV_SCRATCH; i++)
+        qte_timedev_scratch_init(x->scratch + i);
+    x->threads = 0;
+    x->backend = gensym("cpu");
+    x->magbuffer = gensym("");
+    x->phasebuffer = gensym("");
+    x->magref = buffer_ref_new((t_object *)x, x->magbuffer);
+    x->phaseref = buffer_ref_new((t_object *)x, x->phasebuffer);
+    x->clock = clock_new(x, (method)qte_timedev_tick);
+    x->interval = 20.0;
+    x->frame = 0;
+    x->frames_left = 0;
+    x->stream_epoch = 0;
+
+    // four outlets, created right to left
+    x->out_status = outlet_new((t_object *)x, NULL);
+    x->out_obs = outlet_new((t_object *)x, NULL);
+    x->out_magn = outlet_new((t_object *)x, NULL);
+    x->out_phase = outlet_new((t_object *)x, NULL);
+    qte_stats_register((t_object *)x, &x->stats);
+
+    attr_args_process(x, argc, argv);
+    return x;
+}
+
+void qte_timedev_free(t_qte_timedev *x) {
+    qte_stats_unregister((t_object *)x);
+    if (x->clock)
+        object_free(x->clock);
+    qte_timedev_field_free(&x->eig);
+    qte_timedev_field_free(&x->coeff);
+    qte_timedev_field_free(&x->states);
+    for (int i = 0; i < QTE_SLOTS; i++) {
+        qte_timedev_obsset_clear(x->obs_set + i);
+        free(x->obs_set[i].obs);
+    }
+    for (int i = 0; i < QTE_TIMEDEV_SCRATCH; i++)
+        qte_timedev_scratch_free(x->scratch + i);
+    object_free(x->magref);
+    object_free(x->phaseref);
+}
+
+/* ----------------------------------------------------------------------------
+   Assist method
+---------------------------------------------------------------------------- */
+void qte_timedev_assist(t_qte_timedev *x, void *b, long m, long a, char *s) {
+    if (m == 1) {
+        sprintf(s, "Messages: dim <n>, time_settings <tmin> <tmax> <tsteps>, set_eigenvalues, set_coeff, set_eigenstates / jit_matrix, observable / unobserve, compute, step, start [frames], stop, rewind, at <t> [t ...], write / read <file>");
+    } else {
+        switch (a) {
+            case 0: sprintf(s, "Phases (bang once @phasebuffer is written)"); break;
+            case 1: sprintf(s, "Magnitudes (bang once @magbuffer is written)"); break;
+            case 2: sprintf(s, "Observables: <name> t0 <O>(t0) t1 <O>(t1) ... (one t <O>(t) pair per frame)"); break;
+            case 3: sprintf(s, "Status outlet: stats"); break;
+        }
+    }
+}
+
+/* ----------------------------------------------------------------------------
+   1) dim <n>
+---------------------------------------------------------------------------- */
+void qte_timedev_dim(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv) {
+    if (argc < 1)
+        return;
+    long n = atom_getlong(argv);
+    if (n <= 0)
+        return;
+    // The eigen-data of the old dimension is dropped, all of it or none.
+    int ie = qte_slots_claim(&x->eig.slots), ic = qte_slots_claim(&x->coeff.slots);
+    int iv = qte_slots_claim(&x->states.slots), io = qte_slots_claim(&x->obs_slots);
+    if (ie < 0 || ic < 0 || iv < 0 || io < 0) {
+        object_error((t_object *)x, "Eigen-data still in use, dimension stays %ld", x->n);
+        return;
+    }
+    qte_timedev_stop(x);
+    qte_timedev_field_clear(&x->eig, ie);
+    qte_timedev_field_clear(&x->coeff, ic);
+    qte_timedev_field_clear(&x->states, iv);
+    qte_timedev_observables_clear(x, io);
+    x->source_hash = 0;
+    x->n = n;
+    object_post((t_object *)x, "dimension set to %ld", x->n);
+}
+
+/* ----------------------------------------------------------------------------
+   2) time_settings <tmin> <tmax> <tsteps>
+---------------------------------------------------------------------------- */
+void qte_timedev_time_settings(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv) {
+    if (argc < 3) {
+        object_error((t_object *)x, "time_settings needs 3 arguments: tmin tmax tsteps");
+        return;
+    }
+    x->tmin = atom_getfloat(argv);
+    x->tmax = atom_getfloat(argv + 1);
+    x->tsteps = atom_getlong(argv + 2);
+    if (x->tsteps < 2)
+        x->tsteps = 2;
+    __atomic_fetch_add(&x->stream_epoch, 1, __ATOMIC_SEQ_CST);
+    object_post((t_object *)x, "time_settings: tmin=%.2f, tmax=%.2f, tsteps=%ld", x->tmin, x->tmax, x->tsteps);
+}
+
+/* ----------------------------------------------------------------------------
+   3) set_eigenvalues <m floats>, m <= n
+---------------------------------------------------------------------------- */
+void qte_timedev_set_eigenvalues(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv) {
+    if (argc < 1 || argc > x->n) {
+        object_error((t_object *)x, "Expected 1..%ld floats for eigenvalues", x->n);
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    int i;
+    t_qte_timedev_slot *slot = qte_timedev_claim(&x->eig, &i);
+    if (!slot) {
+        object_error((t_object *)x, "Eigenvalues still in use, try again");
+        return;
+    }
+    if (slot->E_size < argc) {
+        free(slot->E);
+        slot->E_size = 0;
+        if (!(slot->E = (double *)malloc(argc * sizeof(double)))) {
+            object_error((t_object *)x, "Memory allocation failed for eigenvalues");
+            return;
+        }
+        slot->E_size = argc;
+    }
+    for (long k = 0; k < argc; k++)
+        slot->E[k] = atom_getfloat(argv + k);
+    qte_timedev_publish(&x->eig, i, x->n, argc);
+    x->source_hash = 0;
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+    object_post((t_object *)x, "Eigenvalues set");
+}
+
+/* ----------------------------------------------------------------------------
+   4) set_coeff <2*m floats> => m complex
+---------------------------------------------------------------------------- */
+void qte_timedev_set_coeff(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv) {
+    long m = argc / 2;
+    if (argc % 2 || m < 1 || m > x->n) {
+        object_error((t_object *)x, "Expected 2*m floats (m <= %ld) for init coeff", x->n);
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    int i;
+    t_qte_timedev_slot *slot = qte_timedev_claim(&x->coeff, &i);
+    if (!slot) {
+        object_error((t_object *)x, "Coefficients still in use, try again");
+        return;
+    }
+    if (qte_cvector_resize(&slot->c, m)) {
+        object_error((t_object *)x, "Memory allocation failed for init coeff");
+        return;
+    }
+    qte_atoms_to_cvector(argc, argv, &slot->c);
+    qte_timedev_publish(&x->coeff, i, x->n, m);
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+    object_post((t_object *)x, "Coefficients set");
+}
+
+/* ----------------------------------------------------------------------------
+   5) set_eigenstates <2*n*m floats>
+---------------------------------------------------------------------------- */
+void qte_timedev_set_eigenstates(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv) {
+    long n = x->n;
+    long m = argc / (2 * n);
+    if (argc % (2 * n) || m < 1 || m > n) {
+        object_error((t_object *)x, "Expected 2*n*m floats (n = %ld, m <= n) for eigenstates", n);
+        return;
+    }
+    // Eigenvector k occupies floats 2*(k*n) .. 2*(k*n + n) - 1, i.e. V column by column.
+    double t = qte_stats_begin(&x->stats);
+    int i;
+    t_qte_timedev_slot *slot = qte_timedev_claim(&x->states, &i);
+    if (!slot) {
+        object_error((t_object *)x, "Eigenstates still in use, try again");
+        return;
+    }
+    // A version read from a snapshot mapping gets storage of its own.
+    qte_snapshot_close(&slot->snap);
+    if (qte_cmatrix_resize(&slot->V, n, m, QTE_ROW_MAJOR)) {
+        object_error((t_object *)x, "Memory allocation failed for eigenstates");
+        return;
+    }
+    qte_atoms_to_cmatrix(argc, argv, &slot->V, QTE_COL_MAJOR);
+    qte_timedev_publish(&x->states, i, n, m);
+    x->source_hash = 0;
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+    object_post((t_object *)x, "Eigenstates set");
+}
+
+/* jit_matrix – the eigenstates as a 2-plane float64 matrix with n rows and
+   m <= n columns, one eigenvector per column. Matrix row i is component i of
+   every eigenvector, a row of V, so the rows copy straight across. */
+void qte_timedev_jit_matrix(t_qte_timedev *x, t_symbol *s) {
+    long n = x->n, rows, cols;
+    if (qte_jit_matrix_dims(s, &rows, &cols) || rows != n || cols < 1 || cols > n) {
+        object_error((t_object *)x, "Expected a 2-plane float64 jit.matrix with %ld rows and at most %ld columns", n, n);
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    int i;
+    t_qte_timedev_slot *slot = qte_timedev_claim(&x->states, &i);
+    if (!slot) {
+        object_error((t_object *)x, "Eigenstates still in use, try again");
+        return;
+    }
+    qte_snapshot_close(&slot->snap);
+    slot->V.layout = QTE_ROW_MAJOR;
+    if (qte_jit_matrix_read(s, &slot->V)) {
+        object_error((t_object *)x, "Could not read jit.matrix %s", s->s_name);
+        return;
+    }
+    qte_timedev_publish(&x->states, i, n, cols);
+    x->source_hash = 0;
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+    object_post((t_object *)x, "Eigenstates set");
+}
+
+/* ----------------------------------------------------------------------------
+   observable <name> <2*n*n floats> | diag <n floats> | energy, unobserve [name]
+---------------------------------------------------------------------------- */
+static t_symbol *qte_timedev_name(const t_atom *a) {
+    char buf[32];
+    if (atom_gettype(a) == A_SYM)
+        return atom_getsym(a);
+    if (atom_gettype(a) == A_LONG)
+        snprintf(buf, sizeof(buf), "%ld", (long)atom_getlong(a));
+    else
+        snprintf(buf, sizeof(buf), "%g", atom_getfloat(a));
+    return gensym(buf);
+}
+
+static long qte_timedev_find(const t_qte_timedev_obsset *set, t_symbol *name) {
+    for (long j = 0; set && j < set->nobs; j++) {
+        if (set->obs[j]->name == name)
+            return j;
+    }
+    return -1;
+}
+
+/* Each change publishes a new set of observables (the unchanged ones shared
+   with the old set), so a compute, frame or "at" keeps the set it pinned. */
+void qte_timedev_observable(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv) {
+    long n = x->n;
+    if (argc < 2) {
+        object_error((t_object *)x, "Expected observable <name> followed by 2*n*n=%ld floats, diag <%ld floats> or energy",
+                     2 * n * n, n);
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    t_symbol *name = qte_timedev_name(argv);
+    t_symbol *kind = atom_gettype(argv + 1) == A_SYM ? atom_getsym(argv + 1) : NULL;
+    t_qte_timedev_observable *o = (t_qte_timedev_observable *)calloc(1, sizeof(*o));
+    if (!o) {
+        object_error((t_object *)x, "Memory allocation failed for observable %s", name->s_name);
+        return;
+    }
+    o->name = name;
+    o->refs = 1;
+    qte_cmatrix_init(&o->O);
+    if (kind == gensym("energy") && argc == 2) {
+        o->kind = QTE_TIMEDEV_ENERGY;
+    } else if (kind == gensym("diag") && argc == 2 + n) {
+        o->kind = QTE_TIMEDEV_DIAG;
+        if (!(o->d = (double *)malloc(n * sizeof(double)))) {
+            object_error((t_object *)x, "Memory allocation failed for observable %s", name->s_name);
+            qte_timedev_unref(o);
+            return;
+        }
+        for (long i = 0; i < n; i++)
+            o->d[i] = atom_getfloat(argv + 2 + i);
+    } else if (!kind && argc == 1 + 2 * n * n) {
+        o->kind = QTE_TIMEDEV_MATRIX;
+        if (qte_cmatrix_resize(&o->O, n, n, QTE_ROW_MAJOR)) {
+            object_error((t_object *)x, "Memory allocation failed for observable %s", name->s_name);
+            qte_timedev_unref(o);
+            return;
+        }
+        qte_atoms_to_cmatrix(argc - 1, argv + 1, &o->O, QTE_ROW_MAJOR);
+    } else {
+        object_error((t_object *)x, "Expected observable <name> followed by 2*n*n=%ld floats, diag <%ld floats> or energy",
+                     2 * n * n, n);
+        qte_timedev_unref(o);
+        return;
+    }
+
+    int i;
+    t_qte_timedev_obsset *set = qte_timedev_obs_claim(x, &i);
+    if (!set) {
+        if (i < 0)
+            object_error((t_object *)x, "Observables still in use, try again");
+        else
+            object_error((t_object *)x, "Memory allocation failed for observable list");
+        qte_timedev_unref(o);
+        return;
+    }
+    o->id = ++x->obs_id;
+    long j = qte_timedev_find(set, name);
+    if (j < 0)
+        j = set->nobs++;
+    else
+        qte_timedev_unref(set->obs[j]);
+    set->obs[j] = o;
+    qte_timedev_obs_publish(x, i);
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+}
+
+void qte_timedev_unobserve(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv) {
+    if (argc < 1) {
+        int i = qte_slots_claim(&x->obs_slots);
+        if (i < 0)
+            object_error((t_object *)x, "Observables still in use, try again");
+        else
+            qte_timedev_observables_clear(x, i);
+        return;
+    }
+    t_symbol *name = qte_timedev_name(argv);
+    if (qte_timedev_find(qte_timedev_obs_current(x), name) < 0) {
+        object_error((t_object *)x, "No observable %s", name->s_name);
+        return;
+    }
+    int i;
+    t_qte_timedev_obsset *set = qte_timedev_obs_claim(x, &i);
+    if (!set) {
+        if (i < 0)
+            object_error((t_object *)x, "Observables still in use, try again");
+        else
+            object_error((t_object *)x, "Memory allocation failed for observable list");
+        return;
+    }
+    long j = qte_timedev_find(set, name);
+    qte_timedev_unref(set->obs[j]);
+    for (long k = j + 1; k < set->nobs; k++)
+        set->obs[k - 1] = set->obs[k];
+    set->nobs--;
+    qte_timedev_obs_publish(x, i);
+}
+
+/* Selects the basis V, E, c (m terms) of sc for the eigen-data pinned in v and
+   @tolerance / @maxterms, copying the kept terms into Vt, Et and ct. The
+   selection stands until a new version of the eigen-data is pinned or the
+   attributes change; the observables are taken into a new basis, and the
+   stream re-anchored, as after a set_*. Every scratch makes the same
+   selection for the same versions, so it is posted by whichever gets there
+   first (x->notice_key), once per change rather than once per scratch. */
+static int qte_timedev_select(t_qte_timedev *x, const t_qte_timedev_view *v, t_qte_timedev_scratch *sc) {
+    double tolerance = x->tolerance;
+    long maxterms = x->maxterms;
+    if (sc->nterms && !memcmp(sc->terms_gen, v->gen, sizeof(v->gen)) &&
+        sc->terms_tol == tolerance && sc->terms_max == maxterms)
+        return 0;
+    long n = v->n, m = v->m;
+    int was_truncated = sc->V == &sc->Vt;
+    int new_states = sc->terms_gen[2] != v->gen[2];
+    sc->nterms = 0;
+    if (n > sc->scratch_n) {
+        free(sc->terms);
+        free(sc->Et);
+        if (sc->frame_list)
+            sysmem_freeptr(sc->frame_list);
+        sc->terms = (long *)malloc(n * sizeof(long));
+        sc->Et = (double *)malloc(n * sizeof(double));
+        sc->frame_list = (t_atom *)sysmem_newptr((1 + n) * sizeof(t_atom));
+        sc->scratch_n = (sc->terms && sc->Et && sc->frame_list) ? n : 0;
+    }
+    if (!sc->scratch_n || qte_cvector_resize(&sc->z, n) || qte_cvector_resize(&sc->rot, n) ||
+        qte_cvector_resize(&sc->amp, n)) {
+        object_error((t_object *)x, "Memory allocation failed for dimension %ld", n);
+        return -1;
+    }
+    if (tolerance > 0.0 || maxterms > 0) {
+        double dropped;
+        m = qte_truncate_weight(v->c, v->m, tolerance, maxterms, sc->terms, &dropped);
+        if (m < 0 || qte_cmatrix_resize(&sc->Vt, n, m, QTE_ROW_MAJOR) || qte_cvector_resize(&sc->ct, m)) {
+            object_error((t_object *)x, "Memory allocation failed for the truncated basis");
+            return -1;
+        }
+        for (long i = 0; i < n; i++) {
+            const double complex *src = v->V->data + i * v->V->ld;
+            double complex *dst = sc->Vt.data + i * sc->Vt.ld;
+            for (long j = 0; j < m; j++)
+                dst[j] = src[sc->terms[j]];
+        }
+        for (long j = 0; j < m; j++) {
+            sc->Et[j] = v->E[sc->terms[j]];
+            sc->ct.data[j] = v->c[sc->terms[j]];
+        }
+        sc->V = &sc->Vt;
+        sc->E = sc->Et;
+        sc->c = sc->ct.data;
+        sc->basis_stamp++;
+        uint64_t key = qte_hash64(v->gen, sizeof(v->gen), qte_hash64(&tolerance, sizeof(tolerance), (uint64_t)maxterms));
+        key += !key;
+        if (__atomic_exchange_n(&x->notice_key, key, __ATOMIC_SEQ_CST) != key)
+            object_post((t_object *)x, "Keeping %ld of %ld eigenstates, weight left out %g (state error %g)",
+                         m, v->m, dropped, sqrt(dropped));
+    } else {
+        __atomic_store_n(&x->notice_key, 0, __ATOMIC_SEQ_CST);
+        sc->V = v->V;
+        sc->E = v->E;
+        sc->c = v->c;
+        if (was_truncated || new_states)
+            sc->basis_stamp++;
+    }
+    // z and rot hold n entries, so shrinking them never allocates.
+    qte_cvector_resize(&sc->z, m);
+    qte_cvector_resize(&sc->rot, m);
+    sc->m = m;
+    sc->nterms = m;
+    memcpy(sc->terms_gen, v->gen, sizeof(v->gen));
+    sc->terms_tol = tolerance;
+    sc->terms_max = maxterms;
+    sc->rot_dt = 0.0;
+    sc->zframe = -1;
+    return 0;
+}
+
+/* Fills sc->expect (nobs x steps) with the expectation of every pinned
+   observable for the steps columns of Phi, taking the observables into the
+   basis of sc first where needed. */
+static int qte_timedev_expectations(t_qte_timedev *x, const t_qte_timedev_view *v, t_qte_timedev_scratch *sc,
+                                    const t_qte_cmatrix *Phi) {
+    long nobs = v->nobs, steps = Phi->cols;
+    if (sc->expect_size < nobs * steps) {
+        free(sc->expect);
+        sc->expect_size = 0;
+        if (!(sc->expect = (double *)malloc(nobs * steps * sizeof(double)))) {
+            object_error((t_object *)x, "Memory allocation failed for expectation values");
+            return -1;
+        }
+        sc->expect_size = nobs * steps;
+        x->stats.bytes += sc->expect_size * sizeof(double);
+    }
+    if (sc->ob_capacity < nobs) {
+        t_qte_timedev_obcache *ob = (t_qte_timedev_obcache *)realloc(sc->ob, nobs * sizeof(*ob));
+        if (!ob) {
+            object_error((t_object *)x, "Memory allocation failed for expectation values");
+            return -1;
+        }
+        for (long j = sc->ob_capacity; j < nobs; j++) {
+            ob[j].id = 0;
+            ob[j].stamp = 0;
+            qte_cmatrix_init(&ob[j].Ob);
+        }
+        sc->ob = ob;
+        sc->ob_capacity = nobs;
+    }
+    for (long j = 0; j < nobs; j++) {
+        const t_qte_timedev_observable *o = v->obs[j];
+        t_qte_timedev_obcache *ob = sc->ob + j;
+        double *e = sc->expect + j * steps;
+        if (o->kind == QTE_TIMEDEV_ENERGY) {
+            qte_expectations(NULL, sc->E, Phi, NULL, e);
+            continue;
+        }
+        if (ob->id != o->id || ob->stamp != sc->basis_stamp) {
+            ob->id = 0;
+            if (qte_observable_basis(sc->V, o->kind == QTE_TIMEDEV_MATRIX ? &o->O : NULL,
+                                     o->d, &sc->obs_w, &ob->Ob)) {
+                object_error((t_object *)x, "Memory allocation failed for observable %s", o->name->s_name);
+                return -1;
+            }
+            ob->id = o->id;
+            ob->stamp = sc->basis_stamp;
+        }
+        if (qte_expectations(&ob->Ob, NULL, Phi, &sc->obs_w, e)) {
+            object_error((t_object *)x, "Memory allocation failed for observable %s", o->name->s_name);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+/* ----------------------------------------------------------------------------
+   6) compute => do the time evolution & output
+---------------------------------------------------------------------------- */
+void qte_timedev_compute(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv) {
+    t_qte_timedev_view v;
+    if (qte_timedev_acquire(x, &v))
+        return;
+    t_qte_timedev_scratch *sc = qte_timedev_scratch_claim(x);
+    if (sc) {
+        qte_timedev_do_compute(x, &v, sc);
+        qte_timedev_scratch_release(sc);
+    }
+    qte_timedev_release(x, &v);
+}
+
+/* ----------------------------------------------------------------------------
+   buffer~ output
+---------------------------------------------------------------------------- */
+#define QTE_TIMEDEV_BUFFER_BLOCK 64     // frames per pass over the components
+
+/* Locks the buffer~ for writing, resized to tsteps frames x n channels unless
+   it already has that shape. Returns its samples, or NULL after an error. */
+static float *qte_timedev_lock_buffer(t_qte_timedev *x, const t_qte_timedev_view *v, t_buffer_ref *ref,
+                                      t_symbol *name) {
+    long n = v->n, tsteps = v->tsteps;
+    t_buffer_obj *b = buffer_ref_getobject(ref);
+    if (!b) {
+        object_error((t_object *)x, "No buffer~ %s", name->s_name);
+        return NULL;
+    }
+    if (buffer_getchannelcount(b) != n || buffer_getframecount(b) != tsteps) {
+        t_atom a[2];
+        atom_setlong(a, tsteps);
+        atom_setlong(a + 1, n);
+        object_method_typed(b, gensym("sizeinsamps"), 2, a, NULL);
+        b = buffer_ref_getobject(ref);
+        if (!b || buffer_getchannelcount(b) != n || buffer_getframecount(b) != tsteps) {
+            object_error((t_object *)x, "Could not resize buffer~ %s to %ld frames x %ld channels",
+                         name->s_name, tsteps, n);
+            return NULL;
+        }
+    }
+    float *samples = buffer_locksamples(b);
+    if (!samples)
+        object_error((t_object *)x, "Could not lock buffer~ %s", name->s_name);
+    return samples;
+}
+
+/* Whether @magbuffer and @phasebuffer resolve to the same buffer~ (posting an
+   error if so). One buffer~ cannot hold both planes: the second write would
+   overwrite the first, and the block path would lock it twice. */
+static int qte_timedev_same_buffer(t_qte_timedev *x) {
+    if (x->magbuffer == gensym("") || x->phasebuffer == gensym(""))
+        return 0;
+    t_buffer_obj *mag = buffer_ref_getobject(x->magref);
+    if (!mag || mag != buffer_ref_getobject(x->phaseref))
+        return 0;
+    object_error((t_object *)x, "@magbuffer and @phasebuffer both name buffer~ %s, give each plane its own",
+                 x->magbuffer->s_name);
+    return 1;
+}
+
+static void qte_timedev_unlock_buffer(t_buffer_ref *ref) {
+    t_buffer_obj *b = buffer_ref_getobject(ref);
+    buffer_unlocksamples(b);
+    buffer_setdirty(b);
+}
+
+/* Writes the magnitudes (phase 0) or phases of psi (n x steps, |psi| + i arg psi)
+   as the buffer~ frames s0 .. s0 + steps - 1. */
+static void qte_timedev_write_frames(long n, const t_qte_cmatrix *psi, long s0, float *samples, int phase) {
+    long steps = psi->cols;
+    // Psi holds one component per row, the buffer~ one frame per n samples:
+    // transpose in blocks of frames so both sides stay in cache.
+    for (long t0 = 0; t0 < steps; t0 += QTE_TIMEDEV_BUFFER_BLOCK) {
+        long t1 = t0 + QTE_TIMEDEV_BUFFER_BLOCK < steps ? t0 + QTE_TIMEDEV_BUFFER_BLOCK : steps;
+        for (long i = 0; i < n; i++) {
+            const double complex *row = psi->data + i * psi->ld;
+            float *dst = samples + s0 * n + i;
+            if (phase) {
+                for (long t = t0; t < t1; t++)
+                    dst[t * n] = (float)cimag(row[t]);
+            } else {
+                for (long t = t0; t < t1; t++)
+                    dst[t * n] = (float)creal(row[t]);
+            }
+        }
+    }
+}
+
+/* Writes the magnitudes (phase 0) or phases of sc->psi into the buffer~. */
+static int qte_timedev_fill_buffer(t_qte_timedev *x, const t_qte_timedev_view *v, t_qte_timedev_scratch *sc,
+                                   t_buffer_ref *ref, t_symbol *name, int phase) {
+    float *samples = qte_timedev_lock_buffer(x, v, ref, name);
+    if (!samples)
+        return -1;
+    qte_timedev_write_frames(v->n, &sc->psi, 0, samples, phase);
+    qte_timedev_unlock_buffer(ref);
+    return 0;
+}
+
+/* Keeps the buffer references bound when a buffer~ is created, renamed or freed. */
+t_max_err qte_timedev_notify(t_qte_timedev *x, t_symbol *s, t_symbol *msg, void *sender, void *data) {
+    buffer_ref_notify(x->magref, s, msg, sender, data);
+    return buffer_ref_notify(x->phaseref, s, msg, sender, data);
+}
+
+t_max_err qte_timedev_magbuffer_set(t_qte_timedev *x, void *attr, long argc, t_atom *argv) {
+    x->magbuffer = (argc && argv) ? atom_getsym(argv) : gensym("");
+    buffer_ref_set(x->magref, x->magbuffer);
+    return MAX_ERR_NONE;
+}
+
+t_max_err qte_timedev_phasebuffer_set(t_qte_timedev *x, void *attr, long argc, t_atom *argv) {
+    x->phasebuffer = (argc && argv) ? atom_getsym(argv) : gensym("");
+    buffer_ref_set(x->phaseref, x->phasebuffer);
+    return MAX_ERR_NONE;
+}
+
+t_max_err qte_timedev_backend_set(t_qte_timedev *x, void *attr, long argc, t_atom *argv) {
+    t_symbol *backend = (argc && argv) ? atom_getsym(argv) : gensym("cpu");
+    if (backend != gensym("cpu") && backend != gensym("metal")) {
+        object_error((t_object *)x, "Unknown backend %s, use cpu or metal", backend->s_name);
+        return MAX_ERR_GENERIC;
+    }
+    if (backend == gensym("metal") && !qte_metal_available())
+        object_warn((t_object *)x, "No Metal device in this build, @backend metal computes on the CPU");
+    x->backend = backend;
+    return MAX_ERR_NONE;
+}
+
+/* Makes sure sc->out_list holds size atoms. */
+static int qte_timedev_reserve(t_qte_timedev *x, t_qte_timedev_scratch *sc, long size) {
+    if (qte_atoms_reserve(&sc->out_list, &sc->out_list_size, size, &x->stats)) {
+        object_error((t_object *)x, "Memory allocation failed for output lines");
+        return -1;
+    }
+    return 0;
+}
+
+/* With @components 0 only the observables are computed. */
+static int qte_timedev_has_output(t_qte_timedev *x, const t_qte_timedev_view *v) {
+    if (v->components || v->nobs)
+        return 1;
+    object_error((t_object *)x, "Nothing to output: @components is 0 and no observable is set");
+    return 0;
+}
+
+/* ----------------------------------------------------------------------------
+   The actual time evolution: Psi (n x tsteps) = V (n x m) * Phi (m x tsteps)
+---------------------------------------------------------------------------- */
+/* qte_trajectories (polar) over the basis of sc, on the GPU with @backend
+   metal from QTE_METAL_MIN_DIM components on. The GPU keeps the scratch's V
+   resident under its basis_stamp; any failure there falls back to the CPU. */
+static void qte_timedev_trajectories(t_qte_timedev *x, t_qte_timedev_scratch *sc, long n, double tmin, double dt,
+                                     t_qte_cmatrix *phi, t_qte_cmatrix *psi) {
+    if (x->backend == gensym("metal") && n >= QTE_METAL_MIN_DIM && qte_metal_available()) {
+        if (!sc->gpu)
+            sc->gpu = qte_metal_new();
+        qte_phase_matrix(phi, sc->E, sc->c, tmin, dt);
+        int err = sc->gpu ? qte_metal_trajectories(sc->gpu, (uint64_t)sc->basis_stamp, sc->V, phi, psi)
+                          : QTE_ERR_ALLOC;
+        if (!err)
+            return;
+        object_warn((t_object *)x, "Metal backend failed (error %d), falling back to the CPU", err);
+    }
+    qte_trajectories(sc->V, sc->E, sc->c, tmin, dt, phi, psi, 1, qte_threads(x->threads));
+}
+
+#define QTE_TIMEDEV_TIME_BLOCK 512      // time steps per pass, both planes to buffer~s
+
+/* With both planes going to buffer~s and no observable, nothing needs the
+   whole trajectory at once: Phi and Psi are computed for QTE_TIMEDEV_TIME_BLOCK
+   steps at a time, each block re-anchored exactly at its first step, and
+   written straight into the locked buffer~s. Memory then stays O(n * block)
+   however long the window, where n = 2048 over 20000 steps would otherwise
+   hold two n x tsteps complex matrices of 655 MB each. The buffer~ writes
+   count as compute here, the bangs as output. */
+static void qte_timedev_compute_buffers(t_qte_timedev *x, const t_qte_timedev_view *v, t_qte_timedev_scratch *sc,
+                                        double t0) {
+    long n = v->n, m = sc->m, tsteps = v->tsteps;
+    double dt = v->dt;
+    long block = tsteps < QTE_TIMEDEV_TIME_BLOCK ? tsteps : QTE_TIMEDEV_TIME_BLOCK;
+    if (qte_cmatrix_resize(&sc->phi, m, block, QTE_ROW_MAJOR) ||
+        qte_cmatrix_resize(&sc->psi, n, block, QTE_ROW_MAJOR)) {
+        object_error((t_object *)x, "Memory allocation failed for %ld time steps", block);
+        return;
+    }
+    float *mag = qte_timedev_lock_buffer(x, v, x->magref, x->magbuffer);
+    if (!mag)
+        return;
+    float *phase = qte_timedev_lock_buffer(x, v, x->phaseref, x->phasebuffer);
+    if (!phase) {
+        qte_timedev_unlock_buffer(x->magref);
+        return;
+    }
+    for (long s0 = 0; s0 < tsteps; s0 += block) {
+        long steps = s0 + block < tsteps ? block : tsteps - s0;
+        t_qte_cmatrix phi = qte_cmatrix_block(&sc->phi, 0, 0, m, steps);
+        t_qte_cmatrix psi = qte_cmatrix_block(&sc->psi, 0, 0, n, steps);
+        qte_timedev_trajectories(x, sc, n, v->tmin + s0 * dt, dt, &phi, &psi);
+        qte_timedev_write_frames(n, &psi, s0, mag, 0);
+        qte_timedev_write_frames(n, &psi, s0, phase, 1);
+    }
+    qte_timedev_unlock_buffer(x->magref);
+    qte_timedev_unlock_buffer(x->phaseref);
+    t0 = qte_stats_lap(&x->stats, QTE_STAGE_COMPUTE, t0);
+    outlet_bang(x->out_magn);
+    outlet_bang(x->out_phase);
+    qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t0);
+    object_post((t_object *)x, "Time development done.");
+}
+
+static void qte_timedev_do_compute(t_qte_timedev *x, const t_qte_timedev_view *v, t_qte_timedev_scratch *sc) {
+    long n = v->n;
+    if (n <= 0 || !qte_timedev_has_output(x, v) || (v->components && qte_timedev_same_buffer(x)) ||
+        qte_timedev_select(x, v, sc))
+        return;
+    long m = sc->m, nobs = v->nobs, components = v->components;
+    long tsteps = v->tsteps;
+    double tmin = v->tmin, dt = v->dt;
+    double t0 = qte_stats_begin(&x->stats);
+    if (components && !nobs && x->magbuffer != gensym("") && x->phasebuffer != gensym("")) {
+        qte_timedev_compute_buffers(x, v, sc, t0);
+        return;
+    }
+
+    if (qte_cmatrix_resize(&sc->phi, m, tsteps, QTE_ROW_MAJOR) ||
+        (components && qte_cmatrix_resize(&sc->psi, n, tsteps, QTE_ROW_MAJOR))) {
+        object_error((t_object *)x, "Memory allocation failed for %ld time steps", tsteps);
+        return;
+    }
+    if (components)
+        qte_timedev_trajectories(x, sc, n, tmin, dt, &sc->phi, &sc->psi);
+    else
+        qte_phase_matrix(&sc->phi, sc->E, sc->c, tmin, dt);
+    if (nobs && qte_timedev_expectations(x, v, sc, &sc->phi))
+        return;
+    t0 = qte_stats_lap(&x->stats, QTE_STAGE_COMPUTE, t0);
+
+    long size = 1 + 2 * tsteps;
+    if (qte_timedev_reserve(x, sc, size))
+        return;
+    // Observables first (rightmost outlet): <name> t0 <O>(t0) t1 <O>(t1) ...
+    for (long j = 0; j < nobs; j++) {
+        const double *e = sc->expect + j * tsteps;
+        for (long t = 0; t < tsteps; t++) {
+            atom_setfloat(sc->out_list + 2 * t, tmin + t * dt);
+            atom_setfloat(sc->out_list + 2 * t + 1, e[t]);
+        }
+        qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t0);
+        outlet_anything(x->out_obs, v->obs[j]->name, 2 * tsteps, sc->out_list);
+        t0 = qte_time_now();
+    }
+    x->stats.atoms += nobs * 2 * tsteps;
+    if (!components)
+        return;
+
+    // Planes sent to a buffer~ are written in bulk, then announced with a bang.
+    int magbuffer = x->magbuffer != gensym("");
+    int phasebuffer = x->phasebuffer != gensym("");
+    if (magbuffer) {
+        int err = qte_timedev_fill_buffer(x, v, sc, x->magref, x->magbuffer, 0);
+        qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t0);
+        if (!err)
+            outlet_bang(x->out_magn);
+        t0 = qte_time_now();
+    }
+    if (phasebuffer) {
+        int err = qte_timedev_fill_buffer(x, v, sc, x->phaseref, x->phasebuffer, 1);
+        qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t0);
+        if (!err)
+            outlet_bang(x->out_phase);
+        t0 = qte_time_now();
+    }
+    if (magbuffer && phasebuffer)
+        return;
+
+    // For each track i: its index, then (time, value) pairs. The magnitude and
+    // phase lines share one buffer, so the times are written once per track.
+    t_atom *line = sc->out_list;
+    for (long i = 0; i < n; i++) {
+        const double complex *row = sc->psi.data + i * sc->psi.ld;
+        atom_setlong(line, i);
+        for (long t = 0; t < tsteps; t++) {
+            atom_setfloat(line + 1 + 2 * t, tmin + t * dt);
+            atom_setfloat(line + 2 + 2 * t, creal(row[t]));
+        }
+        if (!magbuffer) {
+            qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t0);
+            outlet_list(x->out_magn, gensym("list"), size, line);
+            t0 = qte_time_now();
+        }
+        if (phasebuffer)
+            continue;
+        for (long t = 0; t < tsteps; t++)
+            atom_setfloat(line + 2 + 2 * t, cimag(row[t]));
+        qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t0);
+        outlet_list(x->out_phase, gensym("list"), size, line);
+        t0 = qte_time_now();
+    }
+    x->stats.atoms += n * size * (2 - magbuffer - phasebuffer);
+    object_post((t_object *)x, "Time development done.");
+}
+
+/* ----------------------------------------------------------------------------
+   Streaming: one frame per time step
+---------------------------------------------------------------------------- */
+/* Emits the frame at t = tmin + s*dt, s the next frame index, claimed
+   atomically, so frames sent from two threads at once each get a time of their
+   own. The phase factors of a scratch are rotated on from the frame it sent
+   last and rebuilt exactly every QTE_PHASE_ANCHOR frames, when its previous
+   frame was not s - 1 and after any change of the eigen-data or time settings. */
+static int qte_timedev_frame(t_qte_timedev *x, const t_qte_timedev_view *v, t_qte_timedev_scratch *sc) {
+    if (!qte_timedev_has_output(x, v) || qte_timedev_select(x, v, sc))
+        return -1;
+    long n = v->n, m = sc->m, nobs = v->nobs;
+    double dt = v->dt;
+    long epoch = __atomic_load_n(&x->stream_epoch, __ATOMIC_SEQ_CST);
+    long s = __atomic_fetch_add(&x->frame, 1, __ATOMIC_SEQ_CST);
+    double t = v->tmin + s * dt;
+    double complex *z = sc->z.data;
+    double t0 = qte_stats_begin(&x->stats);
+    if (sc->rot_dt != dt) {
+        for (long k = 0; k < m; k++) {
+            double ph = -sc->E[k] * dt;
+            sc->rot.data[k] = cos(ph) + I * sin(ph);
+        }
+        sc->rot_dt = dt;
+    }
+    if (sc->zframe != s || sc->zepoch != epoch || s % QTE_PHASE_ANCHOR == 0) {
+        for (long k = 0; k < m; k++) {
+            double ph = -sc->E[k] * t;
+            z[k] = sc->c[k] * (cos(ph) + I * sin(ph));
+        }
+    }
+    if (nobs) {
+        // z as the single column of an m x 1 phase matrix.
+        t_qte_cmatrix zcol;
+        qte_cmatrix_init(&zcol);
+        zcol.rows = m;
+        zcol.cols = 1;
+        zcol.ld = 1;
+        zcol.layout = QTE_ROW_MAJOR;
+        zcol.data = z;
+        if (qte_timedev_expectations(x, v, sc, &zcol)) {
+            sc->zframe = -1;
+            return -1;
+        }
+    }
+    if (v->components)
+        qte_zgemv(QTE_NOTRANS, 1.0, sc->V, &sc->z, 0.0, &sc->amp);
+    for (long k = 0; k < m; k++)
+        z[k] *= sc->rot.data[k];
+    sc->zframe = s + 1;
+    sc->zepoch = epoch;
+    t0 = qte_stats_lap(&x->stats, QTE_STAGE_COMPUTE, t0);
+
+    t_atom *list = sc->frame_list;
+    for (long j = 0; j < nobs; j++) {
+        t_atom a[2];
+        atom_setfloat(a, t);
+        atom_setfloat(a + 1, sc->expect[j]);
+        qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t0);
+        outlet_anything(x->out_obs, v->obs[j]->name, 2, a);
+        t0 = qte_time_now();
+    }
+    x->stats.atoms += 2 * nobs;
+    if (!v->components)
+        return 0;
+    atom_setfloat(list, t);
+    for (long i = 0; i < n; i++)
+        atom_setfloat(list + 1 + i, cabs(sc->amp.data[i]));
+    qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t0);
+    outlet_list(x->out_magn, gensym("list"), 1 + n, list);
+    t0 = qte_time_now();
+    for (long i = 0; i < n; i++)
+        atom_setfloat(list + 1 + i, carg(sc->amp.data[i]));
+    qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t0);
+    outlet_list(x->out_phase, gensym("list"), 1 + n, list);
+    x->stats.atoms += 2 * (1 + n);
+    return 0;
+}
+
+static int qte_timedev_emit_frame(t_qte_timedev *x) {
+    t_qte_timedev_view v;
+    if (qte_timedev_acquire(x, &v))
+        return -1;
+    t_qte_timedev_scratch *sc = qte_timedev_scratch_claim(x);
+    int err = -1;
+    if (sc) {
+        err = qte_timedev_frame(x, &v, sc);
+        qte_timedev_scratch_release(sc);
+    }
+    qte_timedev_release(x, &v);
+    return err;
+}
+
+/* step / bang – the next frame; bang-driven runs are open-ended. */
+void qte_timedev_step(t_qte_timedev *x) {
+    qte_timedev_emit_frame(x);
+}
+
+/* start [frames] – from tmin, one frame now and one every @interval ms:
+   tsteps frames by default, 0 for no limit. */
+void qte_timedev_start(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv) {
+    long frames = (argc >= 1) ? atom_getlong(argv) : x->tsteps;
+    if (frames < 0) {
+        object_error((t_object *)x, "start: frames must be >= 0");
+        return;
+    }
+    clock_unset(x->clock);
+    qte_timedev_rewind(x);
+    x->frames_left = frames ? frames : -1;
+    qte_timedev_tick(x);
+}
+
+void qte_timedev_stop(t_qte_timedev *x) {
+    clock_unset(x->clock);
+    x->frames_left = 0;
+}
+
+void qte_timedev_rewind(t_qte_timedev *x) {
+    __atomic_fetch_add(&x->stream_epoch, 1, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&x->frame, 0, __ATOMIC_SEQ_CST);
+}
+
+void qte_timedev_tick(t_qte_timedev *x) {
+    if (x->frames_left == 0)
+        return;
+    if (qte_timedev_emit_frame(x)) {
+        x->frames_left = 0;
+        return;
+    }
+    if (x->frames_left > 0)
+        x->frames_left--;
+    if (x->frames_left != 0)
+        clock_fdelay(x->clock, x->interval);
+}
+
+/* ----------------------------------------------------------------------------
+   at <t> [t ...] – one frame per time, the stream left where it is
+---------------------------------------------------------------------------- */
+static void qte_timedev_do_at(t_qte_timedev *x, const t_qte_timedev_view *v, t_qte_timedev_scratch *sc,
+                              long argc, t_atom *argv) {
+    if (!qte_timedev_has_output(x, v) || qte_timedev_select(x, v, sc))
+        return;
+    long n = v->n, m = sc->m, nobs = v->nobs, components = v->components;
+    double t0 = qte_stats_begin(&x->stats);
+    if (sc->at_times_size < argc) {
+        free(sc->at_times);
+        sc->at_times_size = 0;
+        if (!(sc->at_times = (double *)malloc(argc * sizeof(double)))) {
+            object_error((t_object *)x, "Memory allocation failed for %ld times", argc);
+            return;
+        }
+        sc->at_times_size = argc;
+        x->stats.bytes += argc * sizeof(double);
+    }
+    for (long j = 0; j < argc; j++)
+        sc->at_times[j] = atom_getfloat(argv + j);
+    // Phi (m x argc) of the requested times, then Psi = V * Phi in sc->psi.
+    if (qte_cmatrix_resize(&sc->phi, m, argc, QTE_ROW_MAJOR) ||
+        (components && qte_cmatrix_resize(&sc->psi, n, argc, QTE_ROW_MAJOR))) {
+        object_error((t_object *)x, "Memory allocation failed for %ld times", argc);
+        return;
+    }
+    qte_phase_columns(&sc->phi, sc->E, sc->c, sc->at_times);
+    if (components)
+        qte_zgemm(QTE_NOTRANS, QTE_NOTRANS, 1.0, sc->V, &sc->phi, 0.0, &sc->psi);
+    if (nobs && qte_timedev_expectations(x, v, sc, &sc->phi))
+        return;
+    t0 = qte_stats_lap(&x->stats, QTE_STAGE_COMPUTE, t0);
+
+    t_atom *list = sc->frame_list;
+    for (long j = 0; j < argc; j++) {
+        double t = sc->at_times[j];
+        for (long k = 0; k < nobs; k++) {
+            t_atom a[2];
+            atom_setfloat(a, t);
+            atom_setfloat(a + 1, sc->expect[k * argc + j]);
+            qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t0);
+            outlet_anything(x->out_obs, v->obs[k]->name, 2, a);
+            t0 = qte_time_now();
+        }
+        if (!components)
+            continue;
+        const double complex *col = sc->psi.data + j;
+        atom_setfloat(list, t);
+        for (long i = 0; i < n; i++)
+            atom_setfloat(list + 1 + i, cabs(col[i * sc->psi.ld]));
+        qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t0);
+        outlet_list(x->out_magn, gensym("list"), 1 + n, list);
+        t0 = qte_time_now();
+        for (long i = 0; i < n; i++)
+            atom_setfloat(list + 1 + i, carg(col[i * sc->psi.ld]));
+        qte_stats_lap(&x->stats, QTE_STAGE_OUTPUT, t0);
+        outlet_list(x->out_phase, gensym("list"), 1 + n, list);
+        t0 = qte_time_now();
+    }
+    x->stats.atoms += argc * (2 * nobs + (components ? 2 * (1 + n) : 0));
+}
+
+void qte_timedev_at(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv) {
+    if (argc < 1) {
+        object_error((t_object *)x, "at needs at least one time");
+        return;
+    }
+    t_qte_timedev_view v;
+    if (qte_timedev_acquire(x, &v))
+        return;
+    t_qte_timedev_scratch *sc = qte_timedev_scratch_claim(x);
+    if (sc) {
+        qte_timedev_do_at(x, &v, sc, argc, argv);
+        qte_timedev_scratch_release(sc);
+    }
+    qte_timedev_release(x, &v);
+}
+
+/* ----------------------------------------------------------------------------
+   stats – latencies, bytes and atoms ("stats reset" clears them)
+---------------------------------------------------------------------------- */
+void qte_timedev_stats(t_qte_timedev *x, t_symbol *s, long argc, t_atom *argv) {
+    qte_stats_message((t_object *)x, &x->stats, x->out_status, argc, argv);
+}
+
+/* ----------------------------------------------------------------------------
+   Snapshots – "write <file>" / "read <file>"
+---------------------------------------------------------------------------- */
+void qte_timedev_write(t_qte_timedev *x, t_symbol *s) {
+    char path[MAX_PATH_CHARS];
+    // Pins the current versions like a compute; the coefficients are optional.
+    int ie = qte_slots_acquire(&x->eig.slots);
+    int iv = qte_slots_acquire(&x->states.slots);
+    int ic = qte_slots_acquire(&x->coeff.slots);
+    const t_qte_timedev_slot *e = ie >= 0 ? x->eig.slot + ie : NULL;
+    const t_qte_timedev_slot *v = iv >= 0 ? x->states.slot + iv : NULL;
+    const t_qte_timedev_slot *c = ic >= 0 ? x->coeff.slot + ic : NULL;
+    if (!e || !v || !e->n || e->n != v->n || e->m != v->m) {
+        object_error((t_object *)x, "Need eigenvalues and eigenstates first");
+    } else if (!qte_snapshot_path((t_object *)x, s, 1, path)) {
+        long n = e->n, m = e->m;
+        int err = qte_snapshot_write(path, n, m, e->E, &v->V, (c && c->n == n && c->m == m) ? &c->c : NULL,
+                                     x->source_hash);
+        if (err)
+            qte_snapshot_error((t_object *)x, err, path);
+        else
+            object_post((t_object *)x, "Eigenbasis written to %s", path);
+    }
+    if (ie >= 0)
+        qte_slots_release(&x->eig.slots, ie);
+    if (iv >= 0)
+        qte_slots_release(&x->states.slots, iv);
+    if (ic >= 0)
+        qte_slots_release(&x->coeff.slots, ic);
+}
+
+void qte_timedev_read(t_qte_timedev *x, t_symbol *s) {
+    char path[MAX_PATH_CHARS];
+    if (qte_snapshot_path((t_object *)x, s, 0, path))
+        return;
+    double t = qte_stats_begin(&x->stats);
+    // Opened beside the current snapshot, which the eigenstates may still use.
+    t_qte_snapshot snap;
+    qte_snapshot_init(&snap);
+    int err = qte_snapshot_open(&snap, path);
+    if (err) {
+        qte_snapshot_error((t_object *)x, err, path);
+        return;
+    }
+    long n = (long)snap.header.n, m = (long)snap.header.m;
+    if (m < 1 || m > n || !(snap.header.flags & QTE_SNAPSHOT_VECTORS)) {
+        object_error((t_object *)x, "%s holds no eigenvectors (%ld eigenpairs of dimension %ld)",
+                     path, m, n);
+        qte_snapshot_close(&snap);
+        return;
+    }
+    int has_coeff = (snap.header.flags & QTE_SNAPSHOT_COEFF) != 0;
+    uint64_t source_hash = snap.header.source_hash;
+    int ie, iv, ic = -1, io = -1;
+    // All new versions are filled before any is published, so a failure
+    // leaves the published eigen-data as it was.
+    t_qte_timedev_slot *e = qte_timedev_claim(&x->eig, &ie);
+    t_qte_timedev_slot *v = qte_timedev_claim(&x->states, &iv);
+    t_qte_timedev_slot *c = has_coeff ? qte_timedev_claim(&x->coeff, &ic) : NULL;
+    if (n != x->n) {
+        io = qte_slots_claim(&x->obs_slots);
+        if (!has_coeff)
+            ic = qte_slots_claim(&x->coeff.slots);
+    }
+    if (!e || !v || (has_coeff && !c) || (n != x->n && (io < 0 || ic < 0))) {
+        object_error((t_object *)x, "Eigen-data still in use, %s not read", path);
+        qte_snapshot_close(&snap);
+        return;
+    }
+    if (e->E_size < m) {
+        free(e->E);
+        e->E_size = 0;
+        if ((e->E = (double *)malloc(m * sizeof(double))))
+            e->E_size = m;
+    }
+    int in_place = snap.V.layout == QTE_ROW_MAJOR;
+    qte_snapshot_close(&v->snap);
+    if (in_place)
+        qte_cmatrix_free(&v->V);
+    if (!e->E || (c && qte_cvector_resize(&c->c, m)) ||
+        (!in_place && qte_cmatrix_copy(&v->V, &snap.V, QTE_ROW_MAJOR))) {
+        object_error((t_object *)x, "Memory allocation failed for dimension %ld", n);
+        qte_snapshot_close(&snap);
+        return;
+    }
+    memcpy(e->E, snap.w, m * sizeof(double));
+    if (c)
+        memcpy(c->c.data, snap.c.data, m * sizeof(double complex));
+    if (in_place) {
+        v->V = snap.V;                  // the mapping stays open with this version
+        v->snap = snap;
+    } else {
+        qte_snapshot_close(&snap);
+    }
+    if (n != x->n) {
+        qte_timedev_stop(x);
+        qte_timedev_observables_clear(x, io);
+        if (!c)
+            qte_timedev_field_clear(&x->coeff, ic);
+        x->n = n;
+    }
+    qte_timedev_publish(&x->eig, ie, n, m);
+    qte_timedev_publish(&x->states, iv, n, m);
+    if (c)
+        qte_timedev_publish(&x->coeff, ic, n, m);
+    x->source_hash = source_hash;
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+    object_post((t_object *)x, "Eigenbasis read from %s", path);
+}
@@ -0,0 +1,559 @@
+/* qte.timedev~.c – Signal-rate time development for Max/MSP
+ *
+ * The MSP counterpart of qte.timedev. It takes the same eigen-data
+ *    - set_eigenvalues : m floats E_k (m <= n, e.g. a subset from qte.eigencalc @range)
+ *    - set_coeff       : 2*m floats, the complex coefficients c_k of the initial state
+ *    - set_eigenstates : 2*n*m floats, eigenvector k stored contiguously as
+ *                        (real, imag) pairs, exactly as qte.eigencalc outputs them
+ *                        (or "jit_matrix <name>" with one eigenvector per column)
+ * and evaluates
+ *
+ *    psi_i(t) = sum_k c_k * exp(-i E_k t) * v_k[i]
+ *
+ * once per sample. The left multichannel outlet carries the n magnitudes |psi_i(t)|,
+ * the right one the n phases arg psi_i(t).
+ *
+ * Time either advances by itself (@speed time units per second, "time <t>" jumps)
+ * or follows the signal connected to the inlet. The phase factors
+ * z_k = c_k exp(-i E_k t) are advanced with a per-sample rotation z_k *= exp(-i E_k dt)
+ * and re-anchored exactly at the start of every signal vector, so the perform
+ * routine calls no transcendental function per (k, sample) and allocates nothing.
+ * A time signal that is a ramp within QTE_TIMEDEV_TILDE_RAMP_TOL of a step is
+ * followed with the one step of its vector, so sample jitter does not rebuild
+ * the rotations; other time signals are rotated by each sample's increment.
+ *
+ * The whole signal vector is evaluated at once: the phase factors of every sample
+ * form an m x B phase matrix Phi, and a single zgemm Psi = V * Phi against the
+ * contiguous n x m eigenstate matrix V yields all n x B amplitudes.
+ *
+ * The eigen-data lives in a state the perform routine only reads. Every set_*
+ * or jit_matrix builds a new state on the main thread (a copy of the last one
+ * with the change applied) and hands it over with one atomic pointer exchange;
+ * perform64 picks it up at the start of a signal vector, so a vector never
+ * mixes old and new data, and leaves the state it replaced for the main thread
+ * to free.
+ *
+ * "stats" sends the parse (set_*, jit_matrix), compute (phase matrix and zgemm
+ * per signal vector) and output (writing the vector) latencies from the right
+ * outlet, the one message outlet beside the two signal outlets (see
+ * qte_stats_message). The perform routine records with qte_latency_add alone,
+ * which allocates nothing; the report is built on the main thread.
+ */
+
+#include "ext.h"
+#include "ext_obex.h"
+#include "z_dsp.h"
+#include "jit.common.h"
+#include "qte_core.h"
+#include "qte_core_max.h"
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <complex.h>
+
+// The eigen-data of one version, never changed once published.
+typedef struct _qte_timedev_tilde_state {
+    long n;                    // Dimension the storage is sized for
+    long m;                    // Number of eigenpairs in use (set by set_eigenvalues)
+    double *eigenvalues;       // E_k, length n (first m used)
+    t_qte_cvector coeff;       // c_k, length m
+    // Eigenstates V, n x m row-major (capacity n x n): V(i, k) = v_k[i], so the
+    // k-sum for one component runs over contiguous memory.
+    t_qte_cmatrix eigenstates;
+    long have_eigenvalues;
+    long have_coeff;
+    long have_eigenstates;
+} t_qte_timedev_tilde_state;
+
+// Object structure
+typedef struct _qte_timedev_tilde {
+    t_pxobject ob;
+    long n;                    // Dimension (number of basis components / output channels)
+    // State handover: the main thread puts a new state in `next` (replacing
+    // one not yet picked up), perform64 moves it to `state` and the state it
+    // replaced to `dead`, which the main thread frees. `latest` is the last
+    // state published (main thread only), the basis of the next set_*.
+    t_qte_timedev_tilde_state *state;   // read by perform64 (audio thread)
+    t_qte_timedev_tilde_state *next;
+    t_qte_timedev_tilde_state *dead;
+    t_qte_timedev_tilde_state *latest;
+    // Scratch of perform64 (audio thread), sized while audio is off.
+    t_qte_cvector z;           // Phase factors c_k exp(-i E_k t), capacity n
+    t_qte_cvector rot;         // Per-sample rotations exp(-i E_k dt), capacity n
+    double rot_dt;             // dt the rotations were built for
+    t_qte_cmatrix phi;         // Phase matrix, m x B row-major (capacity n x block)
+    t_qte_cmatrix psi;         // Amplitudes, n x B row-major (capacity n x block)
+    long block;                // Signal vector size phi/psi are reserved for (in dsp64)
+    double t;                  // Current time (free-running mode)
+    double speed;              // Time units per second (free-running mode)
+    double sr;                 // Sample rate
+    long dsp_n;                // Channel count the DSP chain was compiled with
+    long time_connected;       // The time inlet has a signal connected
+    t_qte_stats stats;         // "stats" message / qte.profiler
+    void *out_status;          // Right outlet: stats
+} t_qte_timedev_tilde;
+
+static t_class *qte_timedev_tilde_class = NULL;
+
+/* Function prototypes */
+void ext_main(void *r);
+void *qte_timedev_tilde_new(t_symbol *s, long argc, t_atom *argv);
+void  qte_timedev_tilde_free(t_qte_timedev_tilde *x);
+void  qte_timedev_tilde_assist(t_qte_timedev_tilde *x, void *b, long m, long a, char *s);
+void  qte_timedev_tilde_dim(t_qte_timedev_tilde *x, long n);
+void  qte_timedev_tilde_set_eigenvalues(t_qte_timedev_tilde *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_timedev_tilde_set_coeff(t_qte_timedev_tilde *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_timedev_tilde_set_eigenstates(t_qte_timedev_tilde *x, t_symbol *s, long argc, t_atom *argv);
+void  qte_timedev_tilde_jit_matrix(t_qte_timedev_tilde *x, t_symbol *s);
+void  qte_timedev_tilde_time(t_qte_timedev_tilde *x, double t);
+void  qte_timedev_tilde_stats(t_qte_timedev_tilde *x, t_symbol *s, long argc, t_atom *argv);
+long  qte_timedev_tilde_multichanneloutputs(t_qte_timedev_tilde *x, long index);
+void  qte_timedev_tilde_dsp64(t_qte_timedev_tilde *x, t_object *dsp64, short *count,
+                              double samplerate, long maxvectorsize, long flags);
+void  qte_timedev_tilde_perform64(t_qte_timedev_tilde *x, t_object *dsp64, double **ins, long numins,
+                                  double **outs, long numouts, long sampleframes, long flags, void *userparam);
+
+/* ----------------------------------------------------------------------------
+   ext_main – class initialization
+---------------------------------------------------------------------------- */
+void ext_main(void *r) {
+    t_class *c = class_new("qte.timedev~",
+                           (method)qte_timedev_tilde_new,
+                           (method)qte_timedev_tilde_free,
+                           sizeof(t_qte_timedev_tilde),
+                           0L, A_GIMME, 0);
+
+    class_addmethod(c, (method)qte_timedev_tilde_assist, "assist", A_CANT, 0);
+    class_addmethod(c, (method)qte_timedev_tilde_dim, "dim", A_LONG, 0);
+    class_addmethod(c, (method)qte_timedev_tilde_set_eigenvalues, "set_eigenvalues", A_GIMME, 0);
+    class_addmethod(c, (method)qte_timedev_tilde_set_coeff, "set_coeff", A_GIMME, 0);
+    class_addmethod(c, (method)qte_timedev_tilde_set_eigenstates, "set_eigenstates", A_GIMME, 0);
+    class_addmethod(c, (method)qte_timedev_tilde_jit_matrix, "jit_matrix", A_SYM, 0);
+    class_addmethod(c, (method)qte_timedev_tilde_time, "time", A_FLOAT, 0);
+    class_addmethod(c, (method)qte_timedev_tilde_stats, "stats", A_GIMME, 0);
+    class_addmethod(c, (method)qte_timedev_tilde_multichanneloutputs, "multichanneloutputs", A_CANT, 0);
+    class_addmethod(c, (method)qte_timedev_tilde_dsp64, "dsp64", A_CANT, 0);
+
+    CLASS_ATTR_DOUBLE(c, "speed", 0, t_qte_timedev_tilde, speed);
+    CLASS_ATTR_LABEL(c, "speed", 0, "Time Units per Second");
+
+    class_dspinit(c);
+    class_register(CLASS_BOX, c);
+    qte_timedev_tilde_class = c;
+}
+
+/* ----------------------------------------------------------------------------
+   Storage helpers
+---------------------------------------------------------------------------- */
+static void qte_timedev_tilde_state_free(t_qte_timedev_tilde_state *st) {
+    if (!st)
+        return;
+    free(st->eigenvalues);
+    qte_cvector_free(&st->coeff);
+    qte_cmatrix_free(&st->eigenstates);
+    free(st);
+}
+
+/* Sets the number of eigenpairs m <= n; capacities are fixed by state_new. */
+static void qte_timedev_tilde_set_m(t_qte_timedev_tilde_state *st, long m) {
+    st->m = m;
+    qte_cvector_resize(&st->coeff, m);
+    qte_cmatrix_reshape(&st->eigenstates, st->n, m, QTE_ROW_MAJOR);
+}
+
+/* A state for dimension n with nothing set yet, NULL when out of memory. */
+static t_qte_timedev_tilde_state *qte_timedev_tilde_state_new(long n) {
+    t_qte_timedev_tilde_state *st = (t_qte_timedev_tilde_state *)calloc(1, sizeof(*st));
+    if (!st)
+        return NULL;
+    qte_cvector_init(&st->coeff);
+    qte_cmatrix_init(&st->eigenstates);
+    st->eigenvalues = (double *)calloc(n, sizeof(double));
+    if (!st->eigenvalues || qte_cvector_resize(&st->coeff, n) ||
+        qte_cmatrix_resize(&st->eigenstates, n, n, QTE_ROW_MAJOR)) {
+        qte_timedev_tilde_state_free(st);
+        return NULL;
+    }
+    qte_cmatrix_zero(&st->eigenstates);
+    st->n = n;
+    qte_timedev_tilde_set_m(st, n);
+    return st;
+}
+
+/* Main thread: a copy of the last published state to change and publish;
+   posts an error and returns NULL when out of memory. */
+static t_qte_timedev_tilde_state *qte_timedev_tilde_state_copy(t_qte_timedev_tilde *x) {
+    const t_qte_timedev_tilde_state *src = x->latest;
+    t_qte_timedev_tilde_state *st = qte_timedev_tilde_state_new(src->n);
+    if (!st) {
+        object_error((t_object *)x, "Memory allocation failed for the eigen-data");
+        return NULL;
+    }
+    qte_timedev_tilde_set_m(st, src->m);
+    memcpy(st->eigenvalues, src->eigenvalues, src->m * sizeof(double));
+    memcpy(st->coeff.data, src->coeff.data, src->m * sizeof(double complex));
+    memcpy(st->eigenstates.data, src->eigenstates.data, src->n * src->m * sizeof(double complex));
+    st->have_eigenvalues = src->have_eigenvalues;
+    st->have_coeff = src->have_coeff;
+    st->have_eigenstates = src->have_eigenstates;
+    return st;
+}
+
+/* Main thread: hands st to perform64, freeing the state it last replaced and
+   any published state it has not picked up yet (which it never read). */
+static void qte_timedev_tilde_publish(t_qte_timedev_tilde *x, t_qte_timedev_tilde_state *st) {
+    qte_timedev_tilde_state_free(__atomic_exchange_n(&x->dead, NULL, __ATOMIC_ACQ_REL));
+    qte_timedev_tilde_state_free(__atomic_exchange_n(&x->next, st, __ATOMIC_ACQ_REL));
+    x->latest = st;
+}
+
+/* Audio thread, at the start of a vector: takes up a published state. The
+   previous one goes to dead only once the main thread has freed the last. */
+static void qte_timedev_tilde_pickup(t_qte_timedev_tilde *x) {
+    if (__atomic_load_n(&x->dead, __ATOMIC_ACQUIRE))
+        return;
+    t_qte_timedev_tilde_state *st = __atomic_exchange_n(&x->next, NULL, __ATOMIC_ACQ_REL);
+    if (!st)
+        return;
+    __atomic_store_n(&x->dead, x->state, __ATOMIC_RELEASE);
+    x->state = st;
+    x->rot_dt = 0.0;
+}
+
+/* Frees every state and the perform scratch; audio must be off. */
+static void qte_timedev_tilde_free_state(t_qte_timedev_tilde *x) {
+    qte_timedev_tilde_state_free(x->state);
+    qte_timedev_tilde_state_free(x->next);
+    qte_timedev_tilde_state_free(x->dead);
+    x->state = x->next = x->dead = x->latest = NULL;
+    qte_cvector_free(&x->z);
+    qte_cvector_free(&x->rot);
+    qte_cmatrix_free(&x->phi);
+    qte_cmatrix_free(&x->psi);
+    x->block = 0;
+}
+
+/* Audio must be off: perform64 starts from the new state directly. */
+static int qte_timedev_tilde_alloc_state(t_qte_timedev_tilde *x, long n) {
+    x->state = qte_timedev_tilde_state_new(n);
+    if (!x->state || qte_cvector_resize(&x->z, n) || qte_cvector_resize(&x->rot, n)) {
+        qte_timedev_tilde_free_state(x);
+        return -1;
+    }
+    x->latest = x->state;
+    x->n = n;
+    x->rot_dt = 0.0;
+    return 0;
+}
+
+/* ----------------------------------------------------------------------------
+   Constructor / Destructor
+---------------------------------------------------------------------------- */
+void *qte_timedev_tilde_new(t_symbol *s, long argc, t_atom *argv) {
+    t_qte_timedev_tilde *x = (t_qte_timedev_tilde *)object_alloc(qte_timedev_tilde_class);
+    if (x) {
+        long n = 3;
+        if (attr_args_offset(argc, argv) >= 1) {
+            long tmp = atom_getlong(argv);
+            if (tmp > 0)
+                n = tmp;
+        }
+        x->t = 0.0;
+        x->speed = 1.0;
+        x->sr = 44100.0;
+        x->dsp_n = 0;
+        x->state = x->next = x->dead = x->latest = NULL;
+        qte_cvector_init(&x->z);
+        qte_cvector_init(&x->rot);
+        qte_cmatrix_init(&x->phi);
+        qte_cmatrix_init(&x->psi);
+        x->block = 0;
+        x->time_connected = 0;
+        if (qte_timedev_tilde_alloc_state(x, n)) {
+            object_error((t_object *)x, "Memory allocation failed for dimension %ld", n);
+            object_free(x);
+            return NULL;
+        }
+        // One signal inlet (time), a status outlet and two multichannel outlets
+        // (right-to-left).
+        dsp_setup((t_pxobject *)x, 1);
+        x->ob.z_misc |= Z_NO_INPLACE;
+        x->out_status = outlet_new((t_object *)x, NULL);
+        outlet_new((t_object *)x, "multichannelsignal"); // phases
+        outlet_new((t_object *)x, "multichannelsignal"); // magnitudes
+        qte_stats_register((t_object *)x, &x->stats);
+        attr_args_process(x, argc, argv);
+    }
+    return x;
+}
+
+void qte_timedev_tilde_free(t_qte_timedev_tilde *x) {
+    dsp_free((t_pxobject *)x);
+    qte_stats_unregister((t_object *)x);
+    qte_timedev_tilde_free_state(x);
+}
+
+/* ----------------------------------------------------------------------------
+   Assist method
+---------------------------------------------------------------------------- */
+void qte_timedev_tilde_assist(t_qte_timedev_tilde *x, void *b, long m, long a, char *s) {
+    if (m == 1)
+        sprintf(s, "(signal) time; messages: dim, set_eigenvalues, set_coeff, set_eigenstates, jit_matrix, time, stats");
+    else if (a == 0)
+        sprintf(s, "(multichannel signal) %ld magnitudes |psi_i(t)|", x->n);
+    else if (a == 1)
+        sprintf(s, "(multichannel signal) %ld phases arg psi_i(t)", x->n);
+    else
+        sprintf(s, "Status outlet: stats");
+}
+
+/* ----------------------------------------------------------------------------
+   Configuration messages
+---------------------------------------------------------------------------- */
+void qte_timedev_tilde_dim(t_qte_timedev_tilde *x, long n) {
+    if (n <= 0) {
+        object_error((t_object *)x, "dim must be > 0");
+        return;
+    }
+    if (x->n == n)
+        return;
+    // The channel count and the buffers are used by the running perform routine.
+    if (sys_getdspobjdspstate((t_object *)x)) {
+        object_error((t_object *)x, "dim cannot change while audio is running");
+        return;
+    }
+    // The old dimension stays when the new one does not fit in memory.
+    t_qte_timedev_tilde_state *st = qte_timedev_tilde_state_new(n);
+    if (!st || qte_cvector_resize(&x->z, n) || qte_cvector_resize(&x->rot, n)) {
+        object_error((t_object *)x, "Memory allocation failed for dimension %ld", n);
+        qte_timedev_tilde_state_free(st);
+        return;
+    }
+    qte_timedev_tilde_state_free(x->state);
+    qte_timedev_tilde_state_free(x->next);
+    qte_timedev_tilde_state_free(x->dead);
+    x->next = x->dead = NULL;
+    x->state = x->latest = st;
+    x->n = n;
+    x->rot_dt = 0.0;
+    object_post((t_object *)x, "dimension set to %ld", n);
+}
+
+void qte_timedev_tilde_set_eigenvalues(t_qte_timedev_tilde *x, t_symbol *s, long argc, t_atom *argv) {
+    if (argc < 1 || argc > x->n) {
+        object_error((t_object *)x, "Expected 1..%ld floats for eigenvalues", x->n);
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    t_qte_timedev_tilde_state *st = qte_timedev_tilde_state_copy(x);
+    if (!st)
+        return;
+    // A change in the number of eigenpairs invalidates coefficients and eigenstates.
+    if (argc != st->m) {
+        qte_timedev_tilde_set_m(st, argc);
+        st->have_coeff = st->have_eigenstates = 0;
+    }
+    for (long k = 0; k < argc; k++)
+        st->eigenvalues[k] = atom_getfloat(argv + k);
+    st->have_eigenvalues = 1;
+    qte_timedev_tilde_publish(x, st);
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+}
+
+void qte_timedev_tilde_set_coeff(t_qte_timedev_tilde *x, t_symbol *s, long argc, t_atom *argv) {
+    long m = x->latest->m;
+    if (argc != 2 * m) {
+        object_error((t_object *)x, "Expected 2*%ld=%ld floats for init coeff", m, 2 * m);
+        return;
+    }
+    double t = qte_stats_begin(&x->stats);
+    t_qte_timedev_tilde_state *st = qte_timedev_tilde_state_copy(x);
+    if (!st)
+        return;
+    qte_atoms_to_cvector(argc, argv, &st->coeff);
+    st->have_coeff = 1;
+    qte_timedev_tilde_publish(x, st);
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+}
+
+void qte_timedev_tilde_set_eigenstates(t_qte_timedev_tilde *x, t_symbol *s, long argc, t_atom *argv) {
+    long n = x->n;
+    long m = x->latest->m;
+    if (argc != 2 * n * m) {
+        object_error((t_object *)x, "Expected 2*n*m=%ld floats for eigenstates", 2 * n * m);
+        return;
+    }
+    // Input: eigenvector k occupies floats 2*(k*n) .. 2*(k*n + n) - 1, i.e. V column by column.
+    double t = qte_stats_begin(&x->stats);
+    t_qte_timedev_tilde_state *st = qte_timedev_tilde_state_copy(x);
+    if (!st)
+        return;
+    qte_atoms_to_cmatrix(argc, argv, &st->eigenstates, QTE_COL_MAJOR);
+    st->have_eigenstates = 1;
+    qte_timedev_tilde_publish(x, st);
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+}
+
+/* jit_matrix – eigenstates as a 2-plane float64 matrix with n rows and m columns
+   (one eigenvector per column), as produced by qte.eigencalc @format matrix. */
+void qte_timedev_tilde_jit_matrix(t_qte_timedev_tilde *x, t_symbol *s) {
+    long rows, cols;
+    if (qte_jit_matrix_dims(s, &rows, &cols) || rows != x->n || cols != x->latest->m) {
+        object_error((t_object *)x, "Expected a 2-plane float64 jit.matrix with %ld rows and %ld columns",
+                     x->n, x->latest->m);
+        return;
+    }
+    // Matrix row i holds component i of every eigenvector, which is exactly one
+    // row of V; the read fits the n x m shape of the new state, so it does not
+    // allocate beyond the state itself.
+    double t = qte_stats_begin(&x->stats);
+    t_qte_timedev_tilde_state *st = qte_timedev_tilde_state_copy(x);
+    if (!st)
+        return;
+    if (qte_jit_matrix_read(s, &st->eigenstates)) {
+        object_error((t_object *)x, "Could not read jit.matrix %s", s->s_name);
+        qte_timedev_tilde_state_free(st);
+        return;
+    }
+    st->have_eigenstates = 1;
+    qte_timedev_tilde_publish(x, st);
+    qte_stats_lap(&x->stats, QTE_STAGE_PARSE, t);
+}
+
+/* time <t> – jump to time t (free-running mode). */
+void qte_timedev_tilde_time(t_qte_timedev_tilde *x, double t) {
+    x->t = t;
+}
+
+/* stats – posts latencies ("stats reset" clears them). */
+void qte_timedev_tilde_stats(t_qte_timedev_tilde *x, t_symbol *s, long argc, t_atom *argv) {
+    qte_stats_message((t_object *)x, &x->stats, x->out_status, argc, argv);
+}
+
+/* ----------------------------------------------------------------------------
+   DSP
+---------------------------------------------------------------------------- */
+long qte_timedev_tilde_multichanneloutputs(t_qte_timedev_tilde *x, long index) {
+    return x->n;
+}
+
+void qte_timedev_tilde_dsp64(t_qte_timedev_tilde *x, t_object *dsp64, short *count,
+                             double samplerate, long maxvectorsize, long flags) {
+    x->sr = samplerate > 0 ? samplerate : 44100.0;
+    // Size the per-vector scratch here so the perform routine never allocates.
+    if (x->block != maxvectorsize || x->dsp_n != x->n) {
+        long capacity = x->n * maxvectorsize;
+        x->block = 0;
+        if (qte_cmatrix_reserve(&x->phi, capacity) || qte_cmatrix_reserve(&x->psi, capacity))
+            object_error((t_object *)x, "Memory allocation failed for signal vector scratch");
+        else
+            x->block = maxvectorsize;
+    }
+    x->dsp_n = x->n;
+    x->time_connected = count[0];
+    x->rot_dt = 0.0;
+    object_method(dsp64, gensym("dsp_add64"), x, qte_timedev_tilde_perform64, 0, NULL);
+}
+
+/* Rebuild z_k = c_k exp(-i E_k t) exactly; used once per vector. */
+static void qte_timedev_tilde_anchor(t_qte_timedev_tilde *x, const t_qte_timedev_tilde_state *st, double t) {
+    for (long k = 0; k < st->m; k++) {
+        double ph = -st->eigenvalues[k] * t;
+        x->z.data[k] = st->coeff.data[k] * (cos(ph) + I * sin(ph));
+    }
+}
+
+/* A time signal counts as a ramp when no sample is further than this fraction
+   of a step from the line through its first and last sample; float jitter in a
+   line~ or a counter stays far below it. */
+#define QTE_TIMEDEV_TILDE_RAMP_TOL 1e-6
+
+/* The step of the time signal tin (B samples) if it is a ramp, else NAN. */
+static double qte_timedev_tilde_ramp(const double *tin, long B) {
+    if (B < 2)
+        return 0.0;
+    double dt = (tin[B - 1] - tin[0]) / (B - 1);
+    double tol = QTE_TIMEDEV_TILDE_RAMP_TOL * fabs(dt);
+    for (long s = 1; s < B - 1; s++)
+        if (fabs(tin[s] - (tin[0] + s * dt)) > tol)
+            return NAN;
+    return dt;
+}
+
+/* Rebuild the per-sample rotations exp(-i E_k dt) when dt changes. */
+static void qte_timedev_tilde_rotations(t_qte_timedev_tilde *x, const t_qte_timedev_tilde_state *st, double dt) {
+    if (dt == x->rot_dt)
+        return;
+    for (long k = 0; k < st->m; k++) {
+        double ph = -st->eigenvalues[k] * dt;
+        x->rot.data[k] = cos(ph) + I * sin(ph);
+    }
+    x->rot_dt = dt;
+}
+
+void qte_timedev_tilde_perform64(t_qte_timedev_tilde *x, t_object *dsp64, double **ins, long numins,
+                                 double **outs, long numouts, long sampleframes, long flags, void *userparam) {
+    qte_timedev_tilde_pickup(x);
+    const t_qte_timedev_tilde_state *st = x->state;
+    long n = x->dsp_n;
+    long B = sampleframes;
+    double **mag = outs;
+    double **phase = outs + n;
+
+    if (!st || n != st->n || numouts < 2 * n || B > x->block ||
+        !(st->have_eigenvalues && st->have_coeff && st->have_eigenstates)) {
+        for (long c = 0; c < numouts; c++)
+            memset(outs[c], 0, sampleframes * sizeof(double));
+        return;
+    }
+
+    long m = st->m;
+    double t0 = qte_time_now();
+    // Phase matrix: Phi(k, s) = c_k exp(-i E_k t_s). Both reshapes fit the
+    // capacity reserved in dsp64 (m <= n, B <= block).
+    qte_cmatrix_reshape(&x->phi, m, B, QTE_ROW_MAJOR);
+    qte_cmatrix_reshape(&x->psi, n, B, QTE_ROW_MAJOR);
+    double complex *z = x->z.data;
+    double complex *rot = x->rot.data;
+    double complex *phi = x->phi.data;
+    const double *tin = ins[0];
+    double t = x->time_connected ? tin[0] : x->t;
+    double ramp = x->time_connected ? qte_timedev_tilde_ramp(tin, B) : NAN;
+    if (x->time_connected && !isnan(ramp)) {
+        // A ramp (the usual case, e.g. line~): one fixed step for the vector,
+        // so the rotations are built once per vector, not once per sample.
+        qte_phase_matrix(&x->phi, st->eigenvalues, st->coeff.data, t, ramp);
+    } else if (x->time_connected) {
+        qte_timedev_tilde_anchor(x, st, t);
+        // Follow the time signal: rotate by the increment since the last sample.
+        for (long k = 0; k < m; k++)
+            phi[k * B] = z[k];
+        for (long s = 1; s < B; s++) {
+            qte_timedev_tilde_rotations(x, st, tin[s] - tin[s - 1]);
+            for (long k = 0; k < m; k++) {
+                z[k] *= rot[k];
+                phi[k * B + s] = z[k];
+            }
+        }
+    } else {
+        double dt = x->speed / x->sr;
+        qte_phase_matrix(&x->phi, st->eigenvalues, st->coeff.data, t, dt);
+        x->t = t + B * dt;
+    }
+
+    // Psi (n x B) = V (n x m) * Phi (m x B)
+    qte_zgemm(QTE_NOTRANS, QTE_NOTRANS, 1.0, &st->eigenstates, &x->phi, 0.0, &x->psi);
+    double t1 = qte_time_now();
+    qte_latency_add(&x->stats.stage[QTE_STAGE_COMPUTE], t1 - t0);
+
+    for (long i = 0; i < n; i++) {
+        const double complex *row = x->psi.data + i * B;
+        double *mi = mag[i];
+        double *pi = phase[i];
+        for (long s = 0; s < B; s++) {
+            mi[s] = cabs(row[s]);
+            pi[s] = carg(row[s]);
+        }
+    }
+    qte_latency_add(&x->stats.stage[QTE_STAGE_OUTPUT], qte_time_now() - t1);
+}